@@ -0,0 +1,753 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/client/AsyncClient.h>
+
+#include <remus/proto/FrameSet.h>
+#include <remus/proto/Message.h>
+#include <remus/proto/Response.h>
+
+#include <remus/proto/EventTypes.h>
+#include <remus/proto/zmqHelper.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+#include <boost/uuid/random_generator.hpp>
+#include <boost/uuid/uuid_io.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace remus{
+namespace client{
+
+namespace detail{
+
+typedef std::function<void (const remus::proto::Response&)> ResponseHandler;
+typedef std::function<void (const remus::proto::JobStatus&)> DoneHandler;
+
+//how often in milliseconds the status of the jobs we are waiting on is
+//asked for. The done event of a job is lost when the job is done before
+//our subscription reaches the server, so every so often we make sure that
+//hasn't happened
+static const boost::int64_t JobRecheckInterval = 1000;
+
+remus::proto::JobStatus to_JobStatus(const remus::proto::Response& response);
+remus::proto::FrameSet to_FrameSet(const remus::proto::Job& job);
+
+//------------------------------------------------------------------------------
+//a request that is waiting to be sent to the server
+struct AsyncRequest
+{
+  std::string Id;
+  remus::common::MeshIOType Type;
+  remus::SERVICE_TYPE Service;
+  remus::proto::FrameSet Frames;
+  ResponseHandler Handler;
+};
+
+//------------------------------------------------------------------------------
+//a job that somebody is waiting on to be done
+struct JobWatch
+{
+  JobWatch(const remus::proto::Job& job, const DoneHandler& handler):
+    WatchedJob(job),
+    Handler(handler)
+  {}
+
+  remus::proto::Job WatchedJob;
+  DoneHandler Handler;
+};
+
+//------------------------------------------------------------------------------
+static bool is_Done(const remus::proto::JobStatus& status)
+{
+  return status.finished() || status.failed();
+}
+
+//------------------------------------------------------------------------------
+std::string done_Key(const remus::proto::Job& job)
+{
+  return remus::proto::jobevents::done_key(boost::uuids::to_string(job.id()));
+}
+
+//------------------------------------------------------------------------------
+//the frames of a request that only has data
+remus::proto::FrameSet make_FrameSet(std::string data)
+{
+  remus::proto::FrameSet frames;
+  frames.Header = remus::proto::detail::make_HeaderFrame(data);
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+bool has_response(zmq::socket_t& socket)
+{
+  int events = 0;
+  size_t events_size = sizeof(events);
+  socket.getsockopt(ZMQ_EVENTS, &events, &events_size);
+  return (events & ZMQ_POLLIN) != 0;
+}
+
+//------------------------------------------------------------------------------
+//lightweight struct to hide zmq and the thread that talks to the server
+//from leaking into libraries that link to remus client. Application threads
+//queue requests, and the thread owns the socket that is connected to the
+//server, so the socket is only ever used by a single thread.
+struct AsyncZmqManagement
+{
+  typedef std::multimap<std::string, JobWatch> WatchMap;
+
+  boost::shared_ptr<zmq::context_t> Context;
+  zmq::socket_t Server;
+  zmq::socket_t Status;
+  zmq::socket_t WakeUpChannel;
+  std::string WakeUpEndpoint;
+  bool CanSubscribe;
+
+  //the wire format requests are sent in, responses come back in kind
+  remus::proto::WireFormat::Type Format;
+
+  mutable std::mutex Mutex;
+  std::deque<AsyncRequest> Queued;
+  std::deque<JobWatch> QueuedWatches;
+  boost::uint64_t NextRequestId;
+  std::size_t PendingRequests;
+  bool WakeUpSent;
+  bool Stop;
+
+  //the jobs being waited on, keyed by the done key of the job. Only used
+  //by the thread
+  WatchMap Watching;
+  std::deque<AsyncRequest> Unsent;
+
+  std::thread Thread;
+
+  AsyncZmqManagement(const remus::client::ServerConnection &conn):
+    Context(conn.context()),
+    Server(*(conn.context()), ZMQ_DEALER),
+    Status(*(conn.context()), ZMQ_SUB),
+    WakeUpChannel(*(conn.context()), ZMQ_PULL),
+    WakeUpEndpoint(),
+    CanSubscribe(!conn.statusEndpoint().empty()),
+    Format(conn.wireFormat()),
+    Mutex(),
+    Queued(),
+    QueuedWatches(),
+    NextRequestId(0),
+    PendingRequests(0),
+    WakeUpSent(false),
+    Stop(false),
+    Watching(),
+    Unsent(),
+    Thread()
+  {
+    zmq::connectToAddress(this->Server,conn.endpoint());
+    if(this->CanSubscribe)
+      {
+      zmq::connectToAddress(this->Status,conn.statusEndpoint());
+      }
+
+    //bind the wake up channel before the thread starts, so that requests
+    //queued before the thread polls aren't missed
+    boost::uuids::random_generator generator;
+    const zmq::socketInfo<zmq::proto::inproc> wakeUpInfo(
+                                      boost::uuids::to_string(generator()) );
+    zmq::bindToAddress(this->WakeUpChannel, wakeUpInfo);
+    this->WakeUpEndpoint = wakeUpInfo.endpoint();
+
+    this->Thread = std::thread(&AsyncZmqManagement::run, this);
+  }
+
+  ~AsyncZmqManagement()
+  {
+    {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Stop = true;
+    }
+    zmq::wake_up(*this->Context, this->WakeUpEndpoint);
+    this->Thread.join();
+  }
+
+  //----------------------------------------------------------------------------
+  //queue a request for the thread to send. The handler is invoked with the
+  //response on the thread that talks to the server.
+  void request(const remus::common::MeshIOType& type,
+               remus::SERVICE_TYPE service,
+               const remus::proto::FrameSet& frames,
+               const ResponseHandler& handler)
+  {
+    AsyncRequest request;
+    request.Type = type;
+    request.Service = service;
+    request.Frames = frames;
+    request.Handler = [this, handler](const remus::proto::Response& response)
+                        { this->requestFinished(); handler(response); };
+
+    bool needsWakeUp = false;
+    {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    request.Id = this->nextRequestId();
+    this->Queued.push_back(request);
+    ++this->PendingRequests;
+    needsWakeUp = this->markWakeUpSent();
+    }
+
+    if(needsWakeUp)
+      {
+      zmq::wake_up(*this->Context, this->WakeUpEndpoint);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  //queue a job for the thread to wait on. The handler is invoked with the
+  //final status of the job on the thread that talks to the server.
+  void watch(const remus::proto::Job& job, const DoneHandler& handler)
+  {
+    JobWatch w(job, handler);
+
+    bool needsWakeUp = false;
+    {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->QueuedWatches.push_back(w);
+    needsWakeUp = this->markWakeUpSent();
+    }
+
+    if(needsWakeUp)
+      {
+      zmq::wake_up(*this->Context, this->WakeUpEndpoint);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  //requires the mutex to be held
+  std::string nextRequestId()
+  {
+    const boost::uint64_t id = this->NextRequestId++;
+    return std::string(reinterpret_cast<const char*>(&id), sizeof(id));
+  }
+
+  //----------------------------------------------------------------------------
+  //a single wake up is enough for the thread to handle everything that
+  //has been queued, so returns true only when a wake up needs to be sent.
+  //Requires the mutex to be held
+  bool markWakeUpSent()
+  {
+    const bool needsWakeUp = !this->WakeUpSent;
+    this->WakeUpSent = true;
+    return needsWakeUp;
+  }
+
+  //----------------------------------------------------------------------------
+  //queue a request whose response is decoded and given to a promise
+  template<typename T>
+  std::future<T> request(const remus::common::MeshIOType& type,
+                         remus::SERVICE_TYPE service,
+                         const remus::proto::FrameSet& frames,
+                         T (*decode)(const remus::proto::Response&))
+  {
+    //the promise is shared with the handler. When the handler is destroyed
+    //without being invoked the future reports a broken promise
+    std::shared_ptr< std::promise<T> > promise =
+                                  std::make_shared< std::promise<T> >();
+    std::future<T> result = promise->get_future();
+    this->request(type, service, frames,
+                  [promise, decode](const remus::proto::Response& response)
+                    { promise->set_value( decode(response) ); });
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+  //queue a request whose response is decoded and given to a callback
+  template<typename T>
+  void request(const remus::common::MeshIOType& type,
+               remus::SERVICE_TYPE service,
+               const remus::proto::FrameSet& frames,
+               T (*decode)(const remus::proto::Response&),
+               const std::function<void (const T&)>& callback)
+  {
+    this->request(type, service, frames,
+                  [callback, decode](const remus::proto::Response& response)
+                    { callback( decode(response) ); });
+  }
+
+  //----------------------------------------------------------------------------
+  std::size_t pendingRequestCount() const
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    return this->PendingRequests;
+  }
+
+  //----------------------------------------------------------------------------
+  void requestFinished()
+  {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    --this->PendingRequests;
+  }
+
+  //----------------------------------------------------------------------------
+  //ask the server for the status of a job we are waiting on. Only called
+  //by the thread, and isn't counted as a pending request
+  void checkJob(const remus::proto::Job& job)
+  {
+    AsyncRequest request;
+    request.Type = job.type();
+    request.Service = remus::MESH_STATUS;
+    request.Frames = to_FrameSet(job);
+
+    const std::string key = done_Key(job);
+    request.Handler = [this, key](const remus::proto::Response& response)
+      {
+      const remus::proto::JobStatus status = to_JobStatus(response);
+      if(is_Done(status))
+        {
+        this->jobDone(key, status);
+        }
+      };
+
+    {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    request.Id = this->nextRequestId();
+    }
+    this->Unsent.push_back(request);
+  }
+
+  //----------------------------------------------------------------------------
+  //start waiting on the jobs that have been queued. Only called by the thread
+  void startWatching(const std::deque<JobWatch>& watches)
+  {
+    typedef std::deque<JobWatch>::const_iterator cit;
+    for(cit i = watches.begin(); i != watches.end(); ++i)
+      {
+      //subscribe before asking for the status, so that the job can't be done
+      //between us asking and subscribing without us being told
+      const std::string key = done_Key(i->WatchedJob);
+      const bool subscribed = this->Watching.count(key) > 0;
+      if(!subscribed && this->CanSubscribe)
+        {
+        this->Status.setsockopt(ZMQ_SUBSCRIBE, key.c_str(), key.size());
+        }
+      this->Watching.insert( WatchMap::value_type(key, *i) );
+      this->checkJob(i->WatchedJob);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  //ask for the status of every job we are waiting on, which is how we wait
+  //on jobs when we can't subscribe to the status channel. Only called by
+  //the thread
+  void recheckJobs()
+  {
+    typedef WatchMap::const_iterator cit;
+    for(cit i = this->Watching.begin(); i != this->Watching.end();
+        i = this->Watching.upper_bound(i->first))
+      {
+      this->checkJob(i->second.WatchedJob);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  //tell everybody waiting on the job that it is done. Only called by
+  //the thread
+  void jobDone(const std::string& key, const remus::proto::JobStatus& status)
+  {
+    std::pair<WatchMap::iterator, WatchMap::iterator> range =
+                                                this->Watching.equal_range(key);
+    if(range.first == range.second)
+      { //either nobody is waiting, or they have already been told
+      return;
+      }
+
+    std::vector<DoneHandler> handlers;
+    for(WatchMap::iterator i = range.first; i != range.second; ++i)
+      {
+      handlers.push_back(i->second.Handler);
+      }
+    this->Watching.erase(range.first, range.second);
+    if(this->CanSubscribe)
+      {
+      this->Status.setsockopt(ZMQ_UNSUBSCRIBE, key.c_str(), key.size());
+      }
+
+    for(std::size_t i=0; i < handlers.size(); ++i)
+      {
+      handlers[i](status);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  //dispatch the done events that have been published
+  void receiveDoneEvents()
+  {
+    while(has_response(this->Status))
+      {
+      zmq::message_t keyMsg;
+      zmq::message_t dataMsg;
+      zmq::recv_harder(this->Status, &keyMsg);
+      zmq::recv_harder(this->Status, &dataMsg);
+
+      const std::string key(static_cast<const char*>(keyMsg.data()),
+                            keyMsg.size());
+      this->jobDone(key, remus::proto::to_JobStatus(
+                  static_cast<const char*>(dataMsg.data()), dataMsg.size()));
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  //the thread that sends the queued requests and dispatches the responses
+  void run()
+  {
+    typedef std::chrono::steady_clock Clock;
+    typedef std::map<std::string, ResponseHandler> HandlerMap;
+    HandlerMap outstanding;
+
+    //requests that have been taken from the queue but couldn't be sent
+    //yet, because the socket has reached its high water mark
+    std::deque<AsyncRequest>& unsent = this->Unsent;
+
+    Clock::time_point nextRecheck = Clock::now();
+    while(true)
+      {
+      zmq::pollitem_t items[3] = {
+                { this->Server,        0, ZMQ_POLLIN, 0 },
+                { this->WakeUpChannel, 0, ZMQ_POLLIN, 0 },
+                { this->Status,        0, ZMQ_POLLIN, 0 } };
+      if(!unsent.empty())
+        {
+        items[0].events |= ZMQ_POLLOUT;
+        }
+
+      //only wake up to recheck jobs when we are waiting on some
+      boost::int64_t timeout = 60000;
+      if(!this->Watching.empty())
+        {
+        timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          nextRecheck - Clock::now()).count();
+        timeout = std::max(timeout, boost::int64_t(0));
+        }
+      zmq::poll_safely(items, 3, timeout);
+
+      if(items[1].revents & ZMQ_POLLIN)
+        {
+        zmq::drain_wake_ups(this->WakeUpChannel);
+
+        std::deque<JobWatch> watches;
+        {
+        std::unique_lock<std::mutex> lock(this->Mutex);
+        if(this->Stop)
+          {
+          break;
+          }
+        unsent.insert(unsent.end(), this->Queued.begin(), this->Queued.end());
+        this->Queued.clear();
+        watches.swap(this->QueuedWatches);
+        this->WakeUpSent = false;
+        }
+
+        if(!watches.empty())
+          {
+          if(this->Watching.empty())
+            {
+            nextRecheck = Clock::now() +
+                          std::chrono::milliseconds(JobRecheckInterval);
+            }
+          this->startWatching(watches);
+          }
+        }
+
+      if(!this->Watching.empty() && Clock::now() >= nextRecheck)
+        {
+        this->recheckJobs();
+        nextRecheck = Clock::now() +
+                      std::chrono::milliseconds(JobRecheckInterval);
+        }
+
+      //send requests in the order they were made, until the socket can't
+      //take any more
+      while(!unsent.empty())
+        {
+        const AsyncRequest& request = unsent.front();
+        remus::proto::Message sent =
+          remus::proto::send_NonBlockingRequest(request.Id, request.Type,
+                                                request.Service,
+                                                request.Frames,
+                                                &this->Server,
+                                                this->Format);
+        if(!sent.isValid())
+          {
+          break;
+          }
+        outstanding[request.Id] = request.Handler;
+        unsent.pop_front();
+        }
+
+      while(has_response(this->Server))
+        {
+        remus::proto::Response response =
+                                  remus::proto::receive_Response(&this->Server);
+        HandlerMap::iterator handler = outstanding.find(response.requestId());
+        if(handler != outstanding.end())
+          {
+          ResponseHandler h;
+          h.swap(handler->second);
+          outstanding.erase(handler);
+          h(response);
+          }
+        }
+
+      this->receiveDoneEvents();
+      }
+  }
+};
+
+//------------------------------------------------------------------------------
+remus::common::MeshIOTypeSet to_MeshIOTypeSet(const remus::proto::Response& response)
+{
+  std::istringstream buffer(std::string(response.data(), response.dataSize()));
+  remus::common::MeshIOTypeSet supportedTypes;
+  buffer >> supportedTypes;
+  return supportedTypes;
+}
+
+//------------------------------------------------------------------------------
+bool to_bool(const remus::proto::Response& response)
+{
+  std::istringstream buffer(std::string(response.data(), response.dataSize()));
+  bool serverCanMesh = false;
+  buffer >> serverCanMesh;
+  return serverCanMesh;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirementsSet
+to_JobRequirementsSet(const remus::proto::Response& response)
+{
+  std::istringstream buffer(std::string(response.data(), response.dataSize()));
+  remus::proto::JobRequirementsSet set;
+  buffer >> set;
+  return set;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job to_Job(const remus::proto::Response& response)
+{
+  return remus::proto::to_Job(response.data(), response.dataSize());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus to_JobStatus(const remus::proto::Response& response)
+{
+  return remus::proto::to_JobStatus(response.data(), response.dataSize());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult to_JobResult(const remus::proto::Response& response)
+{
+  //the result references the received frames instead of copying them
+  return remus::proto::to_JobResult(response.frames());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::FrameSet to_FrameSet(const remus::proto::JobRequirements& reqs)
+{
+  std::ostringstream buffer;
+  buffer << reqs;
+  return make_FrameSet(buffer.str());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::FrameSet to_FrameSet(const remus::proto::Job& job)
+{
+  return make_FrameSet(remus::proto::to_string(job));
+}
+
+}
+
+//------------------------------------------------------------------------------
+AsyncClient::AsyncClient(const remus::client::ServerConnection &conn):
+  ConnectionInfo(conn),
+  Zmq( new detail::AsyncZmqManagement(conn) )
+{
+}
+
+//------------------------------------------------------------------------------
+AsyncClient::~AsyncClient()
+{
+}
+
+//------------------------------------------------------------------------------
+const remus::client::ServerConnection& AsyncClient::connection() const
+{
+  return this->ConnectionInfo;
+}
+
+//------------------------------------------------------------------------------
+std::future<remus::common::MeshIOTypeSet> AsyncClient::supportedIOTypes()
+{
+  return this->Zmq->request(remus::common::MeshIOType(),
+                            remus::SUPPORTED_IO_TYPES,
+                            remus::proto::FrameSet(),
+                            &detail::to_MeshIOTypeSet);
+}
+
+//------------------------------------------------------------------------------
+std::future<bool> AsyncClient::canMesh(const remus::common::MeshIOType& meshtypes)
+{
+  return this->Zmq->request(meshtypes,
+                            remus::CAN_MESH_IO_TYPE,
+                            remus::proto::FrameSet(),
+                            &detail::to_bool);
+}
+
+//------------------------------------------------------------------------------
+std::future<bool> AsyncClient::canMesh(const remus::proto::JobRequirements& reqs)
+{
+  return this->Zmq->request(reqs.meshTypes(),
+                            remus::CAN_MESH_REQUIREMENTS,
+                            detail::to_FrameSet(reqs),
+                            &detail::to_bool);
+}
+
+//------------------------------------------------------------------------------
+std::future<remus::proto::JobRequirementsSet>
+AsyncClient::retrieveRequirements( const remus::common::MeshIOType& meshtypes)
+{
+  return this->Zmq->request(meshtypes,
+                            remus::MESH_REQUIREMENTS_FOR_IO_TYPE,
+                            remus::proto::FrameSet(),
+                            &detail::to_JobRequirementsSet);
+}
+
+//------------------------------------------------------------------------------
+std::future<remus::proto::Job>
+AsyncClient::submitJob(const remus::proto::JobSubmission& submission)
+{
+  return this->Zmq->request(submission.type(),
+                            remus::MAKE_MESH,
+                            remus::proto::to_FrameSet(submission,
+                                      this->ConnectionInfo.wireFormat()),
+                            &detail::to_Job);
+}
+
+//------------------------------------------------------------------------------
+std::future<remus::proto::JobStatus>
+AsyncClient::jobStatus(const remus::proto::Job& job)
+{
+  return this->Zmq->request(job.type(),
+                            remus::MESH_STATUS,
+                            detail::to_FrameSet(job),
+                            &detail::to_JobStatus);
+}
+
+//------------------------------------------------------------------------------
+std::future<remus::proto::JobResult>
+AsyncClient::retrieveResults(const remus::proto::Job& job)
+{
+  return this->Zmq->request(job.type(),
+                            remus::RETRIEVE_RESULT,
+                            detail::to_FrameSet(job),
+                            &detail::to_JobResult);
+}
+
+//------------------------------------------------------------------------------
+std::future<remus::proto::JobStatus>
+AsyncClient::terminate(const remus::proto::Job& job)
+{
+  return this->Zmq->request(job.type(),
+                            remus::TERMINATE_JOB,
+                            detail::to_FrameSet(job),
+                            &detail::to_JobStatus);
+}
+
+//------------------------------------------------------------------------------
+void AsyncClient::submitJob(const remus::proto::JobSubmission& submission,
+                            const JobCallback& callback)
+{
+  this->Zmq->request(submission.type(),
+                     remus::MAKE_MESH,
+                     remus::proto::to_FrameSet(submission,
+                                      this->ConnectionInfo.wireFormat()),
+                     &detail::to_Job,
+                     callback);
+}
+
+//------------------------------------------------------------------------------
+void AsyncClient::jobStatus(const remus::proto::Job& job,
+                            const StatusCallback& callback)
+{
+  this->Zmq->request(job.type(),
+                     remus::MESH_STATUS,
+                     detail::to_FrameSet(job),
+                     &detail::to_JobStatus,
+                     callback);
+}
+
+//------------------------------------------------------------------------------
+void AsyncClient::retrieveResults(const remus::proto::Job& job,
+                                  const ResultCallback& callback)
+{
+  this->Zmq->request(job.type(),
+                     remus::RETRIEVE_RESULT,
+                     detail::to_FrameSet(job),
+                     &detail::to_JobResult,
+                     callback);
+}
+
+//------------------------------------------------------------------------------
+void AsyncClient::terminate(const remus::proto::Job& job,
+                            const StatusCallback& callback)
+{
+  this->Zmq->request(job.type(),
+                     remus::TERMINATE_JOB,
+                     detail::to_FrameSet(job),
+                     &detail::to_JobStatus,
+                     callback);
+}
+
+//------------------------------------------------------------------------------
+std::future<remus::proto::JobStatus>
+AsyncClient::jobFinished(const remus::proto::Job& job)
+{
+  //the promise is shared with the handler. When the handler is destroyed
+  //without being invoked the future reports a broken promise
+  std::shared_ptr< std::promise<remus::proto::JobStatus> > promise =
+                  std::make_shared< std::promise<remus::proto::JobStatus> >();
+  std::future<remus::proto::JobStatus> result = promise->get_future();
+  this->Zmq->watch(job, [promise](const remus::proto::JobStatus& status)
+                          { promise->set_value(status); });
+  return result;
+}
+
+//------------------------------------------------------------------------------
+void AsyncClient::onJobFinished(const remus::proto::Job& job,
+                                const StatusCallback& callback)
+{
+  this->Zmq->watch(job, callback);
+}
+
+//------------------------------------------------------------------------------
+std::size_t AsyncClient::pendingRequestCount() const
+{
+  return this->Zmq->pendingRequestCount();
+}
+
+}
+}
@@ -0,0 +1,157 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_client_AsyncClient_h
+#define remus_client_AsyncClient_h
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/scoped_ptr.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <remus/client/ServerConnection.h>
+
+#include <remus/common/MeshIOType.h>
+
+//Clients include everything from proto, so that
+//users don't need as many includes
+#include <remus/proto/Job.h>
+#include <remus/proto/JobRequirements.h>
+#include <remus/proto/JobResult.h>
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/JobSubmission.h>
+
+//included for export symbols
+#include <remus/client/ClientExports.h>
+
+#include <functional>
+#include <future>
+
+#ifdef REMUS_MSVC
+ #pragma warning(push)
+ #pragma warning(disable:4251)  /*dll-interface missing on stl type*/
+#endif
+
+//The async client class offers the same calls as the client class, but
+//doesn't wait for the server to respond. Each call returns a future or
+//invokes a callback once the response arrives, so many requests can be
+//outstanding on a single connection. Every request is tagged with an id
+//which the server sends back, so responses are matched to their request in
+//whatever order they arrive.
+//
+//The async client is thread safe, so multiple threads can share it.
+namespace remus{
+namespace client{
+
+namespace detail { struct AsyncZmqManagement; }
+
+class REMUSCLIENT_EXPORT AsyncClient
+{
+public:
+  typedef std::function<void (const remus::proto::Job&)> JobCallback;
+  typedef std::function<void (const remus::proto::JobStatus&)> StatusCallback;
+  typedef std::function<void (const remus::proto::JobResult&)> ResultCallback;
+
+  //connect to a given host on a given port with tcp
+  explicit AsyncClient(const remus::client::ServerConnection& conn);
+
+  //stops talking to the server. The futures of requests that haven't been
+  //answered will throw std::future_error with a broken_promise error, and
+  //callbacks of requests that haven't been answered are never invoked.
+  ~AsyncClient();
+
+  //return the connection info that was used to connect to the
+  //remus server
+  const remus::client::ServerConnection& connection() const;
+
+  //Submit a request to the server to see what MeshIOTypes are supported
+  std::future<remus::common::MeshIOTypeSet> supportedIOTypes();
+
+  //Submit a request to the server to see if the server supports
+  //the requested input and output mesh types
+  std::future<bool> canMesh(const remus::common::MeshIOType& meshtypes);
+
+  //Submit a request to the server to see if the server supports
+  //the exact requested requirements
+  std::future<bool> canMesh(const remus::proto::JobRequirements& requirements);
+
+  //submit a request to the server to see if the server supports
+  //the request input and output mesh types. If the server does support
+  //the given types, return a collection of JobRequirements
+  std::future<remus::proto::JobRequirementsSet>
+  retrieveRequirements( const remus::common::MeshIOType& meshtypes );
+
+  //Submit a job to the server. The job submission has a JobData and
+  //a JobRequirements component
+  std::future<remus::proto::Job>
+  submitJob(const remus::proto::JobSubmission& submission);
+
+  //Given a remus Job object returns the status of the job
+  std::future<remus::proto::JobStatus> jobStatus(const remus::proto::Job& job);
+
+  //Return job result of of a give job
+  std::future<remus::proto::JobResult>
+  retrieveResults(const remus::proto::Job& job);
+
+  //attempts to terminate a given job, see Client::terminate
+  std::future<remus::proto::JobStatus> terminate(const remus::proto::Job& job);
+
+  //The callback versions of the job calls. The callbacks are invoked on
+  //the thread that talks to the server, so they should return quickly and
+  //must not throw. They are allowed to make new requests.
+  void submitJob(const remus::proto::JobSubmission& submission,
+                 const JobCallback& callback);
+  void jobStatus(const remus::proto::Job& job,
+                 const StatusCallback& callback);
+  void retrieveResults(const remus::proto::Job& job,
+                       const ResultCallback& callback);
+  void terminate(const remus::proto::Job& job,
+                 const StatusCallback& callback);
+
+  //Wait on a job to be finished, failed, terminated or expired, and get
+  //the final status of the job. Instead of polling the server for the
+  //status of the job, the client subscribes to the done event of the job
+  //on the status channel of the server ( see
+  //ServerConnection::statusEndpoint ). Waiting on a job isn't counted as a
+  //pending request.
+  std::future<remus::proto::JobStatus>
+  jobFinished(const remus::proto::Job& job);
+  void onJobFinished(const remus::proto::Job& job,
+                     const StatusCallback& callback);
+
+  //returns the number of requests that haven't been answered yet
+  std::size_t pendingRequestCount() const;
+
+protected:
+  remus::client::ServerConnection ConnectionInfo;
+private:
+  //explicitly state the client doesn't support copy or move semantics
+  AsyncClient(const AsyncClient&);
+  void operator=(const AsyncClient&);
+
+  boost::scoped_ptr<detail::AsyncZmqManagement> Zmq;
+};
+
+}
+
+//We want the user to have a nicer experience creating the client interface.
+//For this reason we remove the stuttering when making an instance of the client.
+typedef remus::client::AsyncClient AsyncClient;
+
+}
+
+#ifdef REMUS_MSVC
+  #pragma warning(pop)
+#endif
+
+#endif
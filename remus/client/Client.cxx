@@ -12,11 +12,25 @@
 
 #include <remus/client/Client.h>
 
+#include <remus/proto/FrameSet.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
 
+#include <remus/proto/EventTypes.h>
 #include <remus/proto/zmqHelper.h>
+
+#include <remus/common/SleepFor.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/uuid/uuid_io.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <set>
 #include <sstream>
+#include <vector>
 
 namespace remus{
 namespace client{
@@ -27,11 +41,279 @@ namespace detail{
 struct ZmqManagement
 {
   zmq::socket_t Server;
+  zmq::socket_t Status;
+  bool StatusConnected;
+
+  //false once the server has told us it doesn't have a blob store.
+  //Servers that only understand the text wire format never have one
+  bool BlobStoreSupported;
 
   ZmqManagement(const remus::client::ServerConnection &conn):
-    Server(*(conn.context()), ZMQ_REQ)
+    Server(*(conn.context()), ZMQ_REQ),
+    Status(*(conn.context()), ZMQ_SUB),
+    StatusConnected(false),
+    BlobStoreSupported(conn.wireFormat() == remus::proto::WireFormat::Binary)
   {}
 };
+
+//contents smaller than this are always sent, as asking the server if it
+//already has them takes longer than sending them
+static const std::size_t MinReferencedBlobSize = 64 * 1024;
+
+//------------------------------------------------------------------------------
+//the content hash of every blob of the submission that is large enough to
+//be referenced, and an empty hash for the others. Contents cache their
+//hash, so resubmitting the same contents doesn't hash them again.
+std::vector<std::string> content_Hashes(
+                              const remus::proto::JobSubmission& submission,
+                              const remus::proto::FrameSet& frames)
+{
+  std::vector<std::string> hashes(frames.Blobs.size());
+  for(std::size_t i=0; i < frames.Blobs.size(); ++i)
+    {
+    const remus::proto::Frame& blob = frames.Blobs[i];
+    if(blob.size() < MinReferencedBlobSize)
+      {
+      continue;
+      }
+
+    typedef remus::proto::JobSubmission::const_iterator cit;
+    for(cit c = submission.begin(); c != submission.end() && hashes[i].empty(); ++c)
+      {
+      if(c->second.data() == blob.data() && c->second.dataSize() == blob.size())
+        {
+        hashes[i] = c->second.hash();
+        }
+      }
+    if(hashes[i].empty())
+      {
+      hashes[i] = remus::proto::to_ContentHash(blob);
+      }
+    }
+  return hashes;
+}
+
+//------------------------------------------------------------------------------
+//Submit the job by first asking the server which of the large contents it
+//doesn't have in its blob store, and than only sending those contents.
+//Returns false when the job still needs to be submitted with all of its
+//contents, because the server has no blob store, the submission has no
+//large contents, or the server evicted a content we referenced.
+bool submit_FromBlobs(ZmqManagement& zmq,
+                      const remus::proto::JobSubmission& submission,
+                      const remus::proto::FrameSet& frames,
+                      remus::proto::Job& job)
+{
+  const std::vector<std::string> hashes = content_Hashes(submission, frames);
+  std::ostringstream query;
+  for(std::size_t i=0; i < hashes.size(); ++i)
+    {
+    if(!hashes[i].empty()) { query << hashes[i] << '\n'; }
+    }
+  if(query.tellp() <= 0)
+    {
+    return false;
+    }
+
+  remus::proto::send_Message(submission.type(),
+                             remus::MISSING_BLOBS,
+                             query.str(),
+                             &zmq.Server);
+  remus::proto::Response response = remus::proto::receive_Response(&zmq.Server);
+  if(response.serviceType() != remus::MISSING_BLOBS)
+    { //older servers don't understand the request
+    zmq.BlobStoreSupported = false;
+    return false;
+    }
+
+  std::set<std::string> missing;
+  std::istringstream missingHashes(std::string(response.data(),
+                                               response.dataSize()));
+  std::string hash;
+  while(std::getline(missingHashes, hash))
+    {
+    missing.insert(hash);
+    }
+
+  remus::proto::ReferencedFrameSet refs;
+  refs.Frames = frames;
+  refs.Hashes = hashes;
+  refs.Referenced.resize(hashes.size(), false);
+  for(std::size_t i=0; i < hashes.size(); ++i)
+    {
+    refs.Referenced[i] = !hashes[i].empty() && missing.count(hashes[i]) == 0;
+    }
+
+  remus::proto::send_Message(submission.type(),
+                             remus::MAKE_MESH_FROM_BLOBS,
+                             remus::proto::to_FrameSet(refs),
+                             &zmq.Server);
+  response = remus::proto::receive_Response(&zmq.Server);
+  job = remus::proto::to_Job(std::string(response.data(), response.dataSize()));
+  return job.valid();
+}
+
+//how often in milliseconds the status of a job we are waiting on is asked
+//for. The done event of a job is lost when the job is done before our
+//subscription reaches the server, so every so often we make sure that
+//hasn't happened
+static const boost::int64_t JobRecheckInterval = 1000;
+
+//------------------------------------------------------------------------------
+static bool is_Done(const remus::proto::JobStatus& status)
+{
+  return status.finished() || status.failed();
+}
+
+//------------------------------------------------------------------------------
+bool has_message(zmq::socket_t& socket)
+{
+  int events = 0;
+  size_t events_size = sizeof(events);
+  socket.getsockopt(ZMQ_EVENTS, &events, &events_size);
+  return (events & ZMQ_POLLIN) != 0;
+}
+
+//------------------------------------------------------------------------------
+//wait up to timeout milliseconds for the done event with the given key.
+//Returns true and fills status when the event arrived. Events of jobs we
+//have stopped waiting on are skipped.
+bool receive_DoneStatus(zmq::socket_t& socket, const std::string& key,
+                        boost::int64_t timeout,
+                        remus::proto::JobStatus& status)
+{
+  zmq::pollitem_t items[1] = { { socket, 0, ZMQ_POLLIN, 0 } };
+  zmq::poll_safely(items, 1, timeout);
+
+  bool found = false;
+  while(has_message(socket))
+    {
+    zmq::message_t keyMsg;
+    zmq::message_t dataMsg;
+    zmq::recv_harder(socket, &keyMsg);
+    zmq::recv_harder(socket, &dataMsg);
+
+    const std::string received(static_cast<const char*>(keyMsg.data()),
+                               keyMsg.size());
+    if(received == key)
+      {
+      status = remus::proto::to_JobStatus(
+                  static_cast<const char*>(dataMsg.data()), dataMsg.size());
+      found = true;
+      }
+    }
+  return found;
+}
+
+//the indices of the items given to a bulk call, grouped by the MeshIOType
+//of each item. The server routes requests by their MeshIOType, so each
+//group is sent as its own batch
+typedef std::map< remus::common::MeshIOType,
+                  std::vector<std::size_t> > TypeGroups;
+
+//------------------------------------------------------------------------------
+template<typename T>
+TypeGroups group_ByType(const std::vector<T>& items)
+{
+  TypeGroups groups;
+  for(std::size_t i=0; i < items.size(); ++i)
+    {
+    groups[items[i].type()].push_back(i);
+    }
+  return groups;
+}
+
+//------------------------------------------------------------------------------
+//the batch item that holds a job
+remus::proto::FrameSet to_BatchItem(const remus::proto::Job& job)
+{
+  std::string data = remus::proto::to_string(job);
+  remus::proto::FrameSet item;
+  item.Header = remus::proto::detail::make_HeaderFrame(data);
+  return item;
+}
+
+//------------------------------------------------------------------------------
+//send a batch to the server and return the items of the response, which
+//are empty if the server couldn't handle the request
+std::vector<remus::proto::FrameSet>
+send_Batch(const remus::common::MeshIOType& type,
+           remus::SERVICE_TYPE service,
+           const std::vector<remus::proto::FrameSet>& items,
+           zmq::socket_t& server)
+{
+  remus::proto::send_Message(type, service,
+                             remus::proto::to_FrameSet(items),
+                             &server);
+
+  remus::proto::Response response = remus::proto::receive_Response(&server);
+  if(response.serviceType() != service)
+    {
+    return std::vector<remus::proto::FrameSet>();
+    }
+  return remus::proto::to_FrameSets(response.frames());
+}
+
+//------------------------------------------------------------------------------
+//send the jobs to the server one batch per MeshIOType, and return the
+//items of the responses in the order of the jobs. Jobs the server didn't
+//respond to have an empty item.
+std::vector<remus::proto::FrameSet>
+send_JobBatches(const std::vector<remus::proto::Job>& jobs,
+                remus::SERVICE_TYPE service,
+                zmq::socket_t& server)
+{
+  std::vector<remus::proto::FrameSet> responses(jobs.size());
+
+  const TypeGroups groups = group_ByType(jobs);
+  for(TypeGroups::const_iterator g = groups.begin(); g != groups.end(); ++g)
+    {
+    const std::vector<std::size_t>& indices = g->second;
+
+    std::vector<remus::proto::FrameSet> items;
+    items.reserve(indices.size());
+    for(std::size_t i=0; i < indices.size(); ++i)
+      {
+      items.push_back( to_BatchItem(jobs[indices[i]]) );
+      }
+
+    const std::vector<remus::proto::FrameSet> received =
+                                        send_Batch(g->first, service, items, server);
+    const std::size_t count = std::min(received.size(), indices.size());
+    for(std::size_t i=0; i < count; ++i)
+      {
+      responses[indices[i]] = received[i];
+      }
+    }
+  return responses;
+}
+
+//------------------------------------------------------------------------------
+//convert the batch items that hold a job status, jobs without a status
+//are marked as invalid
+std::vector<remus::proto::JobStatus>
+to_JobStatuses(const std::vector<remus::proto::Job>& jobs,
+               const std::vector<remus::proto::FrameSet>& items)
+{
+  std::vector<remus::proto::JobStatus> statuses;
+  statuses.reserve(jobs.size());
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    const remus::proto::Frame& header = items[i].Header;
+    if(header.size() > 0)
+      {
+      statuses.push_back(
+                remus::proto::to_JobStatus(header.data(), header.size()) );
+      }
+    else
+      {
+      statuses.push_back(
+                remus::proto::JobStatus(jobs[i].id(), remus::INVALID_STATUS) );
+      }
+    }
+  return statuses;
+}
+
 }
 
 //------------------------------------------------------------------------------
@@ -58,7 +340,8 @@ remus::common::MeshIOTypeSet Client::supportedIOTypes()
 {
   remus::proto::send_Message(remus::common::MeshIOType(),
                              remus::SUPPORTED_IO_TYPES,
-                             &this->Zmq->Server);
+                             &this->Zmq->Server,
+                             this->ConnectionInfo.wireFormat());
 
   remus::proto::Response response =
       remus::proto::receive_Response(&this->Zmq->Server);
@@ -74,7 +357,8 @@ bool Client::canMesh(const remus::common::MeshIOType& meshtypes)
 {
   remus::proto::send_Message(meshtypes,
                              remus::CAN_MESH_IO_TYPE,
-                             &this->Zmq->Server);
+                             &this->Zmq->Server,
+                             this->ConnectionInfo.wireFormat());
 
   remus::proto::Response response =
       remus::proto::receive_Response(&this->Zmq->Server);
@@ -93,7 +377,8 @@ bool Client::canMesh(const remus::proto::JobRequirements& reqs)
   remus::proto::send_Message(reqs.meshTypes(),
                              remus::CAN_MESH_REQUIREMENTS,
                              input_buffer.str(),
-                             &this->Zmq->Server);
+                             &this->Zmq->Server,
+                             this->ConnectionInfo.wireFormat());
 
   remus::proto::Response response =
       remus::proto::receive_Response(&this->Zmq->Server);
@@ -110,7 +395,8 @@ Client::retrieveRequirements( const remus::common::MeshIOType& meshtypes)
 {
   remus::proto::send_Message(meshtypes,
                              remus::MESH_REQUIREMENTS_FOR_IO_TYPE,
-                             &this->Zmq->Server);
+                             &this->Zmq->Server,
+                             this->ConnectionInfo.wireFormat());
 
   remus::proto::Response response =
       remus::proto::receive_Response(&this->Zmq->Server);
@@ -125,13 +411,25 @@ Client::retrieveRequirements( const remus::common::MeshIOType& meshtypes)
 remus::proto::Job
 Client::submitJob(const remus::proto::JobSubmission& submission)
 {
-  std::ostringstream buffer;
-  buffer << submission;
+  //each content of the submission is sent as its own frame, without
+  //being copied into a single buffer, unless the server only understands
+  //the text format
+  const remus::proto::FrameSet frames =
+    remus::proto::to_FrameSet(submission, this->ConnectionInfo.wireFormat());
+
+  //large contents that the server already has are only referenced
+  remus::proto::Job referencedJob = remus::proto::make_invalidJob();
+  if(this->Zmq->BlobStoreSupported &&
+     detail::submit_FromBlobs(*this->Zmq, submission, frames, referencedJob))
+    {
+    return referencedJob;
+    }
 
   remus::proto::send_Message(submission.type(),
                              remus::MAKE_MESH,
-                            buffer.str(),
-                            &this->Zmq->Server);
+                             frames,
+                             &this->Zmq->Server,
+                             this->ConnectionInfo.wireFormat());
 
   remus::proto::Response response =
       remus::proto::receive_Response(&this->Zmq->Server);
@@ -144,7 +442,9 @@ remus::proto::JobStatus Client::jobStatus(const remus::proto::Job& job)
 {
   remus::proto::send_Message(job.type(),
                              remus::MESH_STATUS,
-                             remus::proto::to_string(job),&this->Zmq->Server);
+                             remus::proto::to_string(job),
+                             &this->Zmq->Server,
+                             this->ConnectionInfo.wireFormat());
 
   remus::proto::Response response =
       remus::proto::receive_Response(&this->Zmq->Server);
@@ -158,12 +458,13 @@ remus::proto::JobResult Client::retrieveResults(const remus::proto::Job& job)
   remus::proto::send_Message(job.type(),
                              remus::RETRIEVE_RESULT,
                              remus::proto::to_string(job),
-                             &this->Zmq->Server);
+                             &this->Zmq->Server,
+                             this->ConnectionInfo.wireFormat());
 
   remus::proto::Response response =
       remus::proto::receive_Response(&this->Zmq->Server);
-  const std::string result(response.data(), response.dataSize());
-  return remus::proto::to_JobResult(result);
+  //the result references the received frames instead of copying them
+  return remus::proto::to_JobResult(response.frames());
 }
 
 //------------------------------------------------------------------------------
@@ -172,7 +473,8 @@ remus::proto::JobStatus Client::terminate(const remus::proto::Job& job)
   remus::proto::send_Message(job.type(),
                              remus::TERMINATE_JOB,
                              remus::proto::to_string(job),
-                             &this->Zmq->Server);
+                             &this->Zmq->Server,
+                             this->ConnectionInfo.wireFormat());
 
   remus::proto::Response response =
       remus::proto::receive_Response(&this->Zmq->Server);
@@ -180,5 +482,193 @@ remus::proto::JobStatus Client::terminate(const remus::proto::Job& job)
   return remus::proto::to_JobStatus(status);
 }
 
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job>
+Client::submitJobs(const std::vector<remus::proto::JobSubmission>& submissions)
+{
+  //submissions that the server didn't respond to stay invalid jobs
+  std::vector<remus::proto::Job> jobs(submissions.size(),
+                                      remus::proto::make_invalidJob());
+  if(!this->supportsBulkCalls())
+    {
+    for(std::size_t i=0; i < submissions.size(); ++i)
+      {
+      jobs[i] = this->submitJob(submissions[i]);
+      }
+    return jobs;
+    }
+
+  const detail::TypeGroups groups = detail::group_ByType(submissions);
+  typedef detail::TypeGroups::const_iterator cit;
+  for(cit g = groups.begin(); g != groups.end(); ++g)
+    {
+    const std::vector<std::size_t>& indices = g->second;
+
+    //the contents of each submission are still sent as their own frames
+    std::vector<remus::proto::FrameSet> items;
+    items.reserve(indices.size());
+    for(std::size_t i=0; i < indices.size(); ++i)
+      {
+      items.push_back( remus::proto::to_FrameSet(submissions[indices[i]]) );
+      }
+
+    const std::vector<remus::proto::FrameSet> received =
+      detail::send_Batch(g->first, remus::MAKE_MESHES, items, this->Zmq->Server);
+    const std::size_t count = std::min(received.size(), indices.size());
+    for(std::size_t i=0; i < count; ++i)
+      {
+      const remus::proto::Frame& header = received[i].Header;
+      jobs[indices[i]] = remus::proto::to_Job(header.data(), header.size());
+      }
+    }
+  return jobs;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobStatus>
+Client::jobStatuses(const std::vector<remus::proto::Job>& jobs)
+{
+  if(!this->supportsBulkCalls())
+    {
+    std::vector<remus::proto::JobStatus> statuses;
+    statuses.reserve(jobs.size());
+    for(std::size_t i=0; i < jobs.size(); ++i)
+      {
+      statuses.push_back( this->jobStatus(jobs[i]) );
+      }
+    return statuses;
+    }
+
+  return detail::to_JobStatuses(jobs,
+            detail::send_JobBatches(jobs, remus::MESH_STATUSES, this->Zmq->Server));
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobResult>
+Client::retrieveResults(const std::vector<remus::proto::Job>& jobs)
+{
+  if(!this->supportsBulkCalls())
+    {
+    std::vector<remus::proto::JobResult> results;
+    results.reserve(jobs.size());
+    for(std::size_t i=0; i < jobs.size(); ++i)
+      {
+      results.push_back( this->retrieveResults(jobs[i]) );
+      }
+    return results;
+    }
+
+  const std::vector<remus::proto::FrameSet> items =
+    detail::send_JobBatches(jobs, remus::RETRIEVE_RESULTS, this->Zmq->Server);
+
+  //the results reference the received frames instead of copying them
+  std::vector<remus::proto::JobResult> results;
+  results.reserve(jobs.size());
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    if(items[i].Header.size() > 0)
+      {
+      results.push_back( remus::proto::to_JobResult(items[i]) );
+      }
+    else
+      {
+      results.push_back( remus::proto::JobResult(jobs[i].id()) );
+      }
+    }
+  return results;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobStatus>
+Client::terminate(const std::vector<remus::proto::Job>& jobs)
+{
+  if(!this->supportsBulkCalls())
+    {
+    std::vector<remus::proto::JobStatus> statuses;
+    statuses.reserve(jobs.size());
+    for(std::size_t i=0; i < jobs.size(); ++i)
+      {
+      statuses.push_back( this->terminate(jobs[i]) );
+      }
+    return statuses;
+    }
+
+  return detail::to_JobStatuses(jobs,
+            detail::send_JobBatches(jobs, remus::TERMINATE_JOBS, this->Zmq->Server));
+}
+
+//------------------------------------------------------------------------------
+bool Client::supportsBulkCalls() const
+{
+  //servers that only understand the text wire format predate the bulk calls
+  return this->ConnectionInfo.wireFormat() == remus::proto::WireFormat::Binary;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus Client::waitForJob(const remus::proto::Job& job,
+                                           boost::int64_t timeoutInMillisec)
+{
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point start = Clock::now();
+  const std::string& statusEndpoint = this->ConnectionInfo.statusEndpoint();
+
+  //when we don't know where the status channel is, all we can do
+  //is ask the server for the status of the job
+  const bool canSubscribe = !statusEndpoint.empty();
+  if(canSubscribe && !this->Zmq->StatusConnected)
+    {
+    zmq::connectToAddress(this->Zmq->Status, statusEndpoint);
+    this->Zmq->StatusConnected = true;
+    }
+
+  //subscribe before asking for the status, so that the job can't be done
+  //between us asking and subscribing without us being told
+  const std::string key =
+          remus::proto::jobevents::done_key(boost::uuids::to_string(job.id()));
+  if(canSubscribe)
+    {
+    this->Zmq->Status.setsockopt(ZMQ_SUBSCRIBE, key.c_str(), key.size());
+    }
+
+  remus::proto::JobStatus status = this->jobStatus(job);
+  while(!detail::is_Done(status))
+    {
+    boost::int64_t wait = detail::JobRecheckInterval;
+    if(timeoutInMillisec >= 0)
+      {
+      const boost::int64_t elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+                                            Clock::now() - start).count();
+      if(elapsed >= timeoutInMillisec)
+        {
+        break;
+        }
+      wait = std::min(wait, timeoutInMillisec - elapsed);
+      }
+
+    bool received = false;
+    if(canSubscribe)
+      {
+      received = detail::receive_DoneStatus(this->Zmq->Status, key,
+                                            wait, status);
+      }
+    else
+      {
+      remus::common::SleepForMillisec(static_cast<int>(wait));
+      }
+
+    if(!received)
+      {
+      status = this->jobStatus(job);
+      }
+    }
+
+  if(canSubscribe)
+    {
+    this->Zmq->Status.setsockopt(ZMQ_UNSUBSCRIBE, key.c_str(), key.size());
+    }
+  return status;
+}
+
 }
 }
@@ -16,6 +16,7 @@
 #include <remus/common/CompilerInformation.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
 #include <boost/scoped_ptr.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
@@ -34,6 +35,8 @@ REMUS_THIRDPARTY_POST_INCLUDE
 //included for export symbols
 #include <remus/client/ClientExports.h>
 
+#include <vector>
+
 #ifdef REMUS_MSVC
  #pragma warning(push)
  #pragma warning(disable:4251)  /*dll-interface missing on stl type*/
@@ -80,7 +83,11 @@ public:
   retrieveRequirements( const remus::common::MeshIOType& meshtypes );
 
   //Submit a job to the server. The job submission has a JobData and
-  //a JobRequirements component
+  //a JobRequirements component.
+  //Large contents are first offered to the server by their hash, and only
+  //the contents the server doesn't have in its blob store are sent. So
+  //resubmitting the same large contents, for example the same model with
+  //different attributes, doesn't send them again.
   remus::proto::Job submitJob(const remus::proto::JobSubmission& submission);
 
   //Given a remus Job object returns the status of the job
@@ -95,7 +102,39 @@ public:
   //this will be unable to kill the job.
   remus::proto::JobStatus terminate(const remus::proto::Job& job);
 
+  //The bulk versions of the job calls above. Instead of a round trip to
+  //the server for each job, the jobs that share a MeshIOType are sent to
+  //the server as a single request. The results are returned in the same
+  //order as the submissions or jobs given. When the connection uses the
+  //text wire format each job is sent on its own, as older servers don't
+  //understand the bulk requests.
+  std::vector<remus::proto::Job>
+  submitJobs(const std::vector<remus::proto::JobSubmission>& submissions);
+
+  std::vector<remus::proto::JobStatus>
+  jobStatuses(const std::vector<remus::proto::Job>& jobs);
+
+  std::vector<remus::proto::JobResult>
+  retrieveResults(const std::vector<remus::proto::Job>& jobs);
+
+  std::vector<remus::proto::JobStatus>
+  terminate(const std::vector<remus::proto::Job>& jobs);
+
+  //Blocks until the given job has finished, failed, been terminated or
+  //expired and returns the final status of the job. Instead of polling the
+  //server for the status, the client subscribes to the done event of the
+  //job on the status channel of the server ( see
+  //ServerConnection::statusEndpoint ). If the timeout in milliseconds
+  //is reached first, the current status of the job is returned. A negative
+  //timeout waits forever.
+  remus::proto::JobStatus waitForJob(const remus::proto::Job& job,
+                                     boost::int64_t timeoutInMillisec = -1);
+
 protected:
+  //true when the server is sent the bulk requests, which is only the
+  //case for the binary wire format
+  bool supportsBulkCalls() const;
+
   remus::client::ServerConnection ConnectionInfo;
 private:
   //explicitly state the client doesn't support copy or move semantics
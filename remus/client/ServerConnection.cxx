@@ -29,7 +29,10 @@ ServerConnection::ServerConnection():
   Context( remus::client::make_ServerContext() ),
   Endpoint(zmq::socketInfo<zmq::proto::tcp>("127.0.0.1",
                           remus::server::CLIENT_PORT).endpoint()),
-  IsLocalEndpoint(true) //no need to call zmq::isLocalEndpoint
+  StatusEndpoint(zmq::socketInfo<zmq::proto::tcp>("127.0.0.1",
+                          remus::server::STATUS_PORT).endpoint()),
+  IsLocalEndpoint(true), //no need to call zmq::isLocalEndpoint
+  Format(remus::proto::WireFormat::Binary)
 {
 }
 
@@ -37,7 +40,10 @@ ServerConnection::ServerConnection():
 ServerConnection::ServerConnection(const std::string& hostName, int port):
   Context( remus::client::make_ServerContext() ),
   Endpoint(zmq::socketInfo<zmq::proto::tcp>(hostName,port).endpoint()),
-  IsLocalEndpoint( zmq::isLocalEndpoint(zmq::socketInfo<zmq::proto::tcp>(hostName,port)) )
+  StatusEndpoint(zmq::socketInfo<zmq::proto::tcp>(hostName,
+                          remus::server::STATUS_PORT).endpoint()),
+  IsLocalEndpoint( zmq::isLocalEndpoint(zmq::socketInfo<zmq::proto::tcp>(hostName,port)) ),
+  Format(remus::proto::WireFormat::Binary)
 {
   assert(hostName.size() > 0);
   assert(port > 0 && port < 65536);
@@ -22,6 +22,9 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 #include <remus/proto/zmqSocketInfo.h>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <remus/proto/WireFormat.h>
+#include <remus/server/PortNumbers.h>
+
 #ifdef REMUS_MSVC
  #pragma warning(push)
  #pragma warning(disable:4251)  /*dll-interface missing on stl type*/
@@ -54,6 +57,23 @@ public:
   inline std::string const& endpoint() const{ return Endpoint; }
   inline bool isLocalEndpoint() const{ return IsLocalEndpoint; }
 
+  //the endpoint of the status channel of the server, which is where
+  //clients are told when jobs are done. For tcp connections this defaults
+  //to the default status port on the same host, for other connection types
+  //it must be explicitly set.
+  inline std::string const& statusEndpoint() const{ return StatusEndpoint; }
+  void statusEndpoint(const std::string& endpoint)
+    { this->StatusEndpoint = endpoint; }
+
+  //the wire format that jobs are sent to the server in. Binary is the
+  //default and sends each content as its own frame. Servers that predate
+  //the binary format only understand Text, in which case the client sends
+  //every job as a single frame and doesn't use the blob store or the
+  //bulk calls of the server.
+  inline remus::proto::WireFormat::Type wireFormat() const{ return Format; }
+  void wireFormat(remus::proto::WireFormat::Type format)
+    { this->Format = format; }
+
   //we have to leak some details to support inproc communication
   boost::shared_ptr<zmq::context_t> context() const { return this->Context; }
 
@@ -65,7 +85,9 @@ public:
 private:
   boost::shared_ptr<zmq::context_t> Context;
   std::string Endpoint;
+  std::string StatusEndpoint;
   bool IsLocalEndpoint;
+  remus::proto::WireFormat::Type Format;
 };
 
 //convert a string in the form of proto://hostname:port where :port
@@ -79,12 +101,33 @@ remus::client::ServerConnection make_ServerConnection(const std::string& dest);
 REMUSCLIENT_EXPORT
 boost::shared_ptr<zmq::context_t> make_ServerContext(std::size_t num_threads=1);
 
+namespace detail
+{
+//------------------------------------------------------------------------------
+//only tcp connections have a default status endpoint
+template<typename T>
+inline std::string default_StatusEndpoint(zmq::socketInfo<T> const&)
+{
+  return std::string();
+}
+
+//------------------------------------------------------------------------------
+inline std::string
+default_StatusEndpoint(zmq::socketInfo<zmq::proto::tcp> const& socket)
+{
+  return zmq::socketInfo<zmq::proto::tcp>(socket.host(),
+                                          remus::server::STATUS_PORT).endpoint();
+}
+}
+
 //------------------------------------------------------------------------------
 template<typename T>
 ServerConnection::ServerConnection(zmq::socketInfo<T> const& socket):
   Context( remus::client::make_ServerContext() ),
   Endpoint(socket.endpoint()),
-  IsLocalEndpoint( zmq::isLocalEndpoint(socket) )
+  StatusEndpoint( detail::default_StatusEndpoint(socket) ),
+  IsLocalEndpoint( zmq::isLocalEndpoint(socket) ),
+  Format(remus::proto::WireFormat::Binary)
 {
 }
 
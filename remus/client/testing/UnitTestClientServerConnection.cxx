@@ -91,6 +91,27 @@ int UnitTestClientServerConnection(int, char *[])
   REMUS_ASSERT( (sc_ipc.isLocalEndpoint()==true) );
   REMUS_ASSERT( (sc_ipc.endpoint() == std::string("ipc://task_pool")) );
 
+  //test the status endpoint, which only tcp connections have a default for
+  zmq::socketInfo<zmq::proto::tcp> default_status("127.0.0.1",
+                                                  remus::server::STATUS_PORT);
+  REMUS_ASSERT( (sc.statusEndpoint() == default_status.endpoint()) );
+  REMUS_ASSERT( (test_socket_sc2.statusEndpoint() == default_status.endpoint()) );
+  REMUS_ASSERT( (test_full_sc.statusEndpoint() ==
+         make_tcp_socket("74.125.30.106",remus::server::STATUS_PORT).endpoint()) );
+  REMUS_ASSERT( (test_full_sc.statusEndpoint() == test_full_sc2.statusEndpoint()) );
+  REMUS_ASSERT( (sc_inproc.statusEndpoint().empty()) );
+  REMUS_ASSERT( (sc_ipc2.statusEndpoint().empty()) );
+
+  sc_inproc.statusEndpoint("inproc://status");
+  REMUS_ASSERT( (sc_inproc.statusEndpoint() == std::string("inproc://status")) );
+
+  //the binary wire format is the default, older servers need text
+  REMUS_ASSERT( (sc.wireFormat() == remus::proto::WireFormat::Binary) );
+  REMUS_ASSERT( (test_full_sc.wireFormat() == remus::proto::WireFormat::Binary) );
+  REMUS_ASSERT( (sc_inproc.wireFormat() == remus::proto::WireFormat::Binary) );
+  sc_inproc.wireFormat(remus::proto::WireFormat::Text);
+  REMUS_ASSERT( (sc_inproc.wireFormat() == remus::proto::WireFormat::Text) );
+
 
   //test sharing a context.
   remus::client::ServerConnection share_context;
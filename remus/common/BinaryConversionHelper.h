@@ -0,0 +1,352 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_common_BinaryConversionHelper_h
+#define remus_common_BinaryConversionHelper_h
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace remus {
+namespace internal
+{
+
+//The binary wire format is a versioned layout of fixed width little endian
+//integers and length prefixed blobs. Every top level object starts with a
+//header of 3 magic bytes, a version byte and a type tag byte. The first magic
+//byte is a NUL, which can't be the first character of the text wire format,
+//so decoders can tell the two formats apart by looking at the first byte.
+namespace binary
+{
+  static const std::size_t HeaderSize = 5;
+  static const boost::uint8_t Version = 1;
+
+  //type tags for each top level object that can be encoded
+  struct TypeTag { enum Type { Content=1, Requirements=2,
+                               Submission=3, Result=4, WorkerJob=5,
+                               Batch=6, References=7 }; };
+
+  //set on the type tag when the blobs of an object are not stored inline,
+  //but in a separate list of blobs, e.g. one zmq frame per blob
+  static const boost::uint8_t ExternalBlobsFlag = 0x80;
+
+  //set on the format type of a content or result whose data is compressed.
+  //The codec and the uncompressed size are then written before the blob,
+  //which holds the compressed data
+  static const boost::uint8_t CompressedFlag = 0x80;
+}
+
+//------------------------------------------------------------------------------
+//A blob of data that lives outside of the buffer being written or read.
+//Data shares ownership of whatever keeps the bytes alive, which can be
+//nothing when the writer is only referencing memory it doesn't own.
+struct BinaryBlob
+{
+  BinaryBlob(): Data(), Size(0) {}
+  BinaryBlob(const boost::shared_ptr<const char>& d, std::size_t s):
+    Data(d), Size(s) {}
+
+  const char* data() const { return this->Data.get(); }
+  std::size_t size() const { return this->Size; }
+
+  boost::shared_ptr<const char> Data;
+  std::size_t Size;
+};
+
+//------------------------------------------------------------------------------
+//returns true when the data given starts with a binary wire format header
+inline bool isBinaryWireFormat(const char* data, std::size_t size)
+{
+  return data != NULL && size >= binary::HeaderSize &&
+         data[0] == '\0' && data[1] == 'R' && data[2] == 'B';
+}
+
+//------------------------------------------------------------------------------
+//BinaryWriter appends the binary encoding of values into a single string.
+//A writer constructed with CountOnly doesn't write anything, it only sums
+//up how many bytes would be written. That allows callers to do a cheap first
+//pass to compute the exact size, so that the second pass never reallocates
+//while copying large blobs.
+class BinaryWriter
+{
+public:
+  enum Mode { Write, CountOnly };
+
+  explicit BinaryWriter(Mode m = Write):
+    WriteMode(m),
+    Size(0),
+    Buffer(),
+    ExternalBlobs(NULL)
+  {
+  }
+
+  //Instead of copying blobs into the buffer, only write their size and
+  //append a reference to the blob to the given list. The references don't
+  //own the data, so the caller must keep the object being written alive.
+  void externalizeBlobs(std::vector<BinaryBlob>* blobs)
+    { this->ExternalBlobs = blobs; }
+
+  void reserve(std::size_t s)
+    { if(this->WriteMode == Write) { this->Buffer.reserve(s); } }
+
+  void writeHeader(binary::TypeTag::Type tag)
+  {
+    const boost::uint8_t flags = this->ExternalBlobs ?
+                                  binary::ExternalBlobsFlag : 0;
+    const char header[binary::HeaderSize] = { '\0', 'R', 'B',
+                                        static_cast<char>(binary::Version),
+                                        static_cast<char>(tag | flags) };
+    this->writeBytes(header, binary::HeaderSize);
+  }
+
+  void writeUInt8(boost::uint8_t v)
+  {
+    const char c = static_cast<char>(v);
+    this->writeBytes(&c, 1);
+  }
+
+  void writeUInt32(boost::uint32_t v)
+  {
+    char bytes[4];
+    for(int i=0; i < 4; ++i)
+      { bytes[i] = static_cast<char>( (v >> (8*i)) & 0xFF ); }
+    this->writeBytes(bytes, 4);
+  }
+
+  void writeUInt64(boost::uint64_t v)
+  {
+    char bytes[8];
+    for(int i=0; i < 8; ++i)
+      { bytes[i] = static_cast<char>( (v >> (8*i)) & 0xFF ); }
+    this->writeBytes(bytes, 8);
+  }
+
+  //short strings such as names and tags are prefixed with a 32bit length
+  void writeString(const std::string& str)
+  {
+    this->writeUInt32(static_cast<boost::uint32_t>(str.size()));
+    this->writeBytes(str.data(), str.size());
+  }
+
+  //blobs can be larger than 4GB so they are prefixed with a 64bit length
+  void writeBlob(const char* data, std::size_t size)
+  {
+    this->writeUInt64(static_cast<boost::uint64_t>(size));
+    if(!this->ExternalBlobs)
+      {
+      this->writeBytes(data, size);
+      }
+    else if(this->WriteMode == Write)
+      { //reference the data without taking ownership of it
+      boost::shared_ptr<const char> ref(boost::shared_ptr<const char>(), data);
+      this->ExternalBlobs->push_back( BinaryBlob(ref,size) );
+      }
+  }
+
+  void writeBytes(const char* data, std::size_t size)
+  {
+    this->Size += size;
+    if(this->WriteMode == Write && size > 0)
+      { this->Buffer.append(data, size); }
+  }
+
+  //number of bytes written, or that would have been written in CountOnly
+  std::size_t size() const { return this->Size; }
+
+  //steal the encoded buffer from the writer
+  std::string release()
+  {
+    std::string result;
+    result.swap(this->Buffer);
+    this->Size = 0;
+    return result;
+  }
+
+private:
+  Mode WriteMode;
+  std::size_t Size;
+  std::string Buffer;
+  std::vector<BinaryBlob>* ExternalBlobs;
+};
+
+//------------------------------------------------------------------------------
+//BinaryReader walks a buffer encoded by BinaryWriter without copying it.
+//Reading past the end of the buffer doesn't throw, instead the reader is
+//marked as invalid and all further reads return zero or empty values.
+class BinaryReader
+{
+public:
+  BinaryReader(const char* data, std::size_t size):
+    Owner(),
+    CurrentOwner(),
+    Data(data),
+    Size(data != NULL ? size : 0),
+    Position(0),
+    Valid(true),
+    ExternalBlobs(NULL),
+    NextBlob(0)
+  {
+  }
+
+  //construct a reader over a buffer whose lifetime is managed by owner.
+  //Objects decoded from this reader can hold onto the owner and point
+  //directly into the buffer instead of copying blobs out of it.
+  BinaryReader(const boost::shared_ptr<const char>& owner, std::size_t size):
+    Owner(owner),
+    CurrentOwner(owner),
+    Data(owner.get()),
+    Size(owner ? size : 0),
+    Position(0),
+    Valid(true),
+    ExternalBlobs(NULL),
+    NextBlob(0)
+  {
+  }
+
+  //construct a reader over a header written with externalized blobs, where
+  //the blobs are given as a separate list in the order they were written
+  BinaryReader(const BinaryBlob& header, const std::vector<BinaryBlob>& blobs):
+    Owner(header.Data),
+    CurrentOwner(header.Data),
+    Data(header.data()),
+    Size(header.data() != NULL ? header.size() : 0),
+    Position(0),
+    Valid(true),
+    ExternalBlobs(&blobs),
+    NextBlob(0)
+  {
+  }
+
+  //returns the owner of the data returned by the last call to readBlob,
+  //which will be empty when the reader was constructed from a raw pointer
+  const boost::shared_ptr<const char>& owner() const
+    { return this->CurrentOwner; }
+
+  bool valid() const { return this->Valid; }
+
+  //marks the data as invalid, for objects that read data that is well
+  //formed but can't be used, like compressed data that doesn't decompress
+  void invalidate() { this->Valid = false; }
+
+  std::size_t remaining() const { return this->Size - this->Position; }
+
+  //verifies that the header is from a version we understand, and holds
+  //the type we are expecting
+  bool readHeader(binary::TypeTag::Type tag)
+  {
+    const boost::uint8_t flags = this->ExternalBlobs ?
+                                  binary::ExternalBlobsFlag : 0;
+    const char* header = this->readBytes(binary::HeaderSize);
+    if(header == NULL ||
+       !isBinaryWireFormat(header, binary::HeaderSize) ||
+       static_cast<boost::uint8_t>(header[3]) > binary::Version ||
+       static_cast<boost::uint8_t>(header[4]) != (tag | flags))
+      {
+      this->Valid = false;
+      }
+    return this->Valid;
+  }
+
+  boost::uint8_t readUInt8()
+  {
+    const char* bytes = this->readBytes(1);
+    return bytes ? static_cast<boost::uint8_t>(bytes[0]) : 0;
+  }
+
+  boost::uint32_t readUInt32()
+  {
+    const unsigned char* bytes =
+          reinterpret_cast<const unsigned char*>(this->readBytes(4));
+    boost::uint32_t v = 0;
+    for(int i=0; bytes && i < 4; ++i)
+      { v |= static_cast<boost::uint32_t>(bytes[i]) << (8*i); }
+    return v;
+  }
+
+  boost::uint64_t readUInt64()
+  {
+    const unsigned char* bytes =
+          reinterpret_cast<const unsigned char*>(this->readBytes(8));
+    boost::uint64_t v = 0;
+    for(int i=0; bytes && i < 8; ++i)
+      { v |= static_cast<boost::uint64_t>(bytes[i]) << (8*i); }
+    return v;
+  }
+
+  std::string readString()
+  {
+    const std::size_t len = static_cast<std::size_t>(this->readUInt32());
+    const char* bytes = this->readBytes(len);
+    return (bytes && len > 0) ? std::string(bytes,len) : std::string();
+  }
+
+  //returns a pointer into the buffer being read, and sets size to the
+  //length of the blob. No copy of the blob is made.
+  const char* readBlob(std::size_t& size)
+  {
+    const boost::uint64_t len = this->readUInt64();
+    const char* bytes = NULL;
+    if(!this->ExternalBlobs)
+      {
+      bytes = this->readBytes(static_cast<std::size_t>(len));
+      }
+    else if(this->Valid && this->NextBlob < this->ExternalBlobs->size() &&
+            (*this->ExternalBlobs)[this->NextBlob].size() == len)
+      {
+      const BinaryBlob& blob = (*this->ExternalBlobs)[this->NextBlob++];
+      this->CurrentOwner = blob.Data;
+      bytes = blob.data();
+      }
+    else
+      {
+      this->Valid = false;
+      }
+    size = (bytes && this->Valid) ? static_cast<std::size_t>(len) : 0;
+    return this->Valid ? bytes : NULL;
+  }
+
+  const char* readBytes(std::size_t len)
+  {
+    if(!this->Valid || len > this->remaining())
+      {
+      this->Valid = false;
+      return NULL;
+      }
+    const char* result = this->Data + this->Position;
+    this->Position += len;
+    return result;
+  }
+
+private:
+  boost::shared_ptr<const char> Owner;
+  boost::shared_ptr<const char> CurrentOwner;
+  const char* Data;
+  std::size_t Size;
+  std::size_t Position;
+  bool Valid;
+
+  const std::vector<BinaryBlob>* ExternalBlobs;
+  std::size_t NextBlob;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,204 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/Compression.h>
+
+#ifdef REMUS_HAVE_ZLIB
+  #include <zlib.h>
+  #include <algorithm>
+#endif
+
+#include <limits>
+
+namespace
+{
+//deflate can't shrink data by more than this, see the zlib technical
+//details. This is a property of the format, so sizes can be checked
+//without zlib.
+const boost::uint64_t MaxZlibRatio = 1032;
+
+#ifdef REMUS_HAVE_ZLIB
+//zlib counts bytes with 32bit integers, so larger contents are fed to it
+//in pieces
+const std::size_t MaxZlibStep = std::numeric_limits<uInt>::max();
+
+//------------------------------------------------------------------------------
+bool zlib_compress(const char* data, std::size_t length, std::string& result)
+{
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+
+  //favor speed, the contents we send are mostly text which compresses well
+  //even at the fastest level
+  if(deflateInit(&stream, Z_BEST_SPEED) != Z_OK)
+    {
+    return false;
+    }
+
+  //only keep the compressed data if it is smaller than the data
+  result.resize(length);
+  std::size_t consumed = 0;
+  std::size_t produced = 0;
+  int status = Z_OK;
+  while(status == Z_OK && produced < length)
+    {
+    const std::size_t in = std::min(length - consumed, MaxZlibStep);
+    const std::size_t out = std::min(length - produced, MaxZlibStep);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + consumed));
+    stream.avail_in = static_cast<uInt>(in);
+    stream.next_out = reinterpret_cast<Bytef*>(&result[produced]);
+    stream.avail_out = static_cast<uInt>(out);
+
+    const bool last = (consumed + in == length);
+    status = deflate(&stream, last ? Z_FINISH : Z_NO_FLUSH);
+
+    consumed += in - stream.avail_in;
+    produced += out - stream.avail_out;
+    }
+  deflateEnd(&stream);
+
+  if(status != Z_STREAM_END || produced >= length)
+    {
+    result.clear();
+    return false;
+    }
+  //copy so that we don't hold onto a buffer the size of the data
+  std::string(result.data(), produced).swap(result);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool zlib_decompress(const char* data, std::size_t length,
+                     char* result, std::size_t resultLength)
+{
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  stream.next_in = Z_NULL;
+  stream.avail_in = 0;
+  if(inflateInit(&stream) != Z_OK)
+    {
+    return false;
+    }
+
+  std::size_t consumed = 0;
+  std::size_t produced = 0;
+  int status = Z_OK;
+  while(status == Z_OK)
+    {
+    const std::size_t in = std::min(length - consumed, MaxZlibStep);
+    const std::size_t out = std::min(resultLength - produced, MaxZlibStep);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + consumed));
+    stream.avail_in = static_cast<uInt>(in);
+    stream.next_out = reinterpret_cast<Bytef*>(result + produced);
+    stream.avail_out = static_cast<uInt>(out);
+
+    status = inflate(&stream, Z_NO_FLUSH);
+
+    consumed += in - stream.avail_in;
+    produced += out - stream.avail_out;
+    }
+  inflateEnd(&stream);
+
+  //running out of input or output before the end of the stream means the
+  //data is truncated or larger than we were told, which inflate reports
+  //as not being able to make progress
+  return status == Z_STREAM_END && produced == resultLength;
+}
+#endif
+}
+
+namespace remus {
+namespace common {
+
+//------------------------------------------------------------------------------
+bool haveCompressionCodec(remus::common::ContentCompression::Type codec)
+{
+  switch(codec)
+    {
+    case ContentCompression::None:
+      return true;
+#ifdef REMUS_HAVE_ZLIB
+    case ContentCompression::Zlib:
+      return true;
+#endif
+    default:
+      return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool compressContent(remus::common::ContentCompression::Type codec,
+                     const char* data, std::size_t length,
+                     std::string& result)
+{
+  result.clear();
+  if(data == NULL || length == 0)
+    {
+    return false;
+    }
+
+#ifdef REMUS_HAVE_ZLIB
+  if(codec == ContentCompression::Zlib)
+    {
+    return zlib_compress(data, length, result);
+    }
+#endif
+  (void) codec;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool validCompressedSize(remus::common::ContentCompression::Type codec,
+                         std::size_t compressedLength,
+                         boost::uint64_t length)
+{
+  //we only send compressed data that is smaller than the data
+  if(compressedLength == 0 || length <= compressedLength ||
+     length > std::numeric_limits<std::size_t>::max())
+    {
+    return false;
+    }
+
+  if(codec == ContentCompression::Zlib)
+    {
+    return length / MaxZlibRatio <= compressedLength;
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool decompressContent(remus::common::ContentCompression::Type codec,
+                       const char* data, std::size_t length,
+                       char* result, std::size_t resultLength)
+{
+  if(data == NULL || length == 0 || result == NULL)
+    {
+    return false;
+    }
+
+#ifdef REMUS_HAVE_ZLIB
+  if(codec == ContentCompression::Zlib)
+    {
+    return zlib_decompress(data, length, result, resultLength);
+    }
+#endif
+  (void) codec;
+  (void) resultLength;
+  return false;
+}
+
+}
+}
@@ -0,0 +1,65 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_common_Compression_h
+#define remus_common_Compression_h
+
+#include <string>
+#include <remus/common/CommonExports.h>
+#include <remus/common/CompilerInformation.h>
+#include <remus/common/ContentTypes.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+namespace remus {
+namespace common {
+
+//contents smaller than this aren't worth compressing
+static const std::size_t DefaultCompressionThreshold = 16 * 1024;
+
+//returns true when remus was built with the codec. Zlib is only available
+//when zlib was found at build time, None is always available
+REMUSCOMMON_EXPORT
+bool haveCompressionCodec(remus::common::ContentCompression::Type codec);
+
+//compresses the data with the codec into result. Returns false when the
+//codec isn't available, or the compressed data isn't smaller than the data,
+//in which case the data should be stored as is.
+REMUSCOMMON_EXPORT
+bool compressContent(remus::common::ContentCompression::Type codec,
+                     const char* data, std::size_t length,
+                     std::string& result);
+
+//returns true when data that the codec compressed to compressedLength bytes
+//can decompress to length bytes. Used to reject corrupt sizes read off the
+//wire before memory is allocated for them. The sizes are checked even when
+//remus was built without the codec, so that compressed data can be passed
+//on by processes that never decompress it.
+REMUSCOMMON_EXPORT
+bool validCompressedSize(remus::common::ContentCompression::Type codec,
+                         std::size_t compressedLength,
+                         boost::uint64_t length);
+
+//decompresses the data into result, which must be exactly the size of the
+//uncompressed data. Returns false when the codec isn't available or the
+//data isn't valid.
+REMUSCOMMON_EXPORT
+bool decompressContent(remus::common::ContentCompression::Type codec,
+                       const char* data, std::size_t length,
+                       char* result, std::size_t resultLength);
+
+}
+}
+
+#endif
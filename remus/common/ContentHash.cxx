@@ -0,0 +1,261 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/ContentHash.h>
+
+#include <remus/common/ConditionalStorage.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/thread.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+typedef boost::uint64_t u64;
+
+//The hash is the 64 bit hash of xxHash (XXH64) with the four lanes it
+//keeps while reading the data merged a second time, and the tail mixed
+//in separately, to make the upper 64 bits. The lanes are independent, so
+//the loop runs at memory speed.
+const u64 Prime1 = 11400714785074694791ULL;
+const u64 Prime2 = 14029467366897019727ULL;
+const u64 Prime3 =  1609587929392839161ULL;
+const u64 Prime4 =  9650029242287828579ULL;
+const u64 Prime5 =  2870177450012600261ULL;
+
+//contents larger than this are hashed in chunks of ChunkSize, and the hash
+//of the chunks is hashed. The chunks don't depend on the number of threads
+//so that every machine computes the same hash
+const std::size_t ParallelThreshold = 64 * 1024 * 1024;
+const std::size_t ChunkSize = 8 * 1024 * 1024;
+
+struct Hash128
+{
+  u64 High;
+  u64 Low;
+};
+
+//------------------------------------------------------------------------------
+inline u64 rotl(u64 x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+//------------------------------------------------------------------------------
+//read in little endian order so that the hash doesn't depend on the
+//platform, compilers turn this into a single load where they can
+inline u64 read64(const unsigned char* p)
+{
+  return  static_cast<u64>(p[0])        | (static_cast<u64>(p[1]) << 8)  |
+         (static_cast<u64>(p[2]) << 16) | (static_cast<u64>(p[3]) << 24) |
+         (static_cast<u64>(p[4]) << 32) | (static_cast<u64>(p[5]) << 40) |
+         (static_cast<u64>(p[6]) << 48) | (static_cast<u64>(p[7]) << 56);
+}
+
+//------------------------------------------------------------------------------
+inline u64 read32(const unsigned char* p)
+{
+  return  static_cast<u64>(p[0])        | (static_cast<u64>(p[1]) << 8) |
+         (static_cast<u64>(p[2]) << 16) | (static_cast<u64>(p[3]) << 24);
+}
+
+//------------------------------------------------------------------------------
+inline u64 round64(u64 acc, u64 input)
+{
+  acc += input * Prime2;
+  acc = rotl(acc, 31);
+  return acc * Prime1;
+}
+
+//------------------------------------------------------------------------------
+inline u64 mergeRound(u64 acc, u64 lane)
+{
+  acc ^= round64(0, lane);
+  return acc * Prime1 + Prime4;
+}
+
+//------------------------------------------------------------------------------
+inline u64 avalanche(u64 h)
+{
+  h ^= h >> 33;
+  h *= Prime2;
+  h ^= h >> 29;
+  h *= Prime3;
+  h ^= h >> 32;
+  return h;
+}
+
+//------------------------------------------------------------------------------
+Hash128 hash128(const unsigned char* p, std::size_t length, u64 seed)
+{
+  const unsigned char* const end = p + length;
+  u64 h;
+  u64 g;
+
+  if(length >= 32)
+    {
+    u64 v1 = seed + Prime1 + Prime2;
+    u64 v2 = seed + Prime2;
+    u64 v3 = seed;
+    u64 v4 = seed - Prime1;
+
+    const unsigned char* const limit = end - 32;
+    do
+      {
+      v1 = round64(v1, read64(p));
+      v2 = round64(v2, read64(p+8));
+      v3 = round64(v3, read64(p+16));
+      v4 = round64(v4, read64(p+24));
+      p += 32;
+      } while(p <= limit);
+
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    g = rotl(v1, 18) + rotl(v2, 12) + rotl(v3, 7) + rotl(v4, 1);
+    h = mergeRound(mergeRound(mergeRound(mergeRound(h, v1), v2), v3), v4);
+    g = mergeRound(mergeRound(mergeRound(mergeRound(g, v4), v3), v2), v1);
+    }
+  else
+    {
+    h = seed + Prime5;
+    g = seed + Prime1;
+    }
+
+  h += static_cast<u64>(length);
+
+  //the tail that doesn't fill a whole stripe. It is mixed into both
+  //halves with different rotations and primes, so that the upper half
+  //isn't only a function of the lower half for inputs that differ in
+  //the tail
+  for(; p + 8 <= end; p += 8)
+    {
+    const u64 lane = read64(p);
+    h ^= round64(0, lane);
+    h = rotl(h, 27) * Prime1 + Prime4;
+    g ^= round64(Prime3, lane);
+    g = rotl(g, 29) * Prime2 + Prime5;
+    }
+  if(p + 4 <= end)
+    {
+    const u64 lane = read32(p);
+    h ^= lane * Prime1;
+    h = rotl(h, 23) * Prime2 + Prime3;
+    g ^= lane * Prime3;
+    g = rotl(g, 17) * Prime1 + Prime4;
+    p += 4;
+    }
+  for(; p < end; ++p)
+    {
+    const u64 lane = static_cast<u64>(*p);
+    h ^= lane * Prime5;
+    h = rotl(h, 11) * Prime1;
+    g ^= lane * Prime4;
+    g = rotl(g, 13) * Prime3;
+    }
+
+  Hash128 result;
+  result.Low = avalanche(h);
+  result.High = avalanche((g + static_cast<u64>(length)) ^ (h * Prime2));
+  return result;
+}
+
+//------------------------------------------------------------------------------
+//hashes every step'th chunk starting at first, each thread is given
+//a different first chunk
+void hash_chunks(const unsigned char* data, std::size_t length,
+                 std::size_t first, std::size_t step,
+                 std::vector<Hash128>* hashes)
+{
+  for(std::size_t i=first; i < hashes->size(); i+=step)
+    {
+    const std::size_t offset = i * ChunkSize;
+    const std::size_t size = std::min(ChunkSize, length - offset);
+    (*hashes)[i] = hash128(data + offset, size, 0);
+    }
+}
+
+//------------------------------------------------------------------------------
+Hash128 chunked_hash128(const unsigned char* data, std::size_t length)
+{
+  const std::size_t numChunks = (length + ChunkSize - 1) / ChunkSize;
+  std::vector<Hash128> hashes(numChunks);
+
+  const std::size_t numThreads = std::min<std::size_t>(
+                 std::max(boost::thread::hardware_concurrency(), 1u), numChunks);
+
+  //this thread hashes its share of the chunks as well
+  boost::thread_group threads;
+  for(std::size_t t=1; t < numThreads; ++t)
+    {
+    threads.create_thread(boost::bind(&hash_chunks, data, length,
+                                      t, numThreads, &hashes));
+    }
+  hash_chunks(data, length, 0, numThreads, &hashes);
+  threads.join_all();
+
+  //hash the hashes of the chunks, seeded with the length so contents
+  //can't collide with the hashes of their chunks
+  std::vector<unsigned char> digests;
+  digests.reserve(numChunks * 16);
+  for(std::size_t i=0; i < numChunks; ++i)
+    {
+    for(int b=0; b < 8; ++b)
+      { digests.push_back(static_cast<unsigned char>(hashes[i].High >> (8*b))); }
+    for(int b=0; b < 8; ++b)
+      { digests.push_back(static_cast<unsigned char>(hashes[i].Low >> (8*b))); }
+    }
+  return hash128(&digests[0], digests.size(), static_cast<u64>(length));
+}
+
+//------------------------------------------------------------------------------
+std::string to_hash(const char* data, const std::size_t length)
+{
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  const Hash128 h = length > ParallelThreshold ?
+                    chunked_hash128(bytes, length) :
+                    hash128(bytes, length, 0);
+
+  static const char hex[] = "0123456789abcdef";
+  char result[32];
+  for(int i=0; i < 16; ++i)
+    {
+    result[i]    = hex[(h.High >> (60 - 4*i)) & 0xf];
+    result[16+i] = hex[(h.Low  >> (60 - 4*i)) & 0xf];
+    }
+  return std::string(result,32);
+}
+}
+
+namespace remus {
+namespace common {
+
+std::string ContentHash(const remus::common::ConditionalStorage& storage)
+{
+  return to_hash(storage.data(),storage.size());
+}
+
+std::string ContentHash(const std::string& data)
+{
+  return to_hash(data.data(),data.size());
+}
+
+std::string ContentHash(const char* data, std::size_t length)
+{
+  return to_hash(data,length);
+}
+
+}
+}
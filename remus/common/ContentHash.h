@@ -0,0 +1,43 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_common_ContentHash_h
+#define remus_common_ContentHash_h
+
+#include <string>
+#include <remus/common/CommonExports.h>
+
+namespace remus {
+namespace common {
+
+//forward declare ConditionalStorage
+struct ConditionalStorage;
+
+//A fast non-cryptographic 128 bit hash used to identify content, returned
+//as 32 lower case hex characters like MD5Hash. It is many times faster than
+//MD5Hash, and contents larger than 64MB are hashed in chunks on multiple
+//threads. The hash is the same on every platform, but it isn't meant to
+//resist someone crafting collisions, use MD5Hash when that matters.
+
+REMUSCOMMON_EXPORT
+std::string ContentHash(const remus::common::ConditionalStorage& storage);
+
+REMUSCOMMON_EXPORT
+std::string ContentHash(const std::string& data);
+
+REMUSCOMMON_EXPORT
+std::string ContentHash(const char* data, std::size_t length);
+
+}
+}
+
+#endif
@@ -19,6 +19,9 @@ namespace common{
 struct ContentFormat{ enum Type{User=0, XML=1, JSON=2, BSON=3}; };
 struct ContentSource{ enum Type{File=0, Memory=1}; };
 
+//the codec used to compress contents on the wire, None stores them as is
+struct ContentCompression{ enum Type{None=0, Zlib=1}; };
+
 } }
 
 #endif
@@ -20,50 +20,53 @@ namespace remus {
 namespace common {
 
 //------------------------------------------------------------------------------
-MeshIOType::MeshIOType():
-  InputName(),
-  OutputName()
+MeshIOType::MeshIOType()
 {
+  this->setTypes( MeshRegistrar::intern(MeshRegistrar::InvalidId),
+                  MeshRegistrar::intern(MeshRegistrar::InvalidId) );
 }
 
 //------------------------------------------------------------------------------
-MeshIOType::MeshIOType(const std::string& in, const std::string& out):
-  InputName(in),
-  OutputName(out)
+MeshIOType::MeshIOType(const std::string& in, const std::string& out)
 {
+  this->setTypes( MeshRegistrar::intern(in), MeshRegistrar::intern(out) );
 }
 
 //------------------------------------------------------------------------------
 MeshIOType::MeshIOType(const boost::shared_ptr<remus::meshtypes::MeshTypeBase>& in,
-             const boost::shared_ptr<remus::meshtypes::MeshTypeBase>& out):
-  InputName(in->name()),
-  OutputName(out->name())
+             const boost::shared_ptr<remus::meshtypes::MeshTypeBase>& out)
 {
+  this->setTypes( MeshRegistrar::intern(in->name()),
+                  MeshRegistrar::intern(out->name()) );
 }
 
 //------------------------------------------------------------------------------
 MeshIOType::MeshIOType(const remus::meshtypes::MeshTypeBase& in,
-                       const remus::meshtypes::MeshTypeBase& out):
-  InputName(in.name()),
-  OutputName(out.name())
+                       const remus::meshtypes::MeshTypeBase& out)
 {
+  this->setTypes( MeshRegistrar::intern(in.name()),
+                  MeshRegistrar::intern(out.name()) );
 }
 
 //------------------------------------------------------------------------------
-bool MeshIOType::operator ==(const MeshIOType& b) const
+MeshIOType MeshIOType::fromInternedIds(boost::uint32_t in, boost::uint32_t out)
 {
-  return (this->inputType() == b.inputType() &&
-          this->outputType() == b.outputType());
+  MeshIOType result;
+  result.setTypes( MeshRegistrar::intern(in), MeshRegistrar::intern(out) );
+  return result;
 }
 
 //------------------------------------------------------------------------------
-bool MeshIOType::operator <(const MeshIOType& b) const
-  {
-  if( this->inputType() == b.inputType() )
-    { return ( this->outputType() < b.outputType() ); }
-  else
-    { return ( this->inputType() < b.inputType() ); }
-  }
+void MeshIOType::setTypes(const MeshRegistrar::InternedName& in,
+                          const MeshRegistrar::InternedName& out)
+{
+  this->InputId = in.Id;
+  this->InputName = in.Name;
+  this->InputStorage = in.Storage;
+  this->OutputId = out.Id;
+  this->OutputName = out.Name;
+  this->OutputStorage = out.Storage;
+}
 
 //------------------------------------------------------------------------------
 void MeshIOType::serialize(std::ostream& buffer) const
@@ -79,17 +82,16 @@ void MeshIOType::serialize(std::ostream& buffer) const
 }
 
 //------------------------------------------------------------------------------
-MeshIOType::MeshIOType(std::istream& buffer):
-  InputName(),
-  OutputName()
+MeshIOType::MeshIOType(std::istream& buffer)
 {
   std::size_t inputSize=0;
   std::size_t outputSize=0;
 
   buffer >> inputSize;
-  this->InputName = remus::internal::extractString(buffer,inputSize);
+  const std::string in = remus::internal::extractString(buffer,inputSize);
   buffer >> outputSize;
-  this->OutputName = remus::internal::extractString(buffer,outputSize);
+  const std::string out = remus::internal::extractString(buffer,outputSize);
+  this->setTypes( MeshRegistrar::intern(in), MeshRegistrar::intern(out) );
 }
 
 //------------------------------------------------------------------------------
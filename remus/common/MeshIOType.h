@@ -32,7 +32,10 @@ namespace common {
 //These are used to describe worker types at a high level. For example
 //this allows a server to state that it can transform Model into 3D Meshes
 //
-//
+//The names of the types are interned with the MeshRegistrar, so copying
+//and comparing MeshIOTypes of the default mesh types only touches
+//integers. Other types share the MeshRegistrar::DynamicId and are
+//compared by name.
 class REMUSCOMMON_EXPORT MeshIOType
 {
 public:
@@ -47,18 +50,43 @@ public:
   MeshIOType(const remus::meshtypes::MeshTypeBase& in,
              const remus::meshtypes::MeshTypeBase& out);
 
-  const std::string& inputType() const { return this->InputName; }
-  const std::string& outputType() const { return this->OutputName; }
+  //construct from the ids of default mesh types. Any other id is treated
+  //as an invalid type.
+  static MeshIOType fromInternedIds(boost::uint32_t in, boost::uint32_t out);
+
+  const std::string& inputType() const { return *this->InputName; }
+  const std::string& outputType() const { return *this->OutputName; }
+
+  //the interned ids of the input and output type names, every type
+  //that isn't a default mesh type has MeshRegistrar::DynamicId
+  boost::uint32_t inputId() const { return this->InputId; }
+  boost::uint32_t outputId() const { return this->OutputId; }
 
   //If either the input or output is invalid we need say we are invalid.
   //If we just check the combined type we only see if both are invalid.
-  bool valid() const { return !inputType().empty() && !outputType().empty(); }
+  bool valid() const
+    { return this->InputId != MeshRegistrar::InvalidId &&
+             this->OutputId != MeshRegistrar::InvalidId; }
 
   //needed to see if a client request type and a workers type are equal
-  bool operator ==(const MeshIOType& b) const;
+  bool operator ==(const MeshIOType& b) const
+    {
+    return compare(this->InputId, this->InputName,
+                   b.InputId, b.InputName) == 0 &&
+           compare(this->OutputId, this->OutputName,
+                   b.OutputId, b.OutputName) == 0;
+    }
 
-  //needed to properly store mesh types into stl containers
-  bool operator <(const MeshIOType& b) const;
+  //needed to properly store mesh types into stl containers. The default
+  //types are ordered by id and come before every other type, which are
+  //ordered by name.
+  bool operator <(const MeshIOType& b) const
+    {
+    const int in = compare(this->InputId, this->InputName,
+                           b.InputId, b.InputName);
+    return (in == 0) ? (compare(this->OutputId, this->OutputName,
+                                b.OutputId, b.OutputName) < 0) : (in < 0);
+    }
 
   friend std::ostream& operator<<(std::ostream &os,
                                   const MeshIOType &types)
@@ -72,8 +100,25 @@ private:
   void serialize(std::ostream& buffer) const;
   explicit MeshIOType(std::istream& buffer);
 
-  std::string InputName;
-  std::string OutputName;
+  void setTypes(const MeshRegistrar::InternedName& in,
+                const MeshRegistrar::InternedName& out);
+
+  static int compare(boost::uint32_t aId, const std::string* aName,
+                     boost::uint32_t bId, const std::string* bName)
+    {
+    if(aId != bId) { return (aId < bId) ? -1 : 1; }
+    if(aId != MeshRegistrar::DynamicId || aName == bName) { return 0; }
+    return aName->compare(*bName);
+    }
+
+  boost::uint32_t InputId;
+  boost::uint32_t OutputId;
+  const std::string* InputName;
+  const std::string* OutputName;
+
+  //holds the names of types that aren't default mesh types
+  boost::shared_ptr<const std::string> InputStorage;
+  boost::shared_ptr<const std::string> OutputStorage;
 };
 
 //a simple container so we can send a collection of MeshIOType
@@ -14,6 +14,12 @@
 //include the default mesh types
 #include <remus/common/MeshTypes.h>
 
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/make_shared.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <vector>
+
 namespace
 {
   //a work around so that we always have the default types added to the
@@ -43,6 +49,47 @@ namespace
 
       }
   }
+
+  //The table of the default mesh type names. It is built once, the first
+  //time it is used, and is only read after that so it needs no lock.
+  struct StableTable
+  {
+    StableTable():
+      Ids(),
+      Names()
+    {
+      //the ids of the default types are part of the wire format, so the
+      //order here can never change. New default types must be appended.
+      this->Names.push_back(std::string());
+      this->add(remus::meshtypes::Mesh1D().name());
+      this->add(remus::meshtypes::Mesh2D().name());
+      this->add(remus::meshtypes::Mesh3D().name());
+      this->add(remus::meshtypes::Mesh3DSurface().name());
+      this->add(remus::meshtypes::SceneFile().name());
+      this->add(remus::meshtypes::Model().name());
+      this->add(remus::meshtypes::DiscreteModel().name());
+      this->add(remus::meshtypes::DiscreteModel1D().name());
+      this->add(remus::meshtypes::DiscreteModel2D().name());
+      this->add(remus::meshtypes::DiscreteModel3D().name());
+      this->add(remus::meshtypes::Edges().name());
+      this->add(remus::meshtypes::PiecewiseLinearComplex().name());
+    }
+
+    void add(const std::string& name)
+    {
+      this->Ids[name] = static_cast<boost::uint32_t>(this->Names.size());
+      this->Names.push_back(name);
+    }
+
+    boost::unordered_map<std::string, boost::uint32_t> Ids;
+    std::vector<std::string> Names;
+  };
+
+  const StableTable& stableTable()
+  {
+    static const StableTable table;
+    return table;
+  }
 }
 
 namespace remus {
@@ -55,5 +102,46 @@ MeshRegistrar::NameRegisteredMeshMapType & MeshRegistrar::NameRegistry()
   return NameImplementation;
 }
 
+//------------------------------------------------------------------------------
+MeshRegistrar::InternedName MeshRegistrar::intern(const std::string& name)
+{
+  const StableTable& table = stableTable();
+  InternedName result = { InvalidId, &table.Names[InvalidId],
+                          boost::shared_ptr<const std::string>() };
+  if(name.empty())
+    {
+    return result;
+    }
+
+  boost::unordered_map<std::string, boost::uint32_t>::const_iterator it =
+                                                      table.Ids.find(name);
+  if(it != table.Ids.end())
+    {
+    result.Id = it->second;
+    result.Name = &table.Names[result.Id];
+    }
+  else
+    {
+    result.Id = DynamicId;
+    result.Storage = boost::make_shared<const std::string>(name);
+    result.Name = result.Storage.get();
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+MeshRegistrar::InternedName MeshRegistrar::intern(boost::uint32_t id)
+{
+  const StableTable& table = stableTable();
+  InternedName result = { InvalidId, &table.Names[InvalidId],
+                          boost::shared_ptr<const std::string>() };
+  if(isStableId(id) && id < table.Names.size())
+    {
+    result.Id = id;
+    result.Name = &table.Names[id];
+    }
+  return result;
+}
+
 }
 }
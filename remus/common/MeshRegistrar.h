@@ -86,6 +86,35 @@ public:
             ReturnType(new remus::meshtypes::MeshTypeBase()) : (it->second)();
     }
 
+  //Mesh type names are interned so that they can be compared, and sent
+  //over the wire, as compact integer ids. The default remus mesh types
+  //always have the same ids in every process, and those ids are below
+  //DynamicId. The table of default types never changes once built, so
+  //looking them up takes no lock.
+  //Any other name is given DynamicId and its own copy of the string, which
+  //is shared by every copy of the InternedName. Those names are compared by
+  //value, and nothing is added to a global table, so decoding arbitrary
+  //names from the wire can't grow the memory of a long running process.
+  struct InternedName
+  {
+    boost::uint32_t Id;
+    const std::string* Name;
+    boost::shared_ptr<const std::string> Storage;
+  };
+
+  //the empty name is always interned as InvalidId
+  static const boost::uint32_t InvalidId = 0;
+  static const boost::uint32_t DynamicId = 101;
+
+  static InternedName intern(const std::string& name);
+
+  //look up a default type by id, any other id returns the empty name
+  static InternedName intern(boost::uint32_t id);
+
+  //returns true when the id means the same name in every process
+  static bool isStableId(boost::uint32_t id)
+    { return id != InvalidId && id < DynamicId; }
+
 private:
   static void record(std::string const & name, create_function_ptr fp)
     {
@@ -0,0 +1,50 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/MonotonicClock.h>
+
+//First check if we have a C++11 compiler
+#if defined(REMUS_HAVE_CXX_11)
+  #include <chrono>
+#else
+  REMUS_THIRDPARTY_PRE_INCLUDE
+  #include <boost/date_time/posix_time/posix_time.hpp>
+  REMUS_THIRDPARTY_POST_INCLUDE
+#endif
+
+namespace remus{
+namespace common{
+
+//------------------------------------------------------------------------------
+MonotonicClock::TimePoint MonotonicClock::now()
+{
+#ifdef REMUS_HAVE_CXX_11
+
+  //We have detected c++11 support, so use the steady clock
+  const std::chrono::steady_clock::duration sinceEpoch =
+                        std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+                                                    sinceEpoch).count();
+#else
+
+  //Without c++11 fallback to universal time, which isn't steady but
+  //at least skips the time zone conversion of local time
+  static const boost::posix_time::ptime epoch(
+                                boost::gregorian::date(1970,1,1) );
+  const boost::posix_time::time_duration sinceEpoch =
+                  boost::posix_time::microsec_clock::universal_time() - epoch;
+  return sinceEpoch.total_microseconds();
+#endif
+}
+
+}
+}
@@ -0,0 +1,49 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_common_MonotonicClock_h
+#define remus_common_MonotonicClock_h
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <remus/common/CommonExports.h>
+
+namespace remus{
+namespace common{
+
+// The time source used by the polling monitors, heartbeat tracking and
+// the brokering loop. It reads a steady clock, so it never jumps when the
+// wall clock is adjusted, and it doesn't do the time zone conversion that
+// boost::posix_time::microsec_clock::local_time does on every read.
+class REMUSCOMMON_EXPORT MonotonicClock
+{
+public:
+  //microseconds since an unspecified point in the past. Only the difference
+  //between two time points is meaningful.
+  typedef boost::int64_t TimePoint;
+
+  //read the steady clock
+  static TimePoint now();
+
+  //convert between milliseconds and time point durations
+  static TimePoint milliseconds(boost::int64_t ms) { return ms * 1000; }
+  static boost::int64_t toMilliseconds(TimePoint t) { return t / 1000; }
+};
+
+}
+}
+
+#endif
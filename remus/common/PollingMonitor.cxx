@@ -13,7 +13,6 @@
 #include <remus/common/PollingMonitor.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
-#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/circular_buffer.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
@@ -26,24 +25,27 @@ namespace common{
 //------------------------------------------------------------------------------
 class PollingMonitor::PollingTracker
 {
-  typedef boost::posix_time::time_duration time_duration;
-  typedef boost::posix_time::ptime ptime;
-  typedef boost::posix_time::milliseconds milliseconds;
+  //all durations and times are in microseconds on the monotonic clock
+  typedef boost::int64_t time_duration;
+  typedef MonotonicClock::TimePoint TimePoint;
 
   time_duration MinTimeOut; //min heartbeat interval
   time_duration MaxTimeOut; //min heartbeat interval
 
   time_duration AveragePollRate;  //current duration to poll for
   time_duration CurrentPollRate;  //current duration to poll for
-  ptime LastPollTime; //the exact time we last polled
+  TimePoint LastPollTime; //the exact time we last polled
 
   //the frequency we have polled in the past
   boost::circular_buffer< time_duration > PollingFrequency;
 
+  static time_duration milliseconds(boost::int64_t ms)
+    { return MonotonicClock::milliseconds(ms); }
+
 public:
   PollingTracker( const boost::int64_t minRate,
                   const boost::int64_t maxRate,
-                  const ptime& p ):
+                  const TimePoint& p ):
     MinTimeOut(),
     MaxTimeOut(),
     AveragePollRate(),
@@ -92,12 +94,11 @@ public:
   //----------------------------------------------------------------------------
   void pollOccurred()
   {
-    const ptime currentTime = boost::posix_time::microsec_clock::local_time();
-    this->pollOccurred(currentTime);
+    this->pollOccurred( MonotonicClock::now() );
   }
 
   //----------------------------------------------------------------------------
-  void pollOccurred( const ptime& time  )
+  void pollOccurred( const TimePoint& time  )
   {
     const time_duration dur = time - this->LastPollTime;
 
@@ -108,7 +109,7 @@ public:
     time_duration sum = std::accumulate(this->PollingFrequency.begin(),
                                         this->PollingFrequency.end(),
                                         time_duration() );
-    time_duration avg = sum / static_cast<int>(this->PollingFrequency.size());
+    time_duration avg = sum / static_cast<time_duration>(this->PollingFrequency.size());
 
     //update the member vars
     this->LastPollTime = time;
@@ -123,7 +124,8 @@ public:
       }
     else
       {
-      boost::int64_t mil_secs = static_cast<boost::int64_t>(avg.total_milliseconds() * 0.25);
+      boost::int64_t mil_secs = static_cast<boost::int64_t>(
+                          MonotonicClock::toMilliseconds(avg) * 0.25);
       this->CurrentPollRate = avg + milliseconds(mil_secs);
       if(this->CurrentPollRate > this->MaxTimeOut)
         {
@@ -134,6 +136,13 @@ public:
 
   }
 
+  //----------------------------------------------------------------------------
+  //returns the time of the last poll
+  const TimePoint& lastPollTime() const
+  {
+    return this->LastPollTime;
+  }
+
   //----------------------------------------------------------------------------
   //returns the current poll rate
   const time_duration& current() const
@@ -152,7 +161,7 @@ public:
 //------------------------------------------------------------------------------
 PollingMonitor::PollingMonitor():
   Tracker(new PollingMonitor::PollingTracker( (5*1000), (60*1000),
-            boost::posix_time::microsec_clock::local_time() ) )
+            MonotonicClock::now() ) )
 {
 }
 
@@ -162,7 +171,7 @@ PollingMonitor::PollingMonitor( boost::int64_t MinTimeOutInMilliSeconds,
   Tracker(new PollingMonitor::PollingTracker(
             MinTimeOutInMilliSeconds,
             MaxTimeOutInMilliSeconds,
-            boost::posix_time::microsec_clock::local_time() ) )
+            MonotonicClock::now() ) )
 {
 
 }
@@ -196,13 +205,13 @@ void PollingMonitor::changeTimeOutRates(boost::int64_t minRate,
 //------------------------------------------------------------------------------
 boost::int64_t PollingMonitor::minTimeOut() const
 {
-  return this->Tracker->minTimeOut().total_milliseconds();
+  return MonotonicClock::toMilliseconds( this->Tracker->minTimeOut() );
 }
 
 //------------------------------------------------------------------------------
 boost::int64_t PollingMonitor::maxTimeOut() const
 {
-  return this->Tracker->maxTimeOut().total_milliseconds();
+  return MonotonicClock::toMilliseconds( this->Tracker->maxTimeOut() );
 }
 
 //------------------------------------------------------------------------------
@@ -212,21 +221,27 @@ void PollingMonitor::pollOccurred()
 }
 
 //------------------------------------------------------------------------------
-void PollingMonitor::fakeAPollOccurringAt( boost::posix_time::ptime* t )
+MonotonicClock::TimePoint PollingMonitor::lastPollTime() const
+{
+  return this->Tracker->lastPollTime();
+}
+
+//------------------------------------------------------------------------------
+void PollingMonitor::fakeAPollOccurringAt( MonotonicClock::TimePoint t )
 {
-  this->Tracker->pollOccurred( *t );
+  this->Tracker->pollOccurred( t );
 }
 
 //------------------------------------------------------------------------------
 boost::int64_t PollingMonitor::current() const
 {
-  return this->Tracker->current().total_milliseconds();
+  return MonotonicClock::toMilliseconds( this->Tracker->current() );
 }
 
 //------------------------------------------------------------------------------
 boost::int64_t PollingMonitor::average() const
 {
-  return this->Tracker->average().total_milliseconds();
+  return MonotonicClock::toMilliseconds( this->Tracker->average() );
 }
 
 //------------------------------------------------------------------------------
@@ -21,14 +21,13 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <remus/common/CommonExports.h>
+#include <remus/common/MonotonicClock.h>
 
 #ifdef REMUS_MSVC
  #pragma warning(push)
  #pragma warning(disable:4251)  /*dll-interface missing on stl type*/
 #endif
 
-namespace boost { namespace posix_time {  class ptime;  } }
-
 namespace remus{
 namespace common{
 
@@ -83,6 +82,11 @@ public:
   //mark that we just polled
   void pollOccurred( );
 
+  //returns the monotonic clock reading taken by the last call to
+  //pollOccurred. Polling loops use this as the current time for the rest
+  //of the iteration instead of reading the clock again.
+  remus::common::MonotonicClock::TimePoint lastPollTime() const;
+
   //retrieve the current poll rate in milliseconds
   boost::int64_t current() const;
 
@@ -98,8 +102,9 @@ public:
   //This method is mainly testers to verify the polling algorithm without
   //having to actually wait in real-time
   //All times must be forward in time or you will get undefined behavior
+  //Times are monotonic clock readings, see remus::common::MonotonicClock
   //
-  void fakeAPollOccurringAt( boost::posix_time::ptime* t );
+  void fakeAPollOccurringAt( remus::common::MonotonicClock::TimePoint t );
 
 private:
   class PollingTracker;
@@ -31,7 +31,14 @@ namespace remus {
      ServiceTypeMacro(RETRIEVE_RESULT, 7, "RETRIEVE RESULT"), \
      ServiceTypeMacro(HEARTBEAT, 8, "HEARTBEAT"), \
      ServiceTypeMacro(TERMINATE_JOB, 9, "TERMINATE JOB"), \
-     ServiceTypeMacro(TERMINATE_WORKER, 10, "TERMINATE WORKER")
+     ServiceTypeMacro(TERMINATE_WORKER, 10, "TERMINATE WORKER"), \
+     ServiceTypeMacro(MAKE_MESHES, 11, "MAKE MESHES"), \
+     ServiceTypeMacro(MESH_STATUSES, 12, "MESH STATUSES"), \
+     ServiceTypeMacro(RETRIEVE_RESULTS, 13, "RETRIEVE RESULTS"), \
+     ServiceTypeMacro(TERMINATE_JOBS, 14, "TERMINATE JOBS"), \
+     ServiceTypeMacro(MISSING_BLOBS, 15, "MISSING BLOBS"), \
+     ServiceTypeMacro(MAKE_MESH_FROM_BLOBS, 16, "MAKE MESH FROM BLOBS"), \
+     ServiceTypeMacro(CACHED_BLOBS, 17, "CACHED BLOBS")
 
 
 //------------------------------------------------------------------------------
@@ -62,7 +69,7 @@ inline std::string to_string(remus::SERVICE_TYPE t)
 //------------------------------------------------------------------------------
 inline remus::SERVICE_TYPE to_serviceType(const std::string& t)
 {
-  for(int i=1; i<=10; i++)
+  for(int i=1; i<=17; i++)
     {
     remus::SERVICE_TYPE mt=static_cast<remus::SERVICE_TYPE>(i);
     if (remus::to_string(mt) == t)
@@ -11,14 +11,7 @@
 //=============================================================================
 
 #include <remus/common/Timer.h>
-
-REMUS_THIRDPARTY_PRE_INCLUDE
-#include <boost/date_time/posix_time/posix_time.hpp>
-#include <boost/circular_buffer.hpp>
-REMUS_THIRDPARTY_POST_INCLUDE
-
-#include <algorithm>
-#include <numeric>
+#include <remus/common/MonotonicClock.h>
 
 namespace remus{
 namespace common{
@@ -26,15 +19,13 @@ namespace common{
 //------------------------------------------------------------------------------
 class Timer::TimeTracker
 {
-  typedef boost::posix_time::time_duration time_duration;
-  typedef boost::posix_time::ptime ptime;
-  typedef boost::posix_time::milliseconds milliseconds;
+  typedef remus::common::MonotonicClock::TimePoint TimePoint;
 
-  ptime LastTime; //the exact time we last polled
+  TimePoint LastTime; //the exact time we last polled
 
 public:
   TimeTracker():
-    LastTime( boost::posix_time::microsec_clock::local_time() )
+    LastTime( remus::common::MonotonicClock::now() )
   {
 
   }
@@ -42,15 +33,15 @@ public:
   //----------------------------------------------------------------------------
   void reset()
   {
-    this->LastTime = boost::posix_time::microsec_clock::local_time();
+    this->LastTime = remus::common::MonotonicClock::now();
   }
 
   //----------------------------------------------------------------------------
   boost::int64_t elapsed() const
   {
-    const ptime currentTime = boost::posix_time::microsec_clock::local_time();
-    const time_duration dur = currentTime - this->LastTime;
-    return dur.total_milliseconds();
+    const TimePoint currentTime = remus::common::MonotonicClock::now();
+    return remus::common::MonotonicClock::toMilliseconds(
+                                          currentTime - this->LastTime);
   }
 };
 
@@ -30,8 +30,8 @@ namespace remus{
 namespace common{
 
 // A class that can be used to time operations in remus.
-// The system is built around boost::posix_time::microsec_clock::local_time
-// so it should have micro-second resolution, but we report all
+// The system is built around remus::common::MonotonicClock, a steady clock
+// with micro-second resolution, but we report all
 // elapsed times in milliseconds. To keep a consistent time scale with
 // ZMQ, remus::common::PollingMonitor, remus::server::PollingRates, etc
 class REMUSCOMMON_EXPORT Timer
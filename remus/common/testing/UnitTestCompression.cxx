@@ -0,0 +1,117 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/Compression.h>
+
+#include <remus/testing/Testing.h>
+
+#include <string>
+#include <vector>
+
+namespace
+{
+using remus::common::ContentCompression;
+
+//------------------------------------------------------------------------------
+void verify_no_compression()
+{
+  const std::string text = remus::testing::AsciiStringGenerator(4096);
+  std::string result("not empty");
+
+  //storing data as is is always available, but never compresses
+  REMUS_ASSERT( (remus::common::haveCompressionCodec(ContentCompression::None)) );
+  REMUS_ASSERT( (!remus::common::compressContent(ContentCompression::None,
+                                   text.data(), text.size(), result)) );
+  REMUS_ASSERT( (result.empty()) );
+}
+
+//------------------------------------------------------------------------------
+void verify_zlib()
+{
+  std::string text;
+  while(text.size() < 256 * 1024)
+    { text += "<Attribute Name=\"size\" Value=\"0.25\"/>\n"; }
+
+  std::string compressed;
+  const bool compressed_text = remus::common::compressContent(
+               ContentCompression::Zlib, text.data(), text.size(), compressed);
+
+  if(!remus::common::haveCompressionCodec(ContentCompression::Zlib))
+    {
+    //without zlib nothing can be compressed or decompressed
+    REMUS_ASSERT( (!compressed_text) );
+    REMUS_ASSERT( (compressed.empty()) );
+
+    std::vector<char> result(text.size());
+    REMUS_ASSERT( (!remus::common::decompressContent(ContentCompression::Zlib,
+                       text.data(), text.size(), &result[0], result.size())) );
+
+    //but the sizes of compressed data can still be checked, so that it can
+    //be passed on
+    REMUS_ASSERT( (remus::common::validCompressedSize(
+                                      ContentCompression::Zlib, 100, 1000)) );
+    REMUS_ASSERT( (!remus::common::validCompressedSize(
+                                      ContentCompression::Zlib, 1, 5000)) );
+    return;
+    }
+
+  REMUS_ASSERT( (compressed_text) );
+  REMUS_ASSERT( (compressed.size() < text.size() / 10) );
+
+  std::vector<char> result(text.size());
+  REMUS_ASSERT( (remus::common::decompressContent(ContentCompression::Zlib,
+            compressed.data(), compressed.size(), &result[0], result.size())) );
+  REMUS_ASSERT( (std::string(&result[0], result.size()) == text) );
+
+  //sizes read off the wire are checked before memory is allocated for them
+  REMUS_ASSERT( (remus::common::validCompressedSize(ContentCompression::Zlib,
+                                    compressed.size(), text.size())) );
+  REMUS_ASSERT( (!remus::common::validCompressedSize(ContentCompression::Zlib,
+                                    compressed.size(), compressed.size())) );
+  REMUS_ASSERT( (!remus::common::validCompressedSize(ContentCompression::Zlib,
+                                    compressed.size(), boost::uint64_t(1) << 62)) );
+  REMUS_ASSERT( (!remus::common::validCompressedSize(ContentCompression::None,
+                                    compressed.size(), text.size())) );
+  REMUS_ASSERT( (!remus::common::validCompressedSize(ContentCompression::Zlib,
+                                    0, text.size())) );
+
+  //the size of the uncompressed data must be exact
+  std::vector<char> small(text.size() - 1);
+  REMUS_ASSERT( (!remus::common::decompressContent(ContentCompression::Zlib,
+            compressed.data(), compressed.size(), &small[0], small.size())) );
+
+  std::vector<char> large(text.size() + 1);
+  REMUS_ASSERT( (!remus::common::decompressContent(ContentCompression::Zlib,
+            compressed.data(), compressed.size(), &large[0], large.size())) );
+
+  //truncated or garbage data fails instead of producing bad contents
+  REMUS_ASSERT( (!remus::common::decompressContent(ContentCompression::Zlib,
+            compressed.data(), compressed.size() / 2, &result[0], result.size())) );
+  REMUS_ASSERT( (!remus::common::decompressContent(ContentCompression::Zlib,
+            text.data(), text.size(), &result[0], result.size())) );
+
+  //random data doesn't get smaller, so it is stored as is. The generator
+  //repeats itself every 4KB, so stay under that
+  const std::string junk = remus::testing::BinaryDataGenerator(4000);
+  REMUS_ASSERT( (!remus::common::compressContent(ContentCompression::Zlib,
+                                   junk.data(), junk.size(), compressed)) );
+  REMUS_ASSERT( (compressed.empty()) );
+}
+
+}
+
+int UnitTestCompression(int, char *[])
+{
+  verify_no_compression();
+  verify_zlib();
+  return 0;
+}
@@ -0,0 +1,90 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <string>
+
+#include <remus/common/ContentHash.h>
+#include <remus/common/ConditionalStorage.h>
+
+#include <remus/testing/Testing.h>
+
+#include <set>
+
+int UnitTestContentHash(int, char *[])
+{
+  //construct an empty conditional storage
+  remus::common::ConditionalStorage empty;
+  std::string empty_storage_hash = remus::common::ContentHash(empty);
+  std::string empty_storage_hash_c = remus::common::ContentHash(NULL,0);
+  std::string empty_storage_hash_str =
+                            remus::common::ContentHash( (std::string()) );
+
+  REMUS_ASSERT( (empty_storage_hash == empty_storage_hash_c) );
+  REMUS_ASSERT( (empty_storage_hash == empty_storage_hash_str) );
+
+  //the lower half of the hash is XXH64 with a seed of zero, so the hash
+  //of known inputs must never change between platforms or versions
+  REMUS_ASSERT( (empty_storage_hash.substr(16) == "ef46db3751d8e999") );
+  REMUS_ASSERT( (remus::common::ContentHash(std::string("abc")).substr(16) ==
+                 "44bc2cf5ad770999") );
+
+  std::string content("Copyright (c) Kitware, Inc.");
+  remus::common::ConditionalStorage t(content);
+  const std::string t_hash = remus::common::ContentHash(t);
+  REMUS_ASSERT( (t_hash != empty_storage_hash) );
+  REMUS_ASSERT( (remus::common::ContentHash(content) == t_hash) );
+  REMUS_ASSERT( (remus::common::ContentHash(t.data(),t.size()) == t_hash) );
+
+  //every length of a stripe and its tail hashes differently, and a single
+  //changed byte changes the hash
+  std::string binary_junk = remus::testing::BinaryDataGenerator(4096);
+  std::set<std::string> hashes;
+  for(std::size_t i=0; i <= 96; ++i)
+    {
+    hashes.insert(remus::common::ContentHash(binary_junk.data(), i));
+    }
+  REMUS_ASSERT( (hashes.size() == 97) );
+
+  //inputs that only differ in their tail differ in both halves of the
+  //hash, not only in the lower half
+  for(std::size_t i=1; i < 32; ++i)
+    {
+    std::string tail = binary_junk.substr(0, 64 + i);
+    const std::string before = remus::common::ContentHash(tail);
+    tail[tail.size()-1] = static_cast<char>(tail[tail.size()-1] ^ 1);
+    const std::string after = remus::common::ContentHash(tail);
+    REMUS_ASSERT( (before.substr(0,16) != after.substr(0,16)) );
+    REMUS_ASSERT( (before.substr(16) != after.substr(16)) );
+    }
+
+  const std::string junk_hash = remus::common::ContentHash(binary_junk);
+  binary_junk[2048] = static_cast<char>(binary_junk[2048] ^ 1);
+  REMUS_ASSERT( (remus::common::ContentHash(binary_junk) != junk_hash) );
+
+  //contents large enough to be hashed in chunks on multiple threads hash
+  //the same every time, and depend on every chunk
+  std::string big_junk = remus::testing::BinaryDataGenerator(80*1024*1024);
+  remus::common::ConditionalStorage bstorage(big_junk);
+  const std::string big_hash = remus::common::ContentHash(big_junk);
+  REMUS_ASSERT( (remus::common::ContentHash(bstorage) == big_hash) );
+  REMUS_ASSERT( (remus::common::ContentHash(big_junk) == big_hash) );
+
+  big_junk[big_junk.size()-1] = static_cast<char>(big_junk[big_junk.size()-1] ^ 1);
+  REMUS_ASSERT( (remus::common::ContentHash(big_junk) != big_hash) );
+
+  REMUS_ASSERT( (empty_storage_hash.size() == 32) );
+  REMUS_ASSERT( (big_hash.size() == 32) );
+  REMUS_ASSERT( (big_hash.find_first_not_of("0123456789abcdef") ==
+                 std::string::npos) );
+
+  return 0;
+}
@@ -142,6 +142,51 @@ void verify_serialization()
   REMUS_ASSERT( same );
 }
 
+void verify_interned_ids()
+{
+  //types are compared by their interned ids
+  remus::common::MeshIOType a("Model","Mesh2D");
+  remus::common::MeshIOType b( (remus::meshtypes::Model()),
+                               (remus::meshtypes::Mesh2D()) );
+  REMUS_ASSERT( (a.inputId() == b.inputId()) );
+  REMUS_ASSERT( (a.outputId() == b.outputId()) );
+  REMUS_ASSERT( (&a.inputType() == &b.inputType()) );
+  REMUS_ASSERT( (a == b) );
+
+  //and can be rebuilt from those ids
+  remus::common::MeshIOType c =
+    remus::common::MeshIOType::fromInternedIds(a.inputId(), a.outputId());
+  REMUS_ASSERT( (c == a) );
+  REMUS_ASSERT( (c.inputType() == "Model") );
+  REMUS_ASSERT( (c.outputType() == "Mesh2D") );
+
+  //unknown ids make an invalid type
+  remus::common::MeshIOType d =
+    remus::common::MeshIOType::fromInternedIds(a.inputId(), 65000);
+  REMUS_ASSERT( (d.valid() == false) );
+  REMUS_ASSERT( (d.outputType().empty()) );
+
+  //types that aren't default types are compared by name
+  remus::common::MeshIOType e("Model","CustomMesh");
+  remus::common::MeshIOType f("Model",std::string("CustomMesh"));
+  remus::common::MeshIOType g("Model","OtherMesh");
+  REMUS_ASSERT( (e.outputId() == remus::common::MeshRegistrar::DynamicId) );
+  REMUS_ASSERT( (e == f) );
+  REMUS_ASSERT( (!(e < f) && !(f < e)) );
+  REMUS_ASSERT( (!(e == g)) );
+  REMUS_ASSERT( (e < g) );
+  REMUS_ASSERT( (a < e) );
+
+  //and copies share the name
+  remus::common::MeshIOType h = e;
+  REMUS_ASSERT( (&h.outputType() == &e.outputType()) );
+  REMUS_ASSERT( (h == e) );
+
+  remus::common::MeshIOType invalid;
+  REMUS_ASSERT( (invalid.valid() == false) );
+  REMUS_ASSERT( (invalid == remus::common::MeshIOType("","")) );
+}
+
 }
 
 
@@ -151,5 +196,6 @@ int UnitTestMeshIOType(int, char *[])
   verify_custom_type();
   verify_set();
   verify_serialization();
+  verify_interned_ids();
   return 0;
 }
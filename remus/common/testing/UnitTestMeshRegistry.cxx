@@ -92,6 +92,39 @@ namespace
     VerifySame(base, TextMeshType::create() );
     VerifySame(base, remus::meshtypes::to_meshType("TextMeshType"));
   }
+
+  void verify_interning()
+  {
+    typedef remus::common::MeshRegistrar Registrar;
+
+    //the default types have ids that are the same in every process
+    Registrar::InternedName mesh1D = Registrar::intern("Mesh1D");
+    Registrar::InternedName edges = Registrar::intern("Edges");
+    REMUS_ASSERT( (mesh1D.Id == 1) );
+    REMUS_ASSERT( (edges.Id == 11) );
+    REMUS_ASSERT( (Registrar::isStableId(mesh1D.Id)) );
+    REMUS_ASSERT( (*mesh1D.Name == "Mesh1D") );
+
+    //interning the same name gives the same id and the same string
+    Registrar::InternedName again = Registrar::intern(std::string("Mesh1D"));
+    REMUS_ASSERT( (again.Id == mesh1D.Id) );
+    REMUS_ASSERT( (again.Name == mesh1D.Name) );
+    REMUS_ASSERT( (Registrar::intern(mesh1D.Id).Name == mesh1D.Name) );
+
+    //other names share the dynamic id and hold their own copy of the name
+    Registrar::InternedName custom = Registrar::intern("InternedCustomType");
+    REMUS_ASSERT( (custom.Id == Registrar::DynamicId) );
+    REMUS_ASSERT( (!Registrar::isStableId(custom.Id)) );
+    REMUS_ASSERT( (*custom.Name == "InternedCustomType") );
+    REMUS_ASSERT( (custom.Name == custom.Storage.get()) );
+    REMUS_ASSERT( (!mesh1D.Storage) );
+
+    //the empty name and ids that aren't default types are invalid
+    REMUS_ASSERT( (Registrar::intern("").Id == Registrar::InvalidId) );
+    REMUS_ASSERT( (Registrar::intern(custom.Id).Id == Registrar::InvalidId) );
+    REMUS_ASSERT( (Registrar::intern(65000).Name->empty()) );
+    REMUS_ASSERT( (!Registrar::isStableId(Registrar::InvalidId)) );
+  }
 }
 
 
@@ -101,6 +134,7 @@ int UnitTestMeshRegistry(int, char *[])
   verify_create();
   no_conflicting_ids_or_names();
   can_add_custom_type();
+  verify_interning();
 
   return 0;
 }
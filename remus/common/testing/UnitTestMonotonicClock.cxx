@@ -0,0 +1,52 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/MonotonicClock.h>
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+
+namespace
+{
+typedef remus::common::MonotonicClock MonotonicClock;
+
+void verify_conversions()
+{
+  REMUS_ASSERT( (MonotonicClock::milliseconds(0) == 0) );
+  REMUS_ASSERT( (MonotonicClock::milliseconds(250) == 250000) );
+  REMUS_ASSERT( (MonotonicClock::toMilliseconds(250000) == 250) );
+  REMUS_ASSERT( (MonotonicClock::toMilliseconds(250999) == 250) );
+
+  const boost::int64_t ms = 60*60*1000;
+  REMUS_ASSERT( (MonotonicClock::toMilliseconds(
+                 MonotonicClock::milliseconds(ms)) == ms) );
+}
+
+void verify_never_goes_backwards()
+{
+  MonotonicClock::TimePoint previous = MonotonicClock::now();
+  for(int i=0; i < 100000; ++i)
+    {
+    const MonotonicClock::TimePoint current = MonotonicClock::now();
+    REMUS_ASSERT( (current >= previous) );
+    previous = current;
+    }
+}
+
+
+}
+
+int UnitTestMonotonicClock(int, char *[])
+{
+  verify_conversions();
+  verify_never_goes_backwards();
+  return 0;
+}
@@ -13,26 +13,27 @@
 #include <remus/common/PollingMonitor.h>
 #include <remus/testing/Testing.h>
 
-REMUS_THIRDPARTY_PRE_INCLUDE
-#include <boost/date_time/posix_time/posix_time.hpp>
-REMUS_THIRDPARTY_POST_INCLUDE
-
 namespace
 {
+typedef remus::common::MonotonicClock MonotonicClock;
+
+//the monotonic clock uses microseconds
+const MonotonicClock::TimePoint one_hour = MonotonicClock::milliseconds(60*60*1000);
+
 class TestPoller : public remus::common::PollingMonitor
 {
   public:
     //setup the test poller with an initial time
-    TestPoller(boost::posix_time::ptime* t):PollingMonitor()
+    TestPoller(MonotonicClock::TimePoint t):PollingMonitor()
     {
       //work around to clear the superclasses default value in the
       //monitoring
-      boost::posix_time::ptime start = *t;
-      start -= boost::posix_time::milliseconds( 10 * this->minTimeOut() );
+      MonotonicClock::TimePoint start = t;
+      start -= MonotonicClock::milliseconds( 10 * this->minTimeOut() );
       for(int i=0; i < 10; ++i)
         {
-        start += boost::posix_time::milliseconds( this->minTimeOut() );
-        PollingMonitor::fakeAPollOccurringAt(&start);
+        start += MonotonicClock::milliseconds( this->minTimeOut() );
+        PollingMonitor::fakeAPollOccurringAt(start);
         }
     }
 };
@@ -182,20 +183,19 @@ void verify_changing_rates_and_currents_value()
 
 void verify_fast_polling()
 {
-  boost::posix_time::ptime current =
-                              boost::posix_time::microsec_clock::local_time();
-  boost::posix_time::ptime t = current - boost::posix_time::hours(5);
+  MonotonicClock::TimePoint current = MonotonicClock::now();
+  MonotonicClock::TimePoint t = current - 5 * one_hour;
 
 
-  TestPoller p(&t);
+  TestPoller p(t);
 
   //verify polling at the min keeps the duration equal to the min
   const boost::int64_t minTime = p.minTimeOut();
   const boost::int64_t inputTime = (p.minTimeOut() - 1);
   for(int i=0; i < 20; ++i)
   {
-  t += boost::posix_time::milliseconds(inputTime);
-  p.fakeAPollOccurringAt(&t);
+  t += MonotonicClock::milliseconds(inputTime);
+  p.fakeAPollOccurringAt(t);
 
   //we expect that the current will be the min
   REMUS_ASSERT ( (p.current( ) == minTime) );
@@ -214,12 +214,11 @@ void verify_fast_polling()
 
 void verify_slow_polling()
 {
-  boost::posix_time::ptime current =
-                              boost::posix_time::microsec_clock::local_time();
-  boost::posix_time::ptime t = current - boost::posix_time::hours(5);
+  MonotonicClock::TimePoint current = MonotonicClock::now();
+  MonotonicClock::TimePoint t = current - 5 * one_hour;
 
 
-  TestPoller p(&t);
+  TestPoller p(t);
 
   //verify polling at the min keeps the duration equal to the min
   const boost::int64_t pollTime = p.minTimeOut() +
@@ -228,8 +227,8 @@ void verify_slow_polling()
 
   for(int i=0; i < 20; ++i)
   {
-  t += boost::posix_time::milliseconds(pollTimeInMSecs);
-  p.fakeAPollOccurringAt(&t);
+  t += MonotonicClock::milliseconds(pollTimeInMSecs);
+  p.fakeAPollOccurringAt(t);
 
   //we expect that the current will be always greater than min
   REMUS_ASSERT ( (p.current( ) > p.minTimeOut()) );
@@ -247,8 +246,8 @@ void verify_slow_polling()
   {
   boost::int64_t previous_current = p.current();
   boost::int64_t previous_average = p.average();
-  t += boost::posix_time::milliseconds(static_cast<long>(p.current()));
-  p.fakeAPollOccurringAt(&t);
+  t += MonotonicClock::milliseconds(static_cast<long>(p.current()));
+  p.fakeAPollOccurringAt(t);
 
   REMUS_ASSERT ( (p.current( ) >= previous_current ) );
   REMUS_ASSERT ( (p.average( ) >= previous_average ) );
@@ -267,22 +266,21 @@ void verify_handles_resumes()
 {
   //verify if that we get an occurrence of a significant delta between
   //two polling events we don't give a bad value for current()
-  boost::posix_time::ptime current =
-                              boost::posix_time::microsec_clock::local_time();
-  boost::posix_time::ptime t = current - boost::posix_time::hours(5);
+  MonotonicClock::TimePoint current = MonotonicClock::now();
+  MonotonicClock::TimePoint t = current - 5 * one_hour;
 
   //start 5 hours before now
-  TestPoller p(&t);
+  TestPoller p(t);
 
-  t += boost::posix_time::hours(10);
-  p.fakeAPollOccurringAt(&t);
+  t += 10 * one_hour;
+  p.fakeAPollOccurringAt(t);
 
   REMUS_ASSERT ( (p.current( ) == p.maxTimeOut()) );
   REMUS_ASSERT ( (p.average( ) > p.maxTimeOut()) );
   REMUS_ASSERT ( (p.hasAbnormalEvent( ) == true) );
 
-  t += boost::posix_time::hours(10);
-  p.fakeAPollOccurringAt(&t);
+  t += 10 * one_hour;
+  p.fakeAPollOccurringAt(t);
 
   REMUS_ASSERT ( (p.current( ) == p.maxTimeOut()) );
   REMUS_ASSERT ( (p.average( ) > p.maxTimeOut()) );
@@ -290,13 +288,34 @@ void verify_handles_resumes()
 
   while(p.current() == p.maxTimeOut())
     {
-    t += boost::posix_time::milliseconds(10);
-    p.fakeAPollOccurringAt(&t);
+    t += MonotonicClock::milliseconds(10);
+    p.fakeAPollOccurringAt(t);
     }
   REMUS_ASSERT ( (p.average( ) < p.maxTimeOut()) );
   REMUS_ASSERT ( (p.hasAbnormalEvent( ) == false) );
 }
 
+void verify_last_poll_time()
+{
+  //the time of the last poll is shared between copies, and only moves
+  //when a poll occurs
+  remus::common::PollingMonitor p;
+  remus::common::PollingMonitor p2(p);
+
+  const MonotonicClock::TimePoint before = MonotonicClock::now();
+  p.pollOccurred();
+  const MonotonicClock::TimePoint polled = p.lastPollTime();
+  const MonotonicClock::TimePoint after = MonotonicClock::now();
+
+  REMUS_ASSERT( (before <= polled && polled <= after) );
+  REMUS_ASSERT( (p2.lastPollTime() == polled) );
+  REMUS_ASSERT( (p.lastPollTime() == polled) );
+
+  MonotonicClock::TimePoint t = polled + MonotonicClock::milliseconds(25);
+  p.fakeAPollOccurringAt(t);
+  REMUS_ASSERT( (p2.lastPollTime() == t) );
+}
+
 }
 
 
@@ -312,5 +331,7 @@ int UnitTestPollingMonitor(int, char *[])
 
   verify_handles_resumes();
 
+  verify_last_poll_time();
+
   return 0;
 }
@@ -10,21 +10,18 @@
 //
 //=============================================================================
 
+#include <remus/common/MonotonicClock.h>
 #include <remus/common/Timer.h>
 #include <remus/testing/Testing.h>
 
-REMUS_THIRDPARTY_PRE_INCLUDE
-#include <boost/date_time/posix_time/posix_time.hpp>
-REMUS_THIRDPARTY_POST_INCLUDE
-
 namespace
 {
 
 void verify_elapsed()
 {
   //just verify that we have a copy constructor
-  boost::posix_time::ptime before_init =
-                              boost::posix_time::microsec_clock::local_time();
+  remus::common::MonotonicClock::TimePoint before_init =
+                              remus::common::MonotonicClock::now();
   remus::common::Timer timer;
   boost::int64_t milliE = 0;
   do
@@ -33,14 +30,15 @@ void verify_elapsed()
     }
   while( milliE < 20 );
 
-  boost::posix_time::ptime after_elapsed =
-                              boost::posix_time::microsec_clock::local_time();
+  remus::common::MonotonicClock::TimePoint after_elapsed =
+                              remus::common::MonotonicClock::now();
 
-  boost::posix_time::time_duration delta = after_elapsed - before_init;
+  const boost::int64_t delta =
+    remus::common::MonotonicClock::toMilliseconds(after_elapsed - before_init);
 
   std::cout << "milliE: " << milliE << std::endl;
-  std::cout << "delta.total_milliseconds(): " << delta.total_milliseconds() << std::endl;
-  REMUS_ASSERT( (milliE <= delta.total_milliseconds()) );
+  std::cout << "delta: " << delta << std::endl;
+  REMUS_ASSERT( (milliE <= delta) );
 }
 
 void verify_reset()
@@ -57,20 +55,21 @@ void verify_reset()
   while( milliE < 125 );
 
 
-  boost::posix_time::ptime before_reset =
-                              boost::posix_time::microsec_clock::local_time();
+  remus::common::MonotonicClock::TimePoint before_reset =
+                              remus::common::MonotonicClock::now();
 
   timer.reset();
   milliE = timer.elapsed();
 
-  boost::posix_time::ptime after_elapsed =
-                              boost::posix_time::microsec_clock::local_time();
+  remus::common::MonotonicClock::TimePoint after_elapsed =
+                              remus::common::MonotonicClock::now();
 
-  boost::posix_time::time_duration delta = after_elapsed - before_reset;
+  const boost::int64_t delta =
+    remus::common::MonotonicClock::toMilliseconds(after_elapsed - before_reset);
 
   std::cout << "milliE: " << milliE << std::endl;
-  std::cout << "delta.total_milliseconds(): " << delta.total_milliseconds() << std::endl;
-  REMUS_ASSERT( (milliE <= delta.total_milliseconds()) );
+  std::cout << "delta: " << delta << std::endl;
+  REMUS_ASSERT( (milliE <= delta) );
 }
 
 }
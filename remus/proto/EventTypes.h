@@ -48,6 +48,17 @@ inline std::string to_string(remus::proto::jobevents::EVENT_TYPE ev)
 {
   return std::string(remus::proto::jobevents::event_types[(int)ev]);
 }
+
+//------------------------------------------------------------------------------
+//The key that the final status of a job is published under, once the job
+//has finished, failed, been terminated or expired. Unlike the job:<event>:
+//keys the data is a serialized remus::proto::JobStatus and not json, so
+//clients can subscribe to this key to be told when a single job is done
+//instead of polling the server for the status of the job.
+inline std::string done_key(const std::string& jobId)
+{
+  return std::string("done:") + jobId;
+}
 }
 
 namespace workevents {
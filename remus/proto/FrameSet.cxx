@@ -0,0 +1,268 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/proto/FrameSet.h>
+
+#include <remus/common/MD5Hash.h>
+#include <remus/proto/zmq.hpp>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/make_shared.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <algorithm>
+
+namespace
+{
+//------------------------------------------------------------------------------
+//called by zmq once it is done with the data of a message, the hint is the
+//shared pointer that has been keeping the data alive
+void release_frame(void*, void* hint)
+{
+  delete static_cast< boost::shared_ptr<const char>* >(hint);
+}
+}
+
+namespace remus{
+namespace proto{
+namespace detail{
+
+//------------------------------------------------------------------------------
+Frame make_HeaderFrame(std::string& header)
+{
+  boost::shared_ptr<std::string> storage = boost::make_shared<std::string>();
+  storage->swap(header);
+  return Frame(boost::shared_ptr<const char>(storage, storage->data()),
+               storage->size());
+}
+
+//------------------------------------------------------------------------------
+void share_Ownership(std::vector<Frame>& blobs,
+                     const boost::shared_ptr<const void>& owner)
+{
+  typedef std::vector<Frame>::iterator it;
+  for(it i = blobs.begin(); i != blobs.end(); ++i)
+    {
+    i->Data = boost::shared_ptr<const char>(owner, i->data());
+    }
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<zmq::message_t> to_zmqMessage(const Frame& frame)
+{
+  if(frame.size() == 0 || frame.data() == NULL)
+    {
+    return boost::make_shared<zmq::message_t>();
+    }
+
+  //zmq never writes to the data of a message it is sending, so it is
+  //safe to cast away the const
+  boost::shared_ptr<const char>* hint =
+                              new boost::shared_ptr<const char>(frame.Data);
+  return boost::make_shared<zmq::message_t>(const_cast<char*>(frame.data()),
+                                            frame.size(),
+                                            &release_frame,
+                                            hint);
+}
+
+//------------------------------------------------------------------------------
+Frame to_Frame(const boost::shared_ptr<zmq::message_t>& message)
+{
+  if(!message)
+    {
+    return Frame();
+    }
+  //use the aliasing constructor so that the frame shares ownership of the
+  //zmq message that holds the data
+  return Frame(boost::shared_ptr<const char>(message,
+                    static_cast<const char*>(message->data())),
+               message->size());
+}
+
+}
+
+//------------------------------------------------------------------------------
+FrameSet to_FrameSet(const std::vector<FrameSet>& items)
+{
+  typedef std::vector<FrameSet>::const_iterator it;
+  namespace binary = remus::internal::binary;
+
+  //compute the size of the header first, so that copying the item headers
+  //never reallocates
+  std::size_t headerSize = binary::HeaderSize + 4;
+  std::size_t numBlobs = 0;
+  for(it i = items.begin(); i != items.end(); ++i)
+    {
+    headerSize += 8 + i->Header.size() + 4;
+    numBlobs += i->Blobs.size();
+    }
+
+  FrameSet batch;
+  batch.Blobs.reserve(numBlobs);
+
+  //each item is written as its header, followed by the number of blob
+  //frames that belong to it
+  remus::internal::BinaryWriter writer;
+  writer.reserve(headerSize);
+  writer.writeHeader(binary::TypeTag::Batch);
+  writer.writeUInt32(static_cast<boost::uint32_t>(items.size()));
+  for(it i = items.begin(); i != items.end(); ++i)
+    {
+    writer.writeBlob(i->Header.data(), i->Header.size());
+    writer.writeUInt32(static_cast<boost::uint32_t>(i->Blobs.size()));
+    batch.Blobs.insert(batch.Blobs.end(), i->Blobs.begin(), i->Blobs.end());
+    }
+
+  std::string header = writer.release();
+  batch.Header = detail::make_HeaderFrame(header);
+  return batch;
+}
+
+//------------------------------------------------------------------------------
+std::vector<FrameSet> to_FrameSets(const FrameSet& batch)
+{
+  namespace binary = remus::internal::binary;
+
+  std::vector<FrameSet> items;
+  remus::internal::BinaryReader reader(batch.Header.Data, batch.Header.size());
+  if(!reader.readHeader(binary::TypeTag::Batch))
+    {
+    return items;
+    }
+
+  //every item takes at least 12 bytes, so a count that doesn't fit in the
+  //header can't make us allocate a huge vector
+  const std::size_t count = reader.readUInt32();
+  items.reserve( std::min(count, reader.remaining() / 12) );
+
+  std::size_t nextBlob = 0;
+  for(std::size_t i=0; i < count && reader.valid(); ++i)
+    {
+    std::size_t headerSize = 0;
+    const char* header = reader.readBlob(headerSize);
+    const std::size_t numBlobs = reader.readUInt32();
+    if(!reader.valid() || numBlobs > batch.Blobs.size() - nextBlob)
+      {
+      items.clear();
+      return items;
+      }
+
+    //the item header shares ownership of the batch header it points into
+    FrameSet item;
+    item.Header = Frame(boost::shared_ptr<const char>(batch.Header.Data, header),
+                        headerSize);
+    item.Blobs.assign(batch.Blobs.begin() + nextBlob,
+                      batch.Blobs.begin() + nextBlob + numBlobs);
+    nextBlob += numBlobs;
+    items.push_back(item);
+    }
+
+  if(!reader.valid())
+    {
+    items.clear();
+    }
+  return items;
+}
+
+//------------------------------------------------------------------------------
+std::string to_ContentHash(const Frame& blob)
+{
+  return remus::common::MD5Hash(blob.data(), blob.size());
+}
+
+//------------------------------------------------------------------------------
+FrameSet to_FrameSet(const ReferencedFrameSet& frames)
+{
+  namespace binary = remus::internal::binary;
+  const std::vector<Frame>& blobs = frames.Frames.Blobs;
+
+  //the header of the frames is followed by the hash of every blob, and
+  //whether the blob is sent as a frame or is only referenced
+  remus::internal::BinaryWriter writer;
+  writer.writeHeader(binary::TypeTag::References);
+  writer.writeBlob(frames.Frames.Header.data(), frames.Frames.Header.size());
+  writer.writeUInt32(static_cast<boost::uint32_t>(blobs.size()));
+
+  FrameSet result;
+  for(std::size_t i=0; i < blobs.size(); ++i)
+    {
+    const bool referenced = i < frames.Referenced.size() &&
+                            frames.Referenced[i];
+    writer.writeString( i < frames.Hashes.size() ? frames.Hashes[i] :
+                                                   std::string() );
+    writer.writeUInt8( referenced ? 1 : 0 );
+    if(!referenced)
+      {
+      result.Blobs.push_back(blobs[i]);
+      }
+    }
+
+  std::string header = writer.release();
+  result.Header = detail::make_HeaderFrame(header);
+  return result;
+}
+
+//------------------------------------------------------------------------------
+ReferencedFrameSet to_ReferencedFrameSet(const FrameSet& frames)
+{
+  namespace binary = remus::internal::binary;
+
+  ReferencedFrameSet result;
+  remus::internal::BinaryReader reader(frames.Header.Data, frames.Header.size());
+  if(!reader.readHeader(binary::TypeTag::References))
+    {
+    return ReferencedFrameSet();
+    }
+
+  std::size_t headerSize = 0;
+  const char* header = reader.readBlob(headerSize);
+
+  //every blob takes at least 5 bytes, so a count that doesn't fit in the
+  //header can't make us allocate a huge vector
+  const std::size_t count = reader.readUInt32();
+  if(!reader.valid() || count > reader.remaining() / 5)
+    {
+    return ReferencedFrameSet();
+    }
+
+  //the header shares ownership of the header it points into
+  result.Frames.Header =
+        Frame(boost::shared_ptr<const char>(frames.Header.Data, header),
+              headerSize);
+  result.Frames.Blobs.resize(count);
+  result.Hashes.resize(count);
+  result.Referenced.resize(count);
+
+  std::size_t nextBlob = 0;
+  for(std::size_t i=0; i < count && reader.valid(); ++i)
+    {
+    result.Hashes[i] = reader.readString();
+    result.Referenced[i] = reader.readUInt8() != 0;
+    if(!result.Referenced[i])
+      {
+      if(nextBlob >= frames.Blobs.size())
+        {
+        return ReferencedFrameSet();
+        }
+      result.Frames.Blobs[i] = frames.Blobs[nextBlob++];
+      }
+    }
+
+  if(!reader.valid() || nextBlob != frames.Blobs.size())
+    {
+    return ReferencedFrameSet();
+    }
+  return result;
+}
+
+}
+}
@@ -0,0 +1,195 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_FrameSet_h
+#define remus_proto_FrameSet_h
+
+#include <remus/common/BinaryConversionHelper.h>
+#include <remus/proto/WireFormat.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/shared_ptr.hpp>
+#include <boost/uuid/uuid.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+//for export symbols
+#include <remus/proto/ProtoExports.h>
+
+#include <string>
+#include <vector>
+
+namespace zmq
+{
+  class message_t;
+}
+
+namespace remus{
+namespace proto{
+
+class JobRequirements;
+class JobResult;
+class JobSubmission;
+class WorkerJob;
+
+//A single zmq frame worth of data. The data is kept alive by whoever owns
+//it, which is either the object it was encoded from or the received frame.
+typedef remus::internal::BinaryBlob Frame;
+
+//FrameSet is the multi-frame encoding of a proto object. The header frame
+//holds the binary wire format of everything but the contents, and each
+//content blob travels as its own frame. This way large contents are never
+//copied into a single contiguous buffer when sending, and on receive the
+//decoded contents point directly into the frame they arrived in.
+struct FrameSet
+{
+  Frame Header;
+  std::vector<Frame> Blobs;
+};
+
+//----------------------------------------------------------------------------
+//The frames returned share ownership of a copy of the object, so they stay
+//valid after the object given has been destroyed.
+REMUSPROTO_EXPORT
+FrameSet to_FrameSet(const remus::proto::JobSubmission& submission);
+
+REMUSPROTO_EXPORT
+FrameSet to_FrameSet(const remus::proto::JobResult& result);
+
+REMUSPROTO_EXPORT
+FrameSet to_FrameSet(const remus::proto::WorkerJob& job);
+
+//----------------------------------------------------------------------------
+//The frames of the object in the given wire format. The text format has no
+//blob frames, the whole object is encoded into the header frame the way
+//peers that predate frame sets send it. Binary is the same as the
+//functions above.
+REMUSPROTO_EXPORT
+FrameSet to_FrameSet(const remus::proto::JobSubmission& submission,
+                     remus::proto::WireFormat::Type format);
+
+REMUSPROTO_EXPORT
+FrameSet to_FrameSet(const remus::proto::JobResult& result,
+                     remus::proto::WireFormat::Type format);
+
+REMUSPROTO_EXPORT
+FrameSet to_FrameSet(const remus::proto::WorkerJob& job,
+                     remus::proto::WireFormat::Type format);
+
+//----------------------------------------------------------------------------
+//The frames of a WorkerJob whose submission has already been encoded as
+//frames, for example the frames a client sent. The submission frames are
+//forwarded untouched, nothing is decoded or copied.
+REMUSPROTO_EXPORT
+FrameSet to_FrameSet(const boost::uuids::uuid& jobId,
+                     const FrameSet& submission);
+
+//----------------------------------------------------------------------------
+//Decode the frames received. When no blob frames are given the header
+//frame is decoded as a single frame in any wire format, so these work with
+//peers that still send everything in one frame.
+REMUSPROTO_EXPORT
+remus::proto::JobSubmission to_JobSubmission(const FrameSet& frames);
+
+//----------------------------------------------------------------------------
+//Decode only the requirements of the submission held in the frames. The
+//contents of the submission are skipped, which is all a broker needs to
+//schedule a job.
+REMUSPROTO_EXPORT
+remus::proto::JobRequirements to_JobRequirements(const FrameSet& submission);
+
+REMUSPROTO_EXPORT
+remus::proto::JobResult to_JobResult(const FrameSet& frames);
+
+REMUSPROTO_EXPORT
+remus::proto::WorkerJob to_WorkerJob(const FrameSet& frames);
+
+//----------------------------------------------------------------------------
+//A batch holds many frame sets so that they can be sent as a single
+//message, which is how the bulk client calls talk to the server. The header
+//frames of the items are copied into the header of the batch, and the blobs
+//of every item follow as their own frames without being copied.
+REMUSPROTO_EXPORT
+FrameSet to_FrameSet(const std::vector<FrameSet>& items);
+
+//----------------------------------------------------------------------------
+//Split a batch back into its items. The items reference the frames of the
+//batch instead of copying them. Returns no items when the frames aren't a
+//valid batch.
+REMUSPROTO_EXPORT
+std::vector<FrameSet> to_FrameSets(const FrameSet& batch);
+
+//----------------------------------------------------------------------------
+//returns the MD5 hash that content addresses the data of a blob. Equal to
+//JobContent::hash for the blob of a content that isn't compressed.
+REMUSPROTO_EXPORT
+std::string to_ContentHash(const Frame& blob);
+
+//----------------------------------------------------------------------------
+//A frame set where blobs can be referenced by the hash of their data instead
+//of being sent. This is how clients submit jobs whose large contents the
+//server already holds in its blob store, so that only the blobs the server
+//is missing are sent.
+struct ReferencedFrameSet
+{
+  //the frames, with an empty frame for every blob that is only referenced
+  FrameSet Frames;
+
+  //the content hash of each blob, empty for blobs that aren't stored
+  std::vector<std::string> Hashes;
+
+  //true for each blob that is referenced instead of being sent
+  std::vector<bool> Referenced;
+};
+
+//----------------------------------------------------------------------------
+//Only the blobs that aren't referenced become frames of the result, and
+//they are not copied.
+REMUSPROTO_EXPORT
+FrameSet to_FrameSet(const ReferencedFrameSet& frames);
+
+//----------------------------------------------------------------------------
+//Returns a ReferencedFrameSet with an empty header when the frames aren't
+//a valid encoding of one.
+REMUSPROTO_EXPORT
+ReferencedFrameSet to_ReferencedFrameSet(const FrameSet& frames);
+
+namespace detail
+{
+//----------------------------------------------------------------------------
+//move the encoded header into a frame that owns it
+REMUSPROTO_EXPORT
+Frame make_HeaderFrame(std::string& header);
+
+//----------------------------------------------------------------------------
+//the blobs written by BinaryWriter don't own their data, so make each blob
+//share ownership of the object the blobs point into
+REMUSPROTO_EXPORT
+void share_Ownership(std::vector<Frame>& blobs,
+                     const boost::shared_ptr<const void>& owner);
+
+//----------------------------------------------------------------------------
+//construct a zmq message that references the data of the frame instead of
+//copying it. The frame data is kept alive until zmq is done sending it.
+REMUSPROTO_EXPORT
+boost::shared_ptr<zmq::message_t> to_zmqMessage(const Frame& frame);
+
+//----------------------------------------------------------------------------
+//construct a frame that references the data of a received zmq message,
+//and keeps the message alive
+REMUSPROTO_EXPORT
+Frame to_Frame(const boost::shared_ptr<zmq::message_t>& message);
+}
+
+}
+}
+
+#endif
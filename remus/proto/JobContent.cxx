@@ -13,8 +13,10 @@
 #include <remus/proto/JobContent.h>
 
 #include <remus/common/ConditionalStorage.h>
-#include <remus/common/MD5Hash.h>
+#include <remus/common/ContentHash.h>
 #include <remus/common/ConversionHelper.h>
+#include <remus/common/MD5Hash.h>
+#include <remus/common/BinaryConversionHelper.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/make_shared.hpp>
@@ -22,6 +24,8 @@ REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <sstream>
 #include <algorithm>
+#include <mutex>
+#include <new>
 #include <utility>
 
 namespace remus{
@@ -34,8 +38,15 @@ struct JobContent::InternalImpl
     Size(0),
     Data(NULL),
     Storage(),
+    Owner(),
     ShortHash(),
-    FullHash()
+    FullHash(),
+    Compressed(),
+    CompressedData(NULL),
+    CompressedSize(0),
+    Codec(remus::common::ContentCompression::None),
+    NeedsInflate(false),
+    Corrupt(false)
   {
     remus::common::ConditionalStorage temp(t);
     this->Storage.swap(temp);
@@ -47,8 +58,15 @@ struct JobContent::InternalImpl
     Size(s),
     Data(d),
     Storage(),
+    Owner(),
     ShortHash(),
-    FullHash()
+    FullHash(),
+    Compressed(),
+    CompressedData(NULL),
+    CompressedSize(0),
+    Codec(remus::common::ContentCompression::None),
+    NeedsInflate(false),
+    Corrupt(false)
   {
   }
 
@@ -57,8 +75,15 @@ struct JobContent::InternalImpl
     Size(s),
     Data(NULL),
     Storage(),
+    Owner(),
     ShortHash(),
-    FullHash()
+    FullHash(),
+    Compressed(),
+    CompressedData(NULL),
+    CompressedSize(0),
+    Codec(remus::common::ContentCompression::None),
+    NeedsInflate(false),
+    Corrupt(false)
 {
     remus::common::ConditionalStorage temp(d,s);
     this->Storage.swap(temp);
@@ -66,8 +91,88 @@ struct JobContent::InternalImpl
     this->Data = this->Storage.data();
   }
 
-  std::size_t size() const { return Size; }
-  const char* data() const { return Data; }
+  //reference data that lives inside a buffer owned by someone else, for
+  //example a received zmq frame. We hold onto the owner so the buffer
+  //stays alive for as long as we point into it.
+  InternalImpl(const boost::shared_ptr<const char>& owner,
+               const char* d, std::size_t s):
+    Size(s),
+    Data(d),
+    Storage(),
+    Owner(owner),
+    ShortHash(),
+    FullHash(),
+    Compressed(),
+    CompressedData(NULL),
+    CompressedSize(0),
+    Codec(remus::common::ContentCompression::None),
+    NeedsInflate(false),
+    Corrupt(false)
+  {
+  }
+
+  //hold data that was received compressed. We keep the compressed data so
+  //that it can be sent on without being compressed again, and without an
+  //owner we need our own copy of it. The data is only decompressed the
+  //first time it is asked for, so a process that just passes the data on
+  //never pays for it. When the data doesn't decompress it is empty.
+  InternalImpl(remus::common::ContentCompression::Type codec,
+               const boost::shared_ptr<const char>& owner,
+               const char* compressed, std::size_t compressedSize,
+               std::size_t s):
+    Size(s),
+    Data(NULL),
+    Storage(),
+    Owner(owner),
+    ShortHash(),
+    FullHash(),
+    Compressed(),
+    CompressedData(compressed),
+    CompressedSize(compressedSize),
+    Codec(codec),
+    NeedsInflate(true),
+    Corrupt(false)
+  {
+    if(!owner)
+      {
+      this->Compressed.assign(compressed, compressedSize);
+      this->CompressedData = this->Compressed.data();
+      }
+  }
+
+  std::size_t size() const
+    { this->inflate(); return this->Corrupt ? 0 : this->Size; }
+
+  const char* data() const { this->inflate(); return this->Data; }
+
+  //the size of the data without decompressing it
+  std::size_t storedSize() const { return this->Size; }
+
+  //returns the data compressed with the codec, or NULL when the data
+  //should be sent as is. The data is only compressed once, and data that
+  //was received compressed with the codec is returned as it was received.
+  const char* compressed(remus::common::ContentCompression::Type codec,
+                         std::size_t threshold, std::size_t& compressedSize)
+  {
+    if(codec == remus::common::ContentCompression::None ||
+       this->storedSize() == 0 || this->storedSize() < threshold)
+      {
+      return NULL;
+      }
+
+    if(this->Codec != codec)
+      { //remember when the data doesn't compress, so we don't try again
+      std::string result;
+      remus::common::compressContent(codec, this->data(), this->size(), result);
+      this->Compressed.swap(result);
+      this->CompressedData = this->Compressed.empty() ? NULL :
+                                                this->Compressed.data();
+      this->CompressedSize = this->Compressed.size();
+      this->Codec = codec;
+      }
+    compressedSize = this->CompressedSize;
+    return this->CompressedData;
+  }
 
   bool equal(const boost::shared_ptr<InternalImpl> other)
     {
@@ -94,8 +199,8 @@ struct JobContent::InternalImpl
       {
       //only hash the first 4096 characters
       std::size_t hashsize = 4096;
-      this->ShortHash = remus::common::MD5Hash(this->data(),
-                                               hashsize);
+      this->ShortHash = remus::common::ContentHash(this->data(),
+                                                   hashsize);
       }
     return this->ShortHash;
   }
@@ -105,25 +210,83 @@ struct JobContent::InternalImpl
    if(this->FullHash.size() == 0)
       {
       //has the whole damn file
-      this->FullHash = remus::common::MD5Hash(this->data(),
-                                              this->size());
+      this->FullHash = remus::common::ContentHash(this->data(),
+                                                  this->size());
       }
     return this->FullHash;
   }
+
+  const std::string& storeHash()
+  {
+   if(this->StoreHash.size() == 0)
+      {
+      this->StoreHash = remus::common::MD5Hash(this->data(), this->size());
+      }
+    return this->StoreHash;
+  }
 private:
+  void inflate() const
+  {
+    if(this->NeedsInflate)
+      {
+      std::call_once(this->Inflated, [this]() { this->decompress(); });
+      }
+  }
+
+  void decompress() const
+  {
+    //the size comes off the wire, so don't throw when we can't allocate it
+    boost::shared_array<char> space( new (std::nothrow) char[this->Size] );
+    if(space && remus::common::decompressContent(this->Codec,
+                                                 this->CompressedData,
+                                                 this->CompressedSize,
+                                                 space.get(), this->Size))
+      {
+      remus::common::ConditionalStorage temp(space, this->Size);
+      this->Storage.swap(temp);
+      this->Data = this->Storage.data();
+      }
+    else
+      { //the data is corrupt, or too large to hold in memory
+      this->Corrupt = true;
+      }
+  }
 
   //store the size of the data being held
   std::size_t Size;
 
-  //points to the zero copy or data in the conditional storage
-  const char* Data;
+  //points to the zero copy or data in the conditional storage, both are
+  //only set after construction by decompress
+  mutable const char* Data;
 
   //Storage is an optional allocation that is used when we need to copy data
-  remus::common::ConditionalStorage Storage;
+  mutable remus::common::ConditionalStorage Storage;
+
+  //Owner is an optional reference to the buffer that Data points into
+  boost::shared_ptr<const char> Owner;
 
-  //MD5Hash of the data held by us.
+  //ContentHash of the data held by us, used to compare contents
   std::string ShortHash;
   std::string FullHash;
+
+  //MD5Hash of the data held by us, which names the data in the blob stores
+  //of other processes, so it needs to be hard to collide on purpose
+  std::string StoreHash;
+
+  //the data compressed with Codec. Either we compressed it the first time
+  //it was sent compressed, or it was received compressed. Compressed holds
+  //our own copy, otherwise CompressedData points into the buffer held by
+  //Owner.
+  std::string Compressed;
+  const char* CompressedData;
+  std::size_t CompressedSize;
+  remus::common::ContentCompression::Type Codec;
+
+  //set when the data still has to be decompressed, which happens once
+  //the first time the data or its size is asked for
+  bool NeedsInflate;
+  mutable std::once_flag Inflated;
+  mutable bool Corrupt;
 };
 
 //------------------------------------------------------------------------------
@@ -131,6 +294,8 @@ JobContent::JobContent():
   SourceType(),
   FormatType(),
   Tag(),
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold),
   Implementation( boost::make_shared<InternalImpl>(
                  static_cast<char*>(NULL),std::size_t(0)) )
   //make_shared is significantly faster than using manual new
@@ -143,6 +308,8 @@ JobContent::JobContent(remus::common::ContentFormat::Type format,
   SourceType(remus::common::ContentSource::File),
   FormatType(format),
   Tag(),
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold),
   Implementation( boost::make_shared<InternalImpl>(handle) )
   //make_shared is significantly faster than using manual new
 {
@@ -156,6 +323,8 @@ JobContent::JobContent(remus::common::ContentFormat::Type format,
   SourceType(remus::common::ContentSource::Memory),
   FormatType(format),
   Tag(),
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold),
   Implementation( boost::make_shared<InternalImpl>(contents) )
   //make_shared is significantly faster than using manual new
 {
@@ -169,6 +338,8 @@ JobContent::JobContent(remus::common::ContentFormat::Type format,
   SourceType(remus::common::ContentSource::Memory),
   FormatType(format),
   Tag(),
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold),
   Implementation( boost::make_shared<InternalImpl>(contents,size) )
   //make_shared is significantly faster than using manual new
 {
@@ -183,6 +354,8 @@ JobContent& JobContent::operator=(JobContent&& other)
     this->SourceType = other.SourceType;
     this->FormatType = other.FormatType;
     this->Tag = std::move(other.Tag);
+    this->Compression = other.Compression;
+    this->CompressionThreshold = other.CompressionThreshold;
 
     this->Implementation = other.Implementation;
     other.Implementation.reset();
@@ -202,6 +375,12 @@ std::size_t JobContent::dataSize() const
   return this->Implementation->size();
 }
 
+//------------------------------------------------------------------------------
+const std::string& JobContent::hash() const
+{
+  return this->Implementation->storeHash();
+}
+
 //------------------------------------------------------------------------------
 bool JobContent::operator<(const JobContent& other) const
 {
@@ -244,6 +423,7 @@ void JobContent::serialize(std::ostream& buffer) const
   buffer << this->tag().size() << '\n';
   remus::internal::writeString(buffer,this->tag());
 
+  //the text format is never compressed
   buffer << this->Implementation->size() << '\n';
   remus::internal::writeString( buffer,
                                 this->Implementation->data(),
@@ -251,7 +431,9 @@ void JobContent::serialize(std::ostream& buffer) const
 }
 
 //------------------------------------------------------------------------------
-JobContent::JobContent(std::istream& buffer)
+JobContent::JobContent(std::istream& buffer):
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold)
 {
   int stype=0, ftype=0;
   std::size_t tagSize=0;
@@ -290,6 +472,92 @@ JobContent::JobContent(std::istream& buffer)
     }
 }
 
+//------------------------------------------------------------------------------
+void JobContent::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  namespace binary = remus::internal::binary;
+  std::size_t compressedSize = 0;
+  const char* compressed = this->Implementation->compressed(
+                this->Compression, this->CompressionThreshold, compressedSize);
+
+  buffer.writeUInt8( static_cast<boost::uint8_t>(this->sourceType()) );
+  if(compressed)
+    {
+    buffer.writeUInt8( static_cast<boost::uint8_t>(this->formatType()) |
+                       binary::CompressedFlag );
+    buffer.writeString( this->tag() );
+    buffer.writeUInt8( static_cast<boost::uint8_t>(this->Compression) );
+    buffer.writeUInt64( this->Implementation->storedSize() );
+    buffer.writeBlob( compressed, compressedSize );
+    }
+  else
+    {
+    buffer.writeUInt8( static_cast<boost::uint8_t>(this->formatType()) );
+    buffer.writeString( this->tag() );
+    const char* contents = this->Implementation->data();
+    buffer.writeBlob( contents, this->Implementation->size() );
+    }
+}
+
+//------------------------------------------------------------------------------
+JobContent::JobContent(remus::internal::BinaryReader& buffer):
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold)
+{
+  namespace binary = remus::internal::binary;
+  const int stype = buffer.readUInt8();
+  const int ftype = buffer.readUInt8();
+  this->SourceType = static_cast<remus::common::ContentSource::Type>(stype);
+  this->FormatType = static_cast<remus::common::ContentFormat::Type>(
+                                              ftype & ~binary::CompressedFlag);
+  this->Tag = buffer.readString();
+
+  //compressed contents keep their codec, so that they are sent on without
+  //being compressed again
+  const bool isCompressed = (ftype & binary::CompressedFlag) != 0;
+  boost::uint64_t uncompressedSize = 0;
+  if(isCompressed)
+    {
+    this->Compression = static_cast<remus::common::ContentCompression::Type>(
+                                                        buffer.readUInt8());
+    this->CompressionThreshold = 0;
+    uncompressedSize = buffer.readUInt64();
+    }
+
+  std::size_t contentsSize=0;
+  const char* contents = buffer.readBlob(contentsSize);
+  if(isCompressed &&
+     !remus::common::validCompressedSize(this->Compression, contentsSize,
+                                         uncompressedSize))
+    { //corrupt, or compressed with a codec remus doesn't know
+    buffer.invalidate();
+    }
+
+  if( contentsSize == 0 || contents == NULL || !buffer.valid())
+    { //make_shared is significantly faster than using manual new
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                    static_cast<char*>(NULL),std::size_t(0));
+    }
+  else if(isCompressed)
+    { //make_shared is significantly faster than using manual new
+    this->Implementation = boost::make_shared<InternalImpl>(
+                      this->Compression, buffer.owner(), contents,
+                      contentsSize, static_cast<std::size_t>(uncompressedSize));
+    }
+  else if(buffer.owner())
+    { //point straight into the buffer we are reading from, no copy needed
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                  buffer.owner(), contents, contentsSize);
+    }
+  else
+    { //the reader doesn't own the buffer, so we need our own copy
+    boost::shared_array<char> storage( new char[contentsSize] );
+    std::copy(contents, contents+contentsSize, storage.get());
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                                storage, contentsSize);
+    }
+}
+
 //------------------------------------------------------------------------------
 std::string to_string(const remus::proto::JobContent& content)
 {
@@ -298,9 +566,41 @@ std::string to_string(const remus::proto::JobContent& content)
   return buffer.str();
 }
 
+//------------------------------------------------------------------------------
+std::string to_string(const remus::proto::JobContent& content,
+                      remus::proto::WireFormat::Type format)
+{
+  if(format == remus::proto::WireFormat::Text)
+    {
+    return to_string(content);
+    }
+
+  //first pass computes the size so the second pass doesn't reallocate
+  remus::internal::BinaryWriter counter(remus::internal::BinaryWriter::CountOnly);
+  counter.writeHeader(remus::internal::binary::TypeTag::Content);
+  counter << content;
+
+  remus::internal::BinaryWriter buffer;
+  buffer.reserve(counter.size());
+  buffer.writeHeader(remus::internal::binary::TypeTag::Content);
+  buffer << content;
+  return buffer.release();
+}
+
 //------------------------------------------------------------------------------
 remus::proto::JobContent to_JobContent(const char* data, std::size_t size)
 {
+  if(remus::internal::isBinaryWireFormat(data,size))
+    {
+    remus::internal::BinaryReader reader(data,size);
+    remus::proto::JobContent content;
+    if(reader.readHeader(remus::internal::binary::TypeTag::Content))
+      {
+      reader >> content;
+      }
+    return reader.valid() ? content : remus::proto::JobContent();
+    }
+
   std::stringstream buffer;
   remus::internal::writeString(buffer, data, size);
   remus::proto::JobContent content;
@@ -308,6 +608,23 @@ remus::proto::JobContent to_JobContent(const char* data, std::size_t size)
   return content;
 }
 
+//------------------------------------------------------------------------------
+remus::proto::JobContent to_JobContent(const boost::shared_ptr<const char>& data,
+                                       std::size_t size)
+{
+  if(!remus::internal::isBinaryWireFormat(data.get(),size))
+    {
+    return to_JobContent(data.get(),size);
+    }
+
+  remus::internal::BinaryReader reader(data,size);
+  remus::proto::JobContent content;
+  if(reader.readHeader(remus::internal::binary::TypeTag::Content))
+    {
+    reader >> content;
+    }
+  return reader.valid() ? content : remus::proto::JobContent();
+}
 
 }
 }
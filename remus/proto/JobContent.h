@@ -21,10 +21,13 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/shared_ptr.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
-//for ContentFormat and ContentSource
+//for ContentFormat, ContentSource and ContentCompression
+#include <remus/common/Compression.h>
 #include <remus/common/ContentTypes.h>
 #include <remus/common/FileHandle.h>
 
+#include <remus/proto/WireFormat.h>
+
 //included for export symbols
 #include <remus/proto/ProtoExports.h>
 
@@ -82,9 +85,34 @@ public:
   //get the value of the tag for this data
   const std::string& tag() const { return this->Tag; }
 
+  //contents that were received compressed are decompressed the first time
+  //the data or its size is asked for. Contents that don't decompress are
+  //empty, and contents whose sizes don't fit the codec, or use a codec
+  //remus wasn't built with, are rejected like any other malformed content.
   const char* data() const;
   std::size_t dataSize() const;
 
+  //compress the data with the codec when the content is encoded with the
+  //binary wire format and holds at least threshold bytes. The data is sent
+  //as is when remus was built without the codec or the data doesn't
+  //compress. Contents received compressed keep their codec, so they are
+  //sent on without being compressed again. The compressed data is cached
+  //the first time the content is sent, so like the cached hashes a content
+  //shared between threads must not be sent from more than one at a time.
+  void compress(remus::common::ContentCompression::Type codec,
+                std::size_t threshold =
+                              remus::common::DefaultCompressionThreshold)
+    { this->Compression = codec; this->CompressionThreshold = threshold; }
+
+  remus::common::ContentCompression::Type compression() const
+    { return this->Compression; }
+
+  //returns the MD5 hash of the data, which is computed once and than cached.
+  //Content with equal data has equal hashes, which lets the server store
+  //content by its hash so that it doesn't need to be sent again. Comparing
+  //contents uses a faster hash, so it doesn't compute this one.
+  const std::string& hash() const;
+
   ///implement a less than operator and equal operator so you
   //can use the class in containers and algorithms
   bool operator<(const JobContent& other) const;
@@ -96,17 +124,29 @@ public:
   friend std::istream& operator>>(std::istream &is, JobContent &content)
     { content = JobContent(is); return is; }
 
+  friend remus::internal::BinaryWriter& operator<<(
+                  remus::internal::BinaryWriter &bw, const JobContent &content)
+    { content.serialize(bw); return bw; }
+
+  friend remus::internal::BinaryReader& operator>>(
+                  remus::internal::BinaryReader &br, JobContent &content)
+    { content = JobContent(br); return br; }
+
 private:
   //serialize function
   void serialize(std::ostream& buffer) const;
+  void serialize(remus::internal::BinaryWriter& buffer) const;
 
   //deserialize constructor function
   explicit JobContent(std::istream& buffer);
+  explicit JobContent(remus::internal::BinaryReader& buffer);
 
 
   remus::common::ContentSource::Type SourceType;
   remus::common::ContentFormat::Type FormatType;
   std::string Tag;
+  remus::common::ContentCompression::Type Compression;
+  std::size_t CompressionThreshold;
 
   struct InternalImpl;
   boost::shared_ptr<InternalImpl> Implementation;
@@ -138,9 +178,24 @@ std::string to_string(const remus::proto::JobContent& content);
 // }
 
 //------------------------------------------------------------------------------
+//encode the content using the requested wire format
+REMUSPROTO_EXPORT
+std::string to_string(const remus::proto::JobContent& content,
+                      remus::proto::WireFormat::Type format);
+
+//------------------------------------------------------------------------------
+//decodes both the text and binary wire formats
 REMUSPROTO_EXPORT
 remus::proto::JobContent to_JobContent(const char* data, std::size_t size);
 
+//------------------------------------------------------------------------------
+//decode without copying the blobs out of data, instead the result holds
+//a reference to data and points into it. Only the binary wire format can
+//be decoded without a copy, the text format falls back to copying.
+REMUSPROTO_EXPORT
+remus::proto::JobContent to_JobContent(const boost::shared_ptr<const char>& data,
+                                     std::size_t size);
+
 //------------------------------------------------------------------------------
 inline remus::proto::JobContent to_JobContent(const std::string& msg)
 {
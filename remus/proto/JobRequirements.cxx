@@ -14,11 +14,13 @@
 
 #include <remus/common/ConditionalStorage.h>
 #include <remus/common/ConversionHelper.h>
+#include <remus/common/BinaryConversionHelper.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/make_shared.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <algorithm>
 #include <sstream>
 
 namespace remus{
@@ -253,6 +255,49 @@ JobRequirements::JobRequirements(std::istream& buffer)
     }
 }
 
+//------------------------------------------------------------------------------
+void JobRequirements::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.writeUInt8( static_cast<boost::uint8_t>(this->sourceType()) );
+  buffer.writeUInt8( static_cast<boost::uint8_t>(this->formatType()) );
+  buffer.writeString( this->meshTypes().inputType() );
+  buffer.writeString( this->meshTypes().outputType() );
+  buffer.writeString( this->workerName() );
+  buffer.writeString( this->tag() );
+  buffer.writeBlob( this->requirements(), this->requirementsSize() );
+}
+
+//------------------------------------------------------------------------------
+JobRequirements::JobRequirements(remus::internal::BinaryReader& buffer)
+{
+  const int stype = buffer.readUInt8();
+  const int ftype = buffer.readUInt8();
+  this->SourceType = static_cast<remus::common::ContentSource::Type>(stype);
+  this->FormatType = static_cast<remus::common::ContentFormat::Type>(ftype);
+
+  const std::string inputType = buffer.readString();
+  const std::string outputType = buffer.readString();
+  this->MeshType = remus::common::MeshIOType(inputType,outputType);
+
+  this->WorkerName = buffer.readString();
+  this->Tag = buffer.readString();
+
+  std::size_t contentsSize=0;
+  const char* contents = buffer.readBlob(contentsSize);
+  if( contentsSize == 0 || contents == NULL)
+    { //make_shared is significantly faster than using manual new
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                    static_cast<char*>(NULL),std::size_t(0));
+    }
+  else
+    { //the reader doesn't own the buffer, so we need our own copy
+    boost::shared_array<char> storage( new char[contentsSize] );
+    std::copy(contents, contents+contentsSize, storage.get());
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                                storage, contentsSize);
+    }
+}
+
 //------------------------------------------------------------------------------
 std::string to_string(const remus::proto::JobRequirements& reqs)
 {
@@ -261,9 +306,41 @@ std::string to_string(const remus::proto::JobRequirements& reqs)
   return buffer.str();
 }
 
+//------------------------------------------------------------------------------
+std::string to_string(const remus::proto::JobRequirements& reqs,
+                      remus::proto::WireFormat::Type format)
+{
+  if(format == remus::proto::WireFormat::Text)
+    {
+    return to_string(reqs);
+    }
+
+  //first pass computes the size so the second pass doesn't reallocate
+  remus::internal::BinaryWriter counter(remus::internal::BinaryWriter::CountOnly);
+  counter.writeHeader(remus::internal::binary::TypeTag::Requirements);
+  counter << reqs;
+
+  remus::internal::BinaryWriter buffer;
+  buffer.reserve(counter.size());
+  buffer.writeHeader(remus::internal::binary::TypeTag::Requirements);
+  buffer << reqs;
+  return buffer.release();
+}
+
 //------------------------------------------------------------------------------
 remus::proto::JobRequirements to_JobRequirements(const char* data, std::size_t size)
 {
+  if(remus::internal::isBinaryWireFormat(data,size))
+    {
+    remus::internal::BinaryReader reader(data,size);
+    remus::proto::JobRequirements reqs;
+    if(reader.readHeader(remus::internal::binary::TypeTag::Requirements))
+      {
+      reader >> reqs;
+      }
+    return reader.valid() ? reqs : remus::proto::JobRequirements();
+    }
+
   std::stringstream buffer;
   remus::internal::writeString(buffer, data, size);
   remus::proto::JobRequirements reqs;
@@ -18,6 +18,8 @@
 #include <remus/common/FileHandle.h>
 #include <remus/common/MeshIOType.h>
 
+#include <remus/proto/WireFormat.h>
+
 //for export symbols
 #include <remus/proto/ProtoExports.h>
 #include <remus/common/CompilerInformation.h>
@@ -121,6 +123,14 @@ public:
                                   JobRequirements &reqs)
     { reqs = JobRequirements(is); return is; }
 
+  friend remus::internal::BinaryWriter& operator<<(
+                  remus::internal::BinaryWriter &bw, const JobRequirements &reqs)
+    { reqs.serialize(bw); return bw; }
+
+  friend remus::internal::BinaryReader& operator>>(
+                  remus::internal::BinaryReader &br, JobRequirements &reqs)
+    { reqs = JobRequirements(br); return br; }
+
 private:
   //The worker needs to be a friend to send lightweight representations
   //of the full requirements to the server. This is the easiest way to do so.
@@ -129,9 +139,11 @@ private:
 
   //serialize function
   void serialize(std::ostream& buffer) const;
+  void serialize(remus::internal::BinaryWriter& buffer) const;
 
   //deserialize constructor function
   explicit JobRequirements(std::istream& buffer);
+  explicit JobRequirements(remus::internal::BinaryReader& buffer);
 
   remus::common::ContentSource::Type SourceType;
   remus::common::ContentFormat::Type FormatType;
@@ -225,6 +237,13 @@ REMUSPROTO_EXPORT
 std::string to_string(const remus::proto::JobRequirements& reqs);
 
 //------------------------------------------------------------------------------
+//encode the requirements using the requested wire format
+REMUSPROTO_EXPORT
+std::string to_string(const remus::proto::JobRequirements& reqs,
+                      remus::proto::WireFormat::Type format);
+
+//------------------------------------------------------------------------------
+//decodes both the text and binary wire formats
 REMUSPROTO_EXPORT
 remus::proto::JobRequirements to_JobRequirements(const char* data, std::size_t size);
 
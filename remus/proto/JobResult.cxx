@@ -11,19 +11,25 @@
 //=============================================================================
 
 #include <remus/proto/JobResult.h>
+#include <remus/proto/FrameSet.h>
 
 #include <remus/common/CompilerInformation.h>
 #include <remus/common/ConditionalStorage.h>
+#include <remus/common/Compression.h>
 #include <remus/common/MD5Hash.h>
 #include <remus/common/ConversionHelper.h>
+#include <remus/common/BinaryConversionHelper.h>
 
 //suppress warnings inside boost headers for gcc, clang and MSVC
 REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/make_shared.hpp>
+#include <boost/uuid/nil_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <algorithm>
+#include <mutex>
+#include <new>
 #include <sstream>
 
 namespace remus {
@@ -36,7 +42,14 @@ struct JobResult::InternalImpl
   explicit InternalImpl(const T& t):
     Size(0),
     Data(NULL),
-    Storage()
+    Storage(),
+    Owner(),
+    Compressed(),
+    CompressedData(NULL),
+    CompressedSize(0),
+    Codec(remus::common::ContentCompression::None),
+    NeedsInflate(false),
+    Corrupt(false)
   {
     remus::common::ConditionalStorage temp(t);
     this->Storage.swap(temp);
@@ -47,14 +60,28 @@ struct JobResult::InternalImpl
   InternalImpl(const char* d, std::size_t s):
     Size(s),
     Data(d),
-    Storage()
+    Storage(),
+    Owner(),
+    Compressed(),
+    CompressedData(NULL),
+    CompressedSize(0),
+    Codec(remus::common::ContentCompression::None),
+    NeedsInflate(false),
+    Corrupt(false)
   {
   }
 
   InternalImpl(const boost::shared_array<char> d, std::size_t s):
     Size(s),
     Data(NULL),
-    Storage()
+    Storage(),
+    Owner(),
+    Compressed(),
+    CompressedData(NULL),
+    CompressedSize(0),
+    Codec(remus::common::ContentCompression::None),
+    NeedsInflate(false),
+    Corrupt(false)
   {
     remus::common::ConditionalStorage temp(d,s);
     this->Storage.swap(temp);
@@ -62,25 +89,148 @@ struct JobResult::InternalImpl
     this->Data = this->Storage.data();
   }
 
-  std::size_t size() const { return Size; }
-  const char* data() const { return Data; }
+  //reference data that lives inside a buffer owned by someone else, for
+  //example a received zmq frame. We hold onto the owner so the buffer
+  //stays alive for as long as we point into it.
+  InternalImpl(const boost::shared_ptr<const char>& owner,
+               const char* d, std::size_t s):
+    Size(s),
+    Data(d),
+    Storage(),
+    Owner(owner),
+    Compressed(),
+    CompressedData(NULL),
+    CompressedSize(0),
+    Codec(remus::common::ContentCompression::None),
+    NeedsInflate(false),
+    Corrupt(false)
+  {
+  }
+
+  //hold data that was received compressed. We keep the compressed data so
+  //that it can be sent on without being compressed again, and without an
+  //owner we need our own copy of it. The data is only decompressed the
+  //first time it is asked for, so a process that just passes the data on
+  //never pays for it. When the data doesn't decompress it is empty.
+  InternalImpl(remus::common::ContentCompression::Type codec,
+               const boost::shared_ptr<const char>& owner,
+               const char* compressed, std::size_t compressedSize,
+               std::size_t s):
+    Size(s),
+    Data(NULL),
+    Storage(),
+    Owner(owner),
+    Compressed(),
+    CompressedData(compressed),
+    CompressedSize(compressedSize),
+    Codec(codec),
+    NeedsInflate(true),
+    Corrupt(false)
+  {
+    if(!owner)
+      {
+      this->Compressed.assign(compressed, compressedSize);
+      this->CompressedData = this->Compressed.data();
+      }
+  }
+
+  std::size_t size() const
+    { this->inflate(); return this->Corrupt ? 0 : this->Size; }
+
+  const char* data() const { this->inflate(); return this->Data; }
+
+  //the size of the data without decompressing it
+  std::size_t storedSize() const { return this->Size; }
+
+  //returns the data compressed with the codec, or NULL when the data
+  //should be sent as is. The data is only compressed once, and data that
+  //was received compressed with the codec is returned as it was received.
+  const char* compressed(remus::common::ContentCompression::Type codec,
+                         std::size_t threshold, std::size_t& compressedSize)
+  {
+    if(codec == remus::common::ContentCompression::None ||
+       this->storedSize() == 0 || this->storedSize() < threshold)
+      {
+      return NULL;
+      }
+
+    if(this->Codec != codec)
+      { //remember when the data doesn't compress, so we don't try again
+      std::string result;
+      remus::common::compressContent(codec, this->data(), this->size(), result);
+      this->Compressed.swap(result);
+      this->CompressedData = this->Compressed.empty() ? NULL :
+                                                this->Compressed.data();
+      this->CompressedSize = this->Compressed.size();
+      this->Codec = codec;
+      }
+    compressedSize = this->CompressedSize;
+    return this->CompressedData;
+  }
 
 private:
+  void inflate() const
+  {
+    if(this->NeedsInflate)
+      {
+      std::call_once(this->Inflated, [this]() { this->decompress(); });
+      }
+  }
+
+  void decompress() const
+  {
+    //the size comes off the wire, so don't throw when we can't allocate it
+    boost::shared_array<char> space( new (std::nothrow) char[this->Size] );
+    if(space && remus::common::decompressContent(this->Codec,
+                                                 this->CompressedData,
+                                                 this->CompressedSize,
+                                                 space.get(), this->Size))
+      {
+      remus::common::ConditionalStorage temp(space, this->Size);
+      this->Storage.swap(temp);
+      this->Data = this->Storage.data();
+      }
+    else
+      { //the data is corrupt, or too large to hold in memory
+      this->Corrupt = true;
+      }
+  }
 
   //store the size of the data being held
   std::size_t Size;
 
-  //points to the zero copy or data in the conditional storage
-  const char* Data;
+  //points to the zero copy or data in the conditional storage, both are
+  //only set after construction by decompress
+  mutable const char* Data;
 
   //Storage is an optional allocation that is used when we need to copy data
-  remus::common::ConditionalStorage Storage;
+  mutable remus::common::ConditionalStorage Storage;
+
+  //Owner is an optional reference to the buffer that Data points into
+  boost::shared_ptr<const char> Owner;
+
+  //the data compressed with Codec. Either we compressed it the first time
+  //it was sent compressed, or it was received compressed. Compressed holds
+  //our own copy, otherwise CompressedData points into the buffer held by
+  //Owner.
+  std::string Compressed;
+  const char* CompressedData;
+  std::size_t CompressedSize;
+  remus::common::ContentCompression::Type Codec;
+
+  //set when the data still has to be decompressed, which happens once
+  //the first time the data or its size is asked for
+  bool NeedsInflate;
+  mutable std::once_flag Inflated;
+  mutable bool Corrupt;
 };
 
 //------------------------------------------------------------------------------
 JobResult::JobResult(const boost::uuids::uuid& jid):
   JobId(jid),
   FormatType(),
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold),
   Implementation( boost::make_shared<InternalImpl>(
                  static_cast<char*>(NULL),std::size_t(0)) )
   //make_shared is significantly faster than using manual new
@@ -93,6 +243,8 @@ JobResult::JobResult(const boost::uuids::uuid& jid,
             const remus::common::FileHandle& fileHandle):
   JobId(jid),
   FormatType(format),
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold),
   Implementation( boost::make_shared<InternalImpl>(fileHandle) )
   //make_shared is significantly faster than using manual new
 {
@@ -105,6 +257,8 @@ JobResult::JobResult(const boost::uuids::uuid& jid,
             const std::string& contents):
   JobId(jid),
   FormatType(format),
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold),
   Implementation( boost::make_shared<InternalImpl>(contents) )
   //make_shared is significantly faster than using manual new
 {
@@ -117,6 +271,8 @@ JobResult::JobResult(const boost::uuids::uuid& jid,
             std::size_t size):
   JobId(jid),
   FormatType(format),
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold),
   Implementation( boost::make_shared<InternalImpl>(contents,size) )
   //make_shared is significantly faster than using manual new
 {
@@ -130,6 +286,8 @@ JobResult& JobResult::operator=(JobResult&& other)
   {
     this->JobId = other.JobId;
     this->FormatType = other.FormatType;
+    this->Compression = other.Compression;
+    this->CompressionThreshold = other.CompressionThreshold;
 
     this->Implementation = other.Implementation;
     other.Implementation.reset();
@@ -173,6 +331,8 @@ void JobResult::serialize(std::ostream& buffer) const
 { //note don't use std::endl as it flushes stream and decrease performance
   buffer << this->id() << '\n';
   buffer << this->formatType() << '\n';
+
+  //the text format is never compressed
   buffer << this->Implementation->size() << '\n';
   remus::internal::writeString( buffer,
                                 this->Implementation->data(),
@@ -180,7 +340,9 @@ void JobResult::serialize(std::ostream& buffer) const
 }
 
 //------------------------------------------------------------------------------
-JobResult::JobResult(std::istream& buffer)
+JobResult::JobResult(std::istream& buffer):
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold)
 {
   int ftype=0;
   std::size_t contentsSize=0;
@@ -213,6 +375,100 @@ JobResult::JobResult(std::istream& buffer)
     }
 }
 
+//------------------------------------------------------------------------------
+void JobResult::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  namespace binary = remus::internal::binary;
+  std::size_t compressedSize = 0;
+  const char* compressed = this->Implementation->compressed(
+                this->Compression, this->CompressionThreshold, compressedSize);
+
+  buffer.writeBytes( reinterpret_cast<const char*>(this->JobId.data),
+                     this->JobId.size() );
+  if(compressed)
+    {
+    buffer.writeUInt8( static_cast<boost::uint8_t>(this->formatType()) |
+                       binary::CompressedFlag );
+    buffer.writeUInt8( static_cast<boost::uint8_t>(this->Compression) );
+    buffer.writeUInt64( this->Implementation->storedSize() );
+    buffer.writeBlob( compressed, compressedSize );
+    }
+  else
+    {
+    buffer.writeUInt8( static_cast<boost::uint8_t>(this->formatType()) );
+    const char* contents = this->Implementation->data();
+    buffer.writeBlob( contents, this->Implementation->size() );
+    }
+}
+
+//------------------------------------------------------------------------------
+JobResult::JobResult(remus::internal::BinaryReader& buffer):
+  JobId(),
+  FormatType(),
+  Compression(remus::common::ContentCompression::None),
+  CompressionThreshold(remus::common::DefaultCompressionThreshold)
+{
+  namespace binary = remus::internal::binary;
+  const char* id = buffer.readBytes(this->JobId.size());
+  if(id != NULL)
+    {
+    std::copy(id, id+this->JobId.size(), this->JobId.data);
+    }
+  else
+    {
+    this->JobId = boost::uuids::nil_uuid();
+    }
+
+  const int ftype = buffer.readUInt8();
+  this->FormatType = static_cast<remus::common::ContentFormat::Type>(
+                                              ftype & ~binary::CompressedFlag);
+
+  //compressed results keep their codec, so that they are sent on without
+  //being compressed again
+  const bool isCompressed = (ftype & binary::CompressedFlag) != 0;
+  boost::uint64_t uncompressedSize = 0;
+  if(isCompressed)
+    {
+    this->Compression = static_cast<remus::common::ContentCompression::Type>(
+                                                        buffer.readUInt8());
+    this->CompressionThreshold = 0;
+    uncompressedSize = buffer.readUInt64();
+    }
+
+  std::size_t contentsSize=0;
+  const char* contents = buffer.readBlob(contentsSize);
+  if(isCompressed &&
+     !remus::common::validCompressedSize(this->Compression, contentsSize,
+                                         uncompressedSize))
+    { //corrupt, or compressed with a codec remus doesn't know
+    buffer.invalidate();
+    }
+
+  if( contentsSize == 0 || contents == NULL || !buffer.valid())
+    { //make_shared is significantly faster than using manual new
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                    static_cast<char*>(NULL),std::size_t(0));
+    }
+  else if(isCompressed)
+    { //make_shared is significantly faster than using manual new
+    this->Implementation = boost::make_shared<InternalImpl>(
+                      this->Compression, buffer.owner(), contents,
+                      contentsSize, static_cast<std::size_t>(uncompressedSize));
+    }
+  else if(buffer.owner())
+    { //point straight into the buffer we are reading from, no copy needed
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                  buffer.owner(), contents, contentsSize);
+    }
+  else
+    { //the reader doesn't own the buffer, so we need our own copy
+    boost::shared_array<char> storage( new char[contentsSize] );
+    std::copy(contents, contents+contentsSize, storage.get());
+    this->Implementation = boost::make_shared<InternalImpl>(
+                                                storage, contentsSize);
+    }
+}
+
 //------------------------------------------------------------------------------
 std::string to_string(const remus::proto::JobResult& result)
 {
@@ -221,15 +477,121 @@ std::string to_string(const remus::proto::JobResult& result)
   return buffer.str();
 }
 
+//------------------------------------------------------------------------------
+std::string to_string(const remus::proto::JobResult& result,
+                      remus::proto::WireFormat::Type format)
+{
+  if(format == remus::proto::WireFormat::Text)
+    {
+    return to_string(result);
+    }
+
+  //first pass computes the size so the second pass doesn't reallocate
+  remus::internal::BinaryWriter counter(remus::internal::BinaryWriter::CountOnly);
+  counter.writeHeader(remus::internal::binary::TypeTag::Result);
+  counter << result;
+
+  remus::internal::BinaryWriter buffer;
+  buffer.reserve(counter.size());
+  buffer.writeHeader(remus::internal::binary::TypeTag::Result);
+  buffer << result;
+  return buffer.release();
+}
+
 //------------------------------------------------------------------------------
 remus::proto::JobResult to_JobResult(const char* data, std::size_t size)
 {
+  if(remus::internal::isBinaryWireFormat(data,size))
+    {
+    remus::internal::BinaryReader reader(data,size);
+    if(reader.readHeader(remus::internal::binary::TypeTag::Result))
+      {
+      remus::proto::JobResult res(reader);
+      if(reader.valid())
+        {
+        return res;
+        }
+      }
+    return remus::proto::JobResult(boost::uuids::nil_uuid());
+    }
+
   std::stringstream buffer;
   remus::internal::writeString(buffer, data, size);
   remus::proto::JobResult res(buffer);
   return res;
 }
 
+//------------------------------------------------------------------------------
+remus::proto::JobResult to_JobResult(const boost::shared_ptr<const char>& data,
+                                     std::size_t size)
+{
+  if(!remus::internal::isBinaryWireFormat(data.get(),size))
+    {
+    return to_JobResult(data.get(),size);
+    }
+
+  remus::internal::BinaryReader reader(data,size);
+  if(reader.readHeader(remus::internal::binary::TypeTag::Result))
+    {
+    remus::proto::JobResult res(reader);
+    if(reader.valid())
+      {
+      return res;
+      }
+    }
+  return remus::proto::JobResult(boost::uuids::nil_uuid());
+}
+
+//------------------------------------------------------------------------------
+FrameSet to_FrameSet(const remus::proto::JobResult& result)
+{
+  //the blob frame points into the data of this copy
+  boost::shared_ptr<remus::proto::JobResult> keepAlive =
+                          boost::make_shared<remus::proto::JobResult>(result);
+
+  FrameSet frames;
+  remus::internal::BinaryWriter buffer;
+  buffer.externalizeBlobs(&frames.Blobs);
+  buffer.writeHeader(remus::internal::binary::TypeTag::Result);
+  buffer << *keepAlive;
+
+  std::string header = buffer.release();
+  frames.Header = detail::make_HeaderFrame(header);
+  detail::share_Ownership(frames.Blobs, keepAlive);
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+FrameSet to_FrameSet(const remus::proto::JobResult& result,
+                     remus::proto::WireFormat::Type format)
+{
+  if(format == remus::proto::WireFormat::Binary)
+    {
+    return to_FrameSet(result);
+    }
+
+  std::string header = to_string(result, format);
+  FrameSet frames;
+  frames.Header = detail::make_HeaderFrame(header);
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobResult to_JobResult(const FrameSet& frames)
+{
+  if(frames.Blobs.empty())
+    {
+    return to_JobResult(frames.Header.Data, frames.Header.size());
+    }
+
+  remus::internal::BinaryReader reader(frames.Header, frames.Blobs);
+  remus::proto::JobResult res(boost::uuids::nil_uuid());
+  if(reader.readHeader(remus::internal::binary::TypeTag::Result))
+    {
+    reader >> res;
+    }
+  return reader.valid() ? res : remus::proto::JobResult(boost::uuids::nil_uuid());
+}
 
 }
 }
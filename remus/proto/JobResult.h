@@ -22,10 +22,13 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/uuid/uuid.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
-//for ContentFormat and ContentSource
+//for ContentFormat, ContentSource and ContentCompression
+#include <remus/common/Compression.h>
 #include <remus/common/ContentTypes.h>
 #include <remus/common/FileHandle.h>
 
+#include <remus/proto/WireFormat.h>
+
 //included for export symbols
 #include <remus/proto/ProtoExports.h>
 
@@ -83,9 +86,28 @@ public:
 
   const boost::uuids::uuid& id() const { return JobId; }
 
+  //results that were received compressed are decompressed the first time
+  //the data, its size, or valid() is asked for. Results that don't
+  //decompress become invalid then, and results whose sizes don't fit the
+  //codec, or use a codec remus wasn't built with, are read as invalid.
   const char* data() const;
   std::size_t dataSize() const;
 
+  //compress the data with the codec when the result is encoded with the
+  //binary wire format and holds at least threshold bytes. The data is sent
+  //as is when remus was built without the codec or the data doesn't
+  //compress. Results received compressed keep their codec, so the server
+  //sends them on to the client without compressing them again. The
+  //compressed data is cached the first time the result is sent, so a result
+  //shared between threads must not be sent from more than one at a time.
+  void compress(remus::common::ContentCompression::Type codec,
+                std::size_t threshold =
+                              remus::common::DefaultCompressionThreshold)
+    { this->Compression = codec; this->CompressionThreshold = threshold; }
+
+  remus::common::ContentCompression::Type compression() const
+    { return this->Compression; }
+
 
   //implement a less than operator and equal operator so you
   //can use the class in containers and algorithms
@@ -101,16 +123,29 @@ public:
                                   JobResult &submission)
     { submission = JobResult(is); return is; }
 
+  friend remus::internal::BinaryWriter& operator<<(
+                  remus::internal::BinaryWriter &bw, const JobResult &result)
+    { result.serialize(bw); return bw; }
+
+  friend remus::internal::BinaryReader& operator>>(
+                  remus::internal::BinaryReader &br, JobResult &result)
+    { result = JobResult(br); return br; }
+
 private:
   friend REMUSPROTO_EXPORT remus::proto::JobResult to_JobResult(const char* data, std::size_t size);
+  friend REMUSPROTO_EXPORT remus::proto::JobResult to_JobResult(const boost::shared_ptr<const char>& data, std::size_t size);
   //serialize function
   void serialize(std::ostream& buffer) const;
+  void serialize(remus::internal::BinaryWriter& buffer) const;
 
   //deserialize constructor function
   explicit JobResult(std::istream& buffer);
+  explicit JobResult(remus::internal::BinaryReader& buffer);
 
   boost::uuids::uuid JobId;
   remus::common::ContentFormat::Type FormatType;
+  remus::common::ContentCompression::Type Compression;
+  std::size_t CompressionThreshold;
 
   struct InternalImpl;
   boost::shared_ptr<InternalImpl> Implementation;
@@ -137,9 +172,24 @@ REMUSPROTO_EXPORT
 std::string to_string(const remus::proto::JobResult& result);
 
 //------------------------------------------------------------------------------
+//encode the result using the requested wire format
+REMUSPROTO_EXPORT
+std::string to_string(const remus::proto::JobResult& result,
+                      remus::proto::WireFormat::Type format);
+
+//------------------------------------------------------------------------------
+//decodes both the text and binary wire formats
 REMUSPROTO_EXPORT
 remus::proto::JobResult to_JobResult(const char* data, std::size_t size);
 
+//------------------------------------------------------------------------------
+//decode without copying the blobs out of data, instead the result holds
+//a reference to data and points into it. Only the binary wire format can
+//be decoded without a copy, the text format falls back to copying.
+REMUSPROTO_EXPORT
+remus::proto::JobResult to_JobResult(const boost::shared_ptr<const char>& data,
+                                     std::size_t size);
+
 //------------------------------------------------------------------------------
 inline remus::proto::JobResult to_JobResult(const std::string& msg)
 {
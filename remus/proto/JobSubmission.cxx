@@ -11,8 +11,14 @@
 //=============================================================================
 
 #include <remus/proto/JobSubmission.h>
+#include <remus/proto/FrameSet.h>
 
 #include <remus/common/ConversionHelper.h>
+#include <remus/common/BinaryConversionHelper.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/make_shared.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <algorithm>
 #include <sstream>
@@ -120,6 +126,42 @@ JobSubmission::JobSubmission(std::istream& buffer)
     }
 }
 
+//------------------------------------------------------------------------------
+void JobSubmission::serialize(remus::internal::BinaryWriter& buffer) const
+{
+  buffer.writeString( this->MeshType.inputType() );
+  buffer.writeString( this->MeshType.outputType() );
+  buffer << this->Requirements;
+  buffer.writeUInt32( static_cast<boost::uint32_t>(this->Content.size()) );
+  for(JobSubmission::const_iterator i = this->begin();
+      i != this->end();
+      ++i)
+    {
+    buffer.writeString( i->first );
+    buffer << i->second;
+    }
+}
+
+//------------------------------------------------------------------------------
+JobSubmission::JobSubmission(remus::internal::BinaryReader& buffer)
+{
+  const std::string inputType = buffer.readString();
+  const std::string outputType = buffer.readString();
+  this->MeshType = remus::common::MeshIOType(inputType,outputType);
+
+  buffer >> this->Requirements;
+
+  const std::size_t contentSize = buffer.readUInt32();
+  for(std::size_t i = 0; i < contentSize && buffer.valid(); ++i)
+    {
+    std::string key = buffer.readString();
+
+    JobContent value;
+    buffer >> value;
+    this->Content[key]=value;
+    }
+}
+
 //------------------------------------------------------------------------------
 std::string to_string(const remus::proto::JobSubmission& sub)
 {
@@ -128,9 +170,41 @@ std::string to_string(const remus::proto::JobSubmission& sub)
   return buffer.str();
 }
 
+//------------------------------------------------------------------------------
+std::string to_string(const remus::proto::JobSubmission& sub,
+                      remus::proto::WireFormat::Type format)
+{
+  if(format == remus::proto::WireFormat::Text)
+    {
+    return to_string(sub);
+    }
+
+  //first pass computes the size so the second pass doesn't reallocate
+  remus::internal::BinaryWriter counter(remus::internal::BinaryWriter::CountOnly);
+  counter.writeHeader(remus::internal::binary::TypeTag::Submission);
+  counter << sub;
+
+  remus::internal::BinaryWriter buffer;
+  buffer.reserve(counter.size());
+  buffer.writeHeader(remus::internal::binary::TypeTag::Submission);
+  buffer << sub;
+  return buffer.release();
+}
+
 //------------------------------------------------------------------------------
 remus::proto::JobSubmission to_JobSubmission(const char* data, std::size_t size)
 {
+  if(remus::internal::isBinaryWireFormat(data,size))
+    {
+    remus::internal::BinaryReader reader(data,size);
+    remus::proto::JobSubmission sub;
+    if(reader.readHeader(remus::internal::binary::TypeTag::Submission))
+      {
+      reader >> sub;
+      }
+    return reader.valid() ? sub : remus::proto::JobSubmission();
+    }
+
   std::stringstream buffer;
   remus::internal::writeString(buffer, data, size);
   remus::proto::JobSubmission sub;
@@ -138,7 +212,96 @@ remus::proto::JobSubmission to_JobSubmission(const char* data, std::size_t size)
   return sub;
 }
 
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission to_JobSubmission(
+                                const boost::shared_ptr<const char>& data,
+                                std::size_t size)
+{
+  if(!remus::internal::isBinaryWireFormat(data.get(),size))
+    {
+    return to_JobSubmission(data.get(),size);
+    }
+
+  remus::internal::BinaryReader reader(data,size);
+  remus::proto::JobSubmission sub;
+  if(reader.readHeader(remus::internal::binary::TypeTag::Submission))
+    {
+    reader >> sub;
+    }
+  return reader.valid() ? sub : remus::proto::JobSubmission();
+}
+
+//------------------------------------------------------------------------------
+FrameSet to_FrameSet(const remus::proto::JobSubmission& sub)
+{
+  //the blob frames point into the contents of this copy
+  boost::shared_ptr<remus::proto::JobSubmission> keepAlive =
+                          boost::make_shared<remus::proto::JobSubmission>(sub);
 
+  FrameSet frames;
+  remus::internal::BinaryWriter buffer;
+  buffer.externalizeBlobs(&frames.Blobs);
+  buffer.writeHeader(remus::internal::binary::TypeTag::Submission);
+  buffer << *keepAlive;
+
+  std::string header = buffer.release();
+  frames.Header = detail::make_HeaderFrame(header);
+  detail::share_Ownership(frames.Blobs, keepAlive);
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+FrameSet to_FrameSet(const remus::proto::JobSubmission& sub,
+                     remus::proto::WireFormat::Type format)
+{
+  if(format == remus::proto::WireFormat::Binary)
+    {
+    return to_FrameSet(sub);
+    }
+
+  std::string header = to_string(sub, format);
+  FrameSet frames;
+  frames.Header = detail::make_HeaderFrame(header);
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission to_JobSubmission(const FrameSet& frames)
+{
+  if(frames.Blobs.empty())
+    {
+    return to_JobSubmission(frames.Header.Data, frames.Header.size());
+    }
+
+  remus::internal::BinaryReader reader(frames.Header, frames.Blobs);
+  remus::proto::JobSubmission sub;
+  if(reader.readHeader(remus::internal::binary::TypeTag::Submission))
+    {
+    reader >> sub;
+    }
+  return reader.valid() ? sub : remus::proto::JobSubmission();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirements to_JobRequirements(const FrameSet& submission)
+{
+  if(submission.Blobs.empty())
+    { //a single frame doesn't allow us to skip the contents
+    return to_JobSubmission(submission).requirements();
+    }
+
+  //the requirements are the first blob, so we stop reading before
+  //we reach the contents
+  remus::internal::BinaryReader reader(submission.Header, submission.Blobs);
+  remus::proto::JobRequirements reqs;
+  if(reader.readHeader(remus::internal::binary::TypeTag::Submission))
+    {
+    reader.readString(); //input type
+    reader.readString(); //output type
+    reader >> reqs;
+    }
+  return reader.valid() ? reqs : remus::proto::JobRequirements();
+}
 
 }
 }
@@ -104,15 +104,27 @@ public:
                                   JobSubmission &submission)
     { submission = JobSubmission(is); return is; }
 
+  friend remus::internal::BinaryWriter& operator<<(
+                  remus::internal::BinaryWriter &bw,
+                  const JobSubmission &submission)
+    { submission.serialize(bw); return bw; }
+
+  friend remus::internal::BinaryReader& operator>>(
+                  remus::internal::BinaryReader &br,
+                  JobSubmission &submission)
+    { submission = JobSubmission(br); return br; }
+
 protected:
   //these need to protected so we can have derived job submission classes
   //that enforce a given set of keys.
 
   //serialize function
   void serialize(std::ostream& buffer) const;
+  void serialize(remus::internal::BinaryWriter& buffer) const;
 
   //deserialize constructor function
   explicit JobSubmission(std::istream& buffer);
+  explicit JobSubmission(remus::internal::BinaryReader& buffer);
 
 private:
   remus::common::MeshIOType MeshType;
@@ -127,9 +139,24 @@ REMUSPROTO_EXPORT
 std::string to_string(const remus::proto::JobSubmission& sub);
 
 //------------------------------------------------------------------------------
+//encode the submission using the requested wire format
+REMUSPROTO_EXPORT
+std::string to_string(const remus::proto::JobSubmission& sub,
+                      remus::proto::WireFormat::Type format);
+
+//------------------------------------------------------------------------------
+//decodes both the text and binary wire formats
 REMUSPROTO_EXPORT
 remus::proto::JobSubmission to_JobSubmission(const char* data, std::size_t size);
 
+//------------------------------------------------------------------------------
+//decode without copying the blobs out of data, instead the result holds
+//a reference to data and points into it. Only the binary wire format can
+//be decoded without a copy, the text format falls back to copying.
+REMUSPROTO_EXPORT
+remus::proto::JobSubmission to_JobSubmission(const boost::shared_ptr<const char>& data,
+                                     std::size_t size);
+
 //------------------------------------------------------------------------------
 inline remus::proto::JobSubmission to_JobSubmission(const std::string& msg)
 {
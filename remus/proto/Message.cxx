@@ -20,6 +20,145 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <cstring>
+#include <sstream>
+
+namespace
+{
+//In binary mode the mesh type frame is a NUL marker followed by the
+//interned ids of the input and output types as 16bit little endian
+//integers. Types that aren't default mesh types have no id that is the
+//same in every process, so their names follow the ids, each as a 32bit
+//little endian length and the bytes of the name. The text encoding starts
+//with a digit, so the two can't be confused.
+static const std::size_t InternedMeshTypeSize = 5;
+
+//------------------------------------------------------------------------------
+void append_UInt(std::string& buffer, boost::uint32_t value, int bytes)
+{
+  for(int i=0; i < bytes; ++i)
+    {
+    buffer.push_back(static_cast<char>((value >> (8*i)) & 0xFF));
+    }
+}
+
+//------------------------------------------------------------------------------
+bool read_UInt(const unsigned char* bytes, std::size_t size,
+               std::size_t& pos, int count, boost::uint32_t& value)
+{
+  if(size - pos < static_cast<std::size_t>(count))
+    {
+    return false;
+    }
+  value = 0;
+  for(int i=0; i < count; ++i)
+    {
+    value |= static_cast<boost::uint32_t>(bytes[pos+i]) << (8*i);
+    }
+  pos += count;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool read_Name(const unsigned char* bytes, std::size_t size,
+               std::size_t& pos, boost::uint32_t id, std::string& name)
+{
+  typedef remus::common::MeshRegistrar Registrar;
+  if(id != Registrar::DynamicId)
+    {
+    name = *Registrar::intern(id).Name;
+    return true;
+    }
+
+  boost::uint32_t length = 0;
+  if(!read_UInt(bytes,size,pos,4,length) || size - pos < length)
+    {
+    return false;
+    }
+  name.assign(reinterpret_cast<const char*>(bytes+pos), length);
+  pos += length;
+  return !name.empty();
+}
+
+//------------------------------------------------------------------------------
+void encode_MeshIOType(const remus::common::MeshIOType& mtype,
+                       remus::proto::WireFormat::Type format,
+                       zmq::message_t& frame)
+{
+  typedef remus::common::MeshRegistrar Registrar;
+  std::string bufferData;
+  if(format == remus::proto::WireFormat::Binary)
+    {
+    bufferData.reserve(InternedMeshTypeSize);
+    bufferData.push_back('\0');
+    append_UInt(bufferData,mtype.inputId(),2);
+    append_UInt(bufferData,mtype.outputId(),2);
+    if(mtype.inputId() == Registrar::DynamicId)
+      {
+      append_UInt(bufferData,
+                  static_cast<boost::uint32_t>(mtype.inputType().size()),4);
+      bufferData.append(mtype.inputType());
+      }
+    if(mtype.outputId() == Registrar::DynamicId)
+      {
+      append_UInt(bufferData,
+                  static_cast<boost::uint32_t>(mtype.outputType().size()),4);
+      bufferData.append(mtype.outputType());
+      }
+    }
+  else
+    {
+    //servers that only know the text protocol expect the type by name
+    std::ostringstream buffer;
+    buffer << mtype;
+    bufferData = buffer.str();
+    }
+  frame.rebuild(bufferData.size());
+  std::memcpy(frame.data(),bufferData.data(),bufferData.size());
+}
+
+//------------------------------------------------------------------------------
+remus::proto::WireFormat::Type format_MeshIOType(zmq::message_t& frame)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(frame.data());
+  return (frame.size() >= InternedMeshTypeSize && bytes[0] == 0) ?
+          remus::proto::WireFormat::Binary : remus::proto::WireFormat::Text;
+}
+
+//------------------------------------------------------------------------------
+remus::common::MeshIOType decode_MeshIOType(zmq::message_t& frame)
+{
+  typedef remus::common::MeshRegistrar Registrar;
+  const unsigned char* bytes = static_cast<const unsigned char*>(frame.data());
+  const std::size_t size = frame.size();
+  if(format_MeshIOType(frame) == remus::proto::WireFormat::Binary)
+    {
+    std::size_t pos = 1;
+    boost::uint32_t in = 0, out = 0;
+    read_UInt(bytes,size,pos,2,in);
+    read_UInt(bytes,size,pos,2,out);
+    if(Registrar::isStableId(in) && Registrar::isStableId(out))
+      {
+      return (pos == size) ? remus::common::MeshIOType::fromInternedIds(in,out)
+                           : remus::common::MeshIOType();
+      }
+
+    std::string inName, outName;
+    const bool valid = in != Registrar::InvalidId &&
+                       out != Registrar::InvalidId &&
+                       read_Name(bytes,size,pos,in,inName) &&
+                       read_Name(bytes,size,pos,out,outName) &&
+                       pos == size;
+    return valid ? remus::common::MeshIOType(inName,outName)
+                 : remus::common::MeshIOType();
+    }
+
+  std::string bufferData(reinterpret_cast<const char*>(bytes), size);
+  std::istringstream buffer(bufferData);
+  remus::common::MeshIOType mtype;
+  buffer >> mtype;
+  return mtype;
+}
+}
 
 namespace remus{
 namespace proto{
@@ -28,17 +167,29 @@ namespace proto{
 Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
                                 remus::SERVICE_TYPE stype,
                                 const std::string& data,
-                                zmq::socket_t* socket)
+                                zmq::socket_t* socket,
+                                remus::proto::WireFormat::Type format)
+{
+  return Message(mtype,stype,data,socket,Message::NonBlocking,format);
+}
+
+//----------------------------------------------------------------------------
+Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
+                                remus::SERVICE_TYPE stype,
+                                const remus::proto::FrameSet& frames,
+                                zmq::socket_t* socket,
+                                remus::proto::WireFormat::Type format)
 {
-  return Message(mtype,stype,data,socket,Message::NonBlocking);
+  return Message(mtype,stype,frames,socket,Message::NonBlocking,format);
 }
 
 //----------------------------------------------------------------------------
 Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
                                 remus::SERVICE_TYPE stype,
-                                zmq::socket_t* socket)
+                                zmq::socket_t* socket,
+                                remus::proto::WireFormat::Type format)
 {
-  return Message(mtype,stype,socket,Message::NonBlocking);
+  return Message(mtype,stype,socket,Message::NonBlocking,format);
 }
 
 
@@ -46,17 +197,40 @@ Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
 Message send_Message(remus::common::MeshIOType mtype,
                      remus::SERVICE_TYPE stype,
                      const std::string& data,
-                     zmq::socket_t* socket)
+                     zmq::socket_t* socket,
+                     remus::proto::WireFormat::Type format)
 {
-  return Message(mtype,stype,data,socket,Message::Blocking);
+  return Message(mtype,stype,data,socket,Message::Blocking,format);
 }
 
 //----------------------------------------------------------------------------
 Message send_Message(remus::common::MeshIOType mtype,
                      remus::SERVICE_TYPE stype,
-                     zmq::socket_t* socket)
+                     const remus::proto::FrameSet& frames,
+                     zmq::socket_t* socket,
+                     remus::proto::WireFormat::Type format)
+{
+  return Message(mtype,stype,frames,socket,Message::Blocking,format);
+}
+
+//----------------------------------------------------------------------------
+Message send_Message(remus::common::MeshIOType mtype,
+                     remus::SERVICE_TYPE stype,
+                     zmq::socket_t* socket,
+                     remus::proto::WireFormat::Type format)
 {
-  return Message(mtype,stype,socket,Message::Blocking);
+  return Message(mtype,stype,socket,Message::Blocking,format);
+}
+
+//----------------------------------------------------------------------------
+Message send_NonBlockingRequest(const std::string& requestId,
+                                remus::common::MeshIOType mtype,
+                                remus::SERVICE_TYPE stype,
+                                const remus::proto::FrameSet& frames,
+                                zmq::socket_t* socket,
+                                remus::proto::WireFormat::Type format)
+{
+  return Message(requestId,mtype,stype,frames,socket,Message::NonBlocking,format);
 }
 
 //----------------------------------------------------------------------------
@@ -80,11 +254,15 @@ Message::Message(remus::common::MeshIOType mtype,
                  remus::SERVICE_TYPE stype,
                  const std::string& mdata,
                  zmq::socket_t* socket,
-                 Message::SendMode mode):
+                 Message::SendMode mode,
+                 remus::proto::WireFormat::Type format):
   MType(mtype),
   SType(stype),
   Valid(true), //need to be initially valid to be sent
-  Storage( boost::make_shared<zmq::message_t>(mdata.size()) )
+  RequestId(),
+  Format(format),
+  Storage( boost::make_shared<zmq::message_t>(mdata.size()) ),
+  Attachments()
 {
   std::memcpy(Storage->data(),mdata.data(),mdata.size());
 
@@ -94,16 +272,71 @@ Message::Message(remus::common::MeshIOType mtype,
   this->Valid = this->send_impl(socket, mode);
 }
 
+//----------------------------------------------------------------------------
+Message::Message(remus::common::MeshIOType mtype,
+                 remus::SERVICE_TYPE stype,
+                 const remus::proto::FrameSet& frames,
+                 zmq::socket_t* socket,
+                 Message::SendMode mode,
+                 remus::proto::WireFormat::Type format):
+  MType(mtype),
+  SType(stype),
+  Valid(true), //need to be initially valid to be sent
+  RequestId(),
+  Format(format),
+  Storage( detail::to_zmqMessage(frames.Header) ),
+  Attachments()
+{
+  this->Attachments.reserve(frames.Blobs.size());
+  typedef std::vector<remus::proto::Frame>::const_iterator it;
+  for(it i = frames.Blobs.begin(); i != frames.Blobs.end(); ++i)
+    {
+    this->Attachments.push_back( detail::to_zmqMessage(*i) );
+    }
+
+  this->Valid = this->send_impl(socket, mode);
+}
+
+//----------------------------------------------------------------------------
+Message::Message(const std::string& requestId,
+                 remus::common::MeshIOType mtype,
+                 remus::SERVICE_TYPE stype,
+                 const remus::proto::FrameSet& frames,
+                 zmq::socket_t* socket,
+                 Message::SendMode mode,
+                 remus::proto::WireFormat::Type format):
+  MType(mtype),
+  SType(stype),
+  Valid(true), //need to be initially valid to be sent
+  RequestId(requestId),
+  Format(format),
+  Storage( detail::to_zmqMessage(frames.Header) ),
+  Attachments()
+{
+  this->Attachments.reserve(frames.Blobs.size());
+  typedef std::vector<remus::proto::Frame>::const_iterator it;
+  for(it i = frames.Blobs.begin(); i != frames.Blobs.end(); ++i)
+    {
+    this->Attachments.push_back( detail::to_zmqMessage(*i) );
+    }
+
+  this->Valid = this->send_impl(socket, mode);
+}
+
 //----------------------------------------------------------------------------
 //creates a job message with no data
 Message::Message(remus::common::MeshIOType mtype,
                  remus::SERVICE_TYPE stype,
                  zmq::socket_t* socket,
-                 SendMode mode):
+                 SendMode mode,
+                 remus::proto::WireFormat::Type format):
   MType(mtype),
   SType(stype),
   Valid(true), //need to be initially valid to be sent
-  Storage()
+  RequestId(),
+  Format(format),
+  Storage(),
+  Attachments()
 {
   //send_impl wants us to be valid before we are sent, that way it knows
   //that we are in a good state. This allows it to determine if it can forward
@@ -117,19 +350,24 @@ Message::Message(zmq::socket_t* socket):
   MType(),
   SType(),
   Valid(false),
-  Storage( boost::make_shared<zmq::message_t>() )
+  RequestId(),
+  Format(remus::proto::WireFormat::Binary),
+  Storage( boost::make_shared<zmq::message_t>() ),
+  Attachments()
   {
   //we are receiving a multi part message
-  //frame 0: REQ header / attachReqHeader does this
+  //frame 0: REQ header / attachReqHeader does this, holds the request id
   //frame 1: Mesh Type
   //frame 2: Service Type
   //frame 3: Job Data //optional
+  //frame 4+: Job Data Blobs //optional, only when Job Data is sent
   zmq::more_t more;
   size_t more_size = sizeof(more);
   socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
 
   //construct a job message from the socket
-  const bool removedHeader = zmq::removeReqHeader(*socket, ZMQ_DONTWAIT);
+  const bool removedHeader = zmq::removeReqHeader(*socket, this->RequestId,
+                                                  ZMQ_DONTWAIT);
   bool readMeshType = false;
   bool readServiceType = false;
   bool readStorageData = false;
@@ -142,11 +380,8 @@ Message::Message(zmq::socket_t* socket):
     readMeshType = zmq::recv_harder(*socket, &meshIOType, ZMQ_DONTWAIT);
     if(readMeshType)
       {
-      std::string bufferData(reinterpret_cast<const char*>(meshIOType.data()),
-                             meshIOType.size());
-
-      std::istringstream buffer(bufferData);
-      buffer >> this->MType;
+      this->MType = decode_MeshIOType(meshIOType);
+      this->Format = format_MeshIOType(meshIOType);
       }
     }
 
@@ -173,6 +408,20 @@ Message::Message(zmq::socket_t* socket):
                                          this->Storage.get(),
                                          ZMQ_DONTWAIT);
       }
+
+    //any frames after the data are the blobs of a FrameSet
+    socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+    while(readStorageData && more > 0)
+      {
+      boost::shared_ptr<zmq::message_t> blob =
+                                        boost::make_shared<zmq::message_t>();
+      readStorageData = zmq::recv_harder(*socket, blob.get(), ZMQ_DONTWAIT);
+      if(readStorageData)
+        {
+        this->Attachments.push_back(blob);
+        }
+      socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+      }
     }
 
   //see if we have more data. If so we need to say we are invalid
@@ -202,8 +451,12 @@ Message& Message::operator=(Message&& other)
     this->MType = other.MType;
     this->SType = other.SType;
     this->Valid = other.Valid;
+    this->RequestId.swap(other.RequestId);
+    this->Format = other.Format;
     this->Storage = other.Storage;
+    this->Attachments.swap(other.Attachments);
     other.Storage.reset();
+    other.Attachments.clear();
   }
   return *this;
 }
@@ -220,6 +473,33 @@ std::size_t Message::dataSize() const
   return this->Storage ? this->Storage->size() : std::size_t(0);
 }
 
+//------------------------------------------------------------------------------
+boost::shared_ptr<const char> Message::sharedData() const
+{
+  if(!this->Storage)
+    {
+    return boost::shared_ptr<const char>();
+    }
+  //use the aliasing constructor so that the pointer we hand out shares
+  //ownership of the zmq message that holds the data
+  return boost::shared_ptr<const char>(this->Storage,
+                  static_cast<const char*>(this->Storage->data()));
+}
+
+//------------------------------------------------------------------------------
+remus::proto::FrameSet Message::frames() const
+{
+  remus::proto::FrameSet result;
+  result.Header = detail::to_Frame(this->Storage);
+  result.Blobs.reserve(this->Attachments.size());
+  typedef std::vector< boost::shared_ptr<zmq::message_t> >::const_iterator it;
+  for(it i = this->Attachments.begin(); i != this->Attachments.end(); ++i)
+    {
+    result.Blobs.push_back( detail::to_Frame(*i) );
+    }
+  return result;
+}
+
 //------------------------------------------------------------------------------
 bool Message::send_impl(zmq::socket_t *socket, SendMode mode) const
 {
@@ -234,6 +514,7 @@ bool Message::send_impl(zmq::socket_t *socket, SendMode mode) const
   //frame 1: Mesh Type
   //frame 2: Service Type
   //frame 3: Job Data //optional
+  //frame 4+: Job Data Blobs //optional, only when Job Data is sent
 
   //we have to be valid to be sent
   if(!this->isValid())
@@ -241,18 +522,17 @@ bool Message::send_impl(zmq::socket_t *socket, SendMode mode) const
     return false;
     }
 
-  const bool attached_header = zmq::attachReqHeader(*socket,flags);
+  //the request id is kept when forwarding, so the response can be
+  //matched to the request by the client
+  const bool attached_header = zmq::attachReqHeader(*socket,this->RequestId,
+                                                    flags);
 
   bool valid = attached_header;
 
-  //we need to encode the MType as a string buffer
-  //I worry about the performance cost of this
-  std::ostringstream buffer;
-  buffer << this->MType;
-  std::string bufferData = buffer.str();
-
-  zmq::message_t meshIOType(bufferData.size());
-  std::memcpy(meshIOType.data(),bufferData.c_str(),bufferData.size());
+  //in binary mode the MType is sent as interned ids, which avoids
+  //formatting it as a string on every send
+  zmq::message_t meshIOType;
+  encode_MeshIOType(this->MType, this->Format, meshIOType);
 
   valid = valid && zmq::send_harder(*socket,meshIOType,flags|ZMQ_SNDMORE);
 
@@ -263,7 +543,25 @@ bool Message::send_impl(zmq::socket_t *socket, SendMode mode) const
     //send the service line not as the last line
     valid = zmq::send_harder(*socket,service,flags|ZMQ_SNDMORE);
 
-    valid = valid && zmq::send_harder(*socket, *this->Storage, flags);
+    //send a copy of the storage, as zmq empties the message it sends.
+    //Copies share the underlying data, so this is cheap and keeps any
+    //references handed out by sharedData valid.
+    zmq::message_t storageCopy;
+    storageCopy.copy(this->Storage.get());
+    const int dataFlags = this->Attachments.empty() ? flags : flags|ZMQ_SNDMORE;
+    valid = valid && zmq::send_harder(*socket, storageCopy, dataFlags);
+
+    //send each blob as its own frame, the last one ending the message
+    typedef std::vector< boost::shared_ptr<zmq::message_t> >::const_iterator it;
+    for(it i = this->Attachments.begin();
+        valid && i != this->Attachments.end(); ++i)
+      {
+      const bool isLast = ((i+1) == this->Attachments.end());
+      zmq::message_t blobCopy;
+      blobCopy.copy(i->get());
+      valid = zmq::send_harder(*socket, blobCopy,
+                               isLast ? flags : flags|ZMQ_SNDMORE);
+      }
     }
   else if(valid) //we are done
     {
@@ -22,10 +22,14 @@ REMUS_THIRDPARTY_POST_INCLUDE
 #include <remus/common/MeshIOType.h>
 #include <remus/common/ServiceTypes.h>
 #include <remus/common/StatusTypes.h>
+#include <remus/proto/FrameSet.h>
 
 //for export symbols
 #include <remus/proto/ProtoExports.h>
 
+#include <string>
+#include <vector>
+
 #include <remus/common/CompilerInformation.h>
 #ifdef REMUS_MSVC
  #pragma warning(push)
@@ -44,6 +48,11 @@ namespace proto{
 //forward declare message class;
 class Message;
 
+//Every send takes the wire format the mesh type is encoded with. Text is
+//the format that peers which predate the binary wire format understand,
+//and the receiver of a message knows the format it was sent in, so that it
+//can answer in kind.
+
 //----------------------------------------------------------------------------
 //pass in a std::string that we will copy and send.
 //The message returned will have a copy of the data given to it.
@@ -51,7 +60,21 @@ REMUSPROTO_EXPORT
 Message send_Message(remus::common::MeshIOType mtype,
                      remus::SERVICE_TYPE stype,
                      const std::string& data,
-                     zmq::socket_t* socket);
+                     zmq::socket_t* socket,
+                     remus::proto::WireFormat::Type format =
+                       remus::proto::WireFormat::Binary);
+
+//----------------------------------------------------------------------------
+//send the header of the frame set as the data of the message, followed by
+//each blob as its own frame. The blobs are not copied, instead zmq
+//references them until it has sent them.
+REMUSPROTO_EXPORT
+Message send_Message(remus::common::MeshIOType mtype,
+                     remus::SERVICE_TYPE stype,
+                     const remus::proto::FrameSet& frames,
+                     zmq::socket_t* socket,
+                     remus::proto::WireFormat::Type format =
+                       remus::proto::WireFormat::Binary);
 
 //----------------------------------------------------------------------------
 //send a message that has no data.
@@ -59,7 +82,9 @@ Message send_Message(remus::common::MeshIOType mtype,
 REMUSPROTO_EXPORT
 Message send_Message(remus::common::MeshIOType mtype,
                      remus::SERVICE_TYPE stype,
-                     zmq::socket_t* socket);
+                     zmq::socket_t* socket,
+                     remus::proto::WireFormat::Type format =
+                       remus::proto::WireFormat::Binary);
 
 //----------------------------------------------------------------------------
 //pass in a std::string that we will copy and send.
@@ -68,7 +93,20 @@ REMUSPROTO_EXPORT
 Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
                                 remus::SERVICE_TYPE stype,
                                 const std::string& data,
-                                zmq::socket_t* socket);
+                                zmq::socket_t* socket,
+                                remus::proto::WireFormat::Type format =
+                                  remus::proto::WireFormat::Binary);
+
+//----------------------------------------------------------------------------
+//send the header of the frame set as the data of the message, followed by
+//each blob as its own frame. The blobs are not copied.
+REMUSPROTO_EXPORT
+Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
+                                remus::SERVICE_TYPE stype,
+                                const remus::proto::FrameSet& frames,
+                                zmq::socket_t* socket,
+                                remus::proto::WireFormat::Type format =
+                                  remus::proto::WireFormat::Binary);
 
 //----------------------------------------------------------------------------
 //send a message that has no data.
@@ -76,7 +114,23 @@ Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
 REMUSPROTO_EXPORT
 Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
                                 remus::SERVICE_TYPE stype,
-                                zmq::socket_t* socket);
+                                zmq::socket_t* socket,
+                                remus::proto::WireFormat::Type format =
+                                  remus::proto::WireFormat::Binary);
+
+//----------------------------------------------------------------------------
+//send a request that is tagged with the given request id. The server sends
+//the id back with its response, which allows a client to have many requests
+//outstanding on a ZMQ_DEALER socket and match the responses to them in
+//whatever order they arrive. The blobs are not copied.
+REMUSPROTO_EXPORT
+Message send_NonBlockingRequest(const std::string& requestId,
+                                remus::common::MeshIOType mtype,
+                                remus::SERVICE_TYPE stype,
+                                const remus::proto::FrameSet& frames,
+                                zmq::socket_t* socket,
+                                remus::proto::WireFormat::Type format =
+                                  remus::proto::WireFormat::Binary);
 
 //----------------------------------------------------------------------------
 //parse a message from a socket
@@ -85,8 +139,8 @@ REMUSPROTO_EXPORT
 Message receive_Message( zmq::socket_t* socket );
 
 //----------------------------------------------------------------------------
-//forward a message that has been received to another socket
-//
+//forward a message that has been received to another socket, in the wire
+//format it was received in
 REMUSPROTO_EXPORT
 bool forward_Message(const remus::proto::Message& message,
                      zmq::socket_t* socket);
@@ -106,9 +160,26 @@ public:
   const char* data() const;
   std::size_t dataSize() const;
 
+  //returns the data as a shared pointer that keeps the received frame
+  //alive. This allows decoders to reference the data without copying it,
+  //and the data stays valid after this Message has been destroyed.
+  boost::shared_ptr<const char> sharedData() const;
+
+  //returns the data as the header frame, and any frames that followed the
+  //data as blobs. The frames keep the received data alive.
+  remus::proto::FrameSet frames() const;
+
   //is true if all the message was sent, or all of the message was received.
   bool isValid() const { return Valid; }
 
+  //the wire format the message was sent in. Received messages report the
+  //format the sender chose, which is what responses should be encoded in
+  remus::proto::WireFormat::Type wireFormat() const { return Format; }
+
+  //the id the request was tagged with, which is empty for requests sent
+  //by clients that only have a single request outstanding
+  const std::string& requestId() const { return RequestId; }
+
   Message(const Message&) = default;
   Message& operator=(Message&& other);
   Message& operator=(const Message&) = default;
@@ -117,20 +188,43 @@ private:
   friend REMUSPROTO_EXPORT Message send_Message(remus::common::MeshIOType mtype,
                                                 remus::SERVICE_TYPE stype,
                                                 const std::string& data,
-                                                zmq::socket_t* socket);
+                                                zmq::socket_t* socket,
+                                                remus::proto::WireFormat::Type format);
 
   friend REMUSPROTO_EXPORT Message send_Message(remus::common::MeshIOType mtype,
                                                 remus::SERVICE_TYPE stype,
-                                                zmq::socket_t* socket);
+                                                const remus::proto::FrameSet& frames,
+                                                zmq::socket_t* socket,
+                                                remus::proto::WireFormat::Type format);
+
+  friend REMUSPROTO_EXPORT Message send_Message(remus::common::MeshIOType mtype,
+                                                remus::SERVICE_TYPE stype,
+                                                zmq::socket_t* socket,
+                                                remus::proto::WireFormat::Type format);
 
   friend REMUSPROTO_EXPORT Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
                                                            remus::SERVICE_TYPE stype,
                                                            const std::string& data,
-                                                           zmq::socket_t* socket);
+                                                           zmq::socket_t* socket,
+                                                           remus::proto::WireFormat::Type format);
 
   friend REMUSPROTO_EXPORT Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
                                                            remus::SERVICE_TYPE stype,
-                                                           zmq::socket_t* socket);
+                                                           const remus::proto::FrameSet& frames,
+                                                           zmq::socket_t* socket,
+                                                           remus::proto::WireFormat::Type format);
+
+  friend REMUSPROTO_EXPORT Message send_NonBlockingMessage(remus::common::MeshIOType mtype,
+                                                           remus::SERVICE_TYPE stype,
+                                                           zmq::socket_t* socket,
+                                                           remus::proto::WireFormat::Type format);
+
+  friend REMUSPROTO_EXPORT Message send_NonBlockingRequest(const std::string& requestId,
+                                                           remus::common::MeshIOType mtype,
+                                                           remus::SERVICE_TYPE stype,
+                                                           const remus::proto::FrameSet& frames,
+                                                           zmq::socket_t* socket,
+                                                           remus::proto::WireFormat::Type format);
 
   friend REMUSPROTO_EXPORT Message receive_Message( zmq::socket_t* socket );
 
@@ -144,14 +238,36 @@ private:
           remus::SERVICE_TYPE stype,
           const std::string& data,
           zmq::socket_t* socket,
-          SendMode mode);
+          SendMode mode,
+          remus::proto::WireFormat::Type format);
+
+  //----------------------------------------------------------------------------
+  //pass in a FrameSet that Message will reference and send
+  Message(remus::common::MeshIOType mtype,
+          remus::SERVICE_TYPE stype,
+          const remus::proto::FrameSet& frames,
+          zmq::socket_t* socket,
+          SendMode mode,
+          remus::proto::WireFormat::Type format);
+
+  //----------------------------------------------------------------------------
+  //pass in a FrameSet that Message will reference and send tagged with
+  //the request id
+  Message(const std::string& requestId,
+          remus::common::MeshIOType mtype,
+          remus::SERVICE_TYPE stype,
+          const remus::proto::FrameSet& frames,
+          zmq::socket_t* socket,
+          SendMode mode,
+          remus::proto::WireFormat::Type format);
 
   //----------------------------------------------------------------------------
   //creates a Message with no data
   Message(remus::common::MeshIOType mtype,
           remus::SERVICE_TYPE stype,
           zmq::socket_t* socket,
-          SendMode mode);
+          SendMode mode,
+          remus::proto::WireFormat::Type format);
 
   //----------------------------------------------------------------------------
   //creates a Message from reading from the socket
@@ -162,8 +278,16 @@ private:
   remus::common::MeshIOType MType;
   remus::SERVICE_TYPE SType;
   bool Valid; //tells if the message is valid
+  std::string RequestId;
+
+  //the wire format of the mesh type frame. Received messages keep the
+  //format they arrived in, so they are forwarded the same way
+  remus::proto::WireFormat::Type Format;
 
   boost::shared_ptr<zmq::message_t> Storage;
+
+  //frames sent after the data frame, one per blob of a FrameSet
+  std::vector< boost::shared_ptr<zmq::message_t> > Attachments;
 };
 
 }
@@ -32,6 +32,15 @@ Response send_Response(remus::SERVICE_TYPE stype,
   return Response(stype,data,socket,client,Response::Blocking);
 }
 
+//----------------------------------------------------------------------------
+Response send_Response(remus::SERVICE_TYPE stype,
+                       const remus::proto::FrameSet& frames,
+                       zmq::socket_t* socket,
+                       const zmq::SocketIdentity& client)
+{
+  return Response(stype,frames,socket,client,Response::Blocking);
+}
+
 //----------------------------------------------------------------------------
 Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
                                   const std::string& data,
@@ -41,6 +50,15 @@ Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
   return Response(stype,data,socket,client,Response::NonBlocking);
 }
 
+//----------------------------------------------------------------------------
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const remus::proto::FrameSet& frames,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client)
+{
+  return Response(stype,frames,socket,client,Response::NonBlocking);
+}
+
 //----------------------------------------------------------------------------
 //parse a response from a socket
 Response receive_Response( zmq::socket_t* socket )
@@ -54,6 +72,7 @@ bool forward_Response(const remus::proto::Response& response,
                       zmq::socket_t* socket,
                       const zmq::SocketIdentity& client)
 {
+  //the response keeps the request id it was received with
   return response.send_impl(socket,client,Response::Blocking);
 }
 
@@ -65,7 +84,9 @@ Response::Response(remus::SERVICE_TYPE stype,
                    Response::SendMode mode):
   SType(stype),
   Valid(true), //need to be initially valid to be sent
-  Storage( boost::make_shared<zmq::message_t>(rdata.size()) )
+  RequestId(client.requestId()),
+  Storage( boost::make_shared<zmq::message_t>(rdata.size()) ),
+  Attachments()
 {
   std::memcpy(this->Storage->data(),rdata.data(),rdata.size());
 
@@ -75,14 +96,38 @@ Response::Response(remus::SERVICE_TYPE stype,
   this->Valid = this->send_impl(socket, client, mode);
 }
 
+//----------------------------------------------------------------------------
+Response::Response(remus::SERVICE_TYPE stype,
+                   const remus::proto::FrameSet& frames,
+                   zmq::socket_t* socket,
+                   const zmq::SocketIdentity& client,
+                   Response::SendMode mode):
+  SType(stype),
+  Valid(true), //need to be initially valid to be sent
+  RequestId(client.requestId()),
+  Storage( detail::to_zmqMessage(frames.Header) ),
+  Attachments()
+{
+  this->Attachments.reserve(frames.Blobs.size());
+  typedef std::vector<remus::proto::Frame>::const_iterator it;
+  for(it i = frames.Blobs.begin(); i != frames.Blobs.end(); ++i)
+    {
+    this->Attachments.push_back( detail::to_zmqMessage(*i) );
+    }
+
+  this->Valid = this->send_impl(socket, client, mode);
+}
+
 //----------------------------------------------------------------------------
 Response::Response(zmq::socket_t* socket):
   SType(remus::INVALID_SERVICE),
   Valid(false), //need to be initially valid to be sent
-  Storage( boost::make_shared<zmq::message_t>() )
+  RequestId(),
+  Storage( boost::make_shared<zmq::message_t>() ),
+  Attachments()
 {
 
-  const bool removedHeader = zmq::removeReqHeader(*socket);
+  const bool removedHeader = zmq::removeReqHeader(*socket, this->RequestId);
   if(removedHeader)
     {
     zmq::message_t servType;
@@ -90,7 +135,23 @@ Response::Response(zmq::socket_t* socket):
     if(parsedServiceType)
       {
       this->SType = *(reinterpret_cast<SERVICE_TYPE*>(servType.data()));
-      const bool recvStorage = zmq::recv_harder(*socket,this->Storage.get());
+      bool recvStorage = zmq::recv_harder(*socket,this->Storage.get());
+
+      //any frames after the data are the blobs of a FrameSet
+      zmq::more_t more;
+      size_t more_size = sizeof(more);
+      socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+      while(recvStorage && more > 0)
+        {
+        boost::shared_ptr<zmq::message_t> blob =
+                                        boost::make_shared<zmq::message_t>();
+        recvStorage = zmq::recv_harder(*socket,blob.get());
+        if(recvStorage)
+          {
+          this->Attachments.push_back(blob);
+          }
+        socket->getsockopt(ZMQ_RCVMORE, &more, &more_size);
+        }
 
       //if recvStorage is true than we received every chunk of data and we
       //are valid
@@ -106,8 +167,11 @@ Response& Response::operator=(Response&& other)
   {
     this->SType = other.SType;
     this->Valid = other.Valid;
+    this->RequestId.swap(other.RequestId);
     this->Storage = other.Storage;
+    this->Attachments.swap(other.Attachments);
     other.Storage.reset();
+    other.Attachments.clear();
   }
   return *this;
 }
@@ -124,6 +188,33 @@ std::size_t Response::dataSize() const
   return this->Storage ? this->Storage->size() : std::size_t(0);
 }
 
+//------------------------------------------------------------------------------
+boost::shared_ptr<const char> Response::sharedData() const
+{
+  if(!this->Storage)
+    {
+    return boost::shared_ptr<const char>();
+    }
+  //use the aliasing constructor so that the pointer we hand out shares
+  //ownership of the zmq message that holds the data
+  return boost::shared_ptr<const char>(this->Storage,
+                  static_cast<const char*>(this->Storage->data()));
+}
+
+//------------------------------------------------------------------------------
+remus::proto::FrameSet Response::frames() const
+{
+  remus::proto::FrameSet result;
+  result.Header = detail::to_Frame(this->Storage);
+  result.Blobs.reserve(this->Attachments.size());
+  typedef std::vector< boost::shared_ptr<zmq::message_t> >::const_iterator it;
+  for(it i = this->Attachments.begin(); i != this->Attachments.end(); ++i)
+    {
+    result.Blobs.push_back( detail::to_Frame(*i) );
+    }
+  return result;
+}
+
 //------------------------------------------------------------------------------
 bool Response::send_impl(zmq::socket_t* socket,
                          const zmq::SocketIdentity& client,
@@ -137,9 +228,10 @@ bool Response::send_impl(zmq::socket_t* socket,
 
   //we are sending our selves as a multi part response
   //frame 0: client address we need to route too [Optional]
-  //frame 1: fake rep spacer
+  //frame 1: fake rep spacer, holds the request id being answered
   //frame 2: Service Type we are responding too
   //frame 3: data
+  //frame 4+: data blobs [Optional]
 
   bool responseSent = false;
 
@@ -153,7 +245,8 @@ bool Response::send_impl(zmq::socket_t* socket,
 
   if(clientSent)
     {
-    const bool sentFakeReq = zmq::attachReqHeader(*socket,flags);
+    const bool sentFakeReq = zmq::attachReqHeader(*socket,this->RequestId,
+                                                  flags);
     if(sentFakeReq)
       {
       zmq::message_t service(sizeof(this->SType));
@@ -163,7 +256,26 @@ bool Response::send_impl(zmq::socket_t* socket,
                                                  service, flags|ZMQ_SNDMORE );
       if(sentServiceType)
         {
-        responseSent = zmq::send_harder( *socket, *this->Storage, flags);
+        //send a copy of the storage, as zmq empties the message it sends.
+        //Copies share the underlying data, so this is cheap and keeps any
+        //references handed out by sharedData valid.
+        zmq::message_t storageCopy;
+        storageCopy.copy(this->Storage.get());
+        const int dataFlags = this->Attachments.empty() ?
+                              flags : flags|ZMQ_SNDMORE;
+        responseSent = zmq::send_harder( *socket, storageCopy, dataFlags);
+
+        //send each blob as its own frame, the last one ending the response
+        typedef std::vector< boost::shared_ptr<zmq::message_t> >::const_iterator it;
+        for(it i = this->Attachments.begin();
+            responseSent && i != this->Attachments.end(); ++i)
+          {
+          const bool isLast = ((i+1) == this->Attachments.end());
+          zmq::message_t blobCopy;
+          blobCopy.copy(i->get());
+          responseSent = zmq::send_harder( *socket, blobCopy,
+                                           isLast ? flags : flags|ZMQ_SNDMORE);
+          }
 
         }
       }
@@ -22,11 +22,15 @@ REMUS_THIRDPARTY_POST_INCLUDE
 #include <remus/common/MeshIOType.h>
 #include <remus/common/ServiceTypes.h>
 #include <remus/common/StatusTypes.h>
+#include <remus/proto/FrameSet.h>
 #include <remus/proto/zmqSocketIdentity.h>
 
 //for export symbols
 #include <remus/proto/ProtoExports.h>
 
+#include <string>
+#include <vector>
+
 #include <remus/common/CompilerInformation.h>
 #ifdef REMUS_MSVC
  #pragma warning(push)
@@ -54,6 +58,16 @@ Response send_Response(remus::SERVICE_TYPE stype,
                        zmq::socket_t* socket,
                        const zmq::SocketIdentity& client);
 
+//----------------------------------------------------------------------------
+//send the header of the frame set as the data of the response, followed by
+//each blob as its own frame. The blobs are not copied, instead zmq
+//references them until it has sent them.
+REMUSPROTO_EXPORT
+Response send_Response(remus::SERVICE_TYPE stype,
+                       const remus::proto::FrameSet& frames,
+                       zmq::socket_t* socket,
+                       const zmq::SocketIdentity& client);
+
 //----------------------------------------------------------------------------
 //pass in a std::string that we will copy and send.
 //The response returned will have a copy of the data given to it.
@@ -63,6 +77,15 @@ Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
                                   zmq::socket_t* socket,
                                   const zmq::SocketIdentity& client);
 
+//----------------------------------------------------------------------------
+//send the header of the frame set as the data of the response, followed by
+//each blob as its own frame. The blobs are not copied.
+REMUSPROTO_EXPORT
+Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                  const remus::proto::FrameSet& frames,
+                                  zmq::socket_t* socket,
+                                  const zmq::SocketIdentity& client);
+
 //----------------------------------------------------------------------------
 //parse a response from a socket
 //The response returned will have data associated with if it is valid
@@ -90,9 +113,22 @@ public:
   const char* data() const;
   std::size_t dataSize() const;
 
+  //returns the data as a shared pointer that keeps the received frame
+  //alive. This allows decoders to reference the data without copying it,
+  //and the data stays valid after this Response has been destroyed.
+  boost::shared_ptr<const char> sharedData() const;
+
+  //returns the data as the header frame, and any frames that followed the
+  //data as blobs. The frames keep the received data alive.
+  remus::proto::FrameSet frames() const;
+
   //is true if all the response was sent, or all of the response was received.
   bool isValid() const { return Valid; }
 
+  //the id of the request this response answers, which is empty when the
+  //request wasn't tagged with an id
+  const std::string& requestId() const { return RequestId; }
+
   Response(const Response&) = default;
   Response& operator=(Response&& other);
   Response& operator=(const Response&) = default;
@@ -105,11 +141,21 @@ private:
                                                   const zmq::SocketIdentity& client);
 
 
+  friend REMUSPROTO_EXPORT Response send_Response(remus::SERVICE_TYPE stype,
+                                                  const remus::proto::FrameSet& frames,
+                                                  zmq::socket_t* socket,
+                                                  const zmq::SocketIdentity& client);
+
   friend REMUSPROTO_EXPORT Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
                                                              const std::string& data,
                                                              zmq::socket_t* socket,
                                                              const zmq::SocketIdentity& client);
 
+  friend REMUSPROTO_EXPORT Response send_NonBlockingResponse(remus::SERVICE_TYPE stype,
+                                                             const remus::proto::FrameSet& frames,
+                                                             zmq::socket_t* socket,
+                                                             const zmq::SocketIdentity& client);
+
   friend REMUSPROTO_EXPORT Response receive_Response( zmq::socket_t* socket );
 
   friend REMUSPROTO_EXPORT bool forward_Response(const remus::proto::Response& response,
@@ -124,6 +170,14 @@ private:
            const zmq::SocketIdentity& client,
            SendMode mode);
 
+  //----------------------------------------------------------------------------
+  //construct a response, the frames will be referenced and sent.
+  Response(remus::SERVICE_TYPE stype,
+           const remus::proto::FrameSet& frames,
+           zmq::socket_t* socket,
+           const zmq::SocketIdentity& client,
+           SendMode mode);
+
   //----------------------------------------------------------------------------
   //create a response from reading from the socket
   explicit Response(zmq::socket_t* socket);
@@ -132,8 +186,12 @@ private:
 
   remus::SERVICE_TYPE SType;
   bool Valid; //tells if the response is valid
+  std::string RequestId;
 
   boost::shared_ptr<zmq::message_t> Storage;
+
+  //frames sent after the data frame, one per blob of a FrameSet
+  std::vector< boost::shared_ptr<zmq::message_t> > Attachments;
 };
 
 }
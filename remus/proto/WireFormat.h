@@ -0,0 +1,37 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_proto_WireFormat_h
+#define remus_proto_WireFormat_h
+
+namespace remus { namespace internal {
+  //forward declare the binary encoders so that proto classes can befriend
+  //them without exposing the implementation
+  class BinaryWriter;
+  class BinaryReader;
+} }
+
+namespace remus{
+namespace proto{
+
+//The encoding used when converting proto objects to strings.
+//Text is the original newline separated format and is kept for compatibility
+//with older clients, servers and workers. Binary is a versioned format of
+//fixed width little endian headers and length prefixed blobs, which is
+//encoded and decoded in a single pass.
+//Decoding always detects which format was used, so only the sender needs
+//to choose.
+struct WireFormat{ enum Type{Text=0, Binary=1}; };
+
+} }
+
+#endif
@@ -17,11 +17,16 @@
 #endif
 
 #include <remus/proto/WorkerJob.h>
+#include <remus/proto/FrameSet.h>
 
+#include <remus/common/BinaryConversionHelper.h>
+
+#include <algorithm>
 #include <sstream>
 
 //suppress warnings inside boost headers for gcc and clang
 REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/uuid/nil_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
@@ -83,9 +88,91 @@ std::string to_string(const remus::proto::WorkerJob& job)
 }
 
 
+//------------------------------------------------------------------------------
+std::string to_string(const remus::proto::WorkerJob& job,
+                      remus::proto::WireFormat::Type format)
+{
+  if(format == remus::proto::WireFormat::Text)
+    {
+    return to_string(job);
+    }
+
+  const char* id = reinterpret_cast<const char*>(job.id().data);
+
+  //first pass computes the size so the second pass doesn't reallocate
+  remus::internal::BinaryWriter counter(remus::internal::BinaryWriter::CountOnly);
+  counter.writeHeader(remus::internal::binary::TypeTag::WorkerJob);
+  counter.writeBytes(id, job.id().size());
+  counter << job.submission();
+
+  remus::internal::BinaryWriter buffer;
+  buffer.reserve(counter.size());
+  buffer.writeHeader(remus::internal::binary::TypeTag::WorkerJob);
+  buffer.writeBytes(id, job.id().size());
+  buffer << job.submission();
+  return buffer.release();
+}
+
+namespace
+{
+//------------------------------------------------------------------------------
+remus::proto::WorkerJob from_binary(remus::internal::BinaryReader& reader)
+{
+  boost::uuids::uuid id = boost::uuids::nil_uuid();
+  remus::proto::JobSubmission submission;
+
+  if(reader.readHeader(remus::internal::binary::TypeTag::WorkerJob))
+    {
+    const char* idBytes = reader.readBytes(id.size());
+    if(idBytes)
+      {
+      std::copy(idBytes, idBytes+id.size(), id.data);
+      }
+    reader >> submission;
+    }
+
+  if(!reader.valid())
+    {
+    return remus::proto::WorkerJob();
+    }
+  return remus::proto::WorkerJob(id,submission);
+}
+}
+
+//------------------------------------------------------------------------------
+remus::proto::WorkerJob to_WorkerJob(const char* data, std::size_t size)
+{
+  if(remus::internal::isBinaryWireFormat(data,size))
+    {
+    remus::internal::BinaryReader reader(data,size);
+    return from_binary(reader);
+    }
+  //required to use the char*, len constructor as data can
+  //be binary data with lots of null terminators.
+  return to_WorkerJob(std::string(data,size));
+}
+
+//------------------------------------------------------------------------------
+remus::proto::WorkerJob to_WorkerJob(const boost::shared_ptr<const char>& data,
+                                     std::size_t size)
+{
+  if(remus::internal::isBinaryWireFormat(data.get(),size))
+    {
+    remus::internal::BinaryReader reader(data,size);
+    return from_binary(reader);
+    }
+  return to_WorkerJob(data.get(),size);
+}
+
 //------------------------------------------------------------------------------
 remus::proto::WorkerJob to_WorkerJob(const std::string& msg)
 {
+  if(remus::internal::isBinaryWireFormat(msg.c_str(),msg.size()))
+    {
+    remus::internal::BinaryReader reader(msg.c_str(),msg.size());
+    return from_binary(reader);
+    }
+
   //convert a job detail from a string, used as a hack to serialize
   std::istringstream buffer(msg);
 
@@ -98,6 +185,78 @@ remus::proto::WorkerJob to_WorkerJob(const std::string& msg)
   return remus::proto::WorkerJob(id,submission);
 }
 
+//------------------------------------------------------------------------------
+FrameSet to_FrameSet(const remus::proto::WorkerJob& job)
+{
+  return to_FrameSet(job.id(), to_FrameSet(job.submission()));
+}
+
+//------------------------------------------------------------------------------
+FrameSet to_FrameSet(const remus::proto::WorkerJob& job,
+                     remus::proto::WireFormat::Type format)
+{
+  if(format == remus::proto::WireFormat::Binary)
+    {
+    return to_FrameSet(job);
+    }
+
+  std::string header = to_string(job, format);
+  FrameSet frames;
+  frames.Header = detail::make_HeaderFrame(header);
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+FrameSet to_FrameSet(const boost::uuids::uuid& jobId,
+                     const FrameSet& submission)
+{
+  //the header only holds the job id, the header of the submission is the
+  //first blob followed by the blobs of the submission
+  std::vector<Frame> noBlobs;
+  remus::internal::BinaryWriter buffer;
+  buffer.externalizeBlobs(&noBlobs);
+  buffer.writeHeader(remus::internal::binary::TypeTag::WorkerJob);
+  buffer.writeBytes(reinterpret_cast<const char*>(jobId.data), jobId.size());
+
+  FrameSet frames;
+  std::string header = buffer.release();
+  frames.Header = detail::make_HeaderFrame(header);
+  frames.Blobs.reserve(submission.Blobs.size() + 1);
+  frames.Blobs.push_back(submission.Header);
+  frames.Blobs.insert(frames.Blobs.end(),
+                      submission.Blobs.begin(), submission.Blobs.end());
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::WorkerJob to_WorkerJob(const FrameSet& frames)
+{
+  if(frames.Blobs.empty())
+    {
+    return to_WorkerJob(frames.Header.Data, frames.Header.size());
+    }
+
+  boost::uuids::uuid id = boost::uuids::nil_uuid();
+  remus::internal::BinaryReader reader(frames.Header, frames.Blobs);
+  if(reader.readHeader(remus::internal::binary::TypeTag::WorkerJob))
+    {
+    const char* idBytes = reader.readBytes(id.size());
+    if(idBytes)
+      {
+      std::copy(idBytes, idBytes+id.size(), id.data);
+      }
+    }
+  if(!reader.valid())
+    {
+    return remus::proto::WorkerJob();
+    }
+
+  FrameSet submission;
+  submission.Header = frames.Blobs.front();
+  submission.Blobs.assign(frames.Blobs.begin()+1, frames.Blobs.end());
+  return remus::proto::WorkerJob(id, to_JobSubmission(submission));
+}
+
 }
 }
 
@@ -83,6 +83,23 @@ private:
 //------------------------------------------------------------------------------
 REMUSPROTO_EXPORT std::string to_string(const remus::proto::WorkerJob& job);
 
+//------------------------------------------------------------------------------
+//encode the job using the requested wire format
+REMUSPROTO_EXPORT std::string to_string(const remus::proto::WorkerJob& job,
+                                        remus::proto::WireFormat::Type format);
+
+//------------------------------------------------------------------------------
+//decodes both the text and binary wire formats
+REMUSPROTO_EXPORT remus::proto::WorkerJob to_WorkerJob(const char* data,
+                                                       std::size_t size);
+
+//------------------------------------------------------------------------------
+//decode without copying the submission contents out of data, instead the
+//job holds a reference to data and points into it. Only the binary wire
+//format can be decoded without a copy, the text format falls back to copying.
+REMUSPROTO_EXPORT remus::proto::WorkerJob to_WorkerJob(
+                                  const boost::shared_ptr<const char>& data,
+                                  std::size_t size);
 
 //------------------------------------------------------------------------------
 REMUSPROTO_EXPORT remus::proto::WorkerJob to_WorkerJob(const std::string& msg);
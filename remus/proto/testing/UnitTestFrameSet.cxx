@@ -0,0 +1,362 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/shared_array.hpp>
+#include <boost/uuid/uuid.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <remus/proto/FrameSet.h>
+#include <remus/proto/JobResult.h>
+#include <remus/proto/JobSubmission.h>
+#include <remus/proto/WorkerJob.h>
+#include <remus/testing/Testing.h>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using namespace remus::proto;
+
+struct SharedArrayHolder
+{
+  explicit SharedArrayHolder(const boost::shared_array<char>& a): Array(a) {}
+  void operator()(const char*) { this->Array.reset(); }
+  boost::shared_array<char> Array;
+};
+
+//copy a frame into a new buffer, like zmq does when sending the frame to
+//another process
+Frame copy_Frame(const Frame& frame)
+{
+  boost::shared_array<char> slab(new char[frame.size()+1]);
+  std::memcpy(slab.get(), frame.data(), frame.size());
+  boost::shared_ptr<const char> buffer(slab.get(), SharedArrayHolder(slab));
+  return Frame(buffer, frame.size());
+}
+
+FrameSet copy_FrameSet(const FrameSet& frames)
+{
+  FrameSet result;
+  result.Header = copy_Frame(frames.Header);
+  for(std::size_t i=0; i < frames.Blobs.size(); ++i)
+    {
+    result.Blobs.push_back( copy_Frame(frames.Blobs[i]) );
+    }
+  return result;
+}
+
+bool pointsInto(const char* data, const Frame& frame)
+{
+  return data >= frame.data() && data < frame.data() + frame.size();
+}
+
+JobSubmission make_Submission()
+{
+  remus::common::MeshIOType mtypes((remus::meshtypes::Edges()),
+                                   (remus::meshtypes::Mesh2D()) );
+  JobRequirements reqs(remus::common::ContentFormat::User, mtypes,
+                       "worker", "requirements");
+  JobSubmission sub(reqs);
+  sub["a"] = make_JobContent(remus::testing::AsciiStringGenerator(128));
+  sub["b"] = make_JobContent(remus::testing::BinaryDataGenerator(4096));
+  sub["c"] = make_JobContent(remus::common::FileHandle("path/to/file"));
+  return sub;
+}
+
+void submission_frames_test()
+{
+  const JobSubmission expected = make_Submission();
+  JobSubmission sub = expected;
+  FrameSet frames = to_FrameSet(sub);
+
+  //one blob for the requirements, and one for each content
+  REMUS_ASSERT( (frames.Blobs.size() == 4) );
+
+  //the blobs reference the contents instead of copying them
+  REMUS_ASSERT( (frames.Blobs[2].data() == sub["b"].data()) );
+  REMUS_ASSERT( (frames.Blobs[2].size() == sub["b"].dataSize()) );
+
+  //the header is small no matter how large the contents are
+  REMUS_ASSERT( (frames.Header.size() < 256) );
+
+  //the frames keep the contents alive after the submission is gone
+  const std::string b(sub["b"].data(), sub["b"].dataSize());
+  sub = JobSubmission();
+  REMUS_ASSERT( (std::string(frames.Blobs[2].data(),
+                             frames.Blobs[2].size()) == b) );
+
+  //decode the frames as if they have been received
+  FrameSet received = copy_FrameSet(frames);
+  JobSubmission from_wire = to_JobSubmission(received);
+  REMUS_ASSERT( (from_wire == expected) );
+  REMUS_ASSERT( (from_wire.size() == 3) );
+
+  //each decoded content points into the frame it arrived in
+  REMUS_ASSERT( pointsInto(from_wire["a"].data(), received.Blobs[1]) );
+  REMUS_ASSERT( pointsInto(from_wire["b"].data(), received.Blobs[2]) );
+  REMUS_ASSERT( pointsInto(from_wire["c"].data(), received.Blobs[3]) );
+
+  //missing blob frames must not decode into a valid submission
+  received.Blobs.pop_back();
+  JobSubmission missing = to_JobSubmission(received);
+  REMUS_ASSERT( (missing.size() == 0) );
+  REMUS_ASSERT( (!missing.type().valid()) );
+
+  //a single frame in either wire format is still understood
+  FrameSet single;
+  std::string text = to_string(expected);
+  single.Header = detail::make_HeaderFrame(text);
+  REMUS_ASSERT( (to_JobSubmission(single) == expected) );
+}
+
+void result_frames_test()
+{
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::BinaryDataGenerator(8192);
+  JobResult result = make_JobResult(id, data);
+
+  FrameSet frames = copy_FrameSet( to_FrameSet(result) );
+  REMUS_ASSERT( (frames.Blobs.size() == 1) );
+
+  JobResult from_wire = to_JobResult(frames);
+  REMUS_ASSERT( (from_wire.id() == id) );
+  REMUS_ASSERT( (from_wire.dataSize() == data.size()) );
+  REMUS_ASSERT( (from_wire.data() == frames.Blobs[0].data()) );
+  REMUS_ASSERT( (std::string(from_wire.data(),from_wire.dataSize()) == data) );
+}
+
+void compressed_frames_test()
+{
+  using remus::common::ContentCompression;
+  const bool haveZlib =
+            remus::common::haveCompressionCodec(ContentCompression::Zlib);
+
+  //text that compresses well
+  std::string data;
+  while(data.size() < 64 * 1024)
+    { data += "<Attribute Name=\"size\" Value=\"0.25\"/>\n"; }
+
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  JobResult result = make_JobResult(id, data,
+                                    remus::common::ContentFormat::XML);
+  result.compress(ContentCompression::Zlib);
+
+  FrameSet frames = copy_FrameSet( to_FrameSet(result) );
+  REMUS_ASSERT( (frames.Blobs.size() == 1) );
+  REMUS_ASSERT( ((frames.Blobs[0].size() < data.size()) == haveZlib) );
+
+  JobResult from_wire = to_JobResult(frames);
+  REMUS_ASSERT( (from_wire.id() == id) );
+  REMUS_ASSERT( (from_wire.formatType() == remus::common::ContentFormat::XML) );
+
+  //send the result on without looking at the data, which sends the
+  //compressed frame that was received and never decompresses it
+  FrameSet forwarded = to_FrameSet(from_wire);
+  REMUS_ASSERT( (forwarded.Blobs[0].data() == frames.Blobs[0].data()) );
+
+  //the data is decompressed into memory of its own when it is asked for
+  REMUS_ASSERT( (from_wire.dataSize() == data.size()) );
+  REMUS_ASSERT( (std::string(from_wire.data(),from_wire.dataSize()) == data) );
+  REMUS_ASSERT( (pointsInto(from_wire.data(), frames.Blobs[0]) != haveZlib) );
+}
+
+void worker_job_frames_test()
+{
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  WorkerJob job(id, make_Submission());
+
+  FrameSet frames = copy_FrameSet( to_FrameSet(job) );
+  WorkerJob from_wire = to_WorkerJob(frames);
+  REMUS_ASSERT( (from_wire.valid()) );
+  REMUS_ASSERT( (from_wire.id() == id) );
+  REMUS_ASSERT( (from_wire.submission() == job.submission()) );
+
+  //the header of the submission follows the job id, then its blobs
+  remus::proto::JobContent content;
+  REMUS_ASSERT( (from_wire.details("b",content)) );
+  REMUS_ASSERT( pointsInto(content.data(), frames.Blobs[3]) );
+}
+
+void forward_submission_test()
+{
+  //the server only decodes the requirements of a submission, and forwards
+  //the frames it received to the worker untouched
+  const JobSubmission sub = make_Submission();
+  FrameSet received = copy_FrameSet( to_FrameSet(sub) );
+
+  JobRequirements reqs = to_JobRequirements(received);
+  REMUS_ASSERT( (reqs == sub.requirements()) );
+  REMUS_ASSERT( (reqs.workerName() == "worker") );
+  REMUS_ASSERT( (std::string(reqs.requirements(),
+                             reqs.requirementsSize()) == "requirements") );
+
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  FrameSet forwarded = to_FrameSet(id, received);
+  REMUS_ASSERT( (forwarded.Blobs.size() == received.Blobs.size() + 1) );
+  REMUS_ASSERT( (forwarded.Blobs[0].data() == received.Header.data()) );
+  for(std::size_t i=0; i < received.Blobs.size(); ++i)
+    {
+    REMUS_ASSERT( (forwarded.Blobs[i+1].data() == received.Blobs[i].data()) );
+    }
+
+  WorkerJob job = to_WorkerJob( copy_FrameSet(forwarded) );
+  REMUS_ASSERT( (job.valid()) );
+  REMUS_ASSERT( (job.id() == id) );
+  REMUS_ASSERT( (job.submission() == sub) );
+
+  //a submission sent as a single frame still has its requirements decoded,
+  //and can still be forwarded
+  FrameSet single;
+  std::string text = to_string(sub);
+  single.Header = detail::make_HeaderFrame(text);
+  REMUS_ASSERT( (to_JobRequirements(single) == sub.requirements()) );
+  REMUS_ASSERT( (to_WorkerJob(to_FrameSet(id,single)).submission() == sub) );
+}
+
+void batch_frames_test()
+{
+  //a batch mixes items with and without blobs
+  const JobSubmission sub = make_Submission();
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::BinaryDataGenerator(1024);
+
+  std::vector<FrameSet> items;
+  items.push_back( to_FrameSet(sub) );
+  std::string text = "single frame";
+  FrameSet single;
+  single.Header = detail::make_HeaderFrame(text);
+  items.push_back( single );
+  items.push_back( to_FrameSet(make_JobResult(id, data)) );
+
+  FrameSet batch = to_FrameSet(items);
+  REMUS_ASSERT( (batch.Blobs.size() == 5) );
+  REMUS_ASSERT( (batch.Blobs[1].data() == items[0].Blobs[1].data()) );
+
+  //the items point into the frames of the batch they arrived in
+  FrameSet received = copy_FrameSet(batch);
+  std::vector<FrameSet> from_wire = to_FrameSets(received);
+  REMUS_ASSERT( (from_wire.size() == 3) );
+  REMUS_ASSERT( (to_JobSubmission(from_wire[0]) == sub) );
+  REMUS_ASSERT( (std::string(from_wire[1].Header.data(),
+                             from_wire[1].Header.size()) == "single frame") );
+  REMUS_ASSERT( (from_wire[1].Blobs.size() == 0) );
+  REMUS_ASSERT( pointsInto(from_wire[1].Header.data(), received.Header) );
+
+  JobResult result = to_JobResult(from_wire[2]);
+  REMUS_ASSERT( (result.id() == id) );
+  REMUS_ASSERT( (result.data() == received.Blobs[4].data()) );
+
+  //an empty batch is still a valid batch
+  REMUS_ASSERT( (to_FrameSets(to_FrameSet(std::vector<FrameSet>())).size() == 0) );
+
+  //missing blob frames, or frames that aren't a batch, give no items
+  received.Blobs.pop_back();
+  REMUS_ASSERT( (to_FrameSets(received).size() == 0) );
+  REMUS_ASSERT( (to_FrameSets(items[0]).size() == 0) );
+}
+
+void referenced_frames_test()
+{
+  JobSubmission sub = make_Submission();
+  FrameSet frames = to_FrameSet(sub);
+
+  //the content hash of a blob is the hash of its content
+  REMUS_ASSERT( (to_ContentHash(frames.Blobs[2]) == sub["b"].hash()) );
+  REMUS_ASSERT( (to_ContentHash(frames.Blobs[1]) != sub["b"].hash()) );
+
+  //reference the large content, and send the rest
+  ReferencedFrameSet refs;
+  refs.Frames = frames;
+  refs.Hashes.resize(frames.Blobs.size());
+  refs.Referenced.resize(frames.Blobs.size(), false);
+  refs.Hashes[2] = sub["b"].hash();
+  refs.Referenced[2] = true;
+
+  FrameSet sent = to_FrameSet(refs);
+  REMUS_ASSERT( (sent.Blobs.size() == frames.Blobs.size() - 1) );
+  REMUS_ASSERT( (sent.Blobs[2].data() == frames.Blobs[3].data()) );
+
+  FrameSet received = copy_FrameSet(sent);
+  ReferencedFrameSet from_wire = to_ReferencedFrameSet(received);
+  REMUS_ASSERT( (from_wire.Frames.Blobs.size() == frames.Blobs.size()) );
+  REMUS_ASSERT( (from_wire.Hashes[2] == sub["b"].hash()) );
+  REMUS_ASSERT( (from_wire.Hashes[1].empty()) );
+  REMUS_ASSERT( (from_wire.Referenced[2] && !from_wire.Referenced[3]) );
+  REMUS_ASSERT( (from_wire.Frames.Blobs[2].size() == 0) );
+  REMUS_ASSERT( (from_wire.Frames.Blobs[3].data() == received.Blobs[2].data()) );
+
+  //filling in the referenced blob gives back the submission
+  from_wire.Frames.Blobs[2] = frames.Blobs[2];
+  REMUS_ASSERT( (to_JobSubmission(from_wire.Frames) == sub) );
+
+  //missing or extra blob frames, or frames that aren't references, are
+  //invalid
+  FrameSet missing = received;
+  missing.Blobs.pop_back();
+  REMUS_ASSERT( (to_ReferencedFrameSet(missing).Frames.Header.size() == 0) );
+  FrameSet extra = received;
+  extra.Blobs.push_back(frames.Blobs[2]);
+  REMUS_ASSERT( (to_ReferencedFrameSet(extra).Frames.Header.size() == 0) );
+  REMUS_ASSERT( (to_ReferencedFrameSet(frames).Frames.Header.size() == 0) );
+}
+
+void wire_format_frames_test()
+{
+  const JobSubmission sub = make_Submission();
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  const std::string data = remus::testing::BinaryDataGenerator(4000);
+  const JobResult result = make_JobResult(id, data);
+
+  //the text format is a single frame, the way older peers send it
+  FrameSet text = copy_FrameSet( to_FrameSet(sub, WireFormat::Text) );
+  REMUS_ASSERT( (text.Blobs.size() == 0) );
+  REMUS_ASSERT( (std::string(text.Header.data(), text.Header.size()) ==
+                 to_string(sub, WireFormat::Text)) );
+  REMUS_ASSERT( (to_JobSubmission(text) == sub) );
+  REMUS_ASSERT( (to_JobRequirements(text) == sub.requirements()) );
+
+  text = copy_FrameSet( to_FrameSet(result, WireFormat::Text) );
+  REMUS_ASSERT( (text.Blobs.size() == 0) );
+  JobResult from_wire = to_JobResult(text);
+  REMUS_ASSERT( (from_wire.id() == id) );
+  REMUS_ASSERT( (std::string(from_wire.data(),from_wire.dataSize()) == data) );
+
+  //jobs are sent to workers that only understand the text format the same way
+  text = copy_FrameSet( to_FrameSet(WorkerJob(id, sub), WireFormat::Text) );
+  REMUS_ASSERT( (text.Blobs.size() == 0) );
+  const WorkerJob job = to_WorkerJob(text);
+  REMUS_ASSERT( (job.id() == id) );
+  REMUS_ASSERT( (job.submission() == sub) );
+
+  //the binary format keeps the contents as their own frames
+  REMUS_ASSERT( (to_FrameSet(sub, WireFormat::Binary).Blobs.size() == 4) );
+  REMUS_ASSERT( (to_FrameSet(result, WireFormat::Binary).Blobs.size() == 1) );
+}
+
+}
+
+int UnitTestFrameSet(int, char *[])
+{
+  submission_frames_test();
+  result_frames_test();
+  compressed_frames_test();
+  worker_job_frames_test();
+  forward_submission_test();
+  batch_frames_test();
+  referenced_frames_test();
+  wire_format_frames_test();
+  return 0;
+}
@@ -11,8 +11,14 @@
 //=============================================================================
 
 #include <remus/proto/JobContent.h>
+#include <remus/common/Compression.h>
+#include <remus/common/MD5Hash.h>
 #include <remus/testing/Testing.h>
 
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/shared_array.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
 #include <algorithm>
 #include <vector>
 #include <set>
@@ -21,6 +27,14 @@ namespace {
 using namespace remus::common;
 using namespace remus::proto;
 
+//keeps a shared_array alive for as long as a shared_ptr deleter exists
+struct SharedArrayHolder
+{
+  explicit SharedArrayHolder(const boost::shared_array<char>& a): Array(a) {}
+  void operator()(const char*) { this->Array.reset(); }
+  boost::shared_array<char> Array;
+};
+
 
 struct make_empty_string
 {
@@ -146,6 +160,110 @@ void verify_tag()
   REMUS_ASSERT( (test.tag() == "hello") );
 }
 
+void verify_hash()
+{
+  //the hash only depends on the data, so equal data that isn't shared
+  //has an equal hash
+  make_large_string large_str_factory;
+  const std::string data = large_str_factory();
+  JobContent a = make_JobContent(data);
+  JobContent b = make_JobContent(data, ContentFormat::XML);
+  b.tag("tagged");
+  REMUS_ASSERT( (a.data() != b.data()) );
+  REMUS_ASSERT( (a.hash() == b.hash()) );
+  REMUS_ASSERT( (!a.hash().empty()) );
+
+  //the hash names the content in the blob stores of the server and workers,
+  //so it is a MD5 hash that can't be collided on purpose as easily
+  REMUS_ASSERT( (a.hash() == MD5Hash(data)) );
+
+  JobContent c = make_JobContent(data + "more");
+  REMUS_ASSERT( (a.hash() != c.hash()) );
+}
+
+void verify_compression()
+{
+  const bool haveZlib = haveCompressionCodec(ContentCompression::Zlib);
+
+  //text that compresses well
+  std::string text;
+  while(text.size() < 64 * 1024)
+    { text += "<Attribute Name=\"size\" Value=\"0.25\"/>\n"; }
+
+  JobContent input = make_JobContent(text, ContentFormat::XML);
+  input.tag("compressed");
+  input.compress(ContentCompression::Zlib, 1024);
+  REMUS_ASSERT( (input.compression() == ContentCompression::Zlib) );
+
+  //without zlib the content is stored as is
+  const std::string wire_format = to_string(input, WireFormat::Binary);
+  REMUS_ASSERT( ((wire_format.size() < text.size()) == haveZlib) );
+
+  JobContent from_wire = to_JobContent(wire_format);
+  REMUS_ASSERT( (from_wire.compression() == (haveZlib ?
+                      ContentCompression::Zlib : ContentCompression::None)) );
+  REMUS_ASSERT( (from_wire.formatType() == ContentFormat::XML) );
+  REMUS_ASSERT( (from_wire.tag() == "compressed") );
+  REMUS_ASSERT( (from_wire.dataSize() == text.size()) );
+
+  //a content that was received compressed is sent on unchanged
+  REMUS_ASSERT( (to_string(from_wire, WireFormat::Binary) == wire_format) );
+
+  REMUS_ASSERT( (std::string(from_wire.data(),from_wire.dataSize()) == text) );
+  REMUS_ASSERT( (from_wire == input) );
+  REMUS_ASSERT( (from_wire.hash() == input.hash()) );
+
+  //the text wire format is never compressed
+  JobContent from_text = to_JobContent(to_string(from_wire));
+  REMUS_ASSERT( (from_text.compression() == ContentCompression::None) );
+  REMUS_ASSERT( (from_text == input) );
+
+  //contents smaller than the threshold, or that don't get smaller, are
+  //stored as is
+  JobContent small = make_JobContent(text.substr(0,512));
+  small.compress(ContentCompression::Zlib, 1024);
+  REMUS_ASSERT( (to_JobContent(to_string(small, WireFormat::Binary)).compression()
+                  == ContentCompression::None) );
+
+  JobContent noise = make_JobContent(remus::testing::BinaryDataGenerator(4000));
+  noise.compress(ContentCompression::Zlib, 0);
+  JobContent noise_from_wire = to_JobContent(to_string(noise, WireFormat::Binary));
+  REMUS_ASSERT( (noise_from_wire.compression() == ContentCompression::None) );
+  REMUS_ASSERT( (noise_from_wire == noise) );
+
+  if(!haveZlib)
+    {
+    return;
+    }
+
+  //a content whose compressed data is corrupt is only found out when the
+  //data is first asked for, and is then empty. It is still sent on as it
+  //was received.
+  std::string corrupt = wire_format;
+  corrupt[corrupt.size() - 16] = static_cast<char>(corrupt[corrupt.size() - 16] ^ 0x55);
+  JobContent corrupt_from_wire = to_JobContent(corrupt);
+  REMUS_ASSERT( (corrupt_from_wire.tag() == "compressed") );
+  REMUS_ASSERT( (to_string(corrupt_from_wire, WireFormat::Binary) == corrupt) );
+  REMUS_ASSERT( (corrupt_from_wire.data() == NULL) );
+  REMUS_ASSERT( (corrupt_from_wire.dataSize() == 0) );
+
+  //a content that claims to be far larger than its compressed data can
+  //hold is rejected when it is read instead of becoming an empty content
+
+  std::string size_bytes(8, '\0');
+  for(int i=0; i < 8; ++i)
+    { size_bytes[i] = static_cast<char>((text.size() >> (8*i)) & 0xff); }
+  const std::size_t size_pos = wire_format.find(size_bytes);
+  REMUS_ASSERT( (size_pos != std::string::npos) );
+
+  std::string oversized = wire_format;
+  oversized.replace(size_pos, 8, std::string(7, '\xff') + '\x7f');
+  REMUS_ASSERT( (to_JobContent(oversized) == JobContent()) );
+
+  std::string undersized = wire_format;
+  undersized.replace(size_pos, 8, std::string(8, '\0'));
+  REMUS_ASSERT( (to_JobContent(undersized) == JobContent()) );
+}
 
 void verify_container_algorithm_support()
 {
@@ -241,6 +359,59 @@ void verify_serilization_with_tag(StringFactory factory)
   REMUS_ASSERT( (from_wire == input_content) );
 }
 
+template<typename StringFactory>
+void verify_binary_serilization(StringFactory factory)
+{
+  JobContent input_content = make_JobContent(factory(), ContentFormat::BSON);
+  input_content.tag("binary tag");
+
+  std::string wire_format = to_string(input_content, WireFormat::Binary);
+  JobContent from_wire = to_JobContent(wire_format);
+  wire_format = ""; //deallocate massive string
+
+  REMUS_ASSERT( (from_wire.sourceType() == input_content.sourceType() ) );
+  REMUS_ASSERT( (from_wire.formatType() == input_content.formatType() ) );
+  REMUS_ASSERT( (from_wire.tag() == input_content.tag() ) );
+  REMUS_ASSERT( (from_wire.dataSize() == input_content.dataSize() ) );
+
+  if(input_content.dataSize() > 0 )
+    {
+    REMUS_ASSERT( (from_wire.data() != NULL ) );
+    }
+  else
+    {
+    REMUS_ASSERT( (from_wire.data() == NULL ) );
+    }
+
+  REMUS_ASSERT( (from_wire == input_content) );
+}
+
+template<typename StringFactory>
+void verify_shared_deserilization(StringFactory factory)
+{
+  JobContent input_content = make_JobContent(factory(), ContentFormat::BSON);
+  const std::string wire_format = to_string(input_content, WireFormat::Binary);
+
+  //copy the wire format into a buffer that we can release
+  boost::shared_array<char> slab( new char[wire_format.size()] );
+  std::copy(wire_format.begin(), wire_format.end(), slab.get());
+  boost::shared_ptr<const char> buffer(slab.get(), SharedArrayHolder(slab));
+  slab.reset();
+
+  JobContent from_wire = to_JobContent(buffer, wire_format.size());
+  REMUS_ASSERT( (from_wire == input_content) );
+
+  if(input_content.dataSize() > 0 )
+    { //the content must point into the buffer, not at a copy
+    REMUS_ASSERT( (from_wire.data() > buffer.get()) );
+    REMUS_ASSERT( (from_wire.data() < buffer.get() + wire_format.size()) );
+    }
+
+  //releasing our reference to the buffer must not invalidate the content
+  buffer.reset();
+  REMUS_ASSERT( (from_wire == input_content) );
+}
+
 template<typename StringFactory>
 void verify_zero_copy_serilization(StringFactory factory)
 {
@@ -287,6 +458,8 @@ int UnitTestJobContent(int, char *[])
 {
   verify_source_and_format();
   verify_tag();
+  verify_hash();
+  verify_compression();
 
   verify_container_algorithm_support();
 
@@ -316,6 +489,26 @@ int UnitTestJobContent(int, char *[])
   verify_serilization_with_tag( (make_really_large_string()) );
   std::cout << std::endl;
 
+  std::cout << "verify_binary_serilization" << std::endl;
+  std::cout << "make_empty_string" << std::endl;
+  verify_binary_serilization( (make_empty_string()) );
+  std::cout << "make_small_string" << std::endl;
+  verify_binary_serilization( (make_small_string()) );
+  std::cout << "make_small_binary_string" << std::endl;
+  verify_binary_serilization( (make_small_binary_string()) );
+  std::cout << "make_large_string" << std::endl;
+  verify_binary_serilization( (make_large_string()) );
+  std::cout << std::endl;
+
+  std::cout << "verify_shared_deserilization" << std::endl;
+  std::cout << "make_empty_string" << std::endl;
+  verify_shared_deserilization( (make_empty_string()) );
+  std::cout << "make_small_binary_string" << std::endl;
+  verify_shared_deserilization( (make_small_binary_string()) );
+  std::cout << "make_large_string" << std::endl;
+  verify_shared_deserilization( (make_large_string()) );
+  std::cout << std::endl;
+
   std::cout << "verify_zero_copy_serilization" << std::endl;
   std::cout << "make_empty_string" << std::endl;
   verify_zero_copy_serilization( (make_empty_string()) );
@@ -265,6 +265,29 @@ void verify_serilization()
   REMUS_ASSERT( (reqs.requirementsSize() == reqs_serialized.requirementsSize()) );
 }
 
+void verify_binary_serilization()
+{
+  for(int i=0; i < 2048; ++i)
+  {
+    JobRequirements reqs = make_random_MeshReqs();
+    reqs.tag(randomString());
+    JobRequirements reqs_serialized =
+        to_JobRequirements( to_string(reqs, WireFormat::Binary) );
+
+    REMUS_ASSERT( (reqs == reqs_serialized) );
+    REMUS_ASSERT( (reqs.sourceType() == reqs_serialized.sourceType()) );
+    REMUS_ASSERT( (reqs.formatType() == reqs_serialized.formatType()) );
+    REMUS_ASSERT( (reqs.meshTypes() == reqs_serialized.meshTypes()) );
+    REMUS_ASSERT( (reqs.workerName() == reqs_serialized.workerName()) );
+    REMUS_ASSERT( (reqs.tag() == reqs_serialized.tag()) );
+    REMUS_ASSERT( (reqs.requirementsSize() == reqs_serialized.requirementsSize()) );
+
+    const bool same_reqs = std::equal(reqs.requirements(),
+                          reqs.requirements() + reqs.requirementsSize(),
+                          reqs_serialized.requirements());
+    REMUS_ASSERT( same_reqs );
+  }
+}
 
 void verify_req_set()
 {
@@ -299,6 +322,7 @@ int UnitTestJobRequirements(int, char *[])
   verify_less_than_op();
 
   verify_serilization();
+  verify_binary_serilization();
 
   verify_req_set();
   return 0;
@@ -57,6 +57,18 @@ remus::common::ContentFormat::Type ftype = remus::common::ContentFormat::User)
   std::string data_from_buffer(from_buffer.data(),from_buffer.dataSize());
   REMUS_ASSERT( (data_from_string == data_s) );
 
+  //verify the binary wire format
+  std::string binary = to_string(s, remus::proto::WireFormat::Binary);
+  JobResult from_binary = to_JobResult(binary);
+
+  REMUS_ASSERT( (from_binary.id() == s.id()) );
+  REMUS_ASSERT( (from_binary.dataSize() == s.dataSize()) );
+  REMUS_ASSERT( (from_binary.valid() == s.valid()) );
+  REMUS_ASSERT( (from_binary.formatType() == ftype) );
+
+  std::string data_from_binary(from_binary.data(),from_binary.dataSize());
+  REMUS_ASSERT( (data_from_binary == data_s) );
+
 }
 
 void serialize_test()
@@ -104,10 +116,51 @@ void serialize_test()
   validate_serialization(c);
 }
 
+void compression_test()
+{
+  using remus::common::ContentCompression;
+  const bool haveZlib =
+            remus::common::haveCompressionCodec(ContentCompression::Zlib);
+
+  std::string data;
+  while(data.size() < 64 * 1024)
+    { data += "{ \"points\": [0.0, 0.5, 1.0], \"cells\": [0, 1, 2] }\n"; }
+
+  JobResult r = make_JobResult( make_id(), data,
+                                remus::common::ContentFormat::JSON );
+  r.compress(ContentCompression::Zlib);
+  validate_serialization(r, remus::common::ContentFormat::JSON);
+
+  std::string binary = to_string(r, remus::proto::WireFormat::Binary);
+  REMUS_ASSERT( ((binary.size() < data.size()) == haveZlib) );
+
+  JobResult from_binary = to_JobResult(binary);
+  REMUS_ASSERT( (from_binary.compression() == (haveZlib ?
+                      ContentCompression::Zlib : ContentCompression::None)) );
+  REMUS_ASSERT( (to_string(from_binary, remus::proto::WireFormat::Binary) ==
+                 binary) );
+  REMUS_ASSERT( (from_binary.dataSize() == data.size()) );
+  REMUS_ASSERT( (std::string(from_binary.data(),from_binary.dataSize()) == data) );
+
+  //results whose compressed data is corrupt are sent on as they were
+  //received, and are invalid once the data is asked for
+  if(haveZlib)
+    {
+    std::string corrupt = binary;
+    corrupt[corrupt.size() - 16] = static_cast<char>(corrupt[corrupt.size() - 16] ^ 0x55);
+    JobResult corrupt_result = to_JobResult(corrupt);
+    REMUS_ASSERT( (to_string(corrupt_result, remus::proto::WireFormat::Binary) ==
+                   corrupt) );
+    REMUS_ASSERT( (!corrupt_result.valid()) );
+    REMUS_ASSERT( (corrupt_result.data() == NULL) );
+    }
+}
+
 }
 
 int UnitTestJobResult(int, char *[])
 {
   serialize_test();
+  compression_test();
   return 0;
 }
@@ -267,6 +267,38 @@ void to_from_string_test()
   REMUS_ASSERT( (from_wire == to_wire) );
 }
 
+void binary_wire_format_test()
+{ //verify the binary wire format round trips, and that the decoder
+  //detects which format was used
+  for(int i=0; i < 32; ++i)
+  {
+  JobRequirements reqs = make_random_MeshReqs();
+  std::map< std::string, JobContent > content;
+  for(std::size_t j = 0;  j < size_t(16); ++j)
+    { content.insert(make_random_MapPairs()); }
+  JobSubmission to_wire(reqs,content);
+
+  const std::string binary = to_string(to_wire, WireFormat::Binary);
+  const std::string text = to_string(to_wire, WireFormat::Text);
+  REMUS_ASSERT( (binary != text) );
+  REMUS_ASSERT( (text == to_string(to_wire)) );
+
+  JobSubmission from_binary = to_JobSubmission(binary);
+  JobSubmission from_text = to_JobSubmission(text);
+  REMUS_ASSERT( (from_binary == to_wire) );
+  REMUS_ASSERT( (from_binary == from_text) );
+  REMUS_ASSERT( (from_binary.requirements().tag() == reqs.tag()) );
+  }
+
+  //a truncated binary message must not decode into a valid submission
+  JobSubmission sub(make_random_MeshReqs());
+  sub["a"]= remus::proto::make_JobContent(remus::testing::BinaryDataGenerator(256));
+  const std::string binary = to_string(sub, WireFormat::Binary);
+  JobSubmission truncated = to_JobSubmission(binary.c_str(), binary.size()-1);
+  REMUS_ASSERT( (truncated.size() == 0) );
+  REMUS_ASSERT( (!truncated.type().valid()) );
+}
+
 void multiple_content_test()
 { //verify that a job submission with multiple key:values works properly
 
@@ -308,6 +340,7 @@ int UnitTestJobSubmission(int, char *[])
   insert_test();
   serialize_operator_test();
   to_from_string_test();
+  binary_wire_format_test();
 
   multiple_content_test();
 
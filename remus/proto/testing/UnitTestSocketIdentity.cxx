@@ -104,6 +104,15 @@ int UnitTestSocketIdentity(int, char *[])
   REMUS_ASSERT( (intSocket2.size() == 5) );
   REMUS_ASSERT( ( *intSocket2.data() == '\0') );
 
+  //verify that the request id is carried along, but isn't part of the
+  //identity of the socket
+  zmq::SocketIdentity taggedSocket(intSocket2);
+  REMUS_ASSERT( (taggedSocket.requestId().empty()) );
+  taggedSocket.requestId("request");
+  REMUS_ASSERT( (taggedSocket.requestId() == "request") );
+  REMUS_ASSERT( (taggedSocket == intSocket2) );
+  REMUS_ASSERT( (taggedSocket.name() == intSocket2.name()) );
+
   //we just need to verify that the encoding logic is correct.
   verify_uniqueness(randomIdentity);
   verify_uniqueness(nextIntegerIdentity);
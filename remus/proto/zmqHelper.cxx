@@ -111,6 +111,27 @@ void poll_safely(zmq_pollitem_t *items, int nitems, boost::int64_t timeout)
     }
 }
 
+//------------------------------------------------------------------------------
+void wake_up(zmq::context_t& context, const std::string& endpoint)
+{
+  zmq::socket_t socket(context, ZMQ_PUSH);
+  connectToAddress(socket, endpoint);
+
+  //don't block when nothing is bound to the endpoint, as that means the
+  //thread we are waking up isn't polling
+  zmq::message_t wake(0);
+  socket.send(wake, ZMQ_DONTWAIT);
+}
+
+//------------------------------------------------------------------------------
+void drain_wake_ups(zmq::socket_t& socket)
+{
+  zmq::message_t wake;
+  while(socket.recv(&wake, ZMQ_DONTWAIT))
+    {
+    }
+}
+
 } //namespace zmq
 
 //collection of methods that are private and can only be used by classes
@@ -173,6 +194,13 @@ bool recv_harder(zmq::socket_t& socket, zmq::message_t* message, int flags)
 //Returns true if we removed the ReqHeader, or if no header
 //needs to be removed
 bool removeReqHeader(zmq::socket_t& socket, int flags)
+{
+  std::string requestId;
+  return zmq::removeReqHeader(socket, requestId, flags);
+}
+
+//------------------------------------------------------------------------------
+bool removeReqHeader(zmq::socket_t& socket, std::string& requestId, int flags)
 {
   bool removedHeader = true;
   int socketType;
@@ -189,6 +217,11 @@ bool removeReqHeader(zmq::socket_t& socket, int flags)
       {
       removedHeader = false;
       }
+    if(removedHeader)
+      {
+      requestId.assign(static_cast<const char*>(reqHeader.data()),
+                       reqHeader.size());
+      }
     }
   return removedHeader;
 }
@@ -199,6 +232,13 @@ bool removeReqHeader(zmq::socket_t& socket, int flags)
 //Returns true if we added the ReqHeader, or if no header
 //needs to be added
 bool attachReqHeader(zmq::socket_t& socket, int flags)
+{
+  return zmq::attachReqHeader(socket, std::string(), flags);
+}
+
+//------------------------------------------------------------------------------
+bool attachReqHeader(zmq::socket_t& socket, const std::string& requestId,
+                     int flags)
 {
   bool attachedHeader = true;
   int socketType;
@@ -206,7 +246,9 @@ bool attachReqHeader(zmq::socket_t& socket, int flags)
   socket.getsockopt(ZMQ_TYPE,&socketType,&socketTypeSize);
   if(socketType != ZMQ_REQ && socketType != ZMQ_REP)
     {
-    zmq::message_t reqHeader(0);
+    zmq::message_t reqHeader(requestId.size());
+    std::copy(requestId.begin(), requestId.end(),
+              static_cast<char*>(reqHeader.data()));
     try
       {
       attachedHeader = zmq::send_harder(socket, reqHeader, flags|ZMQ_SNDMORE);
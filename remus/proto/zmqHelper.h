@@ -54,6 +54,18 @@ void connectToAddress(zmq::socket_t &socket,const zmq::socketInfo<T> &sInfo)
 REMUSPROTO_EXPORT
 void poll_safely(zmq_pollitem_t *items, int nitems, boost::int64_t timeout);
 
+//------------------------------------------------------------------------------
+//Wake up a thread that is polling its sockets, so that it doesn't have to
+//poll at a fixed rate to notice that it has been told to stop. The polling
+//thread binds a ZMQ_PULL socket to the inproc endpoint and polls it with
+//its other sockets. Waking up a thread that isn't polling does nothing.
+REMUSPROTO_EXPORT
+void wake_up(zmq::context_t& context, const std::string& endpoint);
+
+//remove every wake up that has been queued on the socket
+REMUSPROTO_EXPORT
+void drain_wake_ups(zmq::socket_t& socket);
+
 //------------------------------------------------------------------------------
 //specify a default linger so that if what we are connecting to
 //doesn't exist and we are told to shutdown we don't hang for ever
@@ -73,6 +85,18 @@ inline void set_socket_linger(zmq::socket_t &socket)
 // #endif
 }
 
+//------------------------------------------------------------------------------
+//remove the limit on how many messages a socket queues, so that sends on
+//it never block or drop messages. Only use this on inproc sockets between
+//threads that drain each other, and before binding or connecting.
+inline void remove_high_water_mark(zmq::socket_t &socket)
+{
+  //a value of zero means the socket has no limit on queued messages
+  int hwm = 0;
+  socket.setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
+  socket.setsockopt(ZMQ_RCVHWM, &hwm, sizeof(hwm));
+}
+
 //------------------------------------------------------------------------------
 //bind to initialInfo socket, and return that socket info
 template<typename T>
@@ -147,6 +171,13 @@ bool recv_harder(zmq::socket_t& socket, zmq::message_t* message, int flags=0);
 //needs to be removed
 bool removeReqHeader(zmq::socket_t& socket, int flags=0);
 
+//------------------------------------------------------------------------------
+//removes the ReqHeader, and stores what it holds in requestId. Clients that
+//tag their requests send the id of the request in place of the empty
+//ReqHeader, everybody else sends nothing.
+bool removeReqHeader(zmq::socket_t& socket, std::string& requestId,
+                     int flags=0);
+
 //------------------------------------------------------------------------------
 //we presume that every message needs to be treated like a Req/Rep
 //message and we need to pad a null message on everything
@@ -154,6 +185,13 @@ bool removeReqHeader(zmq::socket_t& socket, int flags=0);
 //needs to be added
 bool attachReqHeader(zmq::socket_t& socket,int flags=0);
 
+//------------------------------------------------------------------------------
+//adds a ReqHeader that holds the given request id, which is only sent on
+//sockets that aren't ZMQ_REQ or ZMQ_REP. An empty id adds the same empty
+//ReqHeader as above.
+bool attachReqHeader(zmq::socket_t& socket, const std::string& requestId,
+                     int flags=0);
+
 } //namespace zmq
 
 
@@ -95,7 +95,8 @@ SocketIdentity::SocketIdentity( const char* start, std::size_t s )
 SocketIdentity::SocketIdentity():
 Size(0),
 Data(),
-Name()
+Name(),
+RequestId()
 {
 }
 //reset our warnings to the original level
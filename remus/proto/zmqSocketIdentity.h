@@ -19,6 +19,11 @@
 #include <remus/proto/ProtoExports.h>
 
 #include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/functional/hash.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
 #ifdef REMUS_MSVC
  #pragma warning(push)
  #pragma warning(disable:4251)  /*dll-interface missing on stl type*/
@@ -46,12 +51,26 @@ struct REMUSPROTO_EXPORT SocketIdentity
   //readable name
   const std::string& name() const { return this->Name; }
 
+  //the id of the request that a response to this socket answers. Clients
+  //that have many requests outstanding tag each of them with an id, which
+  //is sent back with the response. The id isn't part of the identity of the
+  //socket, so it is ignored when comparing identities.
+  const std::string& requestId() const { return this->RequestId; }
+  void requestId(const std::string& id) { this->RequestId = id; }
+
 private:
   std::size_t Size;
   char Data[256];
   std::string Name;
+  std::string RequestId;
 };
 
+//allows socket identities to be used as keys of boost unordered containers
+inline std::size_t hash_value(const SocketIdentity& id)
+{
+  return boost::hash_range(id.data(), id.data() + id.size());
+}
+
 }
 
 #ifdef REMUS_MSVC
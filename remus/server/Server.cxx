@@ -14,39 +14,58 @@
 
 REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/thread.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/uuid/uuid.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <remus/proto/FrameSet.h>
 #include <remus/proto/Job.h>
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
 #include <remus/proto/JobRequirements.h>
+#include <remus/proto/JobSubmission.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
+#include <remus/proto/WorkerJob.h>
 #include <remus/proto/zmqSocketIdentity.h>
 #include <remus/proto/zmqHelper.h>
 
 #include <remus/worker/Job.h>
 
+#include <remus/common/MonotonicClock.h>
 #include <remus/common/PollingMonitor.h>
 
 #include <remus/server/detail/uuidHelper.h>
 #include <remus/server/detail/ActiveJobs.h>
+#include <remus/server/detail/BlobStore.h>
+#include <remus/server/detail/BrokerShards.h>
+#include <remus/server/detail/ClientRouter.h>
 #include <remus/server/detail/EventPublisher.h>
 #include <remus/server/detail/JobQueue.h>
+#include <remus/server/detail/JobStatusTable.h>
+#include <remus/server/detail/RequirementsRegistry.h>
+#include <remus/server/detail/SharedWorkerFactory.h>
 #include <remus/server/detail/SocketMonitor.h>
+#include <remus/server/detail/WorkerAffinity.h>
+#include <remus/server/detail/WorkerCaches.h>
 #include <remus/server/detail/WorkerPool.h>
 #include <remus/server/WorkerFactory.h>
 
+#include <algorithm>
 #include <set>
 #include <ctime>
+#include <sstream>
+#include <vector>
 
 namespace remus{
 namespace server{
 namespace detail{
 
+//the default number of bytes of contents kept in the blob store
+static const std::size_t DefaultBlobStoreSize = 512 * 1024 * 1024;
+
 //------------------------------------------------------------------------------
 void send_terminateWorker(boost::uuids::uuid jobId,
                           zmq::socket_t& socket,
@@ -75,13 +94,53 @@ void send_terminateJob(boost::uuids::uuid jobId,
                                          workerId);
 }
 
+//------------------------------------------------------------------------------
+//the item of a batch that only holds the given data
+remus::proto::FrameSet make_FrameSet(std::string data)
+{
+  remus::proto::FrameSet frames;
+  frames.Header = remus::proto::detail::make_HeaderFrame(data);
+  return frames;
+}
+
+//------------------------------------------------------------------------------
+//returns how many milliseconds the broker can sleep before it has to check
+//for changes in the workers and jobs. That is when a worker misses its
+//heartbeat, or when the factory has launched workers and it is time to ask
+//if they are still running. currentTime is the reading of the clock the
+//loop is using for this iteration.
+boost::int64_t time_until_worker_check(
+                      const remus::server::detail::SocketMonitor& monitor,
+                      const remus::server::WorkerFactoryBase& factory,
+                      remus::common::MonotonicClock::TimePoint currentTime,
+                      remus::common::MonotonicClock::TimePoint lastCheck,
+                      boost::int64_t checkInterval)
+{
+  typedef remus::common::MonotonicClock MonotonicClock;
+
+  boost::int64_t timeout = monitor.timeUntilNextDeadline();
+  if(factory.currentWorkerCount() > 0)
+    {
+    const MonotonicClock::TimePoint sinceLastCheck = currentTime - lastCheck;
+    const boost::int64_t untilFactoryCheck = std::max( boost::int64_t(0),
+          checkInterval - MonotonicClock::toMilliseconds(sinceLastCheck) );
+    timeout = std::min(timeout, untilFactoryCheck);
+    }
+  return timeout;
+}
+
 //------------------------------------------------------------------------------
 struct UUIDManagement
 {
   //----------------------------------------------------------------------------
   UUIDManagement()
   {
-    this->twister = boost::mt19937( static_cast<unsigned int>(std::time(0)) );
+    //the shards of a server are created at the same time, so the seed
+    //also depends on the instance to keep their job ids unique
+    std::size_t seed = 0;
+    boost::hash_combine(seed, std::time(0));
+    boost::hash_combine(seed, this);
+    this->twister = boost::mt19937( static_cast<unsigned int>(seed) );
     this->generator = boost::uuids::basic_random_generator<boost::mt19937>(&this->twister);
   }
 
@@ -103,7 +162,9 @@ struct ThreadManagement
     BrokerThread( new boost::thread() ),
     BrokeringStatus(),
     BrokerStatusChanged(),
-    BrokerIsRunning(false)
+    BrokerIsRunning(false),
+    WakeUpContext(),
+    WakeUpEndpoint()
   {
   }
 
@@ -149,9 +210,37 @@ struct ThreadManagement
   void stop()
   {
   this->setIsBrokering(false);
+  this->wakeUpBroker();
   this->BrokerThread->join();
   }
 
+  //----------------------------------------------------------------------------
+  //the broker sleeps until it has messages or a deadline passes, so it
+  //registers where it can be woken up to notice that it has been stopped
+  void setWakeUpEndpoint(const boost::shared_ptr<zmq::context_t>& context,
+                         const std::string& endpoint)
+  {
+  boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+  this->WakeUpContext = context;
+  this->WakeUpEndpoint = endpoint;
+  }
+
+  //----------------------------------------------------------------------------
+  void wakeUpBroker()
+  {
+  boost::shared_ptr<zmq::context_t> context;
+  std::string endpoint;
+    {
+    boost::lock_guard<boost::mutex> lock(this->BrokeringStatus);
+    context = this->WakeUpContext;
+    endpoint = this->WakeUpEndpoint;
+    }
+  if(context && !endpoint.empty())
+    {
+    zmq::wake_up(*context, endpoint);
+    }
+  }
+
   //----------------------------------------------------------------------------
   void waitForThreadToStart()
   {
@@ -192,6 +281,9 @@ private:
   boost::condition_variable BrokerStatusChanged;
   bool BrokerIsRunning;
 
+  boost::shared_ptr<zmq::context_t> WakeUpContext;
+  std::string WakeUpEndpoint;
+
 
 };
 
@@ -205,11 +297,22 @@ namespace server{
 //------------------------------------------------------------------------------
 Server::Server():
   PortInfo(),
-  QueuedJobs( new remus::server::detail::JobQueue() ),
+  Requirements( boost::make_shared<remus::server::detail::RequirementsRegistry>() ),
+  QueuedJobs( new remus::server::detail::JobQueue(Requirements) ),
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
-  WorkerPool( new remus::server::detail::WorkerPool() ),
+  WorkerPool( new remus::server::detail::WorkerPool(Requirements) ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
   Publish( new remus::server::detail::EventPublisher() ),
+  Blobs( boost::make_shared<remus::server::detail::BlobStore>(
+                                      detail::DefaultBlobStoreSize) ),
+  WorkerCaches( new remus::server::detail::WorkerCaches() ),
+  Affinity( new remus::server::detail::WorkerAffinity() ),
+  TextWorkers(),
+  Threading( SINGLE_THREADED ),
+  JobStatuses( boost::make_shared<remus::server::detail::JobStatusTable>() ),
+  TrackJobStatuses( false ),
+  ShardCount( 0 ),
+  ShardOfBroker( false ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
   WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() )
@@ -219,11 +322,22 @@ Server::Server():
 //------------------------------------------------------------------------------
 Server::Server(const boost::shared_ptr<remus::server::WorkerFactoryBase>& factory):
   PortInfo(),
-  QueuedJobs( new remus::server::detail::JobQueue() ),
+  Requirements( boost::make_shared<remus::server::detail::RequirementsRegistry>() ),
+  QueuedJobs( new remus::server::detail::JobQueue(Requirements) ),
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
-  WorkerPool( new remus::server::detail::WorkerPool() ),
+  WorkerPool( new remus::server::detail::WorkerPool(Requirements) ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
   Publish( new remus::server::detail::EventPublisher() ),
+  Blobs( boost::make_shared<remus::server::detail::BlobStore>(
+                                      detail::DefaultBlobStoreSize) ),
+  WorkerCaches( new remus::server::detail::WorkerCaches() ),
+  Affinity( new remus::server::detail::WorkerAffinity() ),
+  TextWorkers(),
+  Threading( SINGLE_THREADED ),
+  JobStatuses( boost::make_shared<remus::server::detail::JobStatusTable>() ),
+  TrackJobStatuses( false ),
+  ShardCount( 0 ),
+  ShardOfBroker( false ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
   WorkerFactory( factory )
@@ -233,11 +347,22 @@ Server::Server(const boost::shared_ptr<remus::server::WorkerFactoryBase>& factor
 //------------------------------------------------------------------------------
 Server::Server(const remus::server::ServerPorts& ports):
   PortInfo( ports ),
-  QueuedJobs( new remus::server::detail::JobQueue() ),
+  Requirements( boost::make_shared<remus::server::detail::RequirementsRegistry>() ),
+  QueuedJobs( new remus::server::detail::JobQueue(Requirements) ),
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
-  WorkerPool( new remus::server::detail::WorkerPool() ),
+  WorkerPool( new remus::server::detail::WorkerPool(Requirements) ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
   Publish( new remus::server::detail::EventPublisher() ),
+  Blobs( boost::make_shared<remus::server::detail::BlobStore>(
+                                      detail::DefaultBlobStoreSize) ),
+  WorkerCaches( new remus::server::detail::WorkerCaches() ),
+  Affinity( new remus::server::detail::WorkerAffinity() ),
+  TextWorkers(),
+  Threading( SINGLE_THREADED ),
+  JobStatuses( boost::make_shared<remus::server::detail::JobStatusTable>() ),
+  TrackJobStatuses( false ),
+  ShardCount( 0 ),
+  ShardOfBroker( false ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
   WorkerFactory( boost::make_shared<remus::server::WorkerFactory>() )
@@ -248,11 +373,22 @@ Server::Server(const remus::server::ServerPorts& ports):
 Server::Server(const remus::server::ServerPorts& ports,
                const boost::shared_ptr<remus::server::WorkerFactoryBase>& factory):
   PortInfo( ports ),
-  QueuedJobs( new remus::server::detail::JobQueue() ),
+  Requirements( boost::make_shared<remus::server::detail::RequirementsRegistry>() ),
+  QueuedJobs( new remus::server::detail::JobQueue(Requirements) ),
   SocketMonitor( new remus::server::detail::SocketMonitor() ),
-  WorkerPool( new remus::server::detail::WorkerPool() ),
+  WorkerPool( new remus::server::detail::WorkerPool(Requirements) ),
   ActiveJobs( new remus::server::detail::ActiveJobs () ),
   Publish( new remus::server::detail::EventPublisher() ),
+  Blobs( boost::make_shared<remus::server::detail::BlobStore>(
+                                      detail::DefaultBlobStoreSize) ),
+  WorkerCaches( new remus::server::detail::WorkerCaches() ),
+  Affinity( new remus::server::detail::WorkerAffinity() ),
+  TextWorkers(),
+  Threading( SINGLE_THREADED ),
+  JobStatuses( boost::make_shared<remus::server::detail::JobStatusTable>() ),
+  TrackJobStatuses( false ),
+  ShardCount( 0 ),
+  ShardOfBroker( false ),
   UUIDGenerator( new detail::UUIDManagement() ),
   Thread( new detail::ThreadManagement() ),
   WorkerFactory( factory )
@@ -286,6 +422,54 @@ remus::server::PollingRates Server::pollingRates() const
   return remus::server::PollingRates(low,high);
 }
 
+//------------------------------------------------------------------------------
+void Server::threadingMode(Server::ThreadingMode mode)
+{
+  this->Threading = mode;
+}
+
+//------------------------------------------------------------------------------
+Server::ThreadingMode Server::threadingMode() const
+{
+  return this->Threading;
+}
+
+//------------------------------------------------------------------------------
+void Server::shardCount(std::size_t count)
+{
+  this->ShardCount = count;
+}
+
+//------------------------------------------------------------------------------
+std::size_t Server::shardCount() const
+{
+  return this->ShardCount;
+}
+
+//------------------------------------------------------------------------------
+void Server::blobStoreSize(std::size_t bytes)
+{
+  this->Blobs->maxBytes(bytes);
+}
+
+//------------------------------------------------------------------------------
+std::size_t Server::blobStoreSize() const
+{
+  return this->Blobs->maxBytes();
+}
+
+//------------------------------------------------------------------------------
+void Server::affinityWait(boost::int64_t millisec)
+{
+  this->Affinity->maxWait(millisec);
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t Server::affinityWait() const
+{
+  return this->Affinity->maxWait();
+}
+
 //------------------------------------------------------------------------------
 bool Server::Brokering(Server::SignalHandling sh)
   {
@@ -297,9 +481,21 @@ bool Server::Brokering(Server::SignalHandling sh)
     this->StartCatchingSignals();
     }
 
-  zmq::socket_t clientChannel(*(this->PortInfo.context()),ZMQ_ROUTER);
-  zmq::socket_t workerChannel(*(this->PortInfo.context()),ZMQ_ROUTER);
-  zmq::socket_t statusChannel(*(this->PortInfo.context()),ZMQ_PUB);
+  //a shard of a sharded server binds inproc sockets that the server it
+  //belongs to connects to, and relays all our messages over
+  const bool isShard = this->ShardOfBroker;
+  zmq::socket_t clientChannel(*(this->PortInfo.context()),
+                              isShard ? ZMQ_PAIR : ZMQ_ROUTER);
+  zmq::socket_t workerChannel(*(this->PortInfo.context()),
+                              isShard ? ZMQ_PAIR : ZMQ_ROUTER);
+  zmq::socket_t statusChannel(*(this->PortInfo.context()),
+                              isShard ? ZMQ_PUSH : ZMQ_PUB);
+  if(isShard)
+    {
+    zmq::remove_high_water_mark(clientChannel);
+    zmq::remove_high_water_mark(workerChannel);
+    zmq::remove_high_water_mark(statusChannel);
+    }
 
   //attempts to bind to the sockets to the desired ports
   this->PortInfo.bindClient(&clientChannel);
@@ -310,28 +506,89 @@ bool Server::Brokering(Server::SignalHandling sh)
   this->Publish->socketToUse(&statusChannel);
 
   //give to the worker factory the endpoint information so it can properly
-  //setup workers. This needs to happen after the binding of the worker socket
-  this->WorkerFactory->portForWorkersToUse( this->PortInfo.worker() );
+  //setup workers. This needs to happen after the binding of the worker socket.
+  //The workers of a shard connect to the server the shard belongs to.
+  if(!isShard)
+    {
+    this->WorkerFactory->portForWorkersToUse( this->PortInfo.worker() );
+    }
 
-  //construct the pollitems to have client and workers so that we process
-  //messages from both sockets.
-  zmq::pollitem_t items[2] = {
-      { clientChannel, 0, ZMQ_POLLIN, 0 },
-      { workerChannel, 0, ZMQ_POLLIN, 0 } };
+  //we sleep until we have messages or a deadline passes, so other threads
+  //need a way to wake us up when brokering is stopped
+  zmq::socket_t wakeUpChannel(*(this->PortInfo.context()), ZMQ_PULL);
+  const zmq::socketInfo<zmq::proto::inproc> wakeUpInfo(
+                                  remus::to_string((*this->UUIDGenerator)()) );
+  zmq::bindToAddress(wakeUpChannel, wakeUpInfo);
+  this->Thread->setWakeUpEndpoint(this->PortInfo.context(),
+                                  wakeUpInfo.endpoint());
+
+  if(this->Threading == SHARDED && !isShard)
+    {
+    //the shards own the jobs and workers, all we do is route messages
+    //between them and the clients and workers
+    this->RouteToShards(clientChannel, workerChannel, statusChannel,
+                        wakeUpChannel);
+    this->Thread->setWakeUpEndpoint(boost::shared_ptr<zmq::context_t>(),
+                                    std::string());
+
+    this->Publish->stop();
+    if(sh == CAPTURE)
+      {
+      this->StopCatchingSignals();
+      }
+    return true;
+    }
+
+  //when brokering with multiple threads the client socket is handed to a
+  //router running on its own thread. It answers job status queries, and
+  //forwards all other client requests to us over an inproc socket.
+  zmq::socket_t* clientRequests = &clientChannel;
+  boost::scoped_ptr<zmq::socket_t> schedulerChannel;
+  boost::scoped_ptr<remus::server::detail::ClientRouter> clientRouter;
+  if(this->Threading == MULTI_THREADED)
+    {
+    //the table isn't kept up to date otherwise, so it starts out empty.
+    //Jobs it doesn't know are asked of this thread by the router
+    this->JobStatuses->clear();
+    this->TrackJobStatuses = true;
+
+    const zmq::socketInfo<zmq::proto::inproc> schedulerInfo(
+                                  remus::to_string((*this->UUIDGenerator)()) );
+    schedulerChannel.reset(
+                new zmq::socket_t(*(this->PortInfo.context()),ZMQ_PAIR) );
+    remus::server::detail::ClientRouter::bindSchedulerChannel(
+                                               *schedulerChannel,
+                                               schedulerInfo);
+
+    clientRouter.reset( new remus::server::detail::ClientRouter(
+                                    clientChannel, *schedulerChannel,
+                                    schedulerInfo, *(this->PortInfo.context()),
+                                    this->JobStatuses) );
+    clientRouter->start();
+    clientRequests = schedulerChannel.get();
+    }
 
-  //keeps track of what our polling interval is, and adjusts it to
-  //handle operating systems that throttle our polling.
+  //construct the pollitems to have client and workers so that we process
+  //messages from both sockets. We also poll the socket other threads use to
+  //wake us up, so that we can sleep until our next deadline.
+  zmq::pollitem_t items[3] = {
+      { *clientRequests, 0, ZMQ_POLLIN, 0 },
+      { workerChannel, 0, ZMQ_POLLIN, 0 },
+      { wakeUpChannel, 0, ZMQ_POLLIN, 0 } };
+
+  //keeps track of how long our polls take, so that we can detect operating
+  //systems that throttle our polling, and not mark workers as dead when
+  //that happens
   remus::common::PollingMonitor monitor = this->SocketMonitor->pollingMonitor();
 
-  //keep track of current time since we last purged dead workers
-  //we want to clear every dead workers every 250ms.
-  boost::posix_time::ptime currentTime =
-                            boost::posix_time::microsec_clock::local_time();
+  //the worker factory needs to be asked every 250ms if the workers it has
+  //launched are still running. Missed heartbeats are checked as they
+  //happen, as the socket monitor tells us when the next one is.
+  typedef remus::common::MonotonicClock MonotonicClock;
+  MonotonicClock::TimePoint currentTime = MonotonicClock::now();
 
   const boost::int64_t workerCheckInterval(250);
-  boost::posix_time::ptime whenToCheckForDeadOrCompletedWorkers =
-                      boost::posix_time::microsec_clock::local_time() +
-                      boost::posix_time::milliseconds(workerCheckInterval);
+  MonotonicClock::TimePoint lastCheckForDeadOrCompletedWorkers = currentTime;
 
   //We need to notify the Thread management that brokering is about to start.
   //This allows the calling thread to resume, as it has been waiting for this
@@ -345,17 +602,29 @@ bool Server::Brokering(Server::SignalHandling sh)
     //number of living workers. This is done
     bool worker_shutting_down = false;
 
-    zmq::poll_safely(&items[0], 2, monitor.current());
+    //sleep until a message arrives, until we need to check the workers,
+    //or until a job has waited long enough for a worker it has affinity with
+    const boost::int64_t timeout = std::min(
+                      detail::time_until_worker_check(*this->SocketMonitor,
+                                          *this->WorkerFactory,
+                                          currentTime,
+                                          lastCheckForDeadOrCompletedWorkers,
+                                          workerCheckInterval),
+                      this->Affinity->timeUntilNextDeadline(currentTime) );
+    zmq::poll_safely(&items[0], 3, std::max(timeout, boost::int64_t(1)) );
     monitor.pollOccurred();
 
-    //update the current time
-    currentTime = boost::posix_time::microsec_clock::local_time();
+    //the poll has read the clock, use that reading as the current time
+    //for the rest of this iteration
+    currentTime = monitor.lastPollTime();
 
+    bool handledMessage = false;
     if (items[0].revents & ZMQ_POLLIN)
       {
       //we need to strip the client address from the message
-      zmq::SocketIdentity clientIdentity = zmq::address_recv(clientChannel);
-      this->DetermineClientResponse(clientChannel, clientIdentity, workerChannel);
+      zmq::SocketIdentity clientIdentity = zmq::address_recv(*clientRequests);
+      this->DetermineClientResponse(*clientRequests, clientIdentity, workerChannel);
+      handledMessage = true;
       }
     if (items[1].revents & ZMQ_POLLIN)
       {
@@ -363,24 +632,47 @@ bool Server::Brokering(Server::SignalHandling sh)
       //we need to strip the worker address from the message
       zmq::SocketIdentity workerIdentity = zmq::address_recv(workerChannel);
       this->DetermineWorkerResponse(workerChannel,workerIdentity,worker_shutting_down  );
+      handledMessage = true;
+      }
+    if (items[2].revents & ZMQ_POLLIN)
+      {
+      //we have been woken up, the loop condition tells us if we need to stop
+      zmq::drain_wake_ups(wakeUpChannel);
       }
 
-    //only purge dead workers every 250ms or every time a worker shuts down
-    if(whenToCheckForDeadOrCompletedWorkers <= currentTime || worker_shutting_down)
+    //purge dead workers when a deadline has passed, or when a worker shuts down
+    const bool checkWorkers = worker_shutting_down ||
+          detail::time_until_worker_check(*this->SocketMonitor,
+                                          *this->WorkerFactory,
+                                          currentTime,
+                                          lastCheckForDeadOrCompletedWorkers,
+                                          workerCheckInterval) == 0;
+    if(checkWorkers)
       {
       this->CheckForChangeInWorkersAndJobs();
-      whenToCheckForDeadOrCompletedWorkers = currentTime +
-                      boost::posix_time::milliseconds(workerCheckInterval);
+      lastCheckForDeadOrCompletedWorkers = currentTime;
       }
 
     //see if we have a worker in the pool for the next job in the queue,
-    //otherwise as the factory to generate a new worker to handle that job
-    if(Thread->isBrokering())
+    //otherwise as the factory to generate a new worker to handle that job.
+    //Only messages and the worker checks can change which jobs and workers
+    //can be matched, so we match as soon as they happen
+    const bool affinityExpired =
+                  this->Affinity->timeUntilNextDeadline(currentTime) == 0;
+    if(Thread->isBrokering() && (handledMessage || checkWorkers ||
+                                 affinityExpired))
       {
       this->FindWorkerForQueuedJob( workerChannel );
       }
     }
 
+  this->Thread->setWakeUpEndpoint(boost::shared_ptr<zmq::context_t>(),
+                                  std::string());
+
+  //stop routing client requests before we close the client socket
+  clientRouter.reset();
+  this->TrackJobStatuses = false;
+
   this->Publish->stop();
 
   //this should only happen with interrupted threads is hit; lets make sure we close
@@ -428,10 +720,16 @@ void Server::waitForBrokeringToStart()
 
 //------------------------------------------------------------------------------
 void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
-                                     const zmq::SocketIdentity& clientIdentity,
+                                     const zmq::SocketIdentity& sender,
                                      zmq::socket_t& workerChannel)
 {
   remus::proto::Message msg = remus::proto::receive_Message(&clientChannel);
+
+  //the response is tagged with the id of the request, so that clients with
+  //many requests outstanding can tell which one it answers
+  zmq::SocketIdentity clientIdentity(sender);
+  clientIdentity.requestId(msg.requestId());
+
   //server response is the general response message type
   //the client can than convert it to the expected type
   if(!msg.isValid())
@@ -489,9 +787,12 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
       //retrieves the current result of the job related to the passed
       //proto::Job. Returns a proto::JobResult. The result is than deleted
       //from the server.
-      //If no result exists will return an invalid JobResult
-      response_data = this->retrieveResult(msg);
-      break;
+      //If no result exists will return an invalid JobResult.
+      //The result is sent as multiple frames so that its data isn't copied
+      remus::proto::send_NonBlockingResponse(response_service,
+                                             this->retrieveResult(msg),
+                                             &clientChannel, clientIdentity);
+      return;
     case remus::TERMINATE_JOB:
       //Will try to terminate the given proto::Job.
       //If the job is currently queued on the server it will be eliminated
@@ -501,6 +802,47 @@ void Server::DetermineClientResponse(zmq::socket_t& clientChannel,
       //we can do nothing to stop it
       response_data = this->terminateJob(workerChannel,msg);
       break;
+    case remus::MAKE_MESHES:
+      //the bulk version of MAKE_MESH. Queues a batch of submissions that
+      //all share the MeshIOType of the message and returns a batch with
+      //the proto::Job of each of them
+      remus::proto::send_NonBlockingResponse(response_service,
+                                             this->queueJobs(msg),
+                                             &clientChannel, clientIdentity);
+      return;
+    case remus::MESH_STATUSES:
+      //the bulk version of MESH_STATUS. Returns a batch with the
+      //proto::JobStatus of each proto::Job in the message
+      remus::proto::send_NonBlockingResponse(response_service,
+                                             this->meshStatuses(msg),
+                                             &clientChannel, clientIdentity);
+      return;
+    case remus::RETRIEVE_RESULTS:
+      //the bulk version of RETRIEVE_RESULT. Returns a batch with the
+      //proto::JobResult of each proto::Job in the message, which are
+      //deleted from the server
+      remus::proto::send_NonBlockingResponse(response_service,
+                                             this->retrieveResults(msg),
+                                             &clientChannel, clientIdentity);
+      return;
+    case remus::TERMINATE_JOBS:
+      //the bulk version of TERMINATE_JOB. Returns a batch with the
+      //proto::JobStatus of each proto::Job in the message
+      remus::proto::send_NonBlockingResponse(response_service,
+                                             this->terminateJobs(workerChannel,msg),
+                                             &clientChannel, clientIdentity);
+      return;
+    case remus::MISSING_BLOBS:
+      //returns which of the given content hashes aren't in the blob store,
+      //so the client knows which contents it has to send
+      response_data = this->missingBlobs(msg);
+      break;
+    case remus::MAKE_MESH_FROM_BLOBS:
+      //queues a proto::JobSubmission whose contents can be references
+      //to the blob store, and returns a proto::Job. Returns an invalid
+      //job when a referenced content isn't in the blob store
+      response_data = this->queueJobFromBlobs(msg);
+      break;
     default:
       response_service = remus::INVALID_SERVICE;
       response_data = remus::INVALID_MSG;
@@ -595,64 +937,147 @@ std::string Server::meshRequirements(const remus::proto::Message& msg)
 std::string Server::meshStatus(const remus::proto::Message& msg)
 {
   remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
-  remus::proto::JobStatus js(job.id(),remus::INVALID_STATUS);
-  if(this->QueuedJobs->haveUUID(job.id()))
-    {
-    js = remus::proto::JobStatus(job.id(),remus::QUEUED);
-    }
-  else if(this->ActiveJobs->haveUUID(job.id()))
-    {
-    js = this->ActiveJobs->status(job.id());
-    }
-  return remus::proto::to_string(js);
+  return remus::proto::to_string(this->currentStatus(job.id()));
 }
 
 //------------------------------------------------------------------------------
 std::string Server::queueJob(const remus::proto::Message& msg)
+{
+  return this->queueJob(msg.MeshIOType(), msg.frames());
+}
+
+//------------------------------------------------------------------------------
+std::string Server::queueJob(const remus::common::MeshIOType& type,
+                             const remus::proto::FrameSet& submission,
+                             const std::vector<std::string>& blobHashes)
 {
   //generate an UUID
   const boost::uuids::uuid jobUUID = (*this->UUIDGenerator)();
 
-  //create a new job to place on the queue
-  const remus::proto::JobSubmission submission =
-                  remus::proto::to_JobSubmission(msg.data(),msg.dataSize());
+  //create a new job to place on the queue. We only need the requirements
+  //to schedule the job, so the contents of the submission are never decoded.
+  //Instead the frames are kept as received and forwarded to the worker.
+  const remus::proto::JobRequirements reqs =
+                              remus::proto::to_JobRequirements(submission);
 
-  this->QueuedJobs->addJob(jobUUID,submission);
+  this->QueuedJobs->addJob(jobUUID,reqs,submission,blobHashes);
+  this->updateStatusTable(jobUUID);
 
 
-  const remus::proto::Job validJob(jobUUID,msg.MeshIOType());
+  const remus::proto::Job validJob(jobUUID,type);
 
   //publish the job has been queued
-  this->Publish->jobQueued(validJob, submission.requirements() );
+  this->Publish->jobQueued(validJob, reqs );
 
   //return the UUID
   return remus::proto::to_string(validJob);
 }
 
 //------------------------------------------------------------------------------
-std::string Server::retrieveResult(const remus::proto::Message& msg)
+std::string Server::missingBlobs(const remus::proto::Message& msg)
 {
-  //go to the active jobs list and grab the mesh result if it exists
-  remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
+  //the hashes are sent one per line, and we respond the same way. Marking
+  //the blobs we have as used keeps them around for the submission that
+  //will follow
+  std::istringstream hashes(std::string(msg.data(), msg.dataSize()));
+  std::ostringstream missing;
+  std::string hash;
+  while(std::getline(hashes, hash))
+    {
+    if(!hash.empty() && !this->Blobs->touch(hash))
+      {
+      missing << hash << '\n';
+      }
+    }
+  return missing.str();
+}
+
+//------------------------------------------------------------------------------
+std::string Server::queueJobFromBlobs(const remus::proto::Message& msg)
+{
+  remus::proto::ReferencedFrameSet refs =
+                      remus::proto::to_ReferencedFrameSet(msg.frames());
+
+  //an invalid job tells the client to send the whole submission instead
+  const remus::proto::Job invalidJob = remus::proto::make_invalidJob();
+  if(refs.Frames.Header.size() == 0)
+    {
+    return remus::proto::to_string(invalidJob);
+    }
+
+  std::vector<remus::proto::Frame>& blobs = refs.Frames.Blobs;
+  for(std::size_t i=0; i < blobs.size(); ++i)
+    {
+    const std::string& hash = refs.Hashes[i];
+    if(refs.Referenced[i])
+      {
+      //the queued job shares the blob with the store
+      if(!this->Blobs->find(hash, blobs[i]))
+        {
+        return remus::proto::to_string(invalidJob);
+        }
+      }
+    else if(!hash.empty())
+      {
+      //verify the hash before storing the blob, otherwise a bad hash would
+      //give other submissions the wrong contents
+      if(remus::proto::to_ContentHash(blobs[i]) != hash)
+        {
+        return remus::proto::to_string(invalidJob);
+        }
+      this->Blobs->add(hash, blobs[i]);
+      }
+    }
+
+  //keep the hashes so workers that cache blobs are only sent the
+  //blobs they don't hold
+  return this->queueJob(msg.MeshIOType(), refs.Frames, refs.Hashes);
+}
 
-  remus::proto::JobResult result(job.id());
+//------------------------------------------------------------------------------
+remus::proto::FrameSet Server::retrieveResult(const remus::proto::Message& msg)
+{
+  const remus::proto::FrameSet result =
+      this->retrieveResult(remus::proto::to_Job(msg.data(),msg.dataSize()));
+  if(msg.wireFormat() == remus::proto::WireFormat::Text)
+    {
+    //clients that only understand the text wire format expect the whole
+    //result in a single text frame
+    return remus::proto::to_FrameSet(remus::proto::to_JobResult(result),
+                                     remus::proto::WireFormat::Text);
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::FrameSet Server::retrieveResult(const remus::proto::Job& job)
+{
+  //go to the active jobs list and grab the mesh result if it exists
   if( this->ActiveJobs->haveUUID(job.id()) &&
       this->ActiveJobs->haveResult(job.id()))
     {
-    result = this->ActiveJobs->result(job.id());
+    remus::proto::FrameSet result = this->ActiveJobs->result(job.id());
     //for now we remove all references from this job being active
     this->ActiveJobs->remove(job.id());
+    this->updateStatusTable(job.id());
+    return result;
     }
   //return an empty result
-  return remus::proto::to_string(result);
+  return remus::proto::to_FrameSet(remus::proto::JobResult(job.id()));
 }
 
 //------------------------------------------------------------------------------
 std::string Server::terminateJob(zmq::socket_t& workerChannel,
                                  const remus::proto::Message& msg)
 {
-  remus::proto::Job job = remus::proto::to_Job(msg.data(),msg.dataSize());
+  return this->terminateJob(workerChannel,
+                            remus::proto::to_Job(msg.data(),msg.dataSize()));
+}
 
+//------------------------------------------------------------------------------
+std::string Server::terminateJob(zmq::socket_t& workerChannel,
+                                 const remus::proto::Job& job)
+{
   const bool currentlyInQueue = this->QueuedJobs->haveUUID(job.id());
   const bool currentlyActive = this->ActiveJobs->haveUUID(job.id());
   const bool eligableForTermination = currentlyInQueue || currentlyActive;
@@ -669,6 +1094,8 @@ std::string Server::terminateJob(zmq::socket_t& workerChannel,
   if(currentlyInQueue)
     {
     this->QueuedJobs->remove(job.id());
+    this->Affinity->forgetJob(job.id());
+    this->updateStatusTable(job.id());
 
     //publish that this job is now terminated and what it's last status was
     remus::proto::JobStatus lastStatus(job.id(),remus::QUEUED);
@@ -693,6 +1120,81 @@ std::string Server::terminateJob(zmq::socket_t& workerChannel,
   return remus::proto::to_string(jstatus);
 }
 
+//------------------------------------------------------------------------------
+remus::proto::FrameSet Server::queueJobs(const remus::proto::Message& msg)
+{
+  //every submission is queued as its own job, in the order they were sent
+  const std::vector<remus::proto::FrameSet> submissions =
+                                    remus::proto::to_FrameSets(msg.frames());
+
+  std::vector<remus::proto::FrameSet> jobs;
+  jobs.reserve(submissions.size());
+  typedef std::vector<remus::proto::FrameSet>::const_iterator cit;
+  for(cit i = submissions.begin(); i != submissions.end(); ++i)
+    {
+    jobs.push_back( detail::make_FrameSet(
+                      this->queueJob(msg.MeshIOType(), *i)) );
+    }
+  return remus::proto::to_FrameSet(jobs);
+}
+
+//------------------------------------------------------------------------------
+remus::proto::FrameSet Server::meshStatuses(const remus::proto::Message& msg)
+{
+  const std::vector<remus::proto::FrameSet> items =
+                                    remus::proto::to_FrameSets(msg.frames());
+
+  std::vector<remus::proto::FrameSet> statuses;
+  statuses.reserve(items.size());
+  typedef std::vector<remus::proto::FrameSet>::const_iterator cit;
+  for(cit i = items.begin(); i != items.end(); ++i)
+    {
+    const remus::proto::Job job =
+              remus::proto::to_Job(i->Header.data(),i->Header.size());
+    statuses.push_back( detail::make_FrameSet(
+              remus::proto::to_string(this->currentStatus(job.id()))) );
+    }
+  return remus::proto::to_FrameSet(statuses);
+}
+
+//------------------------------------------------------------------------------
+remus::proto::FrameSet Server::retrieveResults(const remus::proto::Message& msg)
+{
+  const std::vector<remus::proto::FrameSet> items =
+                                    remus::proto::to_FrameSets(msg.frames());
+
+  //the results keep their frames, so their data isn't copied
+  std::vector<remus::proto::FrameSet> results;
+  results.reserve(items.size());
+  typedef std::vector<remus::proto::FrameSet>::const_iterator cit;
+  for(cit i = items.begin(); i != items.end(); ++i)
+    {
+    results.push_back( this->retrieveResult(
+          remus::proto::to_Job(i->Header.data(),i->Header.size())) );
+    }
+  return remus::proto::to_FrameSet(results);
+}
+
+//------------------------------------------------------------------------------
+remus::proto::FrameSet Server::terminateJobs(zmq::socket_t& workerChannel,
+                                             const remus::proto::Message& msg)
+{
+  const std::vector<remus::proto::FrameSet> items =
+                                    remus::proto::to_FrameSets(msg.frames());
+
+  std::vector<remus::proto::FrameSet> statuses;
+  statuses.reserve(items.size());
+  typedef std::vector<remus::proto::FrameSet>::const_iterator cit;
+  for(cit i = items.begin(); i != items.end(); ++i)
+    {
+    const remus::proto::Job job =
+              remus::proto::to_Job(i->Header.data(),i->Header.size());
+    statuses.push_back( detail::make_FrameSet(
+              this->terminateJob(workerChannel,job)) );
+    }
+  return remus::proto::to_FrameSet(statuses);
+}
+
 //------------------------------------------------------------------------------
 void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
                                      const zmq::SocketIdentity &workerIdentity,
@@ -722,6 +1224,7 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
       //to response is required to this
       const remus::proto::JobRequirements reqs =
             remus::proto::to_JobRequirements(msg.data(),msg.dataSize());
+      this->updateWorkerFormat(workerIdentity, msg);
       this->WorkerPool->addWorker(workerIdentity,reqs);
       this->Publish->workerRegistered(workerIdentity, reqs);
       }
@@ -733,8 +1236,16 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
       //The worker is waiting for us to respond to the service call
       const remus::proto::JobRequirements reqs =
             remus::proto::to_JobRequirements(msg.data(),msg.dataSize());
+      this->updateWorkerFormat(workerIdentity, msg);
       this->WorkerPool->readyForWork(workerIdentity,reqs);
       this->Publish->workerReady(workerIdentity, reqs);
+
+      //the worker might be the one a waiting job has affinity with, but
+      //the pool only marks a type dirty when its first worker is waiting
+      if(this->Affinity->hasDeferredJobs())
+        {
+        this->QueuedJobs->markDirty(this->Requirements->find(reqs));
+        }
       }
       break;
     case remus::MESH_STATUS:
@@ -742,6 +1253,11 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
       //no response needed
       this->storeMeshStatus(workerIdentity, msg);
       break;
+    case remus::CACHED_BLOBS:
+      //the worker is telling us every blob it holds in its blob cache,
+      //we acknowledge it so the worker can drop the blobs it has evicted
+      this->storeCachedBlobs(workerChannel, workerIdentity, msg);
+      break;
     case remus::RETRIEVE_RESULT:
       {
       //We can't have a worker shutdown before the results are
@@ -776,6 +1292,10 @@ void Server::DetermineWorkerResponse(zmq::socket_t& workerChannel,
       //else as the WorkerPool and ActiveJobs will find out about the dead
       //worker by asking the SocketMonitor
       this->SocketMonitor->markAsDead(workerIdentity);
+      this->WorkerCaches->remove(workerIdentity);
+      this->TextWorkers.erase(std::string(workerIdentity.data(),
+                                          workerIdentity.size()));
+      this->Affinity->remove(workerIdentity);
       this->Publish->workerTerminated(workerIdentity);
       workerTerminated = true;
     default:
@@ -800,6 +1320,7 @@ void Server::storeMeshStatus(const zmq::SocketIdentity &workerIdentity,
   remus::proto::JobStatus js = remus::proto::to_JobStatus(msg.data(),
                                                           msg.dataSize());
   this->ActiveJobs->updateStatus(js);
+  this->updateStatusTable(js.id());
 
   this->Publish->jobStatus(js, workerIdentity);
 }
@@ -808,23 +1329,108 @@ void Server::storeMeshStatus(const zmq::SocketIdentity &workerIdentity,
 void Server::storeMesh(const zmq::SocketIdentity &workerIdentity,
                        const remus::proto::Message& msg)
 {
-  remus::proto::JobResult jr = remus::proto::to_JobResult(msg.data(),
-                                                            msg.dataSize());
-  this->ActiveJobs->updateResult(jr);
+  //we keep the frames as they were received and send them on to the
+  //client as is. The result is only decoded for its id, its data is
+  //never decompressed or copied by the server.
+  const remus::proto::FrameSet frames = msg.frames();
+  remus::proto::JobResult jr = remus::proto::to_JobResult(frames);
+  this->ActiveJobs->updateResult(jr.id(), frames);
+  this->updateStatusTable(jr.id());
 
   this->Publish->jobFinished(jr, workerIdentity);
 }
 
+//------------------------------------------------------------------------------
+void Server::storeCachedBlobs(zmq::socket_t& workerChannel,
+                              const zmq::SocketIdentity &workerIdentity,
+                              const remus::proto::Message& msg)
+{
+  //the first line is the number of the advert, which we send back as the
+  //acknowledgement. The hashes follow one per line
+  std::istringstream buffer(std::string(msg.data(), msg.dataSize()));
+  std::string advert;
+  std::getline(buffer, advert);
+
+  remus::server::detail::WorkerCaches::HashSet hashes;
+  std::string hash;
+  while(std::getline(buffer, hash))
+    {
+    if(!hash.empty())
+      {
+      hashes.insert(hash);
+      }
+    }
+  this->WorkerCaches->update(workerIdentity, hashes);
+
+  remus::proto::send_NonBlockingResponse(remus::CACHED_BLOBS,
+                                         advert,
+                                         &workerChannel,
+                                         workerIdentity);
+}
+
+//------------------------------------------------------------------------------
+void Server::updateWorkerFormat(const zmq::SocketIdentity &workerIdentity,
+                                const remus::proto::Message& msg)
+{
+  const std::string key(workerIdentity.data(), workerIdentity.size());
+  if(msg.wireFormat() == remus::proto::WireFormat::Text)
+    {
+    this->TextWorkers.insert(key);
+    }
+  else
+    {
+    this->TextWorkers.erase(key);
+    }
+}
+
 //------------------------------------------------------------------------------
 void Server::assignJobToWorker(zmq::socket_t& workerChannel,
                                const zmq::SocketIdentity &workerIdentity,
-                               const remus::worker::Job& job )
+                               const remus::server::detail::QueuedJob& job )
 {
   this->ActiveJobs->add( workerIdentity, job.id() );
+  this->updateStatusTable(job.id());
+
+  //the submission frames are sent to the worker as they were received,
+  //unless the worker only understands the text wire format
+  const bool textWorker = this->TextWorkers.count(
+      std::string(workerIdentity.data(), workerIdentity.size())) > 0;
+  remus::proto::FrameSet frames;
+  if(textWorker)
+    {
+    const remus::proto::WorkerJob workerJob(job.id(),
+                          remus::proto::to_JobSubmission(job.submission()));
+    frames = remus::proto::to_FrameSet(workerJob,
+                                       remus::proto::WireFormat::Text);
+    }
+  else
+    {
+    frames = remus::proto::to_FrameSet(job.id(), job.submission());
+    }
+
+  if(!textWorker && this->WorkerCaches->hasCache(workerIdentity))
+    {
+    //the worker caches blobs, so we tell it the hash of each blob and
+    //only send the blobs it doesn't hold. The first blob is the header of
+    //the submission, which isn't cached
+    remus::proto::ReferencedFrameSet refs;
+    refs.Frames = frames;
+    refs.Hashes.resize(frames.Blobs.size());
+    refs.Referenced.resize(frames.Blobs.size(), false);
+
+    const std::vector<std::string>& hashes = job.blobHashes();
+    for(std::size_t i=0; i < hashes.size() && i+1 < frames.Blobs.size(); ++i)
+      {
+      refs.Hashes[i+1] = hashes[i];
+      refs.Referenced[i+1] = !hashes[i].empty() &&
+                             this->WorkerCaches->holds(workerIdentity, hashes[i]);
+      }
+    frames = remus::proto::to_FrameSet(refs);
+    }
 
   remus::proto::Response response =
         remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
-                                               remus::worker::to_string(job),
+                                               frames,
                                                &workerChannel,
                                                workerIdentity);
   if(response.isValid())
@@ -833,7 +1439,9 @@ void Server::assignJobToWorker(zmq::socket_t& workerChannel,
 
     //we should encode the worker id as part of the string
     std::string wi(workerIdentity.data(), workerIdentity.size());
-    this->Publish->jobSentToWorker(job, workerIdentity);
+    this->Publish->jobSentToWorker(
+                  remus::proto::Job(job.id(), job.requirements().meshTypes()),
+                  workerIdentity);
     }
 
 }
@@ -843,74 +1451,106 @@ void Server::assignJobToWorker(zmq::socket_t& workerChannel,
 //------------------------------------------------------------------------------
 void Server::FindWorkerForQueuedJob(zmq::socket_t& workerChannel)
 {
-  //We assume that a worker could possibly handle multiple jobs but all of the same type.
-  //In order to prevent allocating more workers than needed we use a set instead of a vector.
-  //This results in the server only creating one worker per job type.
-  //This gives the new workers the opportunity of getting assigned multiple jobs.
-
-  if(this->QueuedJobs->numJobsWaitingForWorkers() == 0 &&
-     this->QueuedJobs->numJobsJustQueued() == 0)
+  //A job can only be matched to a worker when a job of its type has been
+  //queued, or a worker of its type has started waiting for work, since the
+  //last time we looked. So we only look at the types that are dirty, which
+  //means messages like heartbeats that don't change either cost nothing here.
+  //Jobs that have waited long enough for a worker they have affinity with
+  //also need to be looked at again.
+  typedef remus::server::detail::RequirementsHandle Handle;
+  typedef std::set<Handle>::const_iterator it;
+  const remus::common::MonotonicClock::TimePoint now =
+                                        remus::common::MonotonicClock::now();
+  std::set<Handle> dirty_types;
+  this->QueuedJobs->takeDirtyHandles(dirty_types);
+  this->WorkerPool->takeDirtyHandles(dirty_types);
+  this->Affinity->takeExpiredHandles(now, dirty_types);
+  if(dirty_types.empty())
     {
-    //we have no jobs waiting for work so no need to do
-    //all the heavy queries below
     return;
     }
 
-  typedef remus::proto::JobRequirementsSet::const_iterator it;
-  remus::proto::JobRequirementsSet waiting_types;
-  remus::proto::JobRequirementsSet queued_types;
-
-  //find all the jobs that have been marked as waiting for a worker
-  //and ask if we have a worker in the poll that can mesh that job
-  waiting_types = this->QueuedJobs->waitingJobRequirements();
-  for(it type = waiting_types.begin(); type != waiting_types.end(); ++type)
+  //the queue and pool share the requirements registry, so we match jobs
+  //to workers by comparing the requirement handles. The queue gives out
+  //the jobs that are waiting for a worker before the ones just queued.
+  for(it type = dirty_types.begin(); type != dirty_types.end(); ++type)
     {
-    if(this->WorkerPool->haveWaitingWorker(*type))
+    while(this->QueuedJobs->haveJob(*type) &&
+          this->WorkerPool->haveWaitingWorker(*type))
       {
-      //give this job to that worker
-      this->assignJobToWorker(workerChannel,
-                              this->WorkerPool->takeWorker(*type),
-                              this->QueuedJobs->takeJob(*type));
-      }
-    }
+      //prefer the waiting worker that was most recently sent the data of
+      //the job. When only busy workers have that data, the job can wait
+      //a while for one of them to ask for work
+      const remus::server::detail::QueuedJob next =
+                                            this->QueuedJobs->nextJob(*type);
+      const std::vector<zmq::SocketIdentity> affine =
+                                            this->Affinity->workersFor(next);
+      zmq::SocketIdentity worker;
+      bool haveBusyAffineWorker = false;
+      for(std::size_t i=0; i < affine.size() && worker.size() == 0; ++i)
+        {
+        if(this->WorkerPool->takeWorker(affine[i], *type))
+          {
+          worker = affine[i];
+          }
+        else if(this->WorkerPool->haveWorker(affine[i], *type))
+          {
+          haveBusyAffineWorker = true;
+          }
+        }
 
+      if(worker.size() == 0)
+        {
+        if(haveBusyAffineWorker && this->Affinity->deferJob(next, now))
+          {
+          //the jobs of this type are handed out in order, so the rest of
+          //them wait behind this one
+          break;
+          }
+        worker = this->WorkerPool->takeWorker(*type);
+        }
 
-  //find all jobs that queued up and check if we can assign it to an item in
-  //the worker pool
-  queued_types = this->QueuedJobs->queuedJobRequirements();
-  bool assignedJob = false;
-  for(it type = queued_types.begin(); type != queued_types.end(); ++type)
-    {
-    if(this->WorkerPool->haveWaitingWorker(*type))
-      {
       //give this job to that worker
-      this->assignJobToWorker(workerChannel,
-                              this->WorkerPool->takeWorker(*type),
-                              this->QueuedJobs->takeJob(*type));
-      assignedJob = true;
+      const remus::server::detail::QueuedJob job =
+                                            this->QueuedJobs->takeJob(*type);
+      this->Affinity->jobAssigned(worker, job);
+      this->assignJobToWorker(workerChannel, worker, job);
       }
     }
 
+  //We assume that a worker could possibly handle multiple jobs but all of the same type.
+  //In order to prevent allocating more workers than needed we only create one
+  //worker per job type each time we look at the type.
+  //This gives the new workers the opportunity of getting assigned multiple jobs.
+  //Checking for space first only saves asking the factory when it is full,
+  //the factory itself enforces the limit when the worker is created, which
+  //matters when the factory is shared between shards.
   const bool workerFactoryHasSpace =
         this->WorkerFactory->currentWorkerCount() < this->WorkerFactory->maxWorkerCount();
   if(workerFactoryHasSpace)
     {
-    if(assignedJob)
-      { //since we have assigned a job to a worker, we need to recompute
-        //the set of valid requirements
-        queued_types = this->QueuedJobs->queuedJobRequirements();
-      }
     //We now query the worker factory and see if it has the ability to spawn
     //any new workers that match the requirements that we have queued.
     //We are not going to assign the job to the worker now, instead we will
     //move the job to the waiting queue, and give it to the worker once
     //it has registered with us through the worker port.
-    for(it type = queued_types.begin(); type != queued_types.end(); ++type)
+    //The factories are given the interned requirements, which compare
+    //equal to the requirements the workers will register with.
+    const std::set<Handle>& queued_types = this->QueuedJobs->queuedJobHandles();
+    for(it type = dirty_types.begin(); type != dirty_types.end(); ++type)
       {
-      if(this->WorkerFactory->createWorker(*type,
+      if(queued_types.count(*type) > 0 &&
+         this->WorkerFactory->createWorker(this->Requirements->requirements(*type),
                            WorkerFactoryBase::KillOnFactoryDeletion))
         {
         this->QueuedJobs->workerDispatched(*type);
+
+        //the rest of the jobs of this type might need workers too, so look
+        //at the type again the next time
+        if(queued_types.count(*type) > 0)
+          {
+          this->QueuedJobs->markDirty(*type);
+          }
         }
       }
     }
@@ -919,11 +1559,37 @@ void Server::FindWorkerForQueuedJob(zmq::socket_t& workerChannel)
 //------------------------------------------------------------------------------
 void Server::CheckForChangeInWorkersAndJobs()
 {
+  //only the workers that missed a heartbeat deadline, started heartbeating
+  //again, or have been marked as dead since the last check need to be
+  //looked at
+  const std::set<zmq::SocketIdentity> changedWorkers =
+              this->SocketMonitor->changedSockets();
+
+  //dead workers don't need us to remember what they cache, or what they
+  //were sent
+  typedef std::set<zmq::SocketIdentity>::const_iterator WorkerIt;
+  for(WorkerIt i = changedWorkers.begin(); i != changedWorkers.end(); ++i)
+    {
+    if(this->SocketMonitor->isDead(*i))
+      {
+      this->WorkerCaches->remove(*i);
+      this->Affinity->remove(*i);
+      this->TextWorkers.erase(std::string(i->data(), i->size()));
+      }
+    }
+
   //mark all jobs whose worker haven't sent a heartbeat in time
   //as a job that failed. We are returned the set of job's that are
   //expired
   std::vector< remus::proto::JobStatus > expiredJobs =
-              this->ActiveJobs->markExpiredJobs((*this->SocketMonitor));
+              this->ActiveJobs->markExpiredJobs((*this->SocketMonitor),
+                                                changedWorkers);
+
+  typedef std::vector< remus::proto::JobStatus >::const_iterator StatusIt;
+  for(StatusIt i = expiredJobs.begin(); i != expiredJobs.end(); ++i)
+    {
+    this->updateStatusTable(i->id());
+    }
 
   //publish the jobs that have failed
   this->Publish->jobsExpired( expiredJobs );
@@ -933,12 +1599,16 @@ void Server::CheckForChangeInWorkersAndJobs()
   //as we do that when the service call comes in. This also updates
   //the responsive state of all workers.
   // detail::ChangedWorkers updatedWorkers =
-          this->WorkerPool->purgeDeadWorkers((*this->SocketMonitor));
+          this->WorkerPool->purgeDeadWorkers((*this->SocketMonitor),
+                                             changedWorkers);
 
   //Resync the worker factory with the updated status of workers. If we have
   //purged dead workers, the factory itself needs to become aware of this!
   this->WorkerFactory->updateWorkerCount();
 
+  //the factory might be able to create workers for the queued jobs again
+  this->QueuedJobs->markQueuedHandlesDirty();
+
   // for( worker : updatedWorkers.workers())
   //   {
   //   if( worker->responsive() )
@@ -966,6 +1636,74 @@ void Server::CheckForChangeInWorkersAndJobs()
   //  3. Alive
 }
 
+//------------------------------------------------------------------------------
+remus::proto::JobStatus Server::currentStatus(const boost::uuids::uuid& id)
+{
+  remus::proto::JobStatus js(id,remus::INVALID_STATUS);
+  if(this->QueuedJobs->haveUUID(id))
+    {
+    js = remus::proto::JobStatus(id,remus::QUEUED);
+    }
+  else if(this->ActiveJobs->haveUUID(id))
+    {
+    js = this->ActiveJobs->status(id);
+    }
+  return js;
+}
+
+//------------------------------------------------------------------------------
+void Server::updateStatusTable(const boost::uuids::uuid& id)
+{
+  if(this->TrackJobStatuses)
+    {
+    this->JobStatuses->update( this->currentStatus(id) );
+    }
+}
+
+//------------------------------------------------------------------------------
+void Server::RouteToShards(zmq::socket_t& clientChannel,
+                           zmq::socket_t& workerChannel,
+                           zmq::socket_t& statusChannel,
+                           zmq::socket_t& wakeUpChannel)
+{
+  std::size_t numberOfShards = this->ShardCount;
+  if(numberOfShards == 0)
+    {
+    numberOfShards = std::max(boost::thread::hardware_concurrency(), 1u);
+    }
+
+  //the shards schedule jobs on their own threads, but share our factory
+  //so that the max worker count holds for the whole server
+  boost::shared_ptr<remus::server::WorkerFactoryBase> sharedFactory =
+    boost::make_shared<remus::server::detail::SharedWorkerFactory>(
+                                                          this->WorkerFactory);
+  remus::server::detail::BrokerShards shards(numberOfShards,
+                                       remus::to_string((*this->UUIDGenerator)()),
+                                       this->PortInfo.context(),
+                                       sharedFactory,
+                                       this->Blobs,
+                                       this->affinityWait(),
+                                       this->pollingRates());
+  shards.start();
+
+  remus::common::PollingMonitor monitor = this->SocketMonitor->pollingMonitor();
+
+  //We need to notify the Thread management that brokering is about to start.
+  //The shards keep track of the deadlines of their workers, so we only wake
+  //up for messages, or when we are told to stop.
+  Thread->setIsBrokering(true);
+  while (Thread->isBrokering())
+    {
+    shards.route(clientChannel, workerChannel, statusChannel, wakeUpChannel,
+                 std::max(monitor.maxTimeOut(), boost::int64_t(1)));
+    monitor.pollOccurred();
+    }
+
+  //the shards terminate their workers when they stop
+  this->WorkerFactory->setMaxWorkerCount(0);
+  shards.stop(clientChannel, workerChannel);
+}
+
 //We are crashing we need to terminate all workers
 //------------------------------------------------------------------------------
 void Server::signalCaught( SignalCatcher::SignalType )
@@ -28,6 +28,10 @@ REMUS_THIRDPARTY_POST_INCLUDE
 //included for export symbols
 #include <remus/server/ServerExports.h>
 
+#include <set>
+#include <string>
+#include <vector>
+
 #ifdef REMUS_MSVC
  #pragma warning(push)
  #pragma warning(disable:4251)  /*dll-interface missing on stl type*/
@@ -39,8 +43,11 @@ namespace zmq { struct SocketIdentity; }
 namespace remus {
   //forward declaration of classes only the implementation needs
   namespace proto {
+  class Job;
   class WorkerJob;
+  class JobStatus;
   class Message;
+  struct FrameSet;
   }
 
   namespace worker {
@@ -54,8 +61,15 @@ namespace server{
     {
     //forward declaration of classes only the implementation needs
     class ActiveJobs;
+    class BlobStore;
+    class BrokerShards;
     class JobQueue;
+    class JobStatusTable;
+    struct QueuedJob;
+    class RequirementsRegistry;
     class SocketMonitor;
+    class WorkerAffinity;
+    class WorkerCaches;
     class WorkerPool;
     class EventPublisher;
 
@@ -92,7 +106,9 @@ class REMUSSERVER_EXPORT Server : public remus::common::SignalCatcher
 {
 public:
   friend struct remus::server::detail::ThreadManagement;
+  friend class remus::server::detail::BrokerShards;
   enum SignalHandling {NONE, CAPTURE};
+  enum ThreadingMode {SINGLE_THREADED, MULTI_THREADED, SHARDED};
   //construct a new server with the default worker factory and server ports.
   Server();
 
@@ -121,6 +137,50 @@ public:
   void pollingRates( const remus::server::PollingRates& rates );
   remus::server::PollingRates pollingRates() const;
 
+  //Select how the server divides up the brokering work between threads.
+  //With SINGLE_THREADED, the default, one thread handles client requests,
+  //worker messages and the scheduling of jobs.
+  //With MULTI_THREADED client requests are received on a separate thread,
+  //so that a burst of client queries doesn't delay handing jobs to workers.
+  //Job status queries are answered by that thread, and every other client
+  //request is forwarded to the thread that owns the job queue and the
+  //worker pool.
+  //With SHARDED the jobs and workers are split by mesh type between a
+  //number of shards, that each schedule their jobs on their own thread.
+  //The server thread only routes the messages of clients and workers to
+  //the shard that owns their mesh type. When sharded, FindWorkerForQueuedJob
+  //isn't called on this server, as the shards do the scheduling.
+  //
+  //Note: the mode is read when brokering starts, so changing it while
+  //the server is brokering takes effect the next time brokering starts
+  void threadingMode( ThreadingMode mode );
+  ThreadingMode threadingMode() const;
+
+  //Set the number of shards used when the threading mode is SHARDED.
+  //A count of zero, the default, uses one shard per hardware thread.
+  //
+  //Note: like the threading mode this is read when brokering starts
+  void shardCount( std::size_t count );
+  std::size_t shardCount() const;
+
+  //Set how many bytes of submitted contents the server keeps in its blob
+  //store. Clients that resubmit the same large contents only send the hash
+  //of the contents when the server still has them, see
+  //Client::submitJob. The least recently used contents are evicted once
+  //the store is full. When sharded the shards share the store.
+  //Defaults to 512MB, a size of zero disables the store.
+  void blobStoreSize( std::size_t bytes );
+  std::size_t blobStoreSize() const;
+
+  //Jobs are sent to the waiting worker that was most recently sent jobs
+  //with the same data, which is the same content hashes or the same
+  //requirements tag, so the worker doesn't have to load that data again.
+  //When none of those workers are waiting for work, a job can wait this
+  //many milliseconds for one of them before being sent to any worker.
+  //Defaults to zero, so jobs never wait.
+  void affinityWait( boost::int64_t millisec );
+  boost::int64_t affinityWait() const;
+
   //when you call start brokering the server will actually start accepting
   //worker and client requests.
   //IMPORTANT:
@@ -184,7 +244,7 @@ protected:
 
   //processes all client queries
   void DetermineClientResponse(zmq::socket_t& clientChannel,
-                               const zmq::SocketIdentity &clientIdentity,
+                               const zmq::SocketIdentity &sender,
                                zmq::socket_t& WorkerChannel);
 
   //These methods are all to do with sending responses to clients
@@ -194,9 +254,33 @@ protected:
   std::string meshRequirements(const remus::proto::Message& msg);
   std::string meshStatus(const remus::proto::Message& msg);
   std::string queueJob(const remus::proto::Message& msg);
-  std::string retrieveResult(const remus::proto::Message& msg);
+  remus::proto::FrameSet retrieveResult(const remus::proto::Message& msg);
   std::string terminateJob(zmq::socket_t& WorkerChannel,const remus::proto::Message& msg);
 
+  //The bulk versions of the job methods. The message holds a batch of
+  //submissions or jobs, and the response is a batch with an item for each
+  //of them in the same order.
+  remus::proto::FrameSet queueJobs(const remus::proto::Message& msg);
+  remus::proto::FrameSet meshStatuses(const remus::proto::Message& msg);
+  remus::proto::FrameSet retrieveResults(const remus::proto::Message& msg);
+  remus::proto::FrameSet terminateJobs(zmq::socket_t& WorkerChannel,const remus::proto::Message& msg);
+
+  //The content addressed versions of queueJob. missingBlobs returns which
+  //of the content hashes in the message aren't in the blob store, and
+  //queueJobFromBlobs queues a submission whose blobs can be references to
+  //the blob store.
+  std::string missingBlobs(const remus::proto::Message& msg);
+  std::string queueJobFromBlobs(const remus::proto::Message& msg);
+
+  //the methods that handle a single job, shared by the single and bulk
+  //versions of the job methods
+  std::string queueJob(const remus::common::MeshIOType& type,
+                       const remus::proto::FrameSet& submission,
+                       const std::vector<std::string>& blobHashes =
+                                              std::vector<std::string>());
+  remus::proto::FrameSet retrieveResult(const remus::proto::Job& job);
+  std::string terminateJob(zmq::socket_t& WorkerChannel,const remus::proto::Job& job);
+
   //Methods for processing Worker queries
   void DetermineWorkerResponse(zmq::socket_t& clientChannel,
                                const zmq::SocketIdentity &workerIdentity,
@@ -207,9 +291,17 @@ protected:
                        const remus::proto::Message& msg);
   void storeMesh(const zmq::SocketIdentity &workerIdentity,
                  const remus::proto::Message& msg);
+  void storeCachedBlobs(zmq::socket_t& workerChannel,
+                        const zmq::SocketIdentity &workerIdentity,
+                        const remus::proto::Message& msg);
   void assignJobToWorker(zmq::socket_t& workerChannel,
                          const zmq::SocketIdentity &workerIdentity,
-                         const remus::worker::Job& job);
+                         const remus::server::detail::QueuedJob& job);
+
+  //remember the wire format the worker talks to us in, so that jobs are
+  //sent to it in the same format
+  void updateWorkerFormat(const zmq::SocketIdentity &workerIdentity,
+                          const remus::proto::Message& msg);
 
   //see if we have a worker in the pool for the next job in the queue,
   //otherwise ask the factory to generate a new worker to handle that job
@@ -233,8 +325,26 @@ private:
   Server(const Server&);
   void operator=(const Server&);
 
+  //returns the status of a job, looking at both queued and active jobs
+  remus::proto::JobStatus currentStatus(const boost::uuids::uuid& id);
+
+  //copy the current status of a job into the job status table. Needs to be
+  //called after every change to the state of a job. Does nothing unless
+  //we are brokering with MULTI_THREADED, as nothing else reads the table.
+  void updateStatusTable(const boost::uuids::uuid& id);
+
+  //the brokering loop when sharded, which routes messages to the shards
+  //until brokering is stopped
+  void RouteToShards(zmq::socket_t& clientChannel,
+                     zmq::socket_t& workerChannel,
+                     zmq::socket_t& statusChannel,
+                     zmq::socket_t& wakeUpChannel);
+
   remus::server::ServerPorts PortInfo;
 
+  //shared by the job queue and worker pool so that they hand out the
+  //same handle for equal requirements
+  boost::shared_ptr<remus::server::detail::RequirementsRegistry> Requirements;
   boost::scoped_ptr<remus::server::detail::JobQueue> QueuedJobs;
   boost::scoped_ptr<remus::server::detail::SocketMonitor> SocketMonitor;
   boost::scoped_ptr<remus::server::detail::WorkerPool> WorkerPool;
@@ -242,6 +352,34 @@ private:
 
   boost::scoped_ptr<remus::server::detail::EventPublisher> Publish;
 
+  //the contents clients have submitted, by their hash. Shared with the
+  //shards when sharded
+  boost::shared_ptr<remus::server::detail::BlobStore> Blobs;
+
+  //the blobs each worker holds in its local blob cache
+  boost::scoped_ptr<remus::server::detail::WorkerCaches> WorkerCaches;
+
+  //the data each worker was recently sent, used to send jobs to the worker
+  //that already has their data
+  boost::scoped_ptr<remus::server::detail::WorkerAffinity> Affinity;
+
+  //the workers that talk to us in the text wire format, by the bytes of
+  //their identity. They are sent jobs in the text format, without any
+  //references to the blobs they cache
+  std::set<std::string> TextWorkers;
+
+  //the status of every job, read by the client thread when brokering
+  //with multiple threads. The table is only kept up to date while
+  //TrackJobStatuses is set, which is while brokering with MULTI_THREADED
+  ThreadingMode Threading;
+  boost::shared_ptr<remus::server::detail::JobStatusTable> JobStatuses;
+  bool TrackJobStatuses;
+
+  //when sharded the number of shards to create, and whether this server is
+  //itself a shard of another server
+  std::size_t ShardCount;
+  bool ShardOfBroker;
+
   boost::scoped_ptr<detail::UUIDManagement> UUIDGenerator;
   boost::scoped_ptr<detail::ThreadManagement> Thread;
 
@@ -57,8 +57,8 @@ namespace
   //----------------------------------------------------------------------------
   struct support_JobReqs
   {
-    remus::proto::JobRequirements& Requirements;
-    support_JobReqs(remus::proto::JobRequirements& reqs):
+    const remus::proto::JobRequirements& Requirements;
+    support_JobReqs(const remus::proto::JobRequirements& reqs):
       Requirements(reqs)
       {
       }
@@ -115,7 +115,7 @@ namespace
 
   //----------------------------------------------------------------------------
   template<typename Container >
-  ValidWorker find_worker_path(remus::proto::JobRequirements reqs,
+  ValidWorker find_worker_path(const remus::proto::JobRequirements& reqs,
                                Container const& container)
   {
     support_JobReqs pred(reqs);
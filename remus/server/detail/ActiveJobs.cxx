@@ -24,7 +24,7 @@ ActiveJobs::JobState::JobState(const zmq::SocketIdentity& workerIdentity,
          remus::STATUS_TYPE stat):
   WorkerAddress(workerIdentity),
   jstatus(id,stat),
-  jresult(id),
+  jresult( remus::proto::to_FrameSet(remus::proto::JobResult(id)) ),
   haveResult(false)
 {
 
@@ -51,6 +51,7 @@ bool ActiveJobs::add(const zmq::SocketIdentity &workerIdentity,
     JobState ws(workerIdentity,id,remus::QUEUED);
     InfoPair pair(id,ws);
     this->Info.insert(pair);
+    this->WorkerJobs[workerIdentity].insert(id);
     return true;
     }
   return false;
@@ -59,9 +60,17 @@ bool ActiveJobs::add(const zmq::SocketIdentity &workerIdentity,
 //-----------------------------------------------------------------------------
 bool ActiveJobs::remove(const boost::uuids::uuid& id)
 {
-  if(this->haveUUID(id))
+  InfoIt item = this->Info.find(id);
+  if(item != this->Info.end())
     {
-    this->Info.erase(id);
+    WorkerJobsMap::iterator jobs =
+                          this->WorkerJobs.find(item->second.WorkerAddress);
+    jobs->second.erase(id);
+    if(jobs->second.empty())
+      {
+      this->WorkerJobs.erase(jobs);
+      }
+    this->Info.erase(item);
     return true;
     }
   return false;
@@ -105,7 +114,7 @@ const remus::proto::JobStatus& ActiveJobs::status(
 }
 
 //-----------------------------------------------------------------------------
-const remus::proto::JobResult& ActiveJobs::result(
+const remus::proto::FrameSet& ActiveJobs::result(
     const boost::uuids::uuid& id)
 {
   InfoConstIt item = this->Info.find(id);
@@ -127,20 +136,21 @@ void ActiveJobs::updateStatus(const remus::proto::JobStatus& s)
 }
 
 //-----------------------------------------------------------------------------
-void ActiveJobs::updateResult(const remus::proto::JobResult& r)
+void ActiveJobs::updateResult(const boost::uuids::uuid& id,
+                              const remus::proto::FrameSet& result)
 {
-  InfoIt item = this->Info.find(r.id());
+  InfoIt item = this->Info.find(id);
   if(item != this->Info.end())
     {
     //once we get a result we can state our status is now finished,
     //since the uploading of data has finished.
     if( item->second.jstatus.status() != remus::FAILED )
       {
-      item->second.jstatus = remus::proto::JobStatus(r.id(),remus::FINISHED);
+      item->second.jstatus = remus::proto::JobStatus(id,remus::FINISHED);
       }
 
     //update the client result data to equal the server data
-    item->second.jresult = r;
+    item->second.jresult = result;
     item->second.haveResult = true;
     }
 }
@@ -154,8 +164,7 @@ ActiveJobs::markExpiredJobs(remus::server::detail::SocketMonitor monitor)
     {
     //we can only mark jobs that are IN_PROGRESS or QUEUED as failed.
     //FINISHED is more important than failed
-    const bool is_status_valid_to_expire = (item->second.jstatus.queued() ||
-                                           item->second.jstatus.inProgress());
+    const bool is_status_valid_to_expire = item->second.canExpire();
     const bool worker_is_unresponsive = monitor.isUnresponsive(
                                                   item->second.WorkerAddress);
     if (is_status_valid_to_expire && worker_is_unresponsive)
@@ -169,13 +178,44 @@ ActiveJobs::markExpiredJobs(remus::server::detail::SocketMonitor monitor)
   return expiredJobs;
 }
 
+//-----------------------------------------------------------------------------
+std::vector< remus::proto::JobStatus >
+ActiveJobs::markExpiredJobs(remus::server::detail::SocketMonitor monitor,
+                            const std::set<zmq::SocketIdentity>& changed)
+{
+  std::vector< remus::proto::JobStatus > expiredJobs;
+  typedef std::set<zmq::SocketIdentity>::const_iterator cit;
+  typedef std::set<boost::uuids::uuid>::const_iterator id_cit;
+  for(cit worker = changed.begin(); worker != changed.end(); ++worker)
+    {
+    WorkerJobsMap::const_iterator jobs = this->WorkerJobs.find(*worker);
+    if(jobs == this->WorkerJobs.end() || !monitor.isUnresponsive(*worker))
+      {
+      continue;
+      }
+
+    for(id_cit id = jobs->second.begin(); id != jobs->second.end(); ++id)
+      {
+      JobState& state = this->Info.find(*id)->second;
+      if(state.canExpire())
+        {
+        //marking the job status as expired
+        state.jstatus = remus::proto::JobStatus(*id,remus::EXPIRED);
+        expiredJobs.push_back( state.jstatus );
+        }
+      }
+    }
+  return expiredJobs;
+}
+
 //-----------------------------------------------------------------------------
 std::set<zmq::SocketIdentity> ActiveJobs::activeWorkers() const
 {
   std::set<zmq::SocketIdentity> workerAddresses;
-  for(InfoConstIt item = this->Info.begin(); item != this->Info.end(); ++item)
+  for(WorkerJobsMap::const_iterator i = this->WorkerJobs.begin();
+      i != this->WorkerJobs.end(); ++i)
     {
-    workerAddresses.insert(item->second.WorkerAddress);
+    workerAddresses.insert(i->first);
     }
   return workerAddresses;
 }
@@ -13,6 +13,7 @@
 #ifndef remus_server_detail_ActiveJobs_h
 #define remus_server_detail_ActiveJobs_h
 
+#include <remus/proto/FrameSet.h>
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
 #include <remus/proto/zmqSocketIdentity.h>
@@ -30,7 +31,7 @@ namespace detail{
 class ActiveJobs
 {
   public:
-    ActiveJobs():Info(){}
+    ActiveJobs():Info(),WorkerJobs(){}
 
     bool add(const zmq::SocketIdentity& workerIdentity,
              const boost::uuids::uuid& id);
@@ -46,8 +47,9 @@ class ActiveJobs
     //returns a worker side job status object for a job
     const remus::proto::JobStatus& status(const boost::uuids::uuid& id);
 
-    //returns a worker side job result object for a job
-    const remus::proto::JobResult& result(const boost::uuids::uuid& id);
+    //returns the frames of the result the worker sent for a job, which are
+    //the frames of an invalid result until the job has finished
+    const remus::proto::FrameSet& result(const boost::uuids::uuid& id);
 
     //update the job status of a job.
     //valid values are:
@@ -59,11 +61,21 @@ class ActiveJobs
     // not update status
     void updateStatus(const remus::proto::JobStatus& s);
 
-    void updateResult(const remus::proto::JobResult& r);
+    //the result is kept as the frames it was received in, so that it is
+    //sent on to the client without its data being decoded or copied
+    void updateResult(const boost::uuids::uuid& id,
+                      const remus::proto::FrameSet& result);
 
     std::vector< remus::proto::JobStatus > markExpiredJobs(
                                  remus::server::detail::SocketMonitor monitor);
 
+    //mark the jobs as expired whose workers are unresponsive, only looking
+    //at the jobs of the workers whose sockets are given. Used with the
+    //sockets returned by SocketMonitor::changedSockets.
+    std::vector< remus::proto::JobStatus > markExpiredJobs(
+                                 remus::server::detail::SocketMonitor monitor,
+                                 const std::set<zmq::SocketIdentity>& changed);
+
     std::set<zmq::SocketIdentity> activeWorkers() const;
 
 private:
@@ -71,7 +83,7 @@ private:
     {
       zmq::SocketIdentity WorkerAddress;
       remus::proto::JobStatus jstatus;
-      remus::proto::JobResult jresult;
+      remus::proto::FrameSet jresult;
       bool haveResult;
 
       JobState(const zmq::SocketIdentity& workerIdentity,
@@ -79,12 +91,21 @@ private:
                remus::STATUS_TYPE stat);
 
       bool canUpdateStatusTo(remus::proto::JobStatus s) const;
+
+      bool canExpire() const
+        { return jstatus.queued() || jstatus.inProgress(); }
     };
 
     typedef std::pair<boost::uuids::uuid, JobState> InfoPair;
     typedef std::map< boost::uuids::uuid, JobState>::const_iterator InfoConstIt;
     typedef std::map< boost::uuids::uuid, JobState>::iterator InfoIt;
     std::map<boost::uuids::uuid, JobState> Info;
+
+    //the jobs of each worker, so the jobs of a worker that stops responding
+    //can be found without looking at every job
+    typedef std::map< zmq::SocketIdentity,
+                      std::set<boost::uuids::uuid> > WorkerJobsMap;
+    WorkerJobsMap WorkerJobs;
 };
 
 }
@@ -0,0 +1,135 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/BlobStore.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/thread/locks.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+BlobStore::BlobStore(std::size_t maxBytes):
+  Mutex(),
+  MaxBytes(maxBytes),
+  ByteCount(0),
+  Usage(),
+  Blobs()
+{
+}
+
+//------------------------------------------------------------------------------
+void BlobStore::maxBytes(std::size_t bytes)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  this->MaxBytes = bytes;
+  this->evict();
+}
+
+//------------------------------------------------------------------------------
+std::size_t BlobStore::maxBytes() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->MaxBytes;
+}
+
+//------------------------------------------------------------------------------
+bool BlobStore::add(const std::string& hash, const remus::proto::Frame& blob)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  if(blob.size() > this->MaxBytes)
+    {
+    return false;
+    }
+
+  BlobMap::iterator i = this->Blobs.find(hash);
+  if(i != this->Blobs.end())
+    { //already stored, it is now the most recently used
+    this->Usage.splice(this->Usage.begin(), this->Usage, i->second);
+    return true;
+    }
+
+  this->Usage.push_front( UsageList::value_type(hash, blob) );
+  this->Blobs.insert( BlobMap::value_type(hash, this->Usage.begin()) );
+  this->ByteCount += blob.size();
+  this->evict();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool BlobStore::find(const std::string& hash, remus::proto::Frame& blob)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  BlobMap::iterator i = this->Blobs.find(hash);
+  if(i == this->Blobs.end())
+    {
+    return false;
+    }
+  this->Usage.splice(this->Usage.begin(), this->Usage, i->second);
+  blob = i->second->second;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool BlobStore::touch(const std::string& hash)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  BlobMap::iterator i = this->Blobs.find(hash);
+  if(i == this->Blobs.end())
+    {
+    return false;
+    }
+  this->Usage.splice(this->Usage.begin(), this->Usage, i->second);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+std::size_t BlobStore::size() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Blobs.size();
+}
+
+//------------------------------------------------------------------------------
+std::size_t BlobStore::byteCount() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->ByteCount;
+}
+
+//------------------------------------------------------------------------------
+void BlobStore::clear()
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  this->Usage.clear();
+  this->Blobs.clear();
+  this->ByteCount = 0;
+}
+
+//------------------------------------------------------------------------------
+void BlobStore::evict()
+{
+  while(this->ByteCount > this->MaxBytes && !this->Usage.empty())
+    {
+    const UsageList::value_type& oldest = this->Usage.back();
+    this->ByteCount -= oldest.second.size();
+    this->Blobs.erase(oldest.first);
+    this->Usage.pop_back();
+    }
+}
+
+}
+}
+}
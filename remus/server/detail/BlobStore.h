@@ -0,0 +1,97 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_BlobStore_h
+#define remus_server_detail_BlobStore_h
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <remus/proto/FrameSet.h>
+
+#include <list>
+#include <string>
+#include <utility>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//A content addressed store of the blobs that clients have submitted, so
+//that clients resubmitting the same large contents only need to send the
+//hash of the contents.
+//
+//The store holds at most maxBytes worth of blobs, evicting the least
+//recently used blobs to make room. The blobs are shared with the jobs that
+//reference them, so evicting a blob never invalidates a queued job, the
+//data is freed once the last job referencing it is done.
+//
+//The shards of a server share a single store, so the store is thread safe.
+class BlobStore
+{
+public:
+  explicit BlobStore(std::size_t maxBytes);
+
+  //change how many bytes of blobs the store can hold, evicting blobs
+  //when the store is now too large
+  void maxBytes(std::size_t bytes);
+  std::size_t maxBytes() const;
+
+  //store the blob under the given hash. Returns false when the blob
+  //is larger than the store, and isn't stored
+  bool add(const std::string& hash, const remus::proto::Frame& blob);
+
+  //returns true and sets blob when the store has a blob with the given
+  //hash. The blob is marked as the most recently used.
+  bool find(const std::string& hash, remus::proto::Frame& blob);
+
+  //returns true when the store has a blob with the given hash, and marks
+  //the blob as the most recently used
+  bool touch(const std::string& hash);
+
+  //number of blobs in the store
+  std::size_t size() const;
+
+  //number of bytes of all blobs in the store
+  std::size_t byteCount() const;
+
+  void clear();
+
+private:
+  //explicitly state the store doesn't support copy or move semantics
+  BlobStore(const BlobStore&);
+  void operator=(const BlobStore&);
+
+  //evict the least recently used blobs until we fit in MaxBytes, the
+  //mutex must be held
+  void evict();
+
+  //the blobs ordered from most to least recently used
+  typedef std::list< std::pair<std::string, remus::proto::Frame> > UsageList;
+  typedef boost::unordered_map< std::string, UsageList::iterator > BlobMap;
+
+  mutable boost::mutex Mutex;
+  std::size_t MaxBytes;
+  std::size_t ByteCount;
+  UsageList Usage;
+  BlobMap Blobs;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,400 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/BrokerShards.h>
+
+#include <remus/proto/Message.h>
+#include <remus/proto/Response.h>
+#include <remus/proto/zmqHelper.h>
+
+#include <remus/server/Server.h>
+#include <remus/server/ServerPorts.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/functional/hash.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <cstring>
+#include <sstream>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+namespace
+{
+//------------------------------------------------------------------------------
+zmq::pollitem_t make_pollitem(zmq::socket_t& socket)
+{
+  zmq::pollitem_t item = { socket, 0, ZMQ_POLLIN, 0 };
+  return item;
+}
+
+//------------------------------------------------------------------------------
+bool has_more(zmq::socket_t& socket)
+{
+  zmq::more_t more;
+  size_t more_size = sizeof(more);
+  socket.getsockopt(ZMQ_RCVMORE, &more, &more_size);
+  return more > 0;
+}
+
+//------------------------------------------------------------------------------
+bool has_message(zmq::socket_t& socket)
+{
+  int events = 0;
+  size_t events_size = sizeof(events);
+  socket.getsockopt(ZMQ_EVENTS, &events, &events_size);
+  return (events & ZMQ_POLLIN) != 0;
+}
+
+//------------------------------------------------------------------------------
+//send a message to a shard, prefixed with the identity of who sent it, so
+//the shard reads it the same way as from the client or worker socket
+void forward_to_shard(zmq::socket_t& shardChannel,
+                      const zmq::SocketIdentity& identity,
+                      const remus::proto::Message& msg)
+{
+  zmq::message_t identityFrame(identity.size());
+  std::memcpy(identityFrame.data(), identity.data(), identity.size());
+  if(zmq::send_harder(shardChannel, identityFrame, ZMQ_SNDMORE))
+    {
+    remus::proto::forward_Message(msg, &shardChannel);
+    }
+}
+}
+
+//------------------------------------------------------------------------------
+struct BrokerShards::Shard
+{
+  Shard(const boost::shared_ptr<remus::server::Server>& broker,
+        zmq::context_t& context):
+    Broker(broker),
+    ClientChannel(context, ZMQ_PAIR),
+    WorkerChannel(context, ZMQ_PAIR)
+  {
+    zmq::remove_high_water_mark(this->ClientChannel);
+    zmq::remove_high_water_mark(this->WorkerChannel);
+  }
+
+  boost::shared_ptr<remus::server::Server> Broker;
+  zmq::socket_t ClientChannel;
+  zmq::socket_t WorkerChannel;
+};
+
+//------------------------------------------------------------------------------
+BrokerShards::BrokerShards(std::size_t numberOfShards,
+              const std::string& name,
+              const boost::shared_ptr<zmq::context_t>& context,
+              const boost::shared_ptr<remus::server::WorkerFactoryBase>& factory,
+              const boost::shared_ptr<BlobStore>& blobs,
+              boost::int64_t affinityWait,
+              const remus::server::PollingRates& rates):
+  Context(context),
+  Shards(),
+  EventChannel( new zmq::socket_t(*context, ZMQ_PULL) ),
+  WorkerShards(),
+  PendingMerges(),
+  MergeCount(0)
+{
+  zmq::remove_high_water_mark(*this->EventChannel);
+
+  for(std::size_t i=0; i < numberOfShards; ++i)
+    {
+    typedef zmq::socketInfo<zmq::proto::inproc> InprocInfo;
+    const std::string shardName = name + "_shard" +
+                                  boost::lexical_cast<std::string>(i);
+    remus::server::ServerPorts ports( InprocInfo(shardName + "_client"),
+                                      InprocInfo(shardName + "_status"),
+                                      InprocInfo(shardName + "_worker") );
+    ports.context(context);
+
+    boost::shared_ptr<remus::server::Server> broker(
+                              new remus::server::Server(ports,factory) );
+    broker->ShardOfBroker = true;
+    broker->Blobs = blobs;
+    broker->affinityWait(affinityWait);
+    broker->pollingRates(rates);
+
+    this->Shards.push_back( boost::make_shared<Shard>(broker, *context) );
+    }
+}
+
+//------------------------------------------------------------------------------
+std::size_t BrokerShards::shardFor(const remus::common::MeshIOType& type) const
+{
+  //types that aren't default types all share an id, so hash their names
+  typedef remus::common::MeshRegistrar Registrar;
+  std::size_t seed = 0;
+  if(Registrar::isStableId(type.inputId()))
+    { boost::hash_combine(seed, type.inputId()); }
+  else
+    { boost::hash_combine(seed, type.inputType()); }
+  if(Registrar::isStableId(type.outputId()))
+    { boost::hash_combine(seed, type.outputId()); }
+  else
+    { boost::hash_combine(seed, type.outputType()); }
+  return seed % this->Shards.size();
+}
+
+//------------------------------------------------------------------------------
+void BrokerShards::start()
+{
+  typedef std::vector< boost::shared_ptr<Shard> >::const_iterator it;
+  for(it i = this->Shards.begin(); i != this->Shards.end(); ++i)
+    {
+    //a shard has bound its sockets once it has started brokering
+    Shard& shard = **i;
+    shard.Broker->startBrokering(remus::server::Server::NONE);
+
+    const remus::server::ServerPorts& ports = shard.Broker->serverPortInfo();
+    zmq::connectToAddress(shard.ClientChannel, ports.client().endpoint());
+    zmq::connectToAddress(shard.WorkerChannel, ports.worker().endpoint());
+    zmq::connectToAddress(*this->EventChannel, ports.status().endpoint());
+    }
+}
+
+//------------------------------------------------------------------------------
+void BrokerShards::route(zmq::socket_t& clientChannel,
+                         zmq::socket_t& workerChannel,
+                         zmq::socket_t& statusChannel,
+                         zmq::socket_t& wakeUpChannel,
+                         boost::int64_t timeout)
+{
+  std::vector<zmq::pollitem_t> items;
+  items.reserve(4 + 2 * this->Shards.size());
+  items.push_back( make_pollitem(clientChannel) );
+  items.push_back( make_pollitem(workerChannel) );
+  items.push_back( make_pollitem(*this->EventChannel) );
+  for(std::size_t i=0; i < this->Shards.size(); ++i)
+    {
+    items.push_back( make_pollitem(this->Shards[i]->ClientChannel) );
+    items.push_back( make_pollitem(this->Shards[i]->WorkerChannel) );
+    }
+  items.push_back( make_pollitem(wakeUpChannel) );
+
+  zmq::poll_safely(&items[0], static_cast<int>(items.size()), timeout);
+
+  if(items.back().revents & ZMQ_POLLIN)
+    {
+    //the server has been told to stop, which it checks once we return
+    zmq::drain_wake_ups(wakeUpChannel);
+    }
+
+  //relay what the shards have sent before taking on new messages
+  for(std::size_t i=0; i < this->Shards.size(); ++i)
+    {
+    if(items[3 + 2*i].revents & ZMQ_POLLIN)
+      {
+      this->shardClientResponse(*this->Shards[i], clientChannel);
+      }
+    if(items[4 + 2*i].revents & ZMQ_POLLIN)
+      {
+      this->shardWorkerResponse(*this->Shards[i], workerChannel);
+      }
+    }
+  if(items[2].revents & ZMQ_POLLIN)
+    {
+    this->shardEvent(statusChannel);
+    }
+
+  if(items[0].revents & ZMQ_POLLIN)
+    {
+    this->clientRequest(clientChannel);
+    }
+  if(items[1].revents & ZMQ_POLLIN)
+    {
+    this->workerMessage(workerChannel);
+    }
+}
+
+//------------------------------------------------------------------------------
+void BrokerShards::stop(zmq::socket_t& clientChannel,
+                        zmq::socket_t& workerChannel)
+{
+  //stop the shards at the same time, so that we only wait for the
+  //slowest one to notice
+  boost::thread_group stopping;
+  typedef std::vector< boost::shared_ptr<Shard> >::const_iterator it;
+  for(it i = this->Shards.begin(); i != this->Shards.end(); ++i)
+    {
+    stopping.add_thread( new boost::thread(
+                                    &remus::server::Server::stopBrokering,
+                                    (*i)->Broker.get()) );
+    }
+  stopping.join_all();
+
+  //the shards have stopped, so everything they sent is already queued
+  for(it i = this->Shards.begin(); i != this->Shards.end(); ++i)
+    {
+    Shard& shard = **i;
+    while(has_message(shard.WorkerChannel))
+      {
+      this->shardWorkerResponse(shard, workerChannel);
+      }
+    while(has_message(shard.ClientChannel))
+      {
+      this->shardClientResponse(shard, clientChannel);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void BrokerShards::clientRequest(zmq::socket_t& clientChannel)
+{
+  zmq::SocketIdentity clientIdentity = zmq::address_recv(clientChannel);
+  remus::proto::Message msg = remus::proto::receive_Message(&clientChannel);
+  clientIdentity.requestId(msg.requestId());
+  if(!msg.isValid())
+    {
+    remus::proto::send_NonBlockingResponse(remus::INVALID_SERVICE,
+                                           remus::INVALID_MSG,
+                                           &clientChannel,
+                                           clientIdentity);
+    return;
+    }
+
+  if(msg.serviceType() == remus::SUPPORTED_IO_TYPES)
+    {
+    //every shard knows about different workers, so we ask all of them.
+    //The shards answer to an identity we made up, that way we can tell
+    //their answers apart from the responses we relay to clients
+    const std::string key = "merge" +
+                            boost::lexical_cast<std::string>(++this->MergeCount);
+    const zmq::SocketIdentity mergeIdentity(key.data(), key.size());
+
+    PendingMerge& merge = this->PendingMerges[mergeIdentity];
+    merge.Client = clientIdentity;
+    merge.Remaining = this->Shards.size();
+
+    typedef std::vector< boost::shared_ptr<Shard> >::const_iterator it;
+    for(it i = this->Shards.begin(); i != this->Shards.end(); ++i)
+      {
+      forward_to_shard((*i)->ClientChannel, mergeIdentity, msg);
+      }
+    return;
+    }
+
+  //every other request states the mesh type of the job or worker it is about
+  Shard& shard = *this->Shards[ this->shardFor(msg.MeshIOType()) ];
+  forward_to_shard(shard.ClientChannel, clientIdentity, msg);
+}
+
+//------------------------------------------------------------------------------
+void BrokerShards::workerMessage(zmq::socket_t& workerChannel)
+{
+  const zmq::SocketIdentity workerIdentity = zmq::address_recv(workerChannel);
+  remus::proto::Message msg = remus::proto::receive_Message(&workerChannel);
+  if(!msg.isValid())
+    {
+    return;
+    }
+
+  std::size_t index = 0;
+  WorkerShardMap::const_iterator worker = this->WorkerShards.find(workerIdentity);
+  if(worker != this->WorkerShards.end())
+    {
+    index = worker->second;
+    }
+  else if(msg.MeshIOType().valid())
+    {
+    index = this->shardFor(msg.MeshIOType());
+    this->WorkerShards[workerIdentity] = index;
+    }
+  else
+    {
+    //a heartbeat from a worker that hasn't registered yet. We can't tell
+    //which shard the worker belongs to, and until it registers no shard
+    //is tracking it
+    return;
+    }
+
+  if(msg.serviceType() == remus::TERMINATE_WORKER)
+    {
+    this->WorkerShards.erase(workerIdentity);
+    }
+  forward_to_shard(this->Shards[index]->WorkerChannel, workerIdentity, msg);
+}
+
+//------------------------------------------------------------------------------
+void BrokerShards::shardClientResponse(Shard& shard,
+                                       zmq::socket_t& clientChannel)
+{
+  const zmq::SocketIdentity identity = zmq::address_recv(shard.ClientChannel);
+  remus::proto::Response response =
+                          remus::proto::receive_Response(&shard.ClientChannel);
+
+  PendingMergeMap::iterator merge = this->PendingMerges.find(identity);
+  if(merge == this->PendingMerges.end())
+    {
+    remus::proto::forward_Response(response, &clientChannel, identity);
+    return;
+    }
+
+  if(response.isValid())
+    {
+    std::istringstream buffer(std::string(response.data(),response.dataSize()));
+    remus::common::MeshIOTypeSet shardTypes;
+    buffer >> shardTypes;
+    merge->second.Types.insert(shardTypes.begin(), shardTypes.end());
+    }
+
+  merge->second.Remaining--;
+  if(merge->second.Remaining == 0)
+    {
+    std::ostringstream buffer;
+    buffer << merge->second.Types << '\n';
+    remus::proto::send_NonBlockingResponse(remus::SUPPORTED_IO_TYPES,
+                                           buffer.str(),
+                                           &clientChannel,
+                                           merge->second.Client);
+    this->PendingMerges.erase(merge);
+    }
+}
+
+//------------------------------------------------------------------------------
+void BrokerShards::shardWorkerResponse(Shard& shard,
+                                       zmq::socket_t& workerChannel)
+{
+  const zmq::SocketIdentity identity = zmq::address_recv(shard.WorkerChannel);
+  remus::proto::Response response =
+                          remus::proto::receive_Response(&shard.WorkerChannel);
+
+  //once a worker has been told to terminate it won't send us anything
+  //we need to route
+  if(response.serviceType() == remus::TERMINATE_WORKER)
+    {
+    this->WorkerShards.erase(identity);
+    }
+  remus::proto::forward_Response(response, &workerChannel, identity);
+}
+
+//------------------------------------------------------------------------------
+void BrokerShards::shardEvent(zmq::socket_t& statusChannel)
+{
+  //events are a key frame followed by a value frame, relay every frame
+  bool more = true;
+  while(more)
+    {
+    zmq::message_t frame;
+    zmq::recv_harder(*this->EventChannel, &frame);
+    more = has_more(*this->EventChannel);
+    statusChannel.send(frame, more ? ZMQ_SNDMORE : 0);
+    }
+}
+
+}
+}
+}
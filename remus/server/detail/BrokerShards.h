@@ -0,0 +1,142 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_BrokerShards_h
+#define remus_server_detail_BrokerShards_h
+
+#include <remus/common/CompilerInformation.h>
+#include <remus/common/MeshIOType.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <remus/proto/zmq.hpp>
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace server{
+
+//forward declaration of classes only the implementation needs
+class PollingRates;
+class WorkerFactoryBase;
+
+namespace detail{
+
+class BlobStore;
+
+//Routes the messages of a sharded server between the clients and workers,
+//and the shards that own the jobs and workers.
+//
+//Each shard is a server brokering on its own thread, that owns the job
+//queue, worker pool and active jobs of a subset of the mesh types. Instead
+//of binding the ports of the server, a shard binds inproc sockets that we
+//connect to.
+//
+//Client requests and worker registrations are routed to the shard that owns
+//their mesh type. Once a worker has registered, all of its messages are
+//routed to the same shard by the routing id of the worker, as messages such
+//as heartbeats don't state a mesh type.
+//
+//Queries for every supported mesh type are sent to every shard, and the
+//answers are merged before being sent to the client.
+class BrokerShards
+{
+public:
+  //create the shards. They share the given factory and blob store, and
+  //need to use the same context as the server so that we can talk to them
+  //over inproc sockets. The inproc endpoints are derived from the name, so
+  //it needs to be unique to the server.
+  BrokerShards(std::size_t numberOfShards,
+               const std::string& name,
+               const boost::shared_ptr<zmq::context_t>& context,
+               const boost::shared_ptr<remus::server::WorkerFactoryBase>& factory,
+               const boost::shared_ptr<BlobStore>& blobs,
+               boost::int64_t affinityWait,
+               const remus::server::PollingRates& rates);
+
+  std::size_t size() const { return this->Shards.size(); }
+
+  //returns the shard that owns the jobs and workers of the given type
+  std::size_t shardFor(const remus::common::MeshIOType& type) const;
+
+  //start every shard brokering, and connect to them
+  void start();
+
+  //wait at most timeout milliseconds for a message from the clients,
+  //workers or shards, and route every message that has arrived. Returns
+  //early when woken up through the wake up channel.
+  void route(zmq::socket_t& clientChannel,
+             zmq::socket_t& workerChannel,
+             zmq::socket_t& statusChannel,
+             zmq::socket_t& wakeUpChannel,
+             boost::int64_t timeout);
+
+  //stop every shard. The shards terminate their workers when they stop,
+  //so the messages they send while stopping are still relayed
+  void stop(zmq::socket_t& clientChannel, zmq::socket_t& workerChannel);
+
+private:
+  //explicitly state the shards don't support copy or move semantics
+  BrokerShards(const BrokerShards&);
+  void operator=(const BrokerShards&);
+
+  struct Shard;
+
+  //the answers gathered so far for a query sent to every shard
+  struct PendingMerge
+  {
+    zmq::SocketIdentity Client;
+    std::size_t Remaining;
+    remus::common::MeshIOTypeSet Types;
+  };
+
+  //handle a single message from a client or worker
+  void clientRequest(zmq::socket_t& clientChannel);
+  void workerMessage(zmq::socket_t& workerChannel);
+
+  //relay a single response from a shard to a client or worker
+  void shardClientResponse(Shard& shard, zmq::socket_t& clientChannel);
+  void shardWorkerResponse(Shard& shard, zmq::socket_t& workerChannel);
+
+  //relay a single event that a shard published
+  void shardEvent(zmq::socket_t& statusChannel);
+
+  boost::shared_ptr<zmq::context_t> Context;
+  std::vector< boost::shared_ptr<Shard> > Shards;
+
+  //receives the events of every shard
+  boost::scoped_ptr<zmq::socket_t> EventChannel;
+
+  //the shard every registered worker belongs to
+  typedef boost::unordered_map<zmq::SocketIdentity, std::size_t> WorkerShardMap;
+  WorkerShardMap WorkerShards;
+
+  //queries that have been sent to every shard and are waiting on answers,
+  //keyed by the identity the answers are sent to
+  typedef std::map<zmq::SocketIdentity, PendingMerge> PendingMergeMap;
+  PendingMergeMap PendingMerges;
+  boost::uint64_t MergeCount;
+};
+
+}
+}
+}
+
+#endif
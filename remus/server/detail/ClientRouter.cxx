@@ -0,0 +1,227 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/ClientRouter.h>
+
+#include <remus/proto/FrameSet.h>
+#include <remus/proto/Job.h>
+#include <remus/proto/JobStatus.h>
+#include <remus/proto/Message.h>
+#include <remus/proto/Response.h>
+#include <remus/proto/zmqHelper.h>
+#include <remus/proto/zmqSocketIdentity.h>
+
+#include <remus/server/detail/JobStatusTable.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/thread.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <cstring>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+namespace
+{
+//------------------------------------------------------------------------------
+bool has_more(zmq::socket_t& socket)
+{
+  zmq::more_t more;
+  size_t more_size = sizeof(more);
+  socket.getsockopt(ZMQ_RCVMORE, &more, &more_size);
+  return more > 0;
+}
+}
+
+//------------------------------------------------------------------------------
+ClientRouter::ClientRouter(zmq::socket_t& clientChannel,
+                    zmq::socket_t& schedulerChannel,
+                    const zmq::socketInfo<zmq::proto::inproc>& schedulerInfo,
+                    zmq::context_t& context,
+                    const boost::shared_ptr<JobStatusTable>& statuses):
+  ClientChannel(clientChannel),
+  SchedulerChannel(schedulerChannel),
+  Context(context),
+  SchedulerInfo(schedulerInfo),
+  Statuses(statuses),
+  RouterThread(new boost::thread())
+{
+}
+
+//------------------------------------------------------------------------------
+ClientRouter::~ClientRouter()
+{
+  if(this->RouterThread->joinable())
+    {
+    //a message that only holds an empty frame tells the router to stop
+    zmq::message_t stop(0);
+    zmq::send_harder(this->SchedulerChannel, stop);
+    this->RouterThread->join();
+    }
+}
+
+//------------------------------------------------------------------------------
+void ClientRouter::start()
+{
+  boost::scoped_ptr<boost::thread> rthread(
+                          new boost::thread(&ClientRouter::route, this) );
+  this->RouterThread.swap(rthread);
+}
+
+//------------------------------------------------------------------------------
+void ClientRouter::bindSchedulerChannel(zmq::socket_t& schedulerChannel,
+                    const zmq::socketInfo<zmq::proto::inproc>& schedulerInfo)
+{
+  zmq::remove_high_water_mark(schedulerChannel);
+  zmq::bindToAddress(schedulerChannel, schedulerInfo);
+}
+
+//------------------------------------------------------------------------------
+void ClientRouter::route()
+{
+  zmq::socket_t routerChannel(this->Context, ZMQ_PAIR);
+  zmq::remove_high_water_mark(routerChannel);
+  zmq::connectToAddress(routerChannel, this->SchedulerInfo);
+
+  zmq::pollitem_t items[2] = {
+      { this->ClientChannel, 0, ZMQ_POLLIN, 0 },
+      { routerChannel, 0, ZMQ_POLLIN, 0 } };
+
+  //the scheduling thread tells us when to stop, so the timeout only bounds
+  //how long a single poll blocks
+  const boost::int64_t pollTimeout(1000);
+
+  bool routing = true;
+  while(routing)
+    {
+    zmq::poll_safely(&items[0], 2, pollTimeout);
+
+    //relay responses before taking on new requests
+    if(items[1].revents & ZMQ_POLLIN)
+      {
+      routing = this->schedulerResponse(routerChannel);
+      }
+    if(routing && (items[0].revents & ZMQ_POLLIN))
+      {
+      this->clientRequest(routerChannel);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void ClientRouter::clientRequest(zmq::socket_t& routerChannel)
+{
+  zmq::SocketIdentity clientIdentity = zmq::address_recv(this->ClientChannel);
+  remus::proto::Message msg = remus::proto::receive_Message(&this->ClientChannel);
+  clientIdentity.requestId(msg.requestId());
+  if(!msg.isValid())
+    {
+    remus::proto::send_NonBlockingResponse(remus::INVALID_SERVICE,
+                                           remus::INVALID_MSG,
+                                           &this->ClientChannel,
+                                           clientIdentity);
+    return;
+    }
+
+  if(msg.serviceType() == remus::MESH_STATUS)
+    {
+    //status queries are the bulk of what clients send, so they are answered
+    //here without involving the scheduling thread
+    const remus::proto::Job job =
+                            remus::proto::to_Job(msg.data(),msg.dataSize());
+    const remus::proto::JobStatus js = this->Statuses->status(job.id());
+    if(js.status() != remus::INVALID_STATUS)
+      {
+      remus::proto::send_NonBlockingResponse(remus::MESH_STATUS,
+                                             remus::proto::to_string(js),
+                                             &this->ClientChannel,
+                                             clientIdentity);
+      return;
+      }
+    //jobs the table doesn't know are asked of the scheduling thread, as
+    //they can predate the table
+    }
+
+  if(msg.serviceType() == remus::MESH_STATUSES)
+    {
+    //the bulk version of the status query is answered here as well
+    const std::vector<remus::proto::FrameSet> jobs =
+                                    remus::proto::to_FrameSets(msg.frames());
+
+    std::vector<remus::proto::FrameSet> statuses(jobs.size());
+    bool known = true;
+    for(std::size_t i=0; i < jobs.size() && known; ++i)
+      {
+      const remus::proto::Job job =
+          remus::proto::to_Job(jobs[i].Header.data(),jobs[i].Header.size());
+      const remus::proto::JobStatus status = this->Statuses->status(job.id());
+      known = status.status() != remus::INVALID_STATUS;
+      std::string js = remus::proto::to_string(status);
+      statuses[i].Header = remus::proto::detail::make_HeaderFrame(js);
+      }
+    if(known)
+      {
+      remus::proto::send_NonBlockingResponse(remus::MESH_STATUSES,
+                                           remus::proto::to_FrameSet(statuses),
+                                           &this->ClientChannel,
+                                           clientIdentity);
+      return;
+      }
+    }
+
+  //forward the request prefixed with the identity of the client, so the
+  //scheduling thread reads it the same way as from the client socket
+  zmq::message_t identity(clientIdentity.size());
+  std::memcpy(identity.data(), clientIdentity.data(), clientIdentity.size());
+  if(zmq::send_harder(routerChannel, identity, ZMQ_SNDMORE))
+    {
+    remus::proto::forward_Message(msg, &routerChannel);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool ClientRouter::schedulerResponse(zmq::socket_t& routerChannel)
+{
+  zmq::message_t frame;
+  zmq::recv_harder(routerChannel, &frame);
+  bool more = has_more(routerChannel);
+  if(frame.size() == 0 && !more)
+    {
+    return false;
+    }
+
+  //relay every frame of the response, the first frame is the identity of
+  //the client to route to. We don't want to stall on a client that has
+  //disconnected, but we still need to read the rest of the response when
+  //a frame can't be sent
+  bool sent = zmq::send_harder(this->ClientChannel, frame,
+                               more ? ZMQ_DONTWAIT|ZMQ_SNDMORE : ZMQ_DONTWAIT);
+  while(more)
+    {
+    zmq::message_t next;
+    zmq::recv_harder(routerChannel, &next);
+    more = has_more(routerChannel);
+    if(sent)
+      {
+      sent = zmq::send_harder(this->ClientChannel, next,
+                              more ? ZMQ_DONTWAIT|ZMQ_SNDMORE : ZMQ_DONTWAIT);
+      }
+    }
+  return true;
+}
+
+}
+}
+}
@@ -0,0 +1,101 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_ClientRouter_h
+#define remus_server_detail_ClientRouter_h
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <remus/proto/zmq.hpp>
+#include <remus/proto/zmqSocketInfo.h>
+
+namespace boost { class thread; }
+
+namespace remus{
+namespace server{
+namespace detail{
+
+class JobStatusTable;
+
+//Handles the client socket of a server on its own thread, when the server
+//is brokering with multiple threads.
+//
+//Job status queries are answered directly from the JobStatusTable, unless
+//the table doesn't know one of the jobs. Those queries and every
+//other client request are forwarded to the scheduling thread over an inproc
+//PAIR socket, and the responses the scheduling thread sends back are relayed
+//to the clients. That way a burst of client queries never delays the
+//scheduling thread from handling worker messages and dispatching jobs.
+//
+//The messages on the PAIR socket are the same as on the client socket,
+//starting with the identity of the client. A message that only holds an
+//empty frame tells the router to stop.
+class ClientRouter
+{
+public:
+  //The client socket must already be bound, and the scheduler channel must
+  //be the PAIR socket of the scheduling thread, already bound to the given
+  //endpoint. Once the router has started, the client socket must only be
+  //used by the router.
+  ClientRouter(zmq::socket_t& clientChannel,
+               zmq::socket_t& schedulerChannel,
+               const zmq::socketInfo<zmq::proto::inproc>& schedulerInfo,
+               zmq::context_t& context,
+               const boost::shared_ptr<JobStatusTable>& statuses);
+
+  //tells the router thread to stop, and waits for it to finish. Must be
+  //called from the scheduling thread, as it sends on the scheduler channel
+  ~ClientRouter();
+
+  //launch the thread that routes client messages
+  void start();
+
+  //bind the PAIR socket of the scheduling thread. The socket doesn't have
+  //a high water mark, so responses are never dropped while the router
+  //is busy.
+  static void bindSchedulerChannel(zmq::socket_t& schedulerChannel,
+                    const zmq::socketInfo<zmq::proto::inproc>& schedulerInfo);
+
+private:
+  //explicitly state the router doesn't support copy or move semantics
+  ClientRouter(const ClientRouter&);
+  void operator=(const ClientRouter&);
+
+  //the routing loop, runs on the router thread
+  void route();
+
+  //handle a single request from a client
+  void clientRequest(zmq::socket_t& routerChannel);
+
+  //relay a response from the scheduling thread to the client. Returns false
+  //when the scheduling thread asked us to stop
+  bool schedulerResponse(zmq::socket_t& routerChannel);
+
+  zmq::socket_t& ClientChannel;
+  zmq::socket_t& SchedulerChannel;
+  zmq::context_t& Context;
+  zmq::socketInfo<zmq::proto::inproc> SchedulerInfo;
+  boost::shared_ptr<JobStatusTable> Statuses;
+
+  boost::scoped_ptr<boost::thread> RouterThread;
+};
+
+}
+}
+}
+
+#endif
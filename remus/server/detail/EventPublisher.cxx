@@ -20,7 +20,6 @@
 #include <remus/proto/JobResult.h>
 #include <remus/proto/JobStatus.h>
 #include <remus/proto/zmqSocketIdentity.h>
-#include <remus/worker/Job.h>
 
 #include "cJSON.h"
 
@@ -125,6 +124,11 @@ void EventPublisher::jobStatus(const remus::proto::JobStatus& s, const zmq::Sock
   this->pubWorker(serv_t, work_t, root);
 
   cJSON_Delete(root);
+
+  if(s.failed())
+    {
+    this->pubJobDone(suid, s);
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -152,6 +156,9 @@ void EventPublisher::jobTerminated(const remus::proto::JobStatus& s,
   this->pubWorker(serv_t, work_t, root);
 
   cJSON_Delete(root);
+
+  //a terminated job is reported to clients as failed
+  this->pubJobDone(suid, remus::proto::JobStatus(s.id(),remus::FAILED));
 }
 
 //----------------------------------------------------------------------------
@@ -177,6 +184,9 @@ void EventPublisher::jobTerminated(const remus::proto::JobStatus& s)
   this->pubJob(serv_t, suid, root);
 
   cJSON_Delete(root);
+
+  //a terminated job is reported to clients as failed
+  this->pubJobDone(suid, remus::proto::JobStatus(s.id(),remus::FAILED));
 }
 
 //----------------------------------------------------------------------------
@@ -209,6 +219,8 @@ void EventPublisher::jobExpired(const remus::proto::JobStatus& s)
   this->pubJob(status_service, suid, root);
 
   cJSON_Delete(root);
+
+  this->pubJobDone(suid, s);
 }
 
 //----------------------------------------------------------------------------
@@ -228,10 +240,12 @@ void EventPublisher::jobFinished(const remus::proto::JobResult& r, const zmq::So
   this->pubWorker(serv_t, work_t, root);
 
   cJSON_Delete(root);
+
+  this->pubJobDone(suid, remus::proto::JobStatus(r.id(),remus::FINISHED));
 }
 
   //----------------------------------------------------------------------------
-void EventPublisher::jobSentToWorker(const remus::worker::Job& j, const zmq::SocketIdentity &si)
+void EventPublisher::jobSentToWorker(const remus::proto::Job& j, const zmq::SocketIdentity &si)
 { //assign job to worker
   buffer << j.id();
   const std::string suid = buffer.str(); buffer.str("");
@@ -502,6 +516,22 @@ void EventPublisher::pubWorker(const std::string& st, const std::string suid, cJ
   socket->send(msg);
 }
 
+//----------------------------------------------------------------------------
+void EventPublisher::pubJobDone(const std::string suid,
+                                const remus::proto::JobStatus& s)
+{
+  //the key holds the job id so that a client can subscribe to just
+  //the jobs it is waiting on
+  const std::string key = remus::proto::jobevents::done_key(suid);
+  zmq::message_t keyMsg(key.size());
+  std::memcpy(keyMsg.data(), key.data(), key.size());
+  socket->send(keyMsg, ZMQ_SNDMORE);
+
+  const std::string data = remus::proto::to_string(s);
+  zmq::message_t msg(data.size());
+  std::memcpy(msg.data(), data.data(), data.size());
+  socket->send(msg);
+}
 
 }
 }
@@ -22,11 +22,6 @@ namespace proto{
   class JobRequirements;
   class JobResult;
   class JobStatus;
-  class WorkerJob;
-  }
-
-namespace worker{
-  typedef remus::proto::WorkerJob Job;
   }
 
 struct cJSON;
@@ -74,6 +69,10 @@ public:
   //the key construction is:
   //job:<status>:<jobId>
   //worker:<status>:<workerId>
+  //
+  //When a job is done ( finished, failed, terminated or expired ) we also
+  //publish the final status of the job under the key done:<jobId>, see
+  //remus::proto::jobevents::done_key
 
   //tell this EventPublisher  what socket to send all information out on.
   //the socket_t is merely used, not owned by this class so it's lifespan
@@ -93,7 +92,7 @@ public:
 
   void jobFinished( const remus::proto::JobResult& r,
                     const zmq::SocketIdentity &workerIdentity);
-  void jobSentToWorker( const remus::worker::Job& j,
+  void jobSentToWorker( const remus::proto::Job& j,
                        const zmq::SocketIdentity &workerIdentity);
 
   //helper method for when we have a collection of events to publish
@@ -120,6 +119,7 @@ public:
 private:
   void pubJob(const std::string& st, const std::string suid, cJSON *root);
   void pubWorker(const std::string& st, const std::string suid, cJSON *root);
+  void pubJobDone(const std::string suid, const remus::proto::JobStatus& s);
 
   zmq::socket_t* socket;
   std::stringstream buffer;
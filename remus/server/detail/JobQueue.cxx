@@ -11,7 +11,6 @@
 //=============================================================================
 
 #include <remus/server/detail/JobQueue.h>
-#include <iostream>
 
 namespace remus{
 namespace server{
@@ -20,163 +19,230 @@ namespace detail{
 //------------------------------------------------------------------------------
 bool JobQueue::addJob(const boost::uuids::uuid &id,
                       const remus::proto::JobSubmission& submission)
+{
+  return this->addJob(id, submission.requirements(),
+                      remus::proto::to_FrameSet(submission));
+}
+
+//------------------------------------------------------------------------------
+bool JobQueue::addJob(const boost::uuids::uuid &id,
+                      const remus::proto::JobRequirements& reqs,
+                      const remus::proto::FrameSet& submission,
+                      const std::vector<std::string>& blobHashes)
 {
   //only add the message as a job if the uuid hasn't been used already
-  const bool can_add = QueuedIds.count(id) == 0;
+  const bool can_add = this->Locations.count(id) == 0;
   if(can_add)
     {
-    QueuedJob newQueuedJob(id,submission);
-    this->QueuedJobs.insert(
-          std::lower_bound( this->QueuedJobs.begin(), this->QueuedJobs.end(),
-                            newQueuedJob ),
-          newQueuedJob);
-    this->QueuedIds.insert(id);
-    this->CachedQueuedJobRequirements.insert( submission.requirements() );
+    //each queued job holds a reference to its requirements handle
+    const RequirementsHandle handle = this->Registry->intern(reqs);
+    JobList& queued = this->Buckets[handle].Queued;
+    queued.push_back( QueuedJob(id,handle,reqs,submission,blobHashes) );
+
+    this->Locations.insert( std::make_pair(id,
+                                  JobLocation(handle, --queued.end())) );
+    this->QueuedHandles.insert(handle);
+    this->DirtyHandles.insert(handle);
+    ++this->NumQueued;
     }
   return can_add;
 }
 
 //------------------------------------------------------------------------------
-remus::worker::Job JobQueue::takeJob(const remus::proto::JobRequirements& reqs)
+QueuedJob JobQueue::takeJob(const remus::proto::JobRequirements& reqs)
 {
-  std::vector<QueuedJob>* searched_vector = &this->JobsWaitingForWorker;
-  typedef std::vector<QueuedJob>::iterator iter;
-
-  JobTypeMatches pred(reqs);
-  iter item = std::find_if(searched_vector->begin(), searched_vector->end(),
-                           pred);
-  if(item == searched_vector->end())
+  //requirements that were never interned can't match any queued job
+  const RequirementsHandle handle = this->Registry->find(reqs);
+  if(handle == RequirementsRegistry::InvalidHandle)
     {
-    searched_vector = &this->QueuedJobs;
-    item = std::find_if(searched_vector->begin(), searched_vector->end(),
-                        pred);
-    if(item == searched_vector->end())
-      {
-      //return an invalid job
-      return remus::worker::Job();
-      }
-
-    //the job is from the queue, so invalidate the cache. This is overaggressive
-    //but to fix it we would need to track the number of jobs that each requirement
-    //maps too
-    this->CachedQueuedJobRequirements.clear();
+    return QueuedJob();
     }
+  return this->takeJob(handle);
+}
 
-  //we need to copy the id and the contents of item now into a job
-  //submission, if we use item after the remove_if it is invalid as
-  //remove_if moves the vector items around making what item
-  //is pointing too change
-  remus::worker::Job job(item->Id,item->Submission);
+//------------------------------------------------------------------------------
+QueuedJob JobQueue::takeJob(RequirementsHandle handle)
+{
+  BucketMap::iterator bucket = this->Buckets.find(handle);
+  if(bucket == this->Buckets.end())
+    {
+    //return an invalid job
+    return QueuedJob();
+    }
 
-  //again don't use item after the remove_if the iterator is invalid
-  JobIdMatches id_pred(job.id());
+  //prefer jobs that already have a worker dispatched for them. A bucket
+  //only exists while it holds a job, so one of the lists isn't empty
+  JobList& jobs = bucket->second.Waiting.empty() ? bucket->second.Queued :
+                                                   bucket->second.Waiting;
 
-  iter new_end = std::remove_if(searched_vector->begin(),
-                                searched_vector->end(),
-                                id_pred);
-  searched_vector->erase(new_end,searched_vector->end());
+  //copy the job before we erase it, copying only shares the submission frames
+  QueuedJob job(jobs.front());
 
-  this->QueuedIds.erase(job.id());
+  LocationMap::iterator location = this->Locations.find(job.id());
+  this->erase(location->second);
+  this->Locations.erase(location);
+  return job;
+}
 
-  //clear the queued job cache
+//------------------------------------------------------------------------------
+QueuedJob JobQueue::nextJob(RequirementsHandle handle) const
+{
+  BucketMap::const_iterator bucket = this->Buckets.find(handle);
+  if(bucket == this->Buckets.end())
+    {
+    return QueuedJob();
+    }
 
-  return job;
+  //the same order as takeJob, jobs with a worker dispatched for them first
+  const JobList& jobs = bucket->second.Waiting.empty() ? bucket->second.Queued :
+                                                         bucket->second.Waiting;
+  return jobs.front();
 }
 
 //------------------------------------------------------------------------------
 remus::proto::JobRequirementsSet JobQueue::waitingJobRequirements() const
 {
   remus::proto::JobRequirementsSet result;
-  for(std::vector<QueuedJob>::const_iterator i= this->JobsWaitingForWorker.begin();
-      i != this->JobsWaitingForWorker.end();
-      ++i)
+  typedef std::set<RequirementsHandle>::const_iterator cit;
+  for(cit i = this->WaitingHandles.begin(); i != this->WaitingHandles.end(); ++i)
     {
-    result.insert(i->Submission.requirements());
+    result.insert(this->Registry->requirements(*i));
     }
   return result;
 }
 
 //------------------------------------------------------------------------------
-remus::proto::JobRequirementsSet JobQueue::queuedJobRequirements()
+remus::proto::JobRequirementsSet JobQueue::queuedJobRequirements() const
 {
-  if(this->CachedQueuedJobRequirements.size() == 0)
+  remus::proto::JobRequirementsSet result;
+  typedef std::set<RequirementsHandle>::const_iterator cit;
+  for(cit i = this->QueuedHandles.begin(); i != this->QueuedHandles.end(); ++i)
     {
-    for(std::vector<QueuedJob>::const_iterator i= this->QueuedJobs.begin();
-      i != this->QueuedJobs.end();
-      ++i)
-      {
-      this->CachedQueuedJobRequirements.insert(i->Submission.requirements());
-      }
+    result.insert(this->Registry->requirements(*i));
     }
-
-  return CachedQueuedJobRequirements;
+  return result;
 }
 
 //------------------------------------------------------------------------------
 bool JobQueue::workerDispatched(const remus::proto::JobRequirements& reqs)
 {
-  typedef std::vector<QueuedJob>::iterator iter;
-  JobTypeMatches pred(reqs);
+  const RequirementsHandle handle = this->Registry->find(reqs);
+  return handle != RequirementsRegistry::InvalidHandle &&
+         this->workerDispatched(handle);
+}
 
-  iter item = std::find_if(this->QueuedJobs.begin(),
-                           this->QueuedJobs.end(), pred);
-  const bool found = this->QueuedJobs.end() != item;
+//------------------------------------------------------------------------------
+bool JobQueue::workerDispatched(RequirementsHandle handle)
+{
+  BucketMap::iterator bucket = this->Buckets.find(handle);
+  const bool found = bucket != this->Buckets.end() &&
+                     !bucket->second.Queued.empty();
   if(found)
     {
-    this->JobsWaitingForWorker.push_back(*item);
-    this->QueuedJobs.erase(item);
-    this->CachedQueuedJobRequirements.clear();
+    Bucket& b = bucket->second;
+    JobLocation& location = this->Locations.find(b.Queued.front().id())->second;
+
+    //splicing keeps the iterator to the job valid
+    b.Waiting.splice(b.Waiting.end(), b.Queued, b.Queued.begin());
+    location.IsWaiting = true;
+
+    --this->NumQueued;
+    ++this->NumWaiting;
+    this->WaitingHandles.insert(handle);
+    if(b.Queued.empty())
+      {
+      this->QueuedHandles.erase(handle);
+      }
     }
   return found;
 }
 
+//------------------------------------------------------------------------------
+void JobQueue::takeDirtyHandles(std::set<RequirementsHandle>& dirty)
+{
+  if(dirty.empty())
+    {
+    dirty.swap(this->DirtyHandles);
+    }
+  else
+    {
+    dirty.insert(this->DirtyHandles.begin(), this->DirtyHandles.end());
+    this->DirtyHandles.clear();
+    }
+}
+
 //------------------------------------------------------------------------------
 bool JobQueue::haveUUID(const boost::uuids::uuid &id) const
 {
-  return this->QueuedIds.count(id) == 1;
+  return this->Locations.count(id) == 1;
 }
 
 //------------------------------------------------------------------------------
 bool JobQueue::remove(const boost::uuids::uuid& id)
 {
-  typedef std::vector<QueuedJob>::iterator iter;
-  JobIdMatches pred(id);
-
-  bool id_found = false;
+  LocationMap::iterator location = this->Locations.find(id);
+  const bool id_found = location != this->Locations.end();
+  if(id_found)
+    {
+    this->erase(location->second);
+    this->Locations.erase(location);
+    }
+  return id_found;
+}
 
-  iter new_end = std::remove_if(this->QueuedJobs.begin(),
-                                this->QueuedJobs.end(),
-                                pred);
+//------------------------------------------------------------------------------
+void JobQueue::clear()
+{
+  for(LocationMap::const_iterator i = this->Locations.begin();
+      i != this->Locations.end(); ++i)
+    {
+    this->Registry->release(i->second.Handle);
+    }
+  this->Buckets.clear();
+  this->Locations.clear();
+  this->QueuedHandles.clear();
+  this->WaitingHandles.clear();
+  this->DirtyHandles.clear();
+  this->NumQueued = 0;
+  this->NumWaiting = 0;
+}
 
-  id_found = (new_end != this->QueuedJobs.end());
-  if( id_found )
+//------------------------------------------------------------------------------
+void JobQueue::erase(const JobLocation& location)
+{
+  BucketMap::iterator bucket = this->Buckets.find(location.Handle);
+  Bucket& b = bucket->second;
+  if(location.IsWaiting)
     {
-    this->QueuedJobs.erase(new_end,this->QueuedJobs.end());
-    this->CachedQueuedJobRequirements.clear();
+    b.Waiting.erase(location.Position);
+    --this->NumWaiting;
+    if(b.Waiting.empty())
+      {
+      this->WaitingHandles.erase(location.Handle);
+      }
     }
   else
     {
-    new_end = std::remove_if(this->JobsWaitingForWorker.begin(),
-                            this->JobsWaitingForWorker.end(),
-                            pred);
-
-    id_found = (new_end != this->JobsWaitingForWorker.end());
-
-    if( id_found )
+    b.Queued.erase(location.Position);
+    --this->NumQueued;
+    if(b.Queued.empty())
       {
-      this->JobsWaitingForWorker.erase(new_end,this->JobsWaitingForWorker.end());
+      this->QueuedHandles.erase(location.Handle);
       }
     }
-  return this->QueuedIds.erase(id)==1;
-}
 
-//------------------------------------------------------------------------------
-void JobQueue::clear()
-{
-  this->QueuedIds.clear();
-  this->QueuedJobs.clear();
-  this->QueuedJobs.clear();
-  this->CachedQueuedJobRequirements.clear();
+  //drop buckets that are empty so the bucket map only holds pending types
+  if(b.Waiting.empty() && b.Queued.empty())
+    {
+    this->Buckets.erase(bucket);
+    }
+
+  //once no job or worker holds the requirements, the handle can be given
+  //to other requirements so it must not be looked at again
+  if(this->Registry->release(location.Handle))
+    {
+    this->DirtyHandles.erase(location.Handle);
+    }
 }
 
 }
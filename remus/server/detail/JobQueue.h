@@ -13,66 +13,186 @@
 #ifndef remus_server_detail_JobQueue_h
 #define remus_server_detail_JobQueue_h
 
+#include <remus/proto/FrameSet.h>
 #include <remus/proto/JobSubmission.h>
 #include <remus/proto/Message.h>
 
+#include <remus/server/detail/RequirementsRegistry.h>
 #include <remus/server/detail/uuidHelper.h>
 
-#include <remus/worker/Job.h>
-
 REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/functional/hash.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/nil_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
-#include <algorithm>
+#include <list>
 #include <set>
+#include <string>
 #include <vector>
 
 namespace remus{
 namespace server{
 namespace detail{
 
-//A job id based queue. When jobs are added they are inserted based on
-//the uuid of the job. We use the uuid as the priority of the queue to
-//help alleviate the issue of a single client submitting many jobs and
-//stopping any other client from getting a job finished in a reasonable
-//amount of time.
+//A job held by the server until it is given to a worker. Only the
+//requirements of the submission are decoded, the submission itself is kept
+//as the frames it was received in so that it can be forwarded to the
+//worker without being decoded and encoded again.
+struct QueuedJob
+{
+  QueuedJob():
+            Id(boost::uuids::nil_uuid()),
+            Handle(RequirementsRegistry::InvalidHandle),
+            Requirements(),
+            Submission(),
+            BlobHashes()
+            {}
+
+  QueuedJob(const boost::uuids::uuid& id,
+            RequirementsHandle handle,
+            const remus::proto::JobRequirements& reqs,
+            const remus::proto::FrameSet& submission,
+            const std::vector<std::string>& blobHashes = std::vector<std::string>()):
+            Id(id),
+            Handle(handle),
+            Requirements(reqs),
+            Submission(submission),
+            BlobHashes(blobHashes)
+            {}
+
+  const boost::uuids::uuid& id() const { return Id; }
+  RequirementsHandle handle() const { return Handle; }
+  const remus::proto::JobRequirements& requirements() const
+    { return Requirements; }
+
+  //the frames of the submission as they were received
+  const remus::proto::FrameSet& submission() const { return Submission; }
+
+  //the content hash of each blob of the submission, empty for blobs that
+  //weren't submitted with a hash. Workers that cache blobs are only sent
+  //the hash of the blobs they already hold
+  const std::vector<std::string>& blobHashes() const { return BlobHashes; }
+
+  //a job is valid when it has an id and valid requirements
+  bool valid() const
+    { return !this->Id.is_nil() && this->Requirements.meshTypes().valid(); }
+
+  bool operator<(const QueuedJob& other) const
+    { return this->Id < other.Id; }
+
+  boost::uuids::uuid Id;
+  RequirementsHandle Handle;
+  remus::proto::JobRequirements Requirements;
+  remus::proto::FrameSet Submission;
+  std::vector<std::string> BlobHashes;
+};
+
+//A queue of jobs bucketed by their requirements. Each requirements type
+//has its own first in first out queue, so taking the next job for a
+//requirements type never searches through jobs of other types. A hash index
+//from the job uuid to where the job is stored makes removing a job, for
+//example when it is terminated, independent of the number of queued jobs.
+//The set of requirements with pending jobs is updated as jobs are added
+//and taken, instead of being recomputed.
 class JobQueue
 {
 public:
   JobQueue():
-    QueuedJobs(),
-    JobsWaitingForWorker(),
-    QueuedIds()
+    Registry(new RequirementsRegistry()),
+    Buckets(),
+    Locations(),
+    QueuedHandles(),
+    WaitingHandles(),
+    DirtyHandles(),
+    NumQueued(0),
+    NumWaiting(0)
   {}
 
-  //Convert a Message and UUID into a WorkerMessage.
+  //construct a queue that interns requirements into a registry that is
+  //shared with the rest of the server, so that handles can be compared
+  //against the handles of the worker pool
+  explicit JobQueue(const boost::shared_ptr<RequirementsRegistry>& registry):
+    Registry(registry),
+    Buckets(),
+    Locations(),
+    QueuedHandles(),
+    WaitingHandles(),
+    DirtyHandles(),
+    NumQueued(0),
+    NumWaiting(0)
+  {}
+
+  //Queue the submission frames with the given UUID and requirements, and
+  //optionally the content hash of each blob of the submission.
+  //will return false if the uuid is already queued
+  bool addJob( const boost::uuids::uuid& id,
+               const remus::proto::JobRequirements& reqs,
+               const remus::proto::FrameSet& submission,
+               const std::vector<std::string>& blobHashes =
+                                              std::vector<std::string>());
+
+  //Convenience version of addJob that encodes the submission into frames.
   //will return false if the uuid is already queued
   bool addJob( const boost::uuids::uuid& id,
                const remus::proto::JobSubmission& submission);
 
   //Removes a job from the queue of the given mesh type.
-  //Return it as a worker Job. We prioritize jobs waiting for
-  //workers, and than take jobs that are just queued.
-  remus::worker::Job takeJob(const remus::proto::JobRequirements& reqs);
+  //We prioritize jobs waiting for workers, and than take jobs that are
+  //just queued. Jobs of the same type are taken in the order they were
+  //added. Returns an invalid job when nothing matches.
+  QueuedJob takeJob(const remus::proto::JobRequirements& reqs);
+  QueuedJob takeJob(RequirementsHandle handle);
+
+  //returns the job that takeJob would return, without removing it from
+  //the queue. Returns an invalid job when nothing matches.
+  QueuedJob nextJob(RequirementsHandle handle) const;
 
   //returns the types of jobs that are waiting for a worker
   remus::proto::JobRequirementsSet waitingJobRequirements() const;
+  const std::set<RequirementsHandle>& waitingJobHandles() const
+    { return this->WaitingHandles; }
 
   //returns the types of jobs that are queued and aren't waiting for a worker
-  remus::proto::JobRequirementsSet queuedJobRequirements();
+  remus::proto::JobRequirementsSet queuedJobRequirements() const;
+  const std::set<RequirementsHandle>& queuedJobHandles() const
+    { return this->QueuedHandles; }
+
+  //returns true if jobs of the given type are queued or waiting for a worker
+  bool haveJob(RequirementsHandle handle) const
+    { return this->QueuedHandles.count(handle) > 0 ||
+             this->WaitingHandles.count(handle) > 0; }
+
+  //The types of jobs that have been added since the last call are dirty,
+  //as they might match a waiting worker or need a worker to be created.
+  //Moves the dirty types into the given set.
+  void takeDirtyHandles(std::set<RequirementsHandle>& dirty);
+
+  //mark a type of job as dirty, so that it is looked at by the next
+  //scheduling pass
+  void markDirty(RequirementsHandle handle)
+    { this->DirtyHandles.insert(handle); }
+
+  //mark every type of job that isn't waiting for a worker as dirty, for
+  //when the worker factory might be able to create workers again
+  void markQueuedHandlesDirty()
+    { this->DirtyHandles.insert(this->QueuedHandles.begin(),
+                                this->QueuedHandles.end()); }
 
   //return the number of jobs waiting for workers
   std::size_t numJobsWaitingForWorkers() const
-    { return JobsWaitingForWorker.size(); }
+    { return this->NumWaiting; }
 
   //return the number of jobs queued but not waiting for a worker
   std::size_t numJobsJustQueued() const
-    { return QueuedJobs.size(); }
+    { return this->NumQueued; }
 
   //marks the first job with the given type as having
   //a worker dispatched for it.
   bool workerDispatched(const remus::proto::JobRequirements& reqs);
+  bool workerDispatched(RequirementsHandle handle);
 
   //Returns true if we contain the UUID
   bool haveUUID(const boost::uuids::uuid& id) const;
@@ -84,57 +204,54 @@ public:
   void clear();
 
 private:
-  struct QueuedJob
-  {
-    QueuedJob(const boost::uuids::uuid& id,
-              const remus::proto::JobSubmission& submission):
-              Id(id),
-              Submission(submission)
-              {}
+  typedef std::list<QueuedJob> JobList;
 
-    boost::uuids::uuid Id;
-    remus::proto::JobSubmission Submission;
-
-    bool operator<(const QueuedJob& other) const
-      { return this->Id < other.Id; }
+  //all the jobs of a single requirements type
+  struct Bucket
+  {
+    //kept in the order that the jobs are dispatched since this is a real
+    //queue we want the priority of queued jobs that have a worker incoming
+    //to match the dispatch order
+    JobList Waiting;
 
+    //kept in the order that the jobs are added
+    JobList Queued;
   };
 
-  struct JobIdMatches
+  //where a job is stored, so it can be removed without a search
+  struct JobLocation
   {
-    JobIdMatches(boost::uuids::uuid id):
-    UUID(id) {}
+    JobLocation(RequirementsHandle h, JobList::iterator p):
+      Handle(h), IsWaiting(false), Position(p) {}
 
-    bool operator()(const QueuedJob& job) const
-      { return job.Id == UUID; }
-
-    boost::uuids::uuid UUID;
+    RequirementsHandle Handle;
+    bool IsWaiting;
+    JobList::iterator Position;
   };
 
-  struct JobTypeMatches
-  {
-    JobTypeMatches(const remus::proto::JobRequirements& r):
-    Reqs(r) {}
+  typedef boost::unordered_map<RequirementsHandle, Bucket> BucketMap;
+  typedef boost::unordered_map<boost::uuids::uuid, JobLocation,
+                               boost::hash<boost::uuids::uuid> > LocationMap;
 
-    bool operator()(const QueuedJob& job) const
-      { return Reqs == job.Submission.requirements(); }
+  //removes the job at the given location from its bucket, and keeps the
+  //handle sets and job counts up to date. Releases the reference the job
+  //held to its requirements handle. Doesn't touch the uuid index.
+  void erase(const JobLocation& location);
 
-    const remus::proto::JobRequirements& Reqs;
-  };
+  boost::shared_ptr<RequirementsRegistry> Registry;
+
+  BucketMap Buckets;
+  LocationMap Locations;
 
-  //job queue info, sorted by id when items are added so that we can get
-  //a really rough load balancing when we have multiple clients. This
-  //way jobs that come up for new workers are roughly round robin when
-  //the number of jobs per client is similar.
-  std::vector<QueuedJob> QueuedJobs;
+  //the requirements that have at least one job just queued, or waiting
+  std::set<RequirementsHandle> QueuedHandles;
+  std::set<RequirementsHandle> WaitingHandles;
 
-  //kept in the order that the jobs are added since this is a real queue
-  //we want the priority of queued jobs that have a working incoming to
-  //match the dispatch order
-  std::vector<QueuedJob> JobsWaitingForWorker;
+  //the requirements that have changed since the last scheduling pass
+  std::set<RequirementsHandle> DirtyHandles;
 
-  std::set<boost::uuids::uuid> QueuedIds;
-  std::set<remus::proto::JobRequirements> CachedQueuedJobRequirements;
+  std::size_t NumQueued;
+  std::size_t NumWaiting;
 
   //make copying not possible
   JobQueue (const JobQueue&);
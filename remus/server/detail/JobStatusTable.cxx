@@ -0,0 +1,80 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobStatusTable.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/thread/locks.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+JobStatusTable::JobStatusTable():
+  Mutex(),
+  Statuses()
+{
+}
+
+//------------------------------------------------------------------------------
+void JobStatusTable::update(const remus::proto::JobStatus& status)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  if(status.invalid())
+    {
+    this->Statuses.erase(status.id());
+    }
+  else
+    {
+    StatusMap::iterator i = this->Statuses.find(status.id());
+    if(i != this->Statuses.end())
+      {
+      i->second = status;
+      }
+    else
+      {
+      this->Statuses.insert( StatusMap::value_type(status.id(), status) );
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobStatus JobStatusTable::status(const boost::uuids::uuid& id) const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  StatusMap::const_iterator i = this->Statuses.find(id);
+  if(i != this->Statuses.end())
+    {
+    return i->second;
+    }
+  return remus::proto::JobStatus(id, remus::INVALID_STATUS);
+}
+
+//------------------------------------------------------------------------------
+std::size_t JobStatusTable::size() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Statuses.size();
+}
+
+//------------------------------------------------------------------------------
+void JobStatusTable::clear()
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  this->Statuses.clear();
+}
+
+}
+}
+}
@@ -0,0 +1,68 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_JobStatusTable_h
+#define remus_server_detail_JobStatusTable_h
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/functional/hash.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/uuid.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <remus/proto/JobStatus.h>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//A copy of the status of every queued and active job. The thread that
+//schedules jobs is the only one that writes to the table, and does so after
+//each change to the job queue or the active jobs. Other threads read from it
+//to answer job status queries without touching the scheduling state.
+class JobStatusTable
+{
+public:
+  JobStatusTable();
+
+  //store the status of a job, a status of INVALID_STATUS removes the job
+  void update(const remus::proto::JobStatus& status);
+
+  //returns the status of the job, or INVALID_STATUS for jobs that the
+  //table doesn't have
+  remus::proto::JobStatus status(const boost::uuids::uuid& id) const;
+
+  std::size_t size() const;
+
+  void clear();
+
+private:
+  //explicitly state the table doesn't support copy or move semantics
+  JobStatusTable(const JobStatusTable&);
+  void operator=(const JobStatusTable&);
+
+  typedef boost::unordered_map< boost::uuids::uuid,
+                                remus::proto::JobStatus,
+                                boost::hash<boost::uuids::uuid> > StatusMap;
+
+  mutable boost::mutex Mutex;
+  StatusMap Statuses;
+};
+
+}
+}
+}
+
+#endif
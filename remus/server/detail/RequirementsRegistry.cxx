@@ -0,0 +1,130 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/RequirementsRegistry.h>
+
+#include <string>
+
+namespace
+{
+//------------------------------------------------------------------------------
+//The requirements given to intern can point into the frame they were decoded
+//from, which for a submission can also hold all of its contents. Make a copy
+//that owns its data so the registry never keeps a received frame alive.
+remus::proto::JobRequirements make_OwningCopy(
+                                const remus::proto::JobRequirements& reqs)
+{
+  const std::string data(reqs.requirements(), reqs.requirementsSize());
+  if(reqs.sourceType() == remus::common::ContentSource::File)
+    {
+    remus::proto::JobRequirements copy(reqs.formatType(), reqs.meshTypes(),
+                                       reqs.workerName(),
+                                       remus::common::FileHandle(data));
+    copy.tag(reqs.tag());
+    return copy;
+    }
+  remus::proto::JobRequirements copy(reqs.formatType(), reqs.meshTypes(),
+                                     reqs.workerName(), data);
+  copy.tag(reqs.tag());
+  return copy;
+}
+}
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+RequirementsRegistry::RequirementsRegistry():
+  Handles(),
+  Requirements(1),
+  References(1, 0),
+  FreeHandles()
+{
+}
+
+//------------------------------------------------------------------------------
+RequirementsHandle RequirementsRegistry::intern(
+                                const remus::proto::JobRequirements& reqs)
+{
+  typedef std::map<remus::proto::JobRequirements,
+                   RequirementsHandle>::const_iterator cit;
+  cit i = this->Handles.find(reqs);
+  if(i != this->Handles.end())
+    {
+    ++this->References[i->second];
+    return i->second;
+    }
+
+  RequirementsHandle handle;
+  if(!this->FreeHandles.empty())
+    {
+    handle = this->FreeHandles.back();
+    this->FreeHandles.pop_back();
+    this->Requirements[handle] = make_OwningCopy(reqs);
+    }
+  else
+    {
+    handle = static_cast<RequirementsHandle>(this->Requirements.size());
+    this->Requirements.push_back( make_OwningCopy(reqs) );
+    this->References.push_back(0);
+    }
+  this->References[handle] = 1;
+  this->Handles.insert( std::make_pair(this->Requirements[handle], handle) );
+  return handle;
+}
+
+//------------------------------------------------------------------------------
+void RequirementsRegistry::retain(RequirementsHandle h)
+{
+  if(h < this->References.size() && this->References[h] > 0)
+    {
+    ++this->References[h];
+    }
+}
+
+//------------------------------------------------------------------------------
+bool RequirementsRegistry::release(RequirementsHandle h)
+{
+  if(h >= this->References.size() || this->References[h] == 0 ||
+     --this->References[h] > 0)
+    {
+    return false;
+    }
+
+  this->Handles.erase(this->Requirements[h]);
+  this->Requirements[h] = this->Requirements[InvalidHandle];
+  this->FreeHandles.push_back(h);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+RequirementsHandle RequirementsRegistry::find(
+                                const remus::proto::JobRequirements& reqs) const
+{
+  typedef std::map<remus::proto::JobRequirements,
+                   RequirementsHandle>::const_iterator cit;
+  cit i = this->Handles.find(reqs);
+  return (i != this->Handles.end()) ? i->second : InvalidHandle;
+}
+
+//------------------------------------------------------------------------------
+const remus::proto::JobRequirements& RequirementsRegistry::requirements(
+                                RequirementsHandle h) const
+{
+  return (h < this->Requirements.size()) ? this->Requirements[h] :
+                                           this->Requirements[InvalidHandle];
+}
+
+}
+}
+} //namespace remus::server::detail
@@ -0,0 +1,91 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_RequirementsRegistry_h
+#define remus_server_detail_RequirementsRegistry_h
+
+#include <remus/proto/JobRequirements.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <map>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//A small integer that stands in for a JobRequirements inside the server.
+//Two requirements that compare equal always map to the same handle, so
+//matching jobs to workers is an integer compare instead of comparing the
+//mesh types, names and tags of each requirement.
+typedef boost::uint32_t RequirementsHandle;
+
+//Hash consed registry of the distinct JobRequirements of the jobs and
+//workers the server holds. Requirements are interned when they arrive from
+//a client or worker, and the handle is what the job queue and worker pool
+//carry around. Handles are reference counted, each queued job and each
+//worker registration holds one, and the requirements are dropped when the
+//last reference is released so that requirements that clients and workers
+//make up don't grow the server without bound. Released handles are handed
+//out again for other requirements, and are only meaningful inside the
+//server that handed them out.
+class RequirementsRegistry
+{
+public:
+  static const RequirementsHandle InvalidHandle = 0;
+
+  RequirementsRegistry();
+
+  //returns the handle for the requirements and adds a reference to it,
+  //adding the requirements to the registry when they aren't held
+  RequirementsHandle intern(const remus::proto::JobRequirements& reqs);
+
+  //adds a reference to a handle that is already held
+  void retain(RequirementsHandle h);
+
+  //drops a reference to the handle. Returns true when it was the last
+  //reference, and the requirements have been removed from the registry
+  bool release(RequirementsHandle h);
+
+  //returns the handle for the requirements, or InvalidHandle when they
+  //haven't been interned
+  RequirementsHandle find(const remus::proto::JobRequirements& reqs) const;
+
+  //returns the requirements of the handle. Returns invalid requirements
+  //for a handle that this registry didn't hand out.
+  const remus::proto::JobRequirements& requirements(RequirementsHandle h) const;
+
+  //number of distinct requirements held
+  std::size_t size() const { return this->Handles.size(); }
+
+private:
+  std::map<remus::proto::JobRequirements, RequirementsHandle> Handles;
+
+  //indexed by handle, slot zero holds the invalid requirements. Released
+  //slots hold invalid requirements until they are handed out again
+  std::vector<remus::proto::JobRequirements> Requirements;
+  std::vector<std::size_t> References;
+  std::vector<RequirementsHandle> FreeHandles;
+
+  //make copying not possible
+  RequirementsRegistry (const RequirementsRegistry&);
+  void operator = (const RequirementsRegistry&);
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,100 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/SharedWorkerFactory.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/thread/locks.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+SharedWorkerFactory::SharedWorkerFactory(
+            const boost::shared_ptr<remus::server::WorkerFactoryBase>& factory):
+  remus::server::WorkerFactoryBase(),
+  Factory(factory),
+  Mutex()
+{
+}
+
+//------------------------------------------------------------------------------
+remus::common::MeshIOTypeSet SharedWorkerFactory::supportedIOTypes() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Factory->supportedIOTypes();
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobRequirementsSet SharedWorkerFactory::workerRequirements(
+                                        remus::common::MeshIOType type) const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Factory->workerRequirements(type);
+}
+
+//------------------------------------------------------------------------------
+bool SharedWorkerFactory::haveSupport(
+                              const remus::proto::JobRequirements& reqs) const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Factory->haveSupport(reqs);
+}
+
+//------------------------------------------------------------------------------
+bool SharedWorkerFactory::createWorker(const remus::proto::JobRequirements& type,
+                        WorkerFactoryBase::FactoryDeletionBehavior lifespan)
+{
+  //the shards can't check for space before asking for a worker, as another
+  //shard could take the space in between. So the check and the creation
+  //happen under the same lock
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  if(this->Factory->currentWorkerCount() >= this->Factory->maxWorkerCount())
+    {
+    return false;
+    }
+  return this->Factory->createWorker(type,lifespan);
+}
+
+//------------------------------------------------------------------------------
+void SharedWorkerFactory::updateWorkerCount()
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  this->Factory->updateWorkerCount();
+}
+
+//------------------------------------------------------------------------------
+void SharedWorkerFactory::setMaxWorkerCount(unsigned int count)
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  this->Factory->setMaxWorkerCount(count);
+}
+
+//------------------------------------------------------------------------------
+unsigned int SharedWorkerFactory::maxWorkerCount() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Factory->maxWorkerCount();
+}
+
+//------------------------------------------------------------------------------
+unsigned int SharedWorkerFactory::currentWorkerCount() const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Factory->currentWorkerCount();
+}
+
+}
+}
+}
@@ -0,0 +1,72 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_SharedWorkerFactory_h
+#define remus_server_detail_SharedWorkerFactory_h
+
+#include <remus/server/WorkerFactoryBase.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Allows a single worker factory to be used by the shards of a server, which
+//each broker on their own thread. Every call is forwarded to the wrapped
+//factory while holding a lock, so the factory only ever sees one caller at
+//a time and the maximum worker count stays a limit for the whole server.
+//createWorker checks for space and creates the worker under a single lock,
+//so callers must rely on its return value instead of checking
+//currentWorkerCount first.
+//
+//The workers are launched with the endpoint of the wrapped factory, so
+//portForWorkersToUse needs to be called on the wrapped factory.
+class SharedWorkerFactory : public remus::server::WorkerFactoryBase
+{
+public:
+  explicit SharedWorkerFactory(
+            const boost::shared_ptr<remus::server::WorkerFactoryBase>& factory);
+
+  remus::common::MeshIOTypeSet supportedIOTypes() const;
+
+  remus::proto::JobRequirementsSet workerRequirements(
+                                      remus::common::MeshIOType type) const;
+
+  bool haveSupport(const remus::proto::JobRequirements& reqs) const;
+
+  bool createWorker(const remus::proto::JobRequirements& type,
+                    WorkerFactoryBase::FactoryDeletionBehavior lifespan);
+
+  void updateWorkerCount();
+
+  void setMaxWorkerCount(unsigned int count);
+  unsigned int maxWorkerCount() const;
+  unsigned int currentWorkerCount() const;
+
+private:
+  //explicitly state the factory doesn't support copy or move semantics
+  SharedWorkerFactory(const SharedWorkerFactory&);
+  void operator=(const SharedWorkerFactory&);
+
+  boost::shared_ptr<remus::server::WorkerFactoryBase> Factory;
+  mutable boost::mutex Mutex;
+};
+
+}
+}
+}
+
+#endif
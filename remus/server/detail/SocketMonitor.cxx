@@ -12,11 +12,13 @@
 
 #include <remus/server/detail/SocketMonitor.h>
 
-REMUS_THIRDPARTY_PRE_INCLUDE
-#include <boost/date_time/posix_time/posix_time.hpp>
-REMUS_THIRDPARTY_POST_INCLUDE
+#include <remus/common/MonotonicClock.h>
 
 #include <algorithm>
+#include <functional>
+#include <map>
+#include <queue>
+#include <vector>
 
 namespace remus{
 namespace server{
@@ -25,16 +27,51 @@ namespace detail{
 //------------------------------------------------------------------------------
 class SocketMonitor::WorkerTracker
 {
-  typedef boost::posix_time::ptime ptime;
+  typedef remus::common::MonotonicClock MonotonicClock;
+  typedef MonotonicClock::TimePoint TimePoint;
 
   struct BeatInfo
     {
-    BeatInfo(): Duration(), LastOccurrence()
+    BeatInfo(): Duration(), LastOccurrence(), Ticket(0), ScheduledFor(),
+      MissedDeadline(false)
     {
     }
 
+    TimePoint deadline() const
+      {
+      return this->LastOccurrence + MonotonicClock::milliseconds(this->Duration*2);
+      }
+
     boost::int64_t Duration;
-    ptime LastOccurrence;
+    TimePoint LastOccurrence;
+
+    //the ticket of the entry for this socket in the deadline heap, zero
+    //when the socket doesn't have an entry
+    boost::uint64_t Ticket;
+    TimePoint ScheduledFor;
+
+    //has been reported as missing its deadline
+    bool MissedDeadline;
+    };
+
+  //An entry in the min heap of heartbeat deadlines. Each socket has at most
+  //one entry, identified by its ticket. A heartbeat doesn't touch the heap,
+  //so when an entry reaches the top with a deadline that has since moved,
+  //it is pushed again with the new deadline.
+  struct Deadline
+    {
+    Deadline(const TimePoint& when, const zmq::SocketIdentity& socket,
+             boost::uint64_t ticket):
+      When(when), Socket(socket), Ticket(ticket)
+    {
+    }
+
+    bool operator>(const Deadline& other) const
+      { return this->When > other.When; }
+
+    TimePoint When;
+    zmq::SocketIdentity Socket;
+    boost::uint64_t Ticket;
     };
 
 public:
@@ -45,8 +82,19 @@ public:
   typedef std::pair< zmq::SocketIdentity, BeatInfo > InsertType;
   typedef std::map< zmq::SocketIdentity, BeatInfo >::iterator IteratorType;
 
+  std::priority_queue< Deadline, std::vector<Deadline>,
+                       std::greater<Deadline> > Deadlines;
+  boost::uint64_t NextTicket;
+
+  //sockets whose state changed since the last call to changedSockets
+  std::set< zmq::SocketIdentity > Changed;
+
   WorkerTracker( remus::common::PollingMonitor p):
-    PollMonitor(p)
+    PollMonitor(p),
+    HeartBeats(),
+    Deadlines(),
+    NextTicket(1),
+    Changed()
   {}
 
   //----------------------------------------------------------------------------
@@ -66,7 +114,7 @@ public:
     IteratorType iter = (this->HeartBeats.insert(key_value)).first;
     BeatInfo& beat = iter->second;
 
-    beat.LastOccurrence = boost::posix_time::microsec_clock::local_time();
+    beat.LastOccurrence = MonotonicClock::now();
 
     //look at our current max time out and the and the current duration that
     //we last polled the worker at. Take the slower of the two.
@@ -78,6 +126,7 @@ public:
     //decoding a message that is really large we don't want to mark it as
     //expired, so we always use our max time out
     beat.Duration = std::max( beat.Duration, PollMonitor.maxTimeOut() );
+    this->beatOccurred(iter);
   }
 
   //----------------------------------------------------------------------------
@@ -89,11 +138,12 @@ public:
     IteratorType iter = (this->HeartBeats.insert(key_value)).first;
     BeatInfo& beat = iter->second;
 
-    beat.LastOccurrence = boost::posix_time::microsec_clock::local_time();
+    beat.LastOccurrence = MonotonicClock::now();
 
     //Now we choose the greatest value between the poller and the sent in duration
     //from the socket.
     beat.Duration = std::max( dur, PollMonitor.maxTimeOut() );
+    this->beatOccurred(iter);
   }
 
   //----------------------------------------------------------------------------
@@ -114,7 +164,11 @@ public:
   //----------------------------------------------------------------------------
   void markAsDead( const zmq::SocketIdentity& socket )
   {
-    this->HeartBeats.erase(socket);
+    //the entry in the deadline heap is dropped when it reaches the top
+    if(this->HeartBeats.erase(socket) > 0)
+      {
+      this->Changed.insert(socket);
+      }
   }
 
   //----------------------------------------------------------------------------
@@ -129,15 +183,107 @@ public:
         }
 
       const BeatInfo& beat = this->HeartBeats.find(socket)->second;
-      const ptime current = boost::posix_time::microsec_clock::local_time();
-      const ptime expectedHB = beat.LastOccurrence +
-                               boost::posix_time::milliseconds(beat.Duration*2);
-      return current > expectedHB;
+      const TimePoint current = MonotonicClock::now();
+      return current > beat.deadline();
       }
 
     //the socket isn't contained here, this socket is dead dead
     return true;
   }
+
+  //----------------------------------------------------------------------------
+  std::set< zmq::SocketIdentity > changedSockets()
+  {
+    //polling has been abnormal give every socket a pass, the deadlines
+    //stay in the heap until polling is normal again
+    if(!PollMonitor.hasAbnormalEvent())
+      {
+      const TimePoint current = MonotonicClock::now();
+      while(!this->Deadlines.empty() && current > this->Deadlines.top().When)
+        {
+        const Deadline top = this->Deadlines.top();
+        this->Deadlines.pop();
+
+        IteratorType iter = this->HeartBeats.find(top.Socket);
+        if(iter == this->HeartBeats.end() || iter->second.Ticket != top.Ticket)
+          {
+          //the socket is dead, or this entry has been replaced
+          continue;
+          }
+
+        BeatInfo& beat = iter->second;
+        if(current > beat.deadline())
+          {
+          //the socket missed its heartbeat, it gets a new entry once it
+          //heartbeats again
+          beat.Ticket = 0;
+          beat.MissedDeadline = true;
+          this->Changed.insert(top.Socket);
+          }
+        else
+          {
+          this->schedule(iter);
+          }
+        }
+      }
+
+    std::set< zmq::SocketIdentity > result;
+    result.swap(this->Changed);
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+  boost::int64_t timeUntilNextDeadline() const
+  {
+    const boost::int64_t maxTimeOut = PollMonitor.maxTimeOut();
+    if(!this->Changed.empty())
+      {
+      return boost::int64_t(0);
+      }
+    else if(this->Deadlines.empty() || PollMonitor.hasAbnormalEvent())
+      {
+      //while polling is abnormal the deadlines are ignored, so we don't want
+      //to wake up for ones that have already passed
+      return maxTimeOut;
+      }
+
+    //changedSockets only reports deadlines that have been passed, so we
+    //round up to the first millisecond after the deadline
+    const TimePoint untilDeadline = this->Deadlines.top().When - MonotonicClock::now();
+    if(untilDeadline < 0)
+      {
+      return boost::int64_t(0);
+      }
+    return std::min(MonotonicClock::toMilliseconds(untilDeadline) + 1, maxTimeOut);
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  void beatOccurred(IteratorType iter)
+  {
+    BeatInfo& beat = iter->second;
+    if(beat.MissedDeadline)
+      {
+      //the socket is responsive again
+      beat.MissedDeadline = false;
+      this->Changed.insert(iter->first);
+      }
+    //a deadline that moved later is fixed up when the entry reaches the top
+    //of the heap, but one that moved earlier needs a new entry
+    if(beat.Ticket == 0 || beat.deadline() < beat.ScheduledFor)
+      {
+      this->schedule(iter);
+      }
+  }
+
+  //----------------------------------------------------------------------------
+  void schedule(IteratorType iter)
+  {
+    BeatInfo& beat = iter->second;
+    beat.Ticket = this->NextTicket++;
+    beat.ScheduledFor = beat.deadline();
+    this->Deadlines.push( Deadline(beat.ScheduledFor, iter->first, beat.Ticket) );
+  }
 };
 
 //------------------------------------------------------------------------------
@@ -220,6 +366,18 @@ bool SocketMonitor::isUnresponsive( const zmq::SocketIdentity& socket ) const
   return this->Tracker->isMostlyDead(socket);
 }
 
+//------------------------------------------------------------------------------
+std::set<zmq::SocketIdentity> SocketMonitor::changedSockets()
+{
+  return this->Tracker->changedSockets();
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t SocketMonitor::timeUntilNextDeadline() const
+{
+  return this->Tracker->timeUntilNextDeadline();
+}
+
 }
 }
 }
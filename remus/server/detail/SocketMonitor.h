@@ -24,6 +24,8 @@ REMUS_THIRDPARTY_POST_INCLUDE
 
 #include <remus/common/PollingMonitor.h>
 
+#include <set>
+
 namespace remus{
 namespace server{
 namespace detail{
@@ -71,6 +73,19 @@ public:
   //and we should expect sockets to come back.
   bool isUnresponsive( const zmq::SocketIdentity& socket ) const;
 
+  //returns the sockets whose state may have changed since the last call.
+  //Those are sockets that missed their heartbeat deadline, sockets that
+  //heartbeat again after missing one, and sockets marked as dead. Deadlines
+  //are kept in a min heap, so the cost of this call depends on the number
+  //of deadlines that passed, not on the number of sockets being monitored.
+  std::set<zmq::SocketIdentity> changedSockets();
+
+  //returns how many milliseconds until changedSockets can report a socket,
+  //which is zero when a socket has already changed. The brokering loop uses
+  //this to sleep until the next heartbeat deadline. Never returns more than
+  //the max time out of the polling monitor.
+  boost::int64_t timeUntilNextDeadline() const;
+
 private:
   class WorkerTracker;
   boost::shared_ptr<WorkerTracker> Tracker;
@@ -0,0 +1,229 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/WorkerAffinity.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+namespace
+{
+typedef std::pair<std::size_t, zmq::SocketIdentity> ScoredWorker;
+
+//------------------------------------------------------------------------------
+bool more_SharedKeys(const ScoredWorker& a, const ScoredWorker& b)
+{
+  return a.first > b.first;
+}
+}
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+WorkerAffinity::WorkerAffinity(std::size_t keysPerWorker):
+  KeysPerWorker(keysPerWorker),
+  MaxWait(0),
+  Recent(),
+  Holders(),
+  Deferred()
+{
+}
+
+//------------------------------------------------------------------------------
+std::vector<std::string> WorkerAffinity::keys(const QueuedJob& job)
+{
+  //the tag is prefixed so that it can never be mistaken for a hash
+  std::vector<std::string> result;
+  const std::vector<std::string>& hashes = job.blobHashes();
+  for(std::size_t i=0; i < hashes.size(); ++i)
+    {
+    if(!hashes[i].empty())
+      {
+      result.push_back(hashes[i]);
+      }
+    }
+  if(!job.requirements().tag().empty())
+    {
+    result.push_back("tag:" + job.requirements().tag());
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+void WorkerAffinity::jobAssigned(const zmq::SocketIdentity& worker,
+                                 const QueuedJob& job)
+{
+  this->forgetJob(job.id());
+
+  const std::vector<std::string> jobKeys = WorkerAffinity::keys(job);
+  if(jobKeys.empty() || this->KeysPerWorker == 0)
+    {
+    return;
+    }
+
+  KeyList& recent = this->Recent[worker];
+  typedef std::vector<std::string>::const_iterator It;
+  for(It key = jobKeys.begin(); key != jobKeys.end(); ++key)
+    {
+    //a key we already have moves to the front
+    KeyList::iterator existing = std::find(recent.begin(), recent.end(), *key);
+    if(existing != recent.end())
+      {
+      recent.erase(existing);
+      }
+    recent.push_front(*key);
+    this->Holders[*key].insert(worker);
+    }
+
+  //drop the oldest keys
+  while(recent.size() > this->KeysPerWorker)
+    {
+    HolderMap::iterator holders = this->Holders.find(recent.back());
+    holders->second.erase(worker);
+    if(holders->second.empty())
+      {
+      this->Holders.erase(holders);
+      }
+    recent.pop_back();
+    }
+}
+
+//------------------------------------------------------------------------------
+std::vector<zmq::SocketIdentity> WorkerAffinity::workersFor(
+                                                  const QueuedJob& job) const
+{
+  //count how many keys of the job each worker holds
+  std::map<zmq::SocketIdentity, std::size_t> shared;
+  const std::vector<std::string> jobKeys = WorkerAffinity::keys(job);
+  typedef std::vector<std::string>::const_iterator It;
+  for(It key = jobKeys.begin(); key != jobKeys.end(); ++key)
+    {
+    HolderMap::const_iterator holders = this->Holders.find(*key);
+    if(holders != this->Holders.end())
+      {
+      typedef std::set<zmq::SocketIdentity>::const_iterator WorkerIt;
+      for(WorkerIt w = holders->second.begin(); w != holders->second.end(); ++w)
+        {
+        ++shared[*w];
+        }
+      }
+    }
+
+  //order by the number of shared keys, most first
+  std::vector<ScoredWorker> scored;
+  typedef std::map<zmq::SocketIdentity, std::size_t>::const_iterator SharedIt;
+  for(SharedIt i = shared.begin(); i != shared.end(); ++i)
+    {
+    scored.push_back(std::make_pair(i->second, i->first));
+    }
+  std::stable_sort(scored.begin(), scored.end(), more_SharedKeys);
+
+  std::vector<zmq::SocketIdentity> result;
+  result.reserve(scored.size());
+  for(std::size_t i=0; i < scored.size(); ++i)
+    {
+    result.push_back(scored[i].second);
+    }
+  return result;
+}
+
+//------------------------------------------------------------------------------
+bool WorkerAffinity::deferJob(const QueuedJob& job, TimePoint now)
+{
+  if(this->MaxWait <= 0)
+    {
+    return false;
+    }
+
+  DeferredMap::iterator deferred = this->Deferred.find(job.id());
+  if(deferred == this->Deferred.end())
+    {
+    DeferredJob waiting;
+    waiting.Deadline = now + remus::common::MonotonicClock::milliseconds(this->MaxWait);
+    waiting.Handle = job.handle();
+    waiting.Expired = false;
+    this->Deferred.insert(DeferredMap::value_type(job.id(), waiting));
+    return true;
+    }
+  return deferred->second.Deadline > now;
+}
+
+//------------------------------------------------------------------------------
+void WorkerAffinity::forgetJob(const boost::uuids::uuid& id)
+{
+  this->Deferred.erase(id);
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t WorkerAffinity::timeUntilNextDeadline(TimePoint now) const
+{
+  boost::int64_t timeout = std::numeric_limits<boost::int64_t>::max();
+  for(DeferredMap::const_iterator i = this->Deferred.begin();
+      i != this->Deferred.end(); ++i)
+    {
+    if(!i->second.Expired)
+      {
+      //round up so that we wake up after the deadline
+      const TimePoint until = i->second.Deadline - now;
+      const boost::int64_t millisec = until <= 0 ? 0 :
+                    remus::common::MonotonicClock::toMilliseconds(until) + 1;
+      timeout = std::min(timeout, millisec);
+      }
+    }
+  return timeout;
+}
+
+//------------------------------------------------------------------------------
+void WorkerAffinity::takeExpiredHandles(TimePoint now,
+                                        std::set<RequirementsHandle>& handles)
+{
+  //the expired jobs are kept until they are assigned, so that they aren't
+  //deferred again
+  for(DeferredMap::iterator i = this->Deferred.begin();
+      i != this->Deferred.end(); ++i)
+    {
+    if(!i->second.Expired && i->second.Deadline <= now)
+      {
+      i->second.Expired = true;
+      handles.insert(i->second.Handle);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void WorkerAffinity::remove(const zmq::SocketIdentity& worker)
+{
+  RecentMap::iterator recent = this->Recent.find(worker);
+  if(recent == this->Recent.end())
+    {
+    return;
+    }
+
+  for(KeyList::const_iterator key = recent->second.begin();
+      key != recent->second.end(); ++key)
+    {
+    HolderMap::iterator holders = this->Holders.find(*key);
+    holders->second.erase(worker);
+    if(holders->second.empty())
+      {
+      this->Holders.erase(holders);
+      }
+    }
+  this->Recent.erase(recent);
+}
+
+}
+}
+}
@@ -0,0 +1,114 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_WorkerAffinity_h
+#define remus_server_detail_WorkerAffinity_h
+
+#include <remus/common/MonotonicClock.h>
+#include <remus/proto/zmqSocketIdentity.h>
+#include <remus/server/detail/JobQueue.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/uuid/uuid.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Tracks which jobs each worker has recently been sent, so that a job can be
+//sent to a worker that has already loaded its data. The affinity of a job is
+//the content hashes of its blobs and the tag of its requirements, and we
+//remember the most recent keysPerWorker of those for each worker.
+//
+//When none of the workers a job has affinity with are waiting for work, the
+//job can wait for maxWait milliseconds for one of them to ask for a job,
+//before it is sent to any worker. By default jobs don't wait.
+class WorkerAffinity
+{
+public:
+  typedef remus::common::MonotonicClock::TimePoint TimePoint;
+
+  explicit WorkerAffinity(std::size_t keysPerWorker = 32);
+
+  //how long in milliseconds a job waits for a worker it has affinity with
+  void maxWait(boost::int64_t millisec) { this->MaxWait = millisec; }
+  boost::int64_t maxWait() const { return this->MaxWait; }
+
+  //remember that the worker has been sent the job
+  void jobAssigned(const zmq::SocketIdentity& worker, const QueuedJob& job);
+
+  //the workers that have recently been sent jobs with the same data as the
+  //job, ordered from the most to the least keys shared with the job
+  std::vector<zmq::SocketIdentity> workersFor(const QueuedJob& job) const;
+
+  //returns true when the job should keep waiting for a worker it has
+  //affinity with. The wait of the job starts the first time it is deferred
+  bool deferJob(const QueuedJob& job, TimePoint now);
+
+  //the job has been sent to a worker or removed from the queue, so it is
+  //no longer waiting
+  void forgetJob(const boost::uuids::uuid& id);
+
+  //returns true when jobs are waiting for a worker they have affinity with
+  bool hasDeferredJobs() const { return !this->Deferred.empty(); }
+
+  //milliseconds until the wait of a deferred job runs out, or the largest
+  //value when no job is waiting
+  boost::int64_t timeUntilNextDeadline(TimePoint now) const;
+
+  //adds the requirements of the jobs whose wait ran out since the last
+  //call, so that they are scheduled on any worker
+  void takeExpiredHandles(TimePoint now, std::set<RequirementsHandle>& handles);
+
+  //forget about a worker, used once a worker is dead
+  void remove(const zmq::SocketIdentity& worker);
+
+  //the keys that make up the affinity of a job
+  static std::vector<std::string> keys(const QueuedJob& job);
+
+private:
+  //the most recent keys of a worker, most recent first
+  typedef std::deque<std::string> KeyList;
+  typedef boost::unordered_map<zmq::SocketIdentity, KeyList> RecentMap;
+
+  //the workers that hold a key
+  typedef boost::unordered_map<std::string,
+                               std::set<zmq::SocketIdentity> > HolderMap;
+
+  struct DeferredJob
+  {
+    TimePoint Deadline;
+    RequirementsHandle Handle;
+    bool Expired;
+  };
+  typedef boost::unordered_map<boost::uuids::uuid, DeferredJob> DeferredMap;
+
+  std::size_t KeysPerWorker;
+  boost::int64_t MaxWait;
+  RecentMap Recent;
+  HolderMap Holders;
+  DeferredMap Deferred;
+};
+
+}
+}
+}
+
+#endif
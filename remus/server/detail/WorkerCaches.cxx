@@ -0,0 +1,54 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/WorkerCaches.h>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//------------------------------------------------------------------------------
+WorkerCaches::WorkerCaches():
+  Caches()
+{
+}
+
+//------------------------------------------------------------------------------
+void WorkerCaches::update(const zmq::SocketIdentity& worker,
+                          const HashSet& hashes)
+{
+  this->Caches[worker] = hashes;
+}
+
+//------------------------------------------------------------------------------
+bool WorkerCaches::hasCache(const zmq::SocketIdentity& worker) const
+{
+  return this->Caches.find(worker) != this->Caches.end();
+}
+
+//------------------------------------------------------------------------------
+bool WorkerCaches::holds(const zmq::SocketIdentity& worker,
+                         const std::string& hash) const
+{
+  CacheMap::const_iterator cache = this->Caches.find(worker);
+  return cache != this->Caches.end() && cache->second.count(hash) > 0;
+}
+
+//------------------------------------------------------------------------------
+void WorkerCaches::remove(const zmq::SocketIdentity& worker)
+{
+  this->Caches.erase(worker);
+}
+
+}
+}
+}
@@ -0,0 +1,67 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_server_detail_WorkerCaches_h
+#define remus_server_detail_WorkerCaches_h
+
+#include <remus/proto/zmqSocketIdentity.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <string>
+
+namespace remus{
+namespace server{
+namespace detail{
+
+//Tracks the blobs that each worker holds in its local blob cache, so that
+//jobs sent to a worker only reference the blobs it already has instead of
+//sending them again.
+//
+//Workers advertise the full set of hashes they hold every time it changes,
+//so we replace what we know about a worker instead of merging. Workers that
+//have never advertised don't cache blobs, and are sent every blob.
+class WorkerCaches
+{
+public:
+  typedef boost::unordered_set<std::string> HashSet;
+
+  WorkerCaches();
+
+  //replace the hashes the worker holds
+  void update(const zmq::SocketIdentity& worker, const HashSet& hashes);
+
+  //returns true when the worker has advertised a cache
+  bool hasCache(const zmq::SocketIdentity& worker) const;
+
+  //returns true when the worker holds a blob with the given hash
+  bool holds(const zmq::SocketIdentity& worker, const std::string& hash) const;
+
+  //forget about the cache of a worker, used once a worker is dead
+  void remove(const zmq::SocketIdentity& worker);
+
+  //number of workers that have advertised a cache
+  std::size_t size() const { return this->Caches.size(); }
+
+private:
+  typedef boost::unordered_map<zmq::SocketIdentity, HashSet> CacheMap;
+  CacheMap Caches;
+};
+
+}
+}
+}
+
+#endif
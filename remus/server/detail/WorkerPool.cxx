@@ -15,25 +15,40 @@
 #include <remus/server/detail/uuidHelper.h>
 #include <remus/proto/zmqSocketIdentity.h>
 
-#include <algorithm>
+#include <vector>
 
 namespace remus{
 namespace server{
 namespace detail{
 
 //------------------------------------------------------------------------------
-WorkerPool::WorkerInfo::WorkerInfo(const zmq::SocketIdentity& address,
-                                   const remus::proto::JobRequirements& reqs):
+WorkerPool::WorkerInfo::WorkerInfo():
   NumberOfDesiredJobs(0),
-  Reqs(reqs),
-  Address(address),
-  IsResponsive(true)
+  IsResponsive(true),
+  InReadyQueue(false)
 {
 }
 
 //------------------------------------------------------------------------------
 WorkerPool::WorkerPool():
-  Pool()
+  Registry(new RequirementsRegistry()),
+  NextWorkerId(0),
+  Addresses(),
+  Workers(),
+  Ready(),
+  DirtyHandles()
+{
+
+}
+
+//------------------------------------------------------------------------------
+WorkerPool::WorkerPool(const boost::shared_ptr<RequirementsRegistry>& registry):
+  Registry(registry),
+  NextWorkerId(0),
+  Addresses(),
+  Workers(),
+  Ready(),
+  DirtyHandles()
 {
 
 }
@@ -42,9 +57,32 @@ WorkerPool::WorkerPool():
 bool WorkerPool::addWorker(zmq::SocketIdentity workerIdentity,
                            const remus::proto::JobRequirements& reqs)
 {
-  if(!this->haveWorker(workerIdentity,reqs))
+  //the worker takes its own reference, so drop the one intern gave us
+  const RequirementsHandle handle = this->Registry->intern(reqs);
+  const bool added = this->addWorker(workerIdentity, handle);
+  this->Registry->release(handle);
+  return added;
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::addWorker(zmq::SocketIdentity workerIdentity,
+                           RequirementsHandle handle)
+{
+  AddressMap::const_iterator address = this->Addresses.find(workerIdentity);
+  if(address == this->Addresses.end())
     {
-    this->Pool.push_back( WorkerPool::WorkerInfo(workerIdentity,reqs) );
+    const WorkerId id = this->NextWorkerId++;
+    address = this->Addresses.insert(
+                          std::make_pair(workerIdentity, id)).first;
+    this->Workers.insert( std::make_pair(id, Worker(id, workerIdentity)) );
+    }
+
+  //registering the same requirements again doesn't change the worker.
+  //Each requirements a worker registers with holds a reference to its handle
+  Worker& worker = this->Workers.find(address->second)->second;
+  if(worker.Reqs.insert( std::make_pair(handle, WorkerInfo()) ).second)
+    {
+    this->Registry->retain(handle);
     }
   return true;
 }
@@ -53,10 +91,18 @@ bool WorkerPool::addWorker(zmq::SocketIdentity workerIdentity,
 remus::common::MeshIOTypeSet WorkerPool::supportedIOTypes() const
 {
   remus::common::MeshIOTypeSet validIOTypes;
-  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  typedef std::map<RequirementsHandle, WorkerInfo>::const_iterator InfoIt;
+  for(WorkerMap::const_iterator i=this->Workers.begin();
+      i != this->Workers.end(); ++i)
     {
-    if( i->IsResponsive )
-      { validIOTypes.insert(i->Reqs.meshTypes()); }
+    const Worker& worker = i->second;
+    for(InfoIt j=worker.Reqs.begin(); j != worker.Reqs.end(); ++j)
+      {
+      if( j->second.IsResponsive )
+        {
+        validIOTypes.insert(this->Registry->requirements(j->first).meshTypes());
+        }
+      }
     }
   return validIOTypes;
 }
@@ -66,10 +112,15 @@ remus::proto::JobRequirementsSet WorkerPool::waitingWorkerRequirements(
                                          remus::common::MeshIOType type) const
 {
   remus::proto::JobRequirementsSet validWorkers;
-  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  for(ReadyMap::const_iterator i=this->Ready.begin(); i != this->Ready.end(); ++i)
     {
-    if( i->Reqs.meshTypes() == type && i->isWaitingForWork() )
-      { validWorkers.insert(i->Reqs); }
+    if( i->second.NumberWaiting > 0 )
+      {
+      const remus::proto::JobRequirements& reqs =
+                                    this->Registry->requirements(i->first);
+      if( reqs.meshTypes() == type )
+        { validWorkers.insert(reqs); }
+      }
     }
   return validWorkers;
 }
@@ -78,118 +129,273 @@ remus::proto::JobRequirementsSet WorkerPool::waitingWorkerRequirements(
 bool WorkerPool::haveWaitingWorker(
                            const remus::proto::JobRequirements& reqs) const
 {
-  bool found = false;
-  for(ConstIt i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
-    {
-    found = ( i->Reqs == reqs && i->isWaitingForWork() );
-    }
-  return found;
+  return this->haveWaitingWorker(this->Registry->find(reqs));
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::haveWaitingWorker(RequirementsHandle handle) const
+{
+  ReadyMap::const_iterator ready = this->Ready.find(handle);
+  return ready != this->Ready.end() && ready->second.NumberWaiting > 0;
 }
 
 //------------------------------------------------------------------------------
 bool WorkerPool::haveWorker(const zmq::SocketIdentity& address,
                             const remus::proto::JobRequirements& reqs) const
 {
-  bool found = false;
-  for(ConstIt i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
+  return this->haveWorker(address, this->Registry->find(reqs));
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::haveWorker(const zmq::SocketIdentity& address,
+                            RequirementsHandle handle) const
+{
+  AddressMap::const_iterator id = this->Addresses.find(address);
+  if(id == this->Addresses.end())
     {
-    found = ( i->Address == address && i->Reqs == reqs );
+    return false;
     }
-  return found;
+  const Worker& worker = this->Workers.find(id->second)->second;
+  return worker.Reqs.count(handle) > 0;
 }
 
 //------------------------------------------------------------------------------
 bool WorkerPool::readyForWork(const zmq::SocketIdentity& address,
                               const remus::proto::JobRequirements& reqs)
 {
-  //a worker can be registered multiple times, we need to iterate
-  //over the entire vector and find the correct address and reqs that match
-  //transform every element that matches the address and reqs to be
-  //waiting for work, If the worker is already waiting for work we increase
-  //the number of jobs it is waiting to take.
-  int count = 0;
-   for(It i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  return this->readyForWork(address, this->Registry->find(reqs));
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::readyForWork(const zmq::SocketIdentity& address,
+                              RequirementsHandle handle)
+{
+  //If the worker is already waiting for work we increase the number of jobs
+  //it is waiting to take.
+  AddressMap::const_iterator id = this->Addresses.find(address);
+  if(id == this->Addresses.end())
     {
-    if(i->Address == address && i->Reqs == reqs)
-      {
-      i->IsResponsive = true; //mark the worker as responsive
-      i->addJob();
-      ++count;
-      }
+    return false;
     }
-  return (count > 0);
-}
 
+  Worker& worker = this->Workers.find(id->second)->second;
+  std::map<RequirementsHandle, WorkerInfo>::iterator info =
+                                                  worker.Reqs.find(handle);
+  if(info == worker.Reqs.end())
+    {
+    return false;
+    }
+
+  //mark the worker as responsive
+  this->update(worker, handle, info->second,
+               info->second.NumberOfDesiredJobs + 1, true);
+  return true;
+}
 
 //------------------------------------------------------------------------------
 zmq::SocketIdentity WorkerPool::takeWorker(
                              const remus::proto::JobRequirements& reqs)
 {
-  bool found = false;
-  It i;
-  for(i=this->Pool.begin(); !found && i != this->Pool.end(); ++i)
-    {
-    found = (i->Reqs == reqs) && (i->isWaitingForWork());
-    }
+  return this->takeWorker(this->Registry->find(reqs));
+}
 
+//------------------------------------------------------------------------------
+zmq::SocketIdentity WorkerPool::takeWorker(RequirementsHandle handle)
+{
   zmq::SocketIdentity workerIdentity;
 
-  if(found)
+  ReadyMap::iterator ready = this->Ready.find(handle);
+  if(ready == this->Ready.end() || ready->second.NumberWaiting == 0)
+    {
+    return workerIdentity;
+    }
+
+  //pop workers until we find one that is still waiting for work. Workers
+  //that stopped waiting, or were purged, were left in the queue
+  std::deque<WorkerId>& queue = ready->second.Workers;
+  while(!queue.empty())
     {
-    --i; //we have to decrement the iterator, as the forloop increments it one
-    //past the found position.
+    const WorkerId id = queue.front();
+    queue.pop_front();
 
-    //take the worker id as it matches the reqs
-    workerIdentity = zmq::SocketIdentity(i->Address);
-    i->takesJob();
+    WorkerMap::iterator w = this->Workers.find(id);
+    if(w == this->Workers.end())
+      {
+      continue;
+      }
 
-    //now that the worker has taken the job, we move him to the back of
-    //the vector so he is the last worker to take a job of that type again,
-    //this allows us to handle multiple workers taking jobs
-    std::rotate(this->Pool.begin(), this->Pool.begin() + 1,this->Pool.end());
+    Worker& worker = w->second;
+    WorkerInfo& info = worker.Reqs.find(handle)->second;
+    info.InReadyQueue = false;
+    if(info.isWaitingForWork())
+      {
+      //take the worker id as it matches the reqs. If the worker wants more
+      //jobs it is moved to the back of the queue, so that it is the last
+      //worker to take a job of that type again
+      workerIdentity = worker.Address;
+      this->update(worker, handle, info,
+                   info.NumberOfDesiredJobs - 1, info.IsResponsive);
+      break;
+      }
     }
 
   return workerIdentity;
 }
 
 //------------------------------------------------------------------------------
-void WorkerPool::purgeDeadWorkers(remus::server::detail::SocketMonitor monitor)
+bool WorkerPool::isWaitingForWork(const zmq::SocketIdentity& address,
+                                  RequirementsHandle handle) const
 {
-  //Remove all workers that we know are really dead
-  WorkerPool::DeadWorkers dead(monitor);
+  AddressMap::const_iterator id = this->Addresses.find(address);
+  if(id == this->Addresses.end())
+    {
+    return false;
+    }
+  const Worker& worker = this->Workers.find(id->second)->second;
+  std::map<RequirementsHandle, WorkerInfo>::const_iterator info =
+                                                  worker.Reqs.find(handle);
+  return info != worker.Reqs.end() && info->second.isWaitingForWork();
+}
 
-  //remove if moves all bad items to end of the vector and returns
-  //an iterator to the new end. Remove if is easiest way to remove from middle
-  It newEnd = std::remove_if(this->Pool.begin(),this->Pool.end(),dead);
+//------------------------------------------------------------------------------
+bool WorkerPool::takeWorker(const zmq::SocketIdentity& address,
+                            RequirementsHandle handle)
+{
+  if(!this->isWaitingForWork(address, handle))
+    {
+    return false;
+    }
+
+  //the worker keeps its place in the ready queue when it wants more jobs,
+  //otherwise it is skipped once it reaches the front
+  Worker& worker = this->Workers.find(this->Addresses.find(address)->second)->second;
+  WorkerInfo& info = worker.Reqs.find(handle)->second;
+  this->update(worker, handle, info,
+               info.NumberOfDesiredJobs - 1, info.IsResponsive);
+  return true;
+}
 
-  for(It i=this->Pool.begin(); i != newEnd; ++i)
+//------------------------------------------------------------------------------
+void WorkerPool::purgeDeadWorkers(remus::server::detail::SocketMonitor monitor)
+{
+  //Remove all workers that we know are really dead, and update the
+  //responsive state of the others.
+  std::vector<WorkerId> deadWorkers;
+  for(WorkerMap::iterator i=this->Workers.begin(); i != this->Workers.end(); ++i)
     {
-    i->IsResponsive = !monitor.isUnresponsive(i->Address);
+    if(this->checkWorker(i->second, monitor))
+      {
+      deadWorkers.push_back(i->first);
+      }
     }
 
   //erase all the dead workers to free up space
-  this->Pool.erase(newEnd,this->Pool.end());
+  for(std::vector<WorkerId>::const_iterator i=deadWorkers.begin();
+      i != deadWorkers.end(); ++i)
+    {
+    this->removeWorker(*i);
+    }
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::purgeDeadWorkers(remus::server::detail::SocketMonitor monitor,
+                                  const std::set<zmq::SocketIdentity>& changed)
+{
+  typedef std::set<zmq::SocketIdentity>::const_iterator cit;
+  for(cit i=changed.begin(); i != changed.end(); ++i)
+    {
+    AddressMap::const_iterator id = this->Addresses.find(*i);
+    if(id != this->Addresses.end() &&
+       this->checkWorker(this->Workers.find(id->second)->second, monitor))
+      {
+      this->removeWorker(id->second);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+bool WorkerPool::checkWorker(Worker& worker,
+                             const remus::server::detail::SocketMonitor& monitor)
+{
+  typedef std::map<RequirementsHandle, WorkerInfo>::iterator InfoIt;
+
+  //Only requirements whose state changes touch the ready queues.
+  const bool dead = monitor.isDead(worker.Address);
+  const bool responsive = !dead && !monitor.isUnresponsive(worker.Address);
+  for(InfoIt j=worker.Reqs.begin(); j != worker.Reqs.end(); ++j)
+    {
+    if(j->second.IsResponsive != responsive)
+      {
+      this->update(worker, j->first, j->second,
+                   j->second.NumberOfDesiredJobs, responsive);
+      }
+    }
+  return dead;
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::removeWorker(WorkerId id)
+{
+  WorkerMap::iterator w = this->Workers.find(id);
+
+  //once no job or worker holds the requirements, the handle can be given
+  //to other requirements, so drop what we know about it. No worker is left
+  //in its ready queue that could still be waiting
+  typedef std::map<RequirementsHandle, WorkerInfo>::const_iterator InfoIt;
+  for(InfoIt i=w->second.Reqs.begin(); i != w->second.Reqs.end(); ++i)
+    {
+    if(this->Registry->release(i->first))
+      {
+      this->Ready.erase(i->first);
+      this->DirtyHandles.erase(i->first);
+      }
+    }
+
+  this->Addresses.erase(w->second.Address);
+  this->Workers.erase(w);
+}
+
+//------------------------------------------------------------------------------
+void WorkerPool::takeDirtyHandles(std::set<RequirementsHandle>& dirty)
+{
+  if(dirty.empty())
+    {
+    dirty.swap(this->DirtyHandles);
+    }
+  else
+    {
+    dirty.insert(this->DirtyHandles.begin(), this->DirtyHandles.end());
+    this->DirtyHandles.clear();
+    }
 }
 
 //------------------------------------------------------------------------------
 std::set<zmq::SocketIdentity> WorkerPool::allWorkers() const
 {
   std::set<zmq::SocketIdentity> workerAddresses;
-  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  for(AddressMap::const_iterator i=this->Addresses.begin();
+      i != this->Addresses.end(); ++i)
     {
-    workerAddresses.insert(i->Address);
+    workerAddresses.insert(i->first);
     }
   return workerAddresses;
 }
 //------------------------------------------------------------------------------
 std::set<zmq::SocketIdentity> WorkerPool::allResponsiveWorkers() const
 {
+  typedef std::map<RequirementsHandle, WorkerInfo>::const_iterator InfoIt;
   std::set<zmq::SocketIdentity> workerAddresses;
-  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  for(WorkerMap::const_iterator i=this->Workers.begin();
+      i != this->Workers.end(); ++i)
     {
-    if(i->IsResponsive)
+    const Worker& worker = i->second;
+    for(InfoIt j=worker.Reqs.begin(); j != worker.Reqs.end(); ++j)
       {
-      workerAddresses.insert(i->Address);
+      if(j->second.IsResponsive)
+        {
+        workerAddresses.insert(worker.Address);
+        break;
+        }
       }
     }
   return workerAddresses;
@@ -199,19 +405,60 @@ std::set<zmq::SocketIdentity> WorkerPool::allResponsiveWorkers() const
 //------------------------------------------------------------------------------
 std::set<zmq::SocketIdentity> WorkerPool::allWorkersWantingWork() const
 {
+  typedef std::map<RequirementsHandle, WorkerInfo>::const_iterator InfoIt;
   std::set<zmq::SocketIdentity> workerAddresses;
-  for(ConstIt i=this->Pool.begin(); i != this->Pool.end(); ++i)
+  for(WorkerMap::const_iterator i=this->Workers.begin();
+      i != this->Workers.end(); ++i)
     {
-    if(i->isWaitingForWork())
+    const Worker& worker = i->second;
+    for(InfoIt j=worker.Reqs.begin(); j != worker.Reqs.end(); ++j)
       {
-      workerAddresses.insert(i->Address);
+      if(j->second.isWaitingForWork())
+        {
+        workerAddresses.insert(worker.Address);
+        break;
+        }
       }
     }
   return workerAddresses;
 }
 
+//------------------------------------------------------------------------------
+void WorkerPool::update(Worker& worker, RequirementsHandle handle,
+                        WorkerInfo& info, int desiredJobs, bool responsive)
+{
+  const bool wasWaiting = info.isWaitingForWork();
+  info.NumberOfDesiredJobs = desiredJobs;
+  info.IsResponsive = responsive;
+  const bool isWaiting = info.isWaitingForWork();
+
+  if(wasWaiting == isWaiting && !isWaiting)
+    {
+    return;
+    }
+
+  ReadyQueue& ready = this->Ready[handle];
+  if(wasWaiting != isWaiting)
+    {
+    if(isWaiting) { ++ready.NumberWaiting; }
+    else          { --ready.NumberWaiting; }
+    }
 
+  //only a type that had no waiting workers can have jobs that haven't been
+  //matched to a worker
+  if(isWaiting && ready.NumberWaiting == 1 && !wasWaiting)
+    {
+    this->DirtyHandles.insert(handle);
+    }
 
+  //a worker that is waiting is always in the queue, but a worker that stops
+  //waiting is left in the queue until it reaches the front
+  if(isWaiting && !info.InReadyQueue)
+    {
+    ready.Workers.push_back(worker.Id);
+    info.InReadyQueue = true;
+    }
+}
 
 }
 }
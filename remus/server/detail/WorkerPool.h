@@ -16,22 +16,42 @@
 #include <remus/proto/JobRequirements.h>
 #include <remus/proto/zmqSocketIdentity.h>
 
+#include <remus/server/detail/RequirementsRegistry.h>
 #include <remus/server/detail/SocketMonitor.h>
 
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <deque>
+#include <map>
 #include <set>
-#include <vector>
 
 namespace remus{
 namespace server{
 namespace detail{
 
+//The pool of workers that have registered with the server. Workers are
+//indexed by their socket identity, and each requirements handle has a queue
+//of the workers that are ready to take a job of that type. Taking a worker
+//pops the front of the queue, and a worker that wants more jobs goes to the
+//back of it, so workers of the same type take jobs round robin.
 class WorkerPool
 {
 public:
   WorkerPool();
 
+  //construct a pool that interns requirements into a registry that is
+  //shared with the rest of the server, so that handles can be compared
+  //against the handles of the job queue
+  explicit WorkerPool(const boost::shared_ptr<RequirementsRegistry>& registry);
+
   bool addWorker(zmq::SocketIdentity workerIdentity,
                  const remus::proto::JobRequirements& reqs);
+  bool addWorker(zmq::SocketIdentity workerIdentity,
+                 RequirementsHandle handle);
 
   //return all the MeshIOTypes that workers have registered to support.
   //this allows the client to discover workers that have connected with
@@ -46,25 +66,53 @@ public:
 
   //do we have any worker waiting to take this type of job
   bool haveWaitingWorker(const remus::proto::JobRequirements& reqs) const;
+  bool haveWaitingWorker(RequirementsHandle handle) const;
 
   //do we have a worker with this address?
   bool haveWorker(const zmq::SocketIdentity& address,
                   const remus::proto::JobRequirements& reqs) const;
+  bool haveWorker(const zmq::SocketIdentity& address,
+                  RequirementsHandle handle) const;
 
   //mark a worker with the given address ready to take a job.
   //returns false if a worker with that address wasn't found
   bool readyForWork(const zmq::SocketIdentity& address,
                     const remus::proto::JobRequirements& reqs);
+  bool readyForWork(const zmq::SocketIdentity& address,
+                    RequirementsHandle handle);
 
   //returns the worker address and marks that the worker has taken a job.
   //this doesn't remove the worker from the worker pool, it just decrements
   //the number of jobs the worker is allowed to take, and puts in at the worker
   //queue
   zmq::SocketIdentity takeWorker(const remus::proto::JobRequirements& reqs);
+  zmq::SocketIdentity takeWorker(RequirementsHandle handle);
+
+  //returns true when the given worker is waiting for work of the
+  //requirements type
+  bool isWaitingForWork(const zmq::SocketIdentity& address,
+                        RequirementsHandle handle) const;
+
+  //take the given worker instead of the worker at the front of the queue,
+  //which is how jobs are sent to the worker that already has their data.
+  //Returns false when the worker isn't waiting for work of that type
+  bool takeWorker(const zmq::SocketIdentity& address,
+                  RequirementsHandle handle);
 
   //remove all workers that haven't responded based on the passed in monitor
   void purgeDeadWorkers(remus::server::detail::SocketMonitor monitor);
 
+  //remove dead workers and update the responsive state of workers, only
+  //looking at the workers whose sockets are given. Used with the sockets
+  //returned by SocketMonitor::changedSockets.
+  void purgeDeadWorkers(remus::server::detail::SocketMonitor monitor,
+                        const std::set<zmq::SocketIdentity>& changed);
+
+  //The types of workers that went from having no worker waiting for work
+  //to having one since the last call are dirty, as they might match a
+  //queued job. Moves the dirty types into the given set.
+  void takeDirtyHandles(std::set<RequirementsHandle>& dirty);
+
   //return the socket identity of all workers including workers that are
   //unresponsive
   std::set<zmq::SocketIdentity> allWorkers() const;
@@ -76,34 +124,72 @@ public:
   std::set<zmq::SocketIdentity> allWorkersWantingWork() const;
 
 private:
+  typedef boost::uint32_t WorkerId;
+
+  //the state of a worker for one of the requirements it registered with
   struct WorkerInfo
   {
     int NumberOfDesiredJobs;
-    remus::proto::JobRequirements Reqs;
-    zmq::SocketIdentity Address;
     bool IsResponsive; //as in we are getting heartbeating from the worker
+    bool InReadyQueue; //is in the ready queue of the requirements
 
-    WorkerInfo(const zmq::SocketIdentity& address,
-               const remus::proto::JobRequirements& type);
+    WorkerInfo();
 
     bool isWaitingForWork() const { return NumberOfDesiredJobs > 0 && IsResponsive; }
-    void addJob() { ++NumberOfDesiredJobs; }
-    void takesJob() { --NumberOfDesiredJobs; }
   };
 
-  struct DeadWorkers
+  //a worker can register for multiple requirements
+  struct Worker
   {
-   remus::server::detail::SocketMonitor Monitor;
-   DeadWorkers(remus::server::detail::SocketMonitor monitor):
-     Monitor(monitor){}
-   inline bool operator()(const WorkerPool::WorkerInfo& worker)
-    { return Monitor.isDead(worker.Address); }
+    Worker(WorkerId id, const zmq::SocketIdentity& address):
+      Id(id), Address(address), Reqs() {}
+
+    WorkerId Id;
+    zmq::SocketIdentity Address;
+    std::map<RequirementsHandle, WorkerInfo> Reqs;
+  };
+
+  //the workers that are ready for a requirements type, with the number of
+  //them that are waiting for work. The queue can hold workers that are no
+  //longer waiting, those are skipped when they reach the front.
+  struct ReadyQueue
+  {
+    ReadyQueue(): NumberWaiting(0), Workers() {}
+
+    std::size_t NumberWaiting;
+    std::deque<WorkerId> Workers;
   };
 
+  typedef boost::unordered_map<zmq::SocketIdentity, WorkerId> AddressMap;
+  typedef boost::unordered_map<WorkerId, Worker> WorkerMap;
+  typedef boost::unordered_map<RequirementsHandle, ReadyQueue> ReadyMap;
+
+  //update the state of a worker for a requirements type, keeping the
+  //ready queue of that requirements type in sync
+  void update(Worker& worker, RequirementsHandle handle, WorkerInfo& info,
+              int desiredJobs, bool responsive);
+
+  //update the responsive state of a worker from the monitor, returns true
+  //when the worker is dead and needs to be removed
+  bool checkWorker(Worker& worker,
+                   const remus::server::detail::SocketMonitor& monitor);
+
+  //remove a worker, its ids are skipped when they reach the front of the
+  //ready queues. Releases the requirements handles the worker held
+  void removeWorker(WorkerId id);
+
+  boost::shared_ptr<RequirementsRegistry> Registry;
+
+  //ids are never reused, so a stale id in a ready queue never refers to
+  //a worker that registered again with the same address
+  WorkerId NextWorkerId;
+  AddressMap Addresses;
+  WorkerMap Workers;
+  ReadyMap Ready;
 
-  typedef std::vector<WorkerInfo>::const_iterator ConstIt;
-  typedef std::vector<WorkerInfo>::iterator It;
-  std::vector<WorkerInfo> Pool;
+  //the requirements that have gained a waiting worker since the last
+  //scheduling pass
+  std::set<RequirementsHandle> DirtyHandles;
 };
 
 }
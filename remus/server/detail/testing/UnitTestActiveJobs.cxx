@@ -114,15 +114,22 @@ void verify_updating_status()
       REMUS_ASSERT( (jobs.status(uuids_used[0]).status() != status_type) );
 
       remus::proto::JobResult result(uuids_used[0]);
-      jobs.updateResult(result);
+      jobs.updateResult(result.id(), remus::proto::to_FrameSet(result));
       REMUS_ASSERT( (jobs.status(uuids_used[0]).status() == status_type) );
-      REMUS_ASSERT( (jobs.result(uuids_used[0]).valid() == false) );
+      REMUS_ASSERT( (remus::proto::to_JobResult(
+                        jobs.result(uuids_used[0])).valid() == false) );
 
+      //the frames of the result are kept as they were given
       remus::proto::JobResult result_with_data =
                         remus::proto::make_JobResult(uuids_used[0],"data");
-      jobs.updateResult(result_with_data);
+      const remus::proto::FrameSet frames =
+                        remus::proto::to_FrameSet(result_with_data);
+      jobs.updateResult(result_with_data.id(), frames);
       REMUS_ASSERT( (jobs.status(uuids_used[0]).status() == status_type) );
-      REMUS_ASSERT( (jobs.result(uuids_used[0]).valid() == true) );
+      REMUS_ASSERT( (jobs.result(uuids_used[0]).Header.data() ==
+                     frames.Header.data()) );
+      REMUS_ASSERT( (remus::proto::to_JobResult(
+                        jobs.result(uuids_used[0])).valid() == true) );
       }
     else
       {
@@ -267,9 +274,15 @@ void verify_refresh_jobs()
     }
 
   remus::server::detail::ActiveJobs jobs;
+  remus::server::detail::ActiveJobs changed_jobs;
 
   for(int i=0; i < 5; ++i)
-    { REMUS_ASSERT( (jobs.add(socketIds_used[i], uuids_used[i]) == true) ); }
+    {
+    REMUS_ASSERT( (jobs.add(socketIds_used[i], uuids_used[i]) == true) );
+    REMUS_ASSERT( (changed_jobs.add(socketIds_used[i], uuids_used[i]) == true) );
+    }
+  REMUS_ASSERT( (changed_jobs.markExpiredJobs(monitor,
+                                    monitor.changedSockets()).size() == 0) );
 
   jobs.markExpiredJobs( monitor );
   for(int i=0; i < 5; ++i)
@@ -302,7 +315,8 @@ void verify_refresh_jobs()
                         remus::proto::make_JobResult(finished_job_uuid,"data");
   const zmq::SocketIdentity finishedJobSocketId =  make_socketId();
   jobs.add(finishedJobSocketId, finished_job_uuid);
-  jobs.updateResult(result_with_data);
+  jobs.updateResult(finished_job_uuid,
+                    remus::proto::to_FrameSet(result_with_data));
 
   monitor.refresh( finishedJobSocketId );
   jobs.markExpiredJobs( monitor );
@@ -329,9 +343,15 @@ void verify_expire_jobs()
     }
 
   remus::server::detail::ActiveJobs jobs;
+  remus::server::detail::ActiveJobs changed_jobs;
 
   for(int i=0; i < 5; ++i)
-    { REMUS_ASSERT( (jobs.add(socketIds_used[i], uuids_used[i]) == true) ); }
+    {
+    REMUS_ASSERT( (jobs.add(socketIds_used[i], uuids_used[i]) == true) );
+    REMUS_ASSERT( (changed_jobs.add(socketIds_used[i], uuids_used[i]) == true) );
+    }
+  REMUS_ASSERT( (changed_jobs.markExpiredJobs(monitor,
+                                    monitor.changedSockets()).size() == 0) );
 
   jobs.markExpiredJobs( monitor );
   for(int i=0; i < 5; ++i)
@@ -352,6 +372,25 @@ void verify_expire_jobs()
   for(int i=3; i < 5; ++i)
     { REMUS_ASSERT( (jobs.status(uuids_used[i]).status() == remus::EXPIRED) ); }
 
+  //only the workers that missed their deadline are looked at when using
+  //the changed sockets of the monitor, and we get the same result
+  std::set<zmq::SocketIdentity> changed = monitor.changedSockets();
+  REMUS_ASSERT( (changed.size() == 2) );
+  REMUS_ASSERT( (changed_jobs.markExpiredJobs(monitor, changed).size() == 2) );
+  for(int i=0; i < 3; ++i)
+    {
+    REMUS_ASSERT( (changed_jobs.status(uuids_used[i]).status() == remus::QUEUED) );
+    }
+  for(int i=3; i < 5; ++i)
+    {
+    REMUS_ASSERT( (changed_jobs.status(uuids_used[i]).status() == remus::EXPIRED) );
+    }
+
+  //removing jobs removes them from the jobs of their worker
+  REMUS_ASSERT( (changed_jobs.activeWorkers().size() == 5) );
+  REMUS_ASSERT( (changed_jobs.remove(uuids_used[0]) == true) );
+  REMUS_ASSERT( (changed_jobs.activeWorkers().size() == 4) );
+
 }
 
 } //namespace
@@ -0,0 +1,119 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/server/detail/BlobStore.h>
+
+#include <remus/testing/Testing.h>
+
+#include <string>
+
+namespace {
+
+using remus::proto::Frame;
+using remus::server::detail::BlobStore;
+
+Frame make_Frame(const std::string& data)
+{
+  std::string copy(data);
+  return remus::proto::detail::make_HeaderFrame(copy);
+}
+
+std::string to_string(const Frame& f)
+{
+  return std::string(f.data(), f.size());
+}
+
+void verify_add_and_find()
+{
+  BlobStore store(1024);
+  REMUS_ASSERT( (store.size() == 0) );
+  REMUS_ASSERT( (store.byteCount() == 0) );
+
+  Frame blob;
+  REMUS_ASSERT( (!store.find("a", blob)) );
+  REMUS_ASSERT( (!store.touch("a")) );
+
+  REMUS_ASSERT( (store.add("a", make_Frame(std::string(100,'a')))) );
+  REMUS_ASSERT( (store.size() == 1) );
+  REMUS_ASSERT( (store.byteCount() == 100) );
+  REMUS_ASSERT( (store.touch("a")) );
+  REMUS_ASSERT( (store.find("a", blob)) );
+  REMUS_ASSERT( (to_string(blob) == std::string(100,'a')) );
+
+  //adding the same hash again doesn't store a second copy
+  REMUS_ASSERT( (store.add("a", make_Frame(std::string(100,'a')))) );
+  REMUS_ASSERT( (store.size() == 1) );
+  REMUS_ASSERT( (store.byteCount() == 100) );
+
+  //blobs larger than the store are never stored
+  REMUS_ASSERT( (!store.add("big", make_Frame(std::string(2048,'b')))) );
+  REMUS_ASSERT( (store.size() == 1) );
+
+  store.clear();
+  REMUS_ASSERT( (store.size() == 0) );
+  REMUS_ASSERT( (store.byteCount() == 0) );
+  REMUS_ASSERT( (!store.find("a", blob)) );
+}
+
+void verify_lru_eviction()
+{
+  BlobStore store(300);
+  store.add("a", make_Frame(std::string(100,'a')));
+  store.add("b", make_Frame(std::string(100,'b')));
+  store.add("c", make_Frame(std::string(100,'c')));
+  REMUS_ASSERT( (store.size() == 3) );
+  REMUS_ASSERT( (store.byteCount() == 300) );
+
+  //using a makes b the least recently used, which is evicted first
+  REMUS_ASSERT( (store.touch("a")) );
+  store.add("d", make_Frame(std::string(100,'d')));
+  REMUS_ASSERT( (store.size() == 3) );
+  REMUS_ASSERT( (store.byteCount() == 300) );
+  REMUS_ASSERT( (!store.touch("b")) );
+  REMUS_ASSERT( (store.touch("a")) );
+  REMUS_ASSERT( (store.touch("c")) );
+  REMUS_ASSERT( (store.touch("d")) );
+
+  //a large blob evicts as many blobs as needed
+  store.add("e", make_Frame(std::string(250,'e')));
+  REMUS_ASSERT( (store.size() == 1) );
+  REMUS_ASSERT( (store.byteCount() == 250) );
+
+  //shrinking the store evicts blobs that no longer fit
+  store.maxBytes(100);
+  REMUS_ASSERT( (store.maxBytes() == 100) );
+  REMUS_ASSERT( (store.size() == 0) );
+  REMUS_ASSERT( (store.byteCount() == 0) );
+}
+
+void verify_evicted_blobs_stay_valid()
+{
+  //blobs taken from the store stay valid after they are evicted, since
+  //queued jobs share them
+  BlobStore store(100);
+  store.add("a", make_Frame(std::string(100,'a')));
+
+  Frame blob;
+  REMUS_ASSERT( (store.find("a", blob)) );
+  store.add("b", make_Frame(std::string(100,'b')));
+  REMUS_ASSERT( (!store.touch("a")) );
+  REMUS_ASSERT( (to_string(blob) == std::string(100,'a')) );
+}
+
+}
+
+int UnitTestBlobStore(int, char *[])
+{
+  verify_add_and_find();
+  verify_lru_eviction();
+  verify_evicted_blobs_stay_valid();
+  return 0;
+}
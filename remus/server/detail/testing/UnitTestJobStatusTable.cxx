@@ -0,0 +1,135 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobStatusTable.h>
+
+#include <remus/testing/Testing.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/thread.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <vector>
+
+namespace {
+
+using remus::proto::JobProgress;
+using remus::proto::JobStatus;
+using remus::server::detail::JobStatusTable;
+
+void verify_update()
+{
+  JobStatusTable table;
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+
+  //unknown jobs are invalid
+  REMUS_ASSERT( (table.size() == 0) );
+  REMUS_ASSERT( (table.status(id).invalid()) );
+  REMUS_ASSERT( (table.status(id).id() == id) );
+
+  table.update( JobStatus(id, remus::QUEUED) );
+  REMUS_ASSERT( (table.size() == 1) );
+  REMUS_ASSERT( (table.status(id).queued()) );
+
+  //progress is kept along with the status
+  const JobStatus progress(id, JobProgress(50));
+  table.update( progress );
+  REMUS_ASSERT( (table.size() == 1) );
+  REMUS_ASSERT( (table.status(id) == progress) );
+
+  table.update( JobStatus(id, remus::FINISHED) );
+  REMUS_ASSERT( (table.status(id).finished()) );
+
+  //an invalid status removes the job
+  table.update( JobStatus(id, remus::INVALID_STATUS) );
+  REMUS_ASSERT( (table.size() == 0) );
+  REMUS_ASSERT( (table.status(id).invalid()) );
+
+  //clear removes every job
+  table.update( JobStatus(id, remus::QUEUED) );
+  table.update( JobStatus(remus::testing::UUIDGenerator(), remus::QUEUED) );
+  REMUS_ASSERT( (table.size() == 2) );
+  table.clear();
+  REMUS_ASSERT( (table.size() == 0) );
+}
+
+struct StatusWriter
+{
+  StatusWriter(JobStatusTable* table, const std::vector<boost::uuids::uuid>& ids):
+    Table(table), Ids(ids) {}
+
+  void operator()()
+  {
+    for(int pass=1; pass <= 100; ++pass)
+      {
+      for(std::size_t i=0; i < this->Ids.size(); ++i)
+        {
+        this->Table->update( JobStatus(this->Ids[i], JobProgress(pass)) );
+        }
+      }
+    for(std::size_t i=0; i < this->Ids.size(); ++i)
+      {
+      this->Table->update( JobStatus(this->Ids[i], remus::FINISHED) );
+      }
+  }
+
+  JobStatusTable* Table;
+  std::vector<boost::uuids::uuid> Ids;
+};
+
+void verify_concurrent_reads()
+{
+  //one thread writes the statuses while another reads them, which is how
+  //the server uses the table when brokering with multiple threads
+  JobStatusTable table;
+  std::vector<boost::uuids::uuid> ids;
+  for(int i=0; i < 64; ++i)
+    {
+    ids.push_back( remus::testing::UUIDGenerator() );
+    table.update( JobStatus(ids.back(), remus::QUEUED) );
+    }
+
+  boost::thread writer( (StatusWriter(&table, ids)) );
+
+  //the progress of a job never goes backwards, as the writer only
+  //moves it forward
+  std::vector<int> lastProgress(ids.size(), 0);
+  bool allFinished = false;
+  while(!allFinished)
+    {
+    allFinished = true;
+    for(std::size_t i=0; i < ids.size(); ++i)
+      {
+      const JobStatus js = table.status(ids[i]);
+      REMUS_ASSERT( (js.id() == ids[i]) );
+      REMUS_ASSERT( (js.queued() || js.inProgress() || js.finished()) );
+      if(js.inProgress())
+        {
+        REMUS_ASSERT( (js.progress().value() >= lastProgress[i]) );
+        lastProgress[i] = js.progress().value();
+        }
+      allFinished = allFinished && js.finished();
+      }
+    }
+
+  writer.join();
+  REMUS_ASSERT( (table.size() == ids.size()) );
+}
+
+}
+
+int UnitTestJobStatusTable(int, char *[])
+{
+  verify_update();
+  verify_concurrent_reads();
+  return 0;
+}
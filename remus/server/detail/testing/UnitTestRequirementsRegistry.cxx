@@ -0,0 +1,180 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/JobQueue.h>
+#include <remus/server/detail/RequirementsRegistry.h>
+#include <remus/server/detail/WorkerPool.h>
+
+#include <remus/common/ContentTypes.h>
+#include <remus/testing/Testing.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+namespace {
+
+using namespace remus::common;
+using namespace remus::meshtypes;
+using remus::server::detail::RequirementsHandle;
+using remus::server::detail::RequirementsRegistry;
+
+remus::proto::JobRequirements make_Reqs(const std::string& name,
+                                        const std::string& tag)
+{
+  remus::proto::JobRequirements reqs(ContentFormat::User,
+                                     MeshIOType(Edges(),Mesh2D()),
+                                     name, "requirements");
+  reqs.tag(tag);
+  return reqs;
+}
+
+void verify_intern()
+{
+  RequirementsRegistry registry;
+  REMUS_ASSERT( (registry.size() == 0) );
+
+  const remus::proto::JobRequirements a = make_Reqs("worker", "a");
+  const remus::proto::JobRequirements b = make_Reqs("worker", "b");
+
+  //unknown requirements don't have a handle
+  REMUS_ASSERT( (registry.find(a) == RequirementsRegistry::InvalidHandle) );
+
+  const RequirementsHandle ha = registry.intern(a);
+  const RequirementsHandle hb = registry.intern(b);
+  REMUS_ASSERT( (ha != RequirementsRegistry::InvalidHandle) );
+  REMUS_ASSERT( (hb != RequirementsRegistry::InvalidHandle) );
+  REMUS_ASSERT( (ha != hb) );
+  REMUS_ASSERT( (registry.size() == 2) );
+
+  //equal requirements always get the same handle
+  REMUS_ASSERT( (registry.intern(make_Reqs("worker", "a")) == ha) );
+  REMUS_ASSERT( (registry.find(b) == hb) );
+  REMUS_ASSERT( (registry.size() == 2) );
+
+  //handles map back to equal requirements that own their data
+  REMUS_ASSERT( (registry.requirements(ha) == a) );
+  REMUS_ASSERT( (registry.requirements(hb) == b) );
+  REMUS_ASSERT( (registry.requirements(ha).requirements() != a.requirements()) );
+  REMUS_ASSERT( (std::string(registry.requirements(ha).requirements(),
+                             registry.requirements(ha).requirementsSize()) ==
+                 "requirements") );
+
+  //unknown handles map to invalid requirements
+  REMUS_ASSERT( (!registry.requirements(1000).meshTypes().valid()) );
+}
+
+void verify_release()
+{
+  RequirementsRegistry registry;
+  const remus::proto::JobRequirements a = make_Reqs("worker", "a");
+  const remus::proto::JobRequirements b = make_Reqs("worker", "b");
+
+  //every intern and retain holds a reference, the requirements are only
+  //dropped once all of them are released
+  const RequirementsHandle ha = registry.intern(a);
+  REMUS_ASSERT( (registry.intern(a) == ha) );
+  registry.retain(ha);
+  REMUS_ASSERT( (!registry.release(ha)) );
+  REMUS_ASSERT( (!registry.release(ha)) );
+  REMUS_ASSERT( (registry.find(a) == ha) );
+  REMUS_ASSERT( (registry.release(ha)) );
+  REMUS_ASSERT( (registry.size() == 0) );
+  REMUS_ASSERT( (registry.find(a) == RequirementsRegistry::InvalidHandle) );
+  REMUS_ASSERT( (!registry.requirements(ha).meshTypes().valid()) );
+
+  //releasing a handle that isn't held does nothing
+  REMUS_ASSERT( (!registry.release(ha)) );
+  REMUS_ASSERT( (!registry.release(RequirementsRegistry::InvalidHandle)) );
+  REMUS_ASSERT( (!registry.release(1000)) );
+
+  //released handles are given to new requirements, so the registry only
+  //grows with the number of requirements held at once
+  const RequirementsHandle hb = registry.intern(b);
+  REMUS_ASSERT( (hb == ha) );
+  REMUS_ASSERT( (registry.requirements(hb) == b) );
+  REMUS_ASSERT( (registry.size() == 1) );
+
+  //the queue holds a reference for each job, until the job leaves it
+  boost::shared_ptr<RequirementsRegistry> shared =
+                                boost::make_shared<RequirementsRegistry>();
+  remus::server::detail::JobQueue queue(shared);
+  for(int i=0; i < 100; ++i)
+    {
+    const std::string tag = boost::lexical_cast<std::string>(i % 10);
+    remus::proto::JobSubmission submission(make_Reqs("worker", tag));
+    queue.addJob(remus::testing::UUIDGenerator(), submission);
+    }
+  REMUS_ASSERT( (shared->size() == 10) );
+
+  const RequirementsHandle h0 = shared->find(make_Reqs("worker", "0"));
+  for(int i=0; i < 10; ++i)
+    {
+    REMUS_ASSERT( (queue.takeJob(h0).valid()) );
+    }
+  REMUS_ASSERT( (shared->size() == 9) );
+  REMUS_ASSERT( (shared->find(make_Reqs("worker", "0")) ==
+                 RequirementsRegistry::InvalidHandle) );
+
+  queue.clear();
+  REMUS_ASSERT( (shared->size() == 0) );
+}
+
+void verify_shared_handles()
+{
+  //the job queue and worker pool of a server share a registry, so the
+  //handles of a job can be given directly to the pool
+  boost::shared_ptr<RequirementsRegistry> registry =
+                                boost::make_shared<RequirementsRegistry>();
+  remus::server::detail::JobQueue queue(registry);
+  remus::server::detail::WorkerPool pool(registry);
+
+  const remus::proto::JobRequirements reqs = make_Reqs("worker", "tag");
+  remus::proto::JobSubmission submission(reqs);
+  const boost::uuids::uuid id = remus::testing::UUIDGenerator();
+  queue.addJob(id, submission);
+
+  const std::string str_id = boost::lexical_cast<std::string>(id);
+  zmq::SocketIdentity worker(str_id.c_str(),str_id.size());
+  pool.addWorker(worker, make_Reqs("worker", "tag"));
+  pool.readyForWork(worker, reqs);
+
+  REMUS_ASSERT( (registry->size() == 1) );
+  std::set<RequirementsHandle> handles = queue.queuedJobHandles();
+  REMUS_ASSERT( (handles.size() == 1) );
+
+  const RequirementsHandle handle = *handles.begin();
+  REMUS_ASSERT( (handle == registry->find(reqs)) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(handle)) );
+  REMUS_ASSERT( (pool.takeWorker(handle) == worker) );
+
+  remus::server::detail::QueuedJob job = queue.takeJob(handle);
+  REMUS_ASSERT( (job.valid()) );
+  REMUS_ASSERT( (job.id() == id) );
+  REMUS_ASSERT( (job.handle() == handle) );
+  REMUS_ASSERT( (queue.takeJob(handle).valid() == false) );
+
+  //the worker still holds the requirements
+  REMUS_ASSERT( (registry->size() == 1) );
+  REMUS_ASSERT( (registry->find(reqs) == handle) );
+}
+
+}
+
+int UnitTestRequirementsRegistry(int, char *[])
+{
+  verify_intern();
+  verify_release();
+  verify_shared_handles();
+  return 0;
+}
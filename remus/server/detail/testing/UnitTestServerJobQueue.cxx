@@ -174,11 +174,11 @@ void verify_dispatch_jobs()
 
   REMUS_ASSERT( (queue.takeJob(worker_type1D).valid() == false) );
 
-  remus::worker::Job job_2d_1 = queue.takeJob(worker_type2D);
+  remus::server::detail::QueuedJob job_2d_1 = queue.takeJob(worker_type2D);
   REMUS_ASSERT( (job_2d_1.valid() == true) );
   REMUS_ASSERT( (queue.haveUUID(job_2d_1.id()) == false) );
 
-  remus::worker::Job job_2d_2 = queue.takeJob(worker_type2D);
+  remus::server::detail::QueuedJob job_2d_2 = queue.takeJob(worker_type2D);
   REMUS_ASSERT( (job_2d_2.valid() == true) );
   REMUS_ASSERT( (job_2d_2.id() != job_2d_1.id()) );
   REMUS_ASSERT( (queue.haveUUID(job_2d_2.id()) == false) );
@@ -212,6 +212,135 @@ void verify_dispatch_jobs()
   REMUS_ASSERT( (queue.waitingJobRequirements().count(worker_type3D) == 0) );
 }
 
+void verify_submission_passthrough()
+{
+  remus::server::detail::JobQueue queue;
+
+  remus::proto::JobSubmission submission = make_jobSubmission(Edges(),Mesh2D());
+  submission["data"] = remus::proto::make_JobContent(
+                                remus::testing::BinaryDataGenerator(1024));
+  const remus::proto::FrameSet frames = remus::proto::to_FrameSet(submission);
+
+  const boost::uuids::uuid id = make_id();
+  REMUS_ASSERT( (queue.addJob(id, worker_type2D, frames) == true) );
+  REMUS_ASSERT( (queue.addJob(id, worker_type2D, frames) == false) );
+
+  //the queued job holds the frames it was given, not a copy of them
+  remus::server::detail::QueuedJob job = queue.takeJob(worker_type2D);
+  REMUS_ASSERT( (job.valid() == true) );
+  REMUS_ASSERT( (job.id() == id) );
+  REMUS_ASSERT( (job.requirements() == worker_type2D) );
+  REMUS_ASSERT( (job.submission().Header.data() == frames.Header.data()) );
+  REMUS_ASSERT( (job.submission().Blobs.size() == frames.Blobs.size()) );
+  REMUS_ASSERT( (job.submission().Blobs.back().data() ==
+                 submission["data"].data()) );
+
+  REMUS_ASSERT( (remus::proto::to_JobSubmission(job.submission()) ==
+                 submission) );
+}
+
+void verify_fifo_order()
+{
+  remus::server::detail::JobQueue queue;
+
+  //jobs of the same type are taken in the order they are added, no matter
+  //how many jobs of other types are interleaved with them
+  std::vector< boost::uuids::uuid > ids_2d;
+  for(int i=0; i < 64; ++i)
+    {
+    ids_2d.push_back(make_id());
+    queue.addJob( ids_2d.back(), make_jobSubmission(Edges(),Mesh2D()) );
+    queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh3D()) );
+    }
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 128) );
+
+  //removing jobs from the middle keeps the order of the rest
+  REMUS_ASSERT( (queue.remove(ids_2d[1]) == true) );
+  REMUS_ASSERT( (queue.remove(ids_2d[1]) == false) );
+  ids_2d.erase(ids_2d.begin() + 1);
+
+  //dispatched jobs are taken first, in the order they were dispatched
+  REMUS_ASSERT( (queue.workerDispatched(worker_type2D) == true) );
+  REMUS_ASSERT( (queue.workerDispatched(worker_type2D) == true) );
+  const remus::server::detail::QueuedJob first = queue.takeJob(worker_type2D);
+  REMUS_ASSERT( (first.id() == ids_2d[0]) );
+
+  //looking at the next job doesn't take it
+  REMUS_ASSERT( (queue.nextJob(first.handle()).id() == ids_2d[1]) );
+  REMUS_ASSERT( (queue.nextJob(first.handle()).id() == ids_2d[1]) );
+
+  //a waiting job can be removed as well
+  REMUS_ASSERT( (queue.remove(ids_2d[1]) == true) );
+  REMUS_ASSERT( (queue.numJobsWaitingForWorkers() == 0) );
+  REMUS_ASSERT( (queue.waitingJobRequirements().size() == 0) );
+
+  for(std::size_t i=2; i < ids_2d.size(); ++i)
+    {
+    REMUS_ASSERT( (queue.takeJob(worker_type2D).id() == ids_2d[i]) );
+    }
+  REMUS_ASSERT( (queue.takeJob(worker_type2D).valid() == false) );
+  REMUS_ASSERT( (queue.queuedJobRequirements().size() == 1) );
+  REMUS_ASSERT( (queue.queuedJobRequirements().count(worker_type3D) == 1) );
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 64) );
+
+  //clear removes jobs that are waiting for a worker too
+  REMUS_ASSERT( (queue.workerDispatched(worker_type3D) == true) );
+  queue.clear();
+  REMUS_ASSERT( (queue.numJobsWaitingForWorkers() == 0) );
+  REMUS_ASSERT( (queue.numJobsJustQueued() == 0) );
+  REMUS_ASSERT( (queue.waitingJobRequirements().size() == 0) );
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).valid() == false) );
+}
+
+void verify_dirty_types()
+{
+  typedef remus::server::detail::RequirementsHandle Handle;
+  remus::server::detail::JobQueue queue;
+
+  //adding jobs marks their type as dirty
+  queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh2D()) );
+  queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh2D()) );
+  queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh3D()) );
+  std::set<Handle> dirty;
+  queue.takeDirtyHandles(dirty);
+  REMUS_ASSERT( (dirty.size() == 2) );
+  REMUS_ASSERT( (dirty == queue.queuedJobHandles()) );
+
+  //taking the dirty types clears them, and taking jobs or dispatching
+  //workers doesn't make a type dirty
+  REMUS_ASSERT( (queue.workerDispatched(worker_type2D) == true) );
+  REMUS_ASSERT( (queue.takeJob(worker_type3D).valid() == true) );
+  std::set<Handle> again;
+  queue.takeDirtyHandles(again);
+  REMUS_ASSERT( (again.size() == 0) );
+
+  const Handle handle2D = *queue.queuedJobHandles().begin();
+  dirty.erase(handle2D);
+  const Handle handle3D = *dirty.begin();
+  REMUS_ASSERT( (queue.haveJob(handle2D) == true) );
+  REMUS_ASSERT( (queue.haveJob(handle3D) == false) );
+
+  //only types with jobs that aren't waiting for a worker are marked dirty
+  REMUS_ASSERT( (queue.workerDispatched(handle2D) == true) );
+  queue.markQueuedHandlesDirty();
+  queue.takeDirtyHandles(again);
+  REMUS_ASSERT( (again.size() == 0) );
+  REMUS_ASSERT( (queue.haveJob(handle2D) == true) );
+
+  //dirty types are merged into the types already given
+  again.insert(handle2D);
+  queue.markDirty(handle3D);
+  queue.takeDirtyHandles(again);
+  REMUS_ASSERT( (again.size() == 2) );
+
+  //clearing the queue clears the dirty types
+  queue.addJob( make_id(), make_jobSubmission(Edges(),Mesh3D()) );
+  queue.clear();
+  dirty.clear();
+  queue.takeDirtyHandles(dirty);
+  REMUS_ASSERT( (dirty.size() == 0) );
+}
+
 } //namespace
 
 int UnitTestServerJobQueue(int, char *[])
@@ -221,6 +350,12 @@ int UnitTestServerJobQueue(int, char *[])
 
   verify_dispatch_jobs();
 
+  verify_submission_passthrough();
+
+  verify_fifo_order();
+
+  verify_dirty_types();
+
 
   return 0;
 }
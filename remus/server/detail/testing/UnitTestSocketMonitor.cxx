@@ -237,6 +237,75 @@ void verify_responiveness()
   }
 }
 
+void verify_changed_sockets()
+{
+  zmq::SocketIdentity fast = make_socketId();
+  zmq::SocketIdentity slow = make_socketId();
+  SocketMonitor monitor;
+  monitor.pollingMonitor().changeTimeOutRates(25,125);
+
+  monitor.heartbeat(fast, make_heartbeat(25) );
+  monitor.heartbeat(slow, make_heartbeat(25) );
+  REMUS_ASSERT( (monitor.changedSockets().size() == 0) );
+
+  //only the socket that misses its deadline is reported
+  remus::common::SleepForMillisec(150);
+  monitor.heartbeat(fast, make_heartbeat(25) );
+  remus::common::SleepForMillisec(150);
+  std::set<zmq::SocketIdentity> changed = monitor.changedSockets();
+  REMUS_ASSERT( (changed.size() == 1) );
+  REMUS_ASSERT( (changed.count(slow) == 1) );
+  REMUS_ASSERT( (monitor.isUnresponsive(slow) == true) );
+  REMUS_ASSERT( (monitor.isUnresponsive(fast) == false) );
+
+  //it is only reported once
+  REMUS_ASSERT( (monitor.changedSockets().size() == 0) );
+
+  //it is reported again when it comes back, and when the other is killed
+  monitor.heartbeat(slow, make_heartbeat(25) );
+  monitor.markAsDead(fast);
+  changed = monitor.changedSockets();
+  REMUS_ASSERT( (changed.size() == 2) );
+  REMUS_ASSERT( (changed.count(slow) == 1) );
+  REMUS_ASSERT( (changed.count(fast) == 1) );
+  REMUS_ASSERT( (monitor.isUnresponsive(slow) == false) );
+  REMUS_ASSERT( (monitor.isDead(fast) == true) );
+
+  //a socket that keeps heartbeating is never reported
+  for(int i=0; i < 4; ++i)
+    {
+    remus::common::SleepForMillisec(100);
+    monitor.heartbeat(slow, make_heartbeat(25) );
+    REMUS_ASSERT( (monitor.changedSockets().size() == 0) );
+    }
+}
+
+void verify_next_deadline()
+{
+  zmq::SocketIdentity socket = make_socketId();
+  SocketMonitor monitor;
+  monitor.pollingMonitor().changeTimeOutRates(25,125);
+
+  //without sockets we only wait for the max time out
+  REMUS_ASSERT( (monitor.timeUntilNextDeadline() == 125) );
+
+  //the deadline is two heartbeats away, which is past the max time out
+  monitor.heartbeat(socket, make_heartbeat(25) );
+  REMUS_ASSERT( (monitor.timeUntilNextDeadline() == 125) );
+
+  //once the deadline has passed we shouldn't wait at all
+  remus::common::SleepForMillisec(300);
+  REMUS_ASSERT( (monitor.timeUntilNextDeadline() == 0) );
+  REMUS_ASSERT( (monitor.changedSockets().size() == 1) );
+  REMUS_ASSERT( (monitor.timeUntilNextDeadline() == 125) );
+
+  //a socket that comes back or is killed needs to be reported right away
+  monitor.heartbeat(socket, make_heartbeat(25) );
+  REMUS_ASSERT( (monitor.timeUntilNextDeadline() == 0) );
+  REMUS_ASSERT( (monitor.changedSockets().size() == 1) );
+  monitor.markAsDead(socket);
+  REMUS_ASSERT( (monitor.timeUntilNextDeadline() == 0) );
+}
 
 }
 int UnitTestSocketMonitor(int, char *[])
@@ -250,6 +319,8 @@ int UnitTestSocketMonitor(int, char *[])
   verify_resurrection();
   verify_heartbeat_interval();
   verify_responiveness();
+  verify_changed_sockets();
+  verify_next_deadline();
 
   return 0;
 }
@@ -0,0 +1,199 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/WorkerAffinity.h>
+
+#include <remus/proto/zmqSocketIdentity.h>
+#include <remus/testing/Testing.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/lexical_cast.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <limits>
+
+namespace
+{
+using namespace remus::common;
+using namespace remus::meshtypes;
+typedef remus::server::detail::WorkerAffinity WorkerAffinity;
+typedef remus::server::detail::QueuedJob QueuedJob;
+typedef remus::server::detail::RequirementsHandle RequirementsHandle;
+
+//makes a random socket identity
+zmq::SocketIdentity make_socketId()
+{
+  boost::uuids::uuid new_uid = remus::testing::UUIDGenerator();
+  const std::string str_id = boost::lexical_cast<std::string>(new_uid);
+  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+}
+
+//makes a queued job with the given blob hashes and requirements tag
+QueuedJob make_job(const std::vector<std::string>& hashes,
+                   const std::string& tag = std::string(),
+                   RequirementsHandle handle = 1)
+{
+  remus::proto::JobRequirements reqs(ContentFormat::User,
+                                     MeshIOType(Edges(),Mesh2D()),
+                                     "", "");
+  reqs.tag(tag);
+  return QueuedJob(remus::testing::UUIDGenerator(), handle, reqs,
+                   remus::proto::FrameSet(), hashes);
+}
+
+std::vector<std::string> make_hashes(const std::string& a,
+                                     const std::string& b = std::string())
+{
+  std::vector<std::string> hashes;
+  hashes.push_back(a);
+  hashes.push_back(b);
+  return hashes;
+}
+
+//------------------------------------------------------------------------------
+void verify_keys()
+{
+  //blobs without a hash don't add to the affinity of a job
+  std::vector<std::string> keys =
+                          WorkerAffinity::keys(make_job(make_hashes("a")));
+  REMUS_ASSERT( (keys.size() == 1) )
+  REMUS_ASSERT( (keys[0] == "a") )
+
+  keys = WorkerAffinity::keys(make_job(make_hashes("a","b"), "mesh"));
+  REMUS_ASSERT( (keys.size() == 3) )
+  REMUS_ASSERT( (keys[2] == "tag:mesh") )
+
+  keys = WorkerAffinity::keys(make_job(std::vector<std::string>()));
+  REMUS_ASSERT( (keys.empty()) )
+}
+
+//------------------------------------------------------------------------------
+void verify_workers_for()
+{
+  WorkerAffinity affinity;
+  zmq::SocketIdentity first = make_socketId();
+  zmq::SocketIdentity second = make_socketId();
+
+  //nobody has affinity with a job before any jobs are sent
+  REMUS_ASSERT( (affinity.workersFor(make_job(make_hashes("a"))).empty()) )
+
+  affinity.jobAssigned(first, make_job(make_hashes("a")));
+  affinity.jobAssigned(second, make_job(make_hashes("a","b")));
+
+  //the worker sharing the most keys comes first
+  std::vector<zmq::SocketIdentity> workers =
+                        affinity.workersFor(make_job(make_hashes("a","b")));
+  REMUS_ASSERT( (workers.size() == 2) )
+  REMUS_ASSERT( (workers[0] == second) )
+  REMUS_ASSERT( (workers[1] == first) )
+
+  workers = affinity.workersFor(make_job(make_hashes("b")));
+  REMUS_ASSERT( (workers.size() == 1) )
+  REMUS_ASSERT( (workers[0] == second) )
+
+  REMUS_ASSERT( (affinity.workersFor(make_job(make_hashes("c"))).empty()) )
+
+  //jobs with the same tag have affinity without any hashes
+  affinity.jobAssigned(first, make_job(std::vector<std::string>(), "mesh"));
+  workers = affinity.workersFor(make_job(std::vector<std::string>(), "mesh"));
+  REMUS_ASSERT( (workers.size() == 1) )
+  REMUS_ASSERT( (workers[0] == first) )
+
+  //dead workers are forgotten
+  affinity.remove(second);
+  workers = affinity.workersFor(make_job(make_hashes("a","b")));
+  REMUS_ASSERT( (workers.size() == 1) )
+  REMUS_ASSERT( (workers[0] == first) )
+}
+
+//------------------------------------------------------------------------------
+void verify_keys_per_worker()
+{
+  //only the most recent keys of each worker are remembered
+  WorkerAffinity affinity(2);
+  zmq::SocketIdentity worker = make_socketId();
+
+  affinity.jobAssigned(worker, make_job(make_hashes("a")));
+  affinity.jobAssigned(worker, make_job(make_hashes("b")));
+  affinity.jobAssigned(worker, make_job(make_hashes("a")));
+  affinity.jobAssigned(worker, make_job(make_hashes("c")));
+
+  REMUS_ASSERT( (affinity.workersFor(make_job(make_hashes("a"))).size() == 1) )
+  REMUS_ASSERT( (affinity.workersFor(make_job(make_hashes("b"))).empty()) )
+  REMUS_ASSERT( (affinity.workersFor(make_job(make_hashes("c"))).size() == 1) )
+}
+
+//------------------------------------------------------------------------------
+void verify_defer()
+{
+  const WorkerAffinity::TimePoint start = MonotonicClock::now();
+  const boost::int64_t never = std::numeric_limits<boost::int64_t>::max();
+
+  //by default jobs are never deferred
+  WorkerAffinity affinity;
+  QueuedJob job = make_job(make_hashes("a"), "", 3);
+  REMUS_ASSERT( (affinity.maxWait() == 0) )
+  REMUS_ASSERT( (!affinity.deferJob(job, start)) )
+  REMUS_ASSERT( (!affinity.hasDeferredJobs()) )
+  REMUS_ASSERT( (affinity.timeUntilNextDeadline(start) == never) )
+
+  affinity.maxWait(100);
+  REMUS_ASSERT( (affinity.deferJob(job, start)) )
+  REMUS_ASSERT( (affinity.hasDeferredJobs()) )
+  REMUS_ASSERT( (affinity.timeUntilNextDeadline(start) > 0) )
+  REMUS_ASSERT( (affinity.timeUntilNextDeadline(start) <= 101) )
+
+  //deferring again doesn't restart the wait
+  const WorkerAffinity::TimePoint later =
+                                      start + MonotonicClock::milliseconds(50);
+  REMUS_ASSERT( (affinity.deferJob(job, later)) )
+  REMUS_ASSERT( (affinity.timeUntilNextDeadline(later) <= 51) )
+
+  std::set<RequirementsHandle> handles;
+  affinity.takeExpiredHandles(later, handles);
+  REMUS_ASSERT( (handles.empty()) )
+
+  //once the wait runs out the requirements of the job are rescheduled once
+  const WorkerAffinity::TimePoint expired =
+                                      start + MonotonicClock::milliseconds(100);
+  REMUS_ASSERT( (affinity.timeUntilNextDeadline(expired) == 0) )
+  affinity.takeExpiredHandles(expired, handles);
+  REMUS_ASSERT( (handles.size() == 1) )
+  REMUS_ASSERT( (handles.count(3) == 1) )
+  REMUS_ASSERT( (!affinity.deferJob(job, expired)) )
+  REMUS_ASSERT( (affinity.timeUntilNextDeadline(expired) == never) )
+
+  handles.clear();
+  affinity.takeExpiredHandles(expired, handles);
+  REMUS_ASSERT( (handles.empty()) )
+
+  //assigning the job stops it from waiting
+  affinity.jobAssigned(make_socketId(), job);
+  REMUS_ASSERT( (!affinity.hasDeferredJobs()) )
+
+  //as does removing it from the queue
+  QueuedJob other = make_job(make_hashes("b"));
+  REMUS_ASSERT( (affinity.deferJob(other, start)) )
+  affinity.forgetJob(other.id());
+  REMUS_ASSERT( (!affinity.hasDeferredJobs()) )
+}
+
+}
+
+int UnitTestWorkerAffinity(int, char *[])
+{
+  verify_keys();
+  verify_workers_for();
+  verify_keys_per_worker();
+  verify_defer();
+  return 0;
+}
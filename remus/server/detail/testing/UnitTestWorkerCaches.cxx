@@ -0,0 +1,99 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/server/detail/WorkerCaches.h>
+
+#include <remus/proto/zmqSocketIdentity.h>
+#include <remus/testing/Testing.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/lexical_cast.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+namespace
+{
+typedef remus::server::detail::WorkerCaches WorkerCaches;
+
+//makes a random socket identity
+zmq::SocketIdentity make_socketId()
+{
+  boost::uuids::uuid new_uid = remus::testing::UUIDGenerator();
+  const std::string str_id = boost::lexical_cast<std::string>(new_uid);
+  return zmq::SocketIdentity(str_id.c_str(),str_id.size());
+}
+
+//------------------------------------------------------------------------------
+void verify_update()
+{
+  WorkerCaches caches;
+  zmq::SocketIdentity worker = make_socketId();
+  zmq::SocketIdentity other = make_socketId();
+
+  //workers that haven't advertised don't have a cache
+  REMUS_ASSERT( (!caches.hasCache(worker)) )
+  REMUS_ASSERT( (!caches.holds(worker, "a")) )
+
+  //an empty advert still means the worker caches blobs
+  caches.update(worker, WorkerCaches::HashSet());
+  REMUS_ASSERT( (caches.hasCache(worker)) )
+  REMUS_ASSERT( (!caches.hasCache(other)) )
+  REMUS_ASSERT( (caches.size() == 1) )
+
+  WorkerCaches::HashSet hashes;
+  hashes.insert("a");
+  hashes.insert("b");
+  caches.update(worker, hashes);
+  REMUS_ASSERT( (caches.holds(worker, "a")) )
+  REMUS_ASSERT( (caches.holds(worker, "b")) )
+  REMUS_ASSERT( (!caches.holds(other, "a")) )
+
+  //adverts replace what the worker holds
+  hashes.erase("a");
+  hashes.insert("c");
+  caches.update(worker, hashes);
+  REMUS_ASSERT( (!caches.holds(worker, "a")) )
+  REMUS_ASSERT( (caches.holds(worker, "b")) )
+  REMUS_ASSERT( (caches.holds(worker, "c")) )
+}
+
+//------------------------------------------------------------------------------
+void verify_remove()
+{
+  WorkerCaches caches;
+  zmq::SocketIdentity worker = make_socketId();
+  zmq::SocketIdentity other = make_socketId();
+
+  WorkerCaches::HashSet hashes;
+  hashes.insert("a");
+  caches.update(worker, hashes);
+  caches.update(other, hashes);
+  REMUS_ASSERT( (caches.size() == 2) )
+
+  caches.remove(worker);
+  REMUS_ASSERT( (!caches.hasCache(worker)) )
+  REMUS_ASSERT( (!caches.holds(worker, "a")) )
+  REMUS_ASSERT( (caches.holds(other, "a")) )
+  REMUS_ASSERT( (caches.size() == 1) )
+
+  //removing a worker without a cache does nothing
+  caches.remove(worker);
+  REMUS_ASSERT( (caches.size() == 1) )
+}
+
+}
+
+int UnitTestWorkerCaches(int, char *[])
+{
+  verify_update();
+  verify_remove();
+  return 0;
+}
@@ -261,6 +261,163 @@ void verify_taking_works()
   }
 }
 
+void verify_round_robin()
+{
+  remus::server::detail::WorkerPool pool;
+
+  //each worker wants two jobs, and the workers should take jobs in turns
+  std::vector<zmq::SocketIdentity> workers;
+  for(int i=0; i < 3; ++i)
+    {
+    workers.push_back(make_socketId());
+    pool.addWorker(workers.back(), worker_type2D);
+    pool.addWorker(workers.back(), worker_type3D);
+    pool.readyForWork(workers.back(), worker_type2D);
+    pool.readyForWork(workers.back(), worker_type2D);
+    }
+  pool.readyForWork(workers[1], worker_type3D);
+
+  for(int round=0; round < 2; ++round)
+    {
+    for(std::size_t i=0; i < workers.size(); ++i)
+      {
+      REMUS_ASSERT( (pool.takeWorker(worker_type2D) == workers[i]) );
+      }
+    }
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == zmq::SocketIdentity()) );
+
+  //taking workers of one type doesn't change the other type
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type3D) == true) );
+  REMUS_ASSERT( (pool.allWorkersWantingWork().size() == 1) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type3D) == workers[1]) );
+
+  //a worker that becomes ready again goes to the back of the queue
+  pool.readyForWork(workers[2], worker_type2D);
+  pool.readyForWork(workers[0], worker_type2D);
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == workers[2]) );
+  REMUS_ASSERT( (pool.takeWorker(worker_type2D) == workers[0]) );
+  REMUS_ASSERT( (pool.allWorkers().size() == 3) );
+}
+
+void verify_dirty_types()
+{
+  typedef remus::server::detail::RequirementsHandle Handle;
+  boost::shared_ptr<remus::server::detail::RequirementsRegistry> registry(
+                          new remus::server::detail::RequirementsRegistry() );
+  remus::server::detail::WorkerPool pool(registry);
+  const Handle handle2D = registry->intern(worker_type2D);
+  const Handle handle3D = registry->intern(worker_type3D);
+
+  //registering doesn't make a type dirty, only being ready for work does
+  zmq::SocketIdentity first = make_socketId();
+  zmq::SocketIdentity second = make_socketId();
+  pool.addWorker(first, handle2D);
+  pool.addWorker(second, handle2D);
+  pool.addWorker(second, handle3D);
+  std::set<Handle> dirty;
+  pool.takeDirtyHandles(dirty);
+  REMUS_ASSERT( (dirty.size() == 0) );
+
+  pool.readyForWork(first, handle2D);
+  pool.readyForWork(second, handle3D);
+  pool.takeDirtyHandles(dirty);
+  REMUS_ASSERT( (dirty.size() == 2) );
+  REMUS_ASSERT( (dirty.count(handle2D) == 1) );
+  REMUS_ASSERT( (dirty.count(handle3D) == 1) );
+
+  //a type that already has a waiting worker doesn't become dirty again
+  dirty.clear();
+  pool.readyForWork(first, handle2D);
+  pool.readyForWork(second, handle2D);
+  pool.takeDirtyHandles(dirty);
+  REMUS_ASSERT( (dirty.size() == 0) );
+
+  //once every worker of a type has been taken, it becomes dirty when a
+  //worker is ready again
+  while(pool.haveWaitingWorker(handle2D))
+    {
+    pool.takeWorker(handle2D);
+    }
+  pool.takeDirtyHandles(dirty);
+  REMUS_ASSERT( (dirty.size() == 0) );
+  pool.readyForWork(second, handle2D);
+  pool.takeDirtyHandles(dirty);
+  REMUS_ASSERT( (dirty.size() == 1) );
+  REMUS_ASSERT( (dirty.count(handle2D) == 1) );
+}
+
+void verify_taking_a_given_worker()
+{
+  typedef remus::server::detail::RequirementsHandle Handle;
+  boost::shared_ptr<remus::server::detail::RequirementsRegistry> registry(
+                          new remus::server::detail::RequirementsRegistry() );
+  remus::server::detail::WorkerPool pool(registry);
+  const Handle handle2D = registry->intern(worker_type2D);
+  const Handle handle3D = registry->intern(worker_type3D);
+
+  zmq::SocketIdentity first = make_socketId();
+  zmq::SocketIdentity second = make_socketId();
+  pool.addWorker(first, handle2D);
+  pool.addWorker(second, handle2D);
+  pool.readyForWork(first, handle2D);
+  pool.readyForWork(second, handle2D);
+
+  //a worker can be taken out of order, and only while it is waiting
+  REMUS_ASSERT( (pool.isWaitingForWork(second, handle2D) == true) );
+  REMUS_ASSERT( (pool.takeWorker(second, handle3D) == false) );
+  REMUS_ASSERT( (pool.takeWorker(second, handle2D) == true) );
+  REMUS_ASSERT( (pool.isWaitingForWork(second, handle2D) == false) );
+  REMUS_ASSERT( (pool.takeWorker(second, handle2D) == false) );
+  REMUS_ASSERT( (pool.haveWorker(second, handle2D) == true) );
+
+  //the rest of the workers are still taken in order
+  REMUS_ASSERT( (pool.takeWorker(handle2D) == first) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(handle2D) == false) );
+  REMUS_ASSERT( (pool.takeWorker(make_socketId(), handle2D) == false) );
+}
+
+void verify_dead_workers_release_requirements()
+{
+  typedef remus::server::detail::RequirementsHandle Handle;
+  typedef remus::server::detail::RequirementsRegistry Registry;
+  boost::shared_ptr<Registry> registry( new Registry() );
+  remus::server::detail::WorkerPool pool(registry);
+  remus::server::detail::SocketMonitor monitor = make_Monitor( );
+
+  zmq::SocketIdentity first = make_socketId();
+  zmq::SocketIdentity second = make_socketId();
+  pool.addWorker(first, worker_type2D);
+  pool.addWorker(first, worker_type3D);
+  pool.addWorker(second, worker_type2D);
+  pool.readyForWork(first, worker_type2D);
+  pool.readyForWork(first, worker_type3D);
+  monitor.refresh(first);
+  monitor.refresh(second);
+  REMUS_ASSERT( (registry->size() == 2) );
+
+  //requirements stay around while any worker still supports them
+  monitor.markAsDead(first);
+  pool.purgeDeadWorkers(monitor);
+  REMUS_ASSERT( (pool.allWorkers().size() == 1) );
+  REMUS_ASSERT( (registry->size() == 1) );
+  REMUS_ASSERT( (registry->find(worker_type2D) != Registry::InvalidHandle) );
+  REMUS_ASSERT( (registry->find(worker_type3D) == Registry::InvalidHandle) );
+  REMUS_ASSERT( (pool.haveWaitingWorker(worker_type2D) == false) );
+
+  monitor.markAsDead(second);
+  pool.purgeDeadWorkers(monitor);
+  REMUS_ASSERT( (pool.allWorkers().size() == 0) );
+  REMUS_ASSERT( (registry->size() == 0) );
+
+  //a released handle that is handed out again starts without workers
+  const Handle handle = registry->intern(worker_type3D);
+  REMUS_ASSERT( (pool.haveWaitingWorker(handle) == false) );
+  std::set<Handle> dirty;
+  pool.takeDirtyHandles(dirty);
+  REMUS_ASSERT( (dirty.size() == 0) );
+}
+
 } //namespace
 
 int UnitTestWorkerPool(int, char *[])
@@ -273,5 +430,13 @@ int UnitTestWorkerPool(int, char *[])
 
   verify_taking_works();
 
+  verify_round_robin();
+
+  verify_dirty_types();
+
+  verify_taking_a_given_worker();
+
+  verify_dead_workers_release_requirements();
+
   return 0;
 }
@@ -0,0 +1,141 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/testing/Testing.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/date_time/posix_time/posix_time.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <remus/testing/integration/detail/Helpers.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+static std::size_t blob_size = 512;
+static std::size_t num_jobs = 20000;
+static std::size_t batch_sizes[] = { 1, 10, 100, 1000 };
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //no workers are ever launched, so every job stays queued
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission()
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Model(),Model());
+  JobRequirements reqs = make_JobRequirements(io_type, "PerfWorker", "");
+
+  JobSubmission sub(reqs);
+  const std::string binary_input = remus::testing::BinaryDataGenerator( blob_size );
+  sub["blob"] = JobContent(remus::common::ContentFormat::User, binary_input);
+  return sub;
+}
+
+//------------------------------------------------------------------------------
+void report(const std::string& name, boost::int64_t msecs)
+{
+  //avoid dividing by zero on really fast machines
+  msecs = std::max(msecs, boost::int64_t(1));
+  const boost::int64_t jobs_per_sec = (1000 * num_jobs) / msecs;
+  std::cout << name << ": " << num_jobs << " jobs in " << msecs
+            << " milliseconds, " << jobs_per_sec << " jobs/sec" << std::endl;
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t unbatched_submission(boost::shared_ptr<remus::Client> client,
+                                    const remus::proto::JobSubmission& sub)
+{
+  typedef boost::posix_time::ptime ptime;
+
+  const ptime startTime = boost::posix_time::microsec_clock::local_time();
+  for(std::size_t i=0; i < num_jobs; ++i)
+    {
+    REMUS_ASSERT( (client->submitJob(sub).valid()) );
+    }
+  const ptime endTime = boost::posix_time::microsec_clock::local_time();
+  return (endTime - startTime).total_milliseconds();
+}
+
+//------------------------------------------------------------------------------
+boost::int64_t batched_submission(boost::shared_ptr<remus::Client> client,
+                                  const remus::proto::JobSubmission& sub,
+                                  std::size_t batch_size)
+{
+  typedef boost::posix_time::ptime ptime;
+
+  const std::vector<remus::proto::JobSubmission> batch(batch_size, sub);
+
+  const ptime startTime = boost::posix_time::microsec_clock::local_time();
+  for(std::size_t i=0; i < num_jobs; i+=batch_size)
+    {
+    const std::vector<remus::proto::Job> jobs = client->submitJobs(batch);
+    REMUS_ASSERT( (jobs.size() == batch_size) );
+    REMUS_ASSERT( (jobs.back().valid()) );
+    }
+  const ptime endTime = boost::posix_time::microsec_clock::local_time();
+  return (endTime - startTime).total_milliseconds();
+}
+
+}
+
+//Compares the throughput of submitting jobs one request at a time against
+//submitting them in batches with the bulk client calls
+int main(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  remus::server::ServerPorts tcp_ports = remus::server::ServerPorts();
+  boost::shared_ptr<remus::Server> server = make_Server( tcp_ports );
+  tcp_ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = detail::make_Client( tcp_ports );
+  const remus::proto::JobSubmission sub = make_Submission();
+
+  report("Unbatched submitJob", unbatched_submission(client, sub));
+
+  const std::size_t num_sizes = sizeof(batch_sizes) / sizeof(std::size_t);
+  for(std::size_t i=0; i < num_sizes; ++i)
+    {
+    std::ostringstream name;
+    name << "Batched submitJobs (batch size " << batch_sizes[i] << ")";
+    report(name.str(), batched_submission(client, sub, batch_sizes[i]));
+    }
+
+  server->stopBrokering();
+  return 0;
+}
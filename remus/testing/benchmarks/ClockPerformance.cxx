@@ -0,0 +1,138 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/common/MonotonicClock.h>
+#include <remus/common/PollingMonitor.h>
+
+#include <remus/testing/Testing.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/date_time/posix_time/posix_time.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <iostream>
+
+namespace
+{
+typedef remus::common::MonotonicClock MonotonicClock;
+
+static std::size_t num_iterations = 10000000;
+
+//keeps the compiler from removing the loops we are timing
+static volatile boost::int64_t sink = 0;
+
+//------------------------------------------------------------------------------
+void report(const std::string& name, MonotonicClock::TimePoint dur)
+{
+  //report nanoseconds per iteration, time points are in microseconds
+  const double ns_per_iteration = (1000.0 * static_cast<double>(dur)) /
+                                  static_cast<double>(num_iterations);
+  std::cout << name << ": " << ns_per_iteration << " ns per iteration"
+            << std::endl;
+}
+
+//------------------------------------------------------------------------------
+//The time keeping the brokering loop used to do each iteration. The polling
+//monitor read local time once when the poll finished, and the loop read it
+//again to decide if it was time to check on the workers.
+MonotonicClock::TimePoint local_time_iterations()
+{
+  typedef boost::posix_time::ptime ptime;
+  const boost::posix_time::milliseconds interval(250);
+
+  ptime whenToCheck = boost::posix_time::microsec_clock::local_time() + interval;
+  boost::int64_t checks = 0;
+
+  const MonotonicClock::TimePoint start = MonotonicClock::now();
+  for(std::size_t i=0; i < num_iterations; ++i)
+    {
+    const ptime polled = boost::posix_time::microsec_clock::local_time();
+    const ptime current = boost::posix_time::microsec_clock::local_time();
+    if(whenToCheck <= current)
+      {
+      ++checks;
+      whenToCheck = polled + interval;
+      }
+    }
+  const MonotonicClock::TimePoint end = MonotonicClock::now();
+
+  sink = checks;
+  return end - start;
+}
+
+//------------------------------------------------------------------------------
+//The time keeping the brokering loop does now. The clock is read once when
+//the poll finishes, and that cached reading is used for the rest of the
+//iteration.
+MonotonicClock::TimePoint monotonic_iterations()
+{
+  const MonotonicClock::TimePoint interval = MonotonicClock::milliseconds(250);
+
+  MonotonicClock::TimePoint whenToCheck = MonotonicClock::now() + interval;
+  boost::int64_t checks = 0;
+
+  const MonotonicClock::TimePoint start = MonotonicClock::now();
+  for(std::size_t i=0; i < num_iterations; ++i)
+    {
+    const MonotonicClock::TimePoint current = MonotonicClock::now();
+    if(whenToCheck <= current)
+      {
+      ++checks;
+      whenToCheck = current + interval;
+      }
+    }
+  const MonotonicClock::TimePoint end = MonotonicClock::now();
+
+  sink = checks;
+  return end - start;
+}
+
+//------------------------------------------------------------------------------
+//The full cost of a polling monitor update, which is what the brokering
+//and worker loops pay each iteration.
+MonotonicClock::TimePoint polling_monitor_iterations()
+{
+  remus::common::PollingMonitor monitor(25,60000);
+  boost::int64_t checks = 0;
+
+  const MonotonicClock::TimePoint start = MonotonicClock::now();
+  for(std::size_t i=0; i < num_iterations; ++i)
+    {
+    monitor.pollOccurred();
+    checks += monitor.lastPollTime() & 1;
+    }
+  const MonotonicClock::TimePoint end = MonotonicClock::now();
+
+  sink = checks;
+  return end - start;
+}
+
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  const MonotonicClock::TimePoint before = local_time_iterations();
+  const MonotonicClock::TimePoint after = monotonic_iterations();
+  const MonotonicClock::TimePoint monitor = polling_monitor_iterations();
+
+  report("local_time read twice (before)", before);
+  report("steady clock read once (after)", after);
+  report("PollingMonitor::pollOccurred", monitor);
+
+  //the steady clock read once per iteration should never cost more than
+  //reading local time twice
+  REMUS_ASSERT( (after <= before) );
+  return 0;
+}
@@ -0,0 +1,105 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/common/ContentHash.h>
+#include <remus/common/MD5Hash.h>
+#include <remus/common/MonotonicClock.h>
+
+#include <remus/testing/Testing.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+typedef remus::common::MonotonicClock MonotonicClock;
+typedef std::string (*HashFunction)(const char*, std::size_t);
+
+//every size is hashed until at least this many bytes have been hashed
+static const std::size_t bytes_per_size = 256 * 1024 * 1024;
+
+//keeps the compiler from removing the loops we are timing
+static volatile std::size_t sink = 0;
+
+//------------------------------------------------------------------------------
+std::string md5_hash(const char* data, std::size_t length)
+{
+  return remus::common::MD5Hash(data, length);
+}
+
+//------------------------------------------------------------------------------
+std::string content_hash(const char* data, std::size_t length)
+{
+  return remus::common::ContentHash(data, length);
+}
+
+//------------------------------------------------------------------------------
+//returns the throughput in megabytes per second of hashing the first size
+//bytes of the data
+double time_hash(HashFunction hash, const std::vector<char>& data,
+                 std::size_t size)
+{
+  const std::size_t iterations = std::max<std::size_t>(bytes_per_size / size, 1);
+
+  const MonotonicClock::TimePoint start = MonotonicClock::now();
+  for(std::size_t i=0; i < iterations; ++i)
+    {
+    sink = sink + hash(&data[0], size)[0];
+    }
+  const MonotonicClock::TimePoint end = MonotonicClock::now();
+
+  //time points are in microseconds, which makes bytes per microsecond
+  //the same as megabytes per second
+  const double elapsed = static_cast<double>(
+                          std::max<MonotonicClock::TimePoint>(end - start, 1));
+  return static_cast<double>(size) * static_cast<double>(iterations) / elapsed;
+}
+
+//------------------------------------------------------------------------------
+void report(std::size_t size, double md5, double content)
+{
+  std::cout << size / 1024 << " KB: MD5Hash " << md5 << " MB/s, ContentHash "
+            << content << " MB/s, " << content / md5 << "x" << std::endl;
+}
+
+}
+
+//------------------------------------------------------------------------------
+//Compares MD5Hash and ContentHash from 4KB to 1GB. The largest size can be
+//lowered by passing it in megabytes, for machines without the memory
+int main(int argc, char* argv[])
+{
+  std::size_t max_size = 1024 * 1024 * 1024;
+  if(argc > 1)
+    {
+    max_size = static_cast<std::size_t>(std::atol(argv[1])) * 1024 * 1024;
+    }
+
+  //random data is slow to generate, so repeat a megabyte of it
+  const std::string pattern = remus::testing::BinaryDataGenerator(1024*1024);
+  std::vector<char> data(max_size);
+  for(std::size_t i=0; i < max_size; i += pattern.size())
+    {
+    const std::size_t len = std::min(pattern.size(), max_size - i);
+    std::copy(pattern.begin(), pattern.begin() + len, data.begin() + i);
+    }
+
+  for(std::size_t size = 4 * 1024; size < max_size; size *= 16)
+    {
+    report(size, time_hash(md5_hash, data, size),
+                 time_hash(content_hash, data, size));
+    }
+  report(max_size, time_hash(md5_hash, data, max_size),
+                   time_hash(content_hash, data, max_size));
+  return 0;
+}
@@ -17,6 +17,7 @@
 #include <remus/server/Server.h>
 #include <remus/worker/Worker.h>
 
+#include <remus/common/SleepFor.h>
 #include <remus/testing/Testing.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
@@ -36,6 +37,11 @@ namespace
 static std::size_t blob_size = 512;
 static std::size_t num_messages = 100000;
 
+//the jobs used to measure how long a worker waits on its next job
+static std::size_t prefetch_blob_size = 256 * 1024;
+static std::size_t num_prefetch_jobs = 200;
+static unsigned int prefetch_depth = 2;
+
 //------------------------------------------------------------------------------
 boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
 {
@@ -61,7 +67,8 @@ boost::shared_ptr<remus::Worker> make_Worker( const remus::server::ServerPorts&
 }
 
 //------------------------------------------------------------------------------
-remus::proto::Job submit_Job(boost::shared_ptr<remus::Client> client)
+remus::proto::Job submit_Job(boost::shared_ptr<remus::Client> client,
+                             std::size_t size)
 {
   using namespace remus::meshtypes;
   using namespace remus::proto;
@@ -71,7 +78,7 @@ remus::proto::Job submit_Job(boost::shared_ptr<remus::Client> client)
 
   JobSubmission sub(reqs);
 
-  const std::string binary_input = remus::testing::BinaryDataGenerator( blob_size );
+  const std::string binary_input = remus::testing::BinaryDataGenerator( size );
   sub["blob"] = JobContent(remus::common::ContentFormat::User, binary_input);
 
   remus::proto::Job job = client->submitJob(sub);
@@ -152,7 +159,60 @@ void worker_transfer_performance( boost::shared_ptr< remus::Worker > worker)
 #endif
 }
 
+//------------------------------------------------------------------------------
+//returns the total time in microseconds that the worker spent waiting
+//on its next job, while processing num_prefetch_jobs jobs
+boost::int64_t worker_idle_time( const remus::server::ServerPorts& ports,
+                                 boost::shared_ptr<remus::Client> client,
+                                 unsigned int depth )
+{
+  typedef boost::posix_time::ptime ptime;
+
+  for( std::size_t i=0; i < num_prefetch_jobs; ++i)
+    {
+    submit_Job(client, prefetch_blob_size);
+    }
+
+  boost::shared_ptr<remus::Worker> worker = make_Worker( ports );
+  worker->prefetchDepth(depth);
+
+  boost::int64_t idle_usec = 0;
+  for( std::size_t i=0; i < num_prefetch_jobs; ++i)
+    {
+    const ptime startTime = boost::posix_time::microsec_clock::local_time();
+    remus::worker::Job wjob = worker->getJob();
+    const ptime endTime = boost::posix_time::microsec_clock::local_time();
+    idle_usec += (endTime - startTime).total_microseconds();
+
+    REMUS_ASSERT( (wjob.valid()) )
 
+    //pretend to mesh, which is when the next jobs are fetched
+    remus::common::SleepForMillisec(2);
+    worker->returnResult( remus::proto::JobResult(wjob.id()) );
+    }
+  return idle_usec;
+}
+
+//------------------------------------------------------------------------------
+void worker_prefetch_performance( const remus::server::ServerPorts& ports,
+                                  boost::shared_ptr<remus::Client> client )
+{
+  const boost::int64_t idle = worker_idle_time(ports, client, 0);
+  const boost::int64_t prefetched_idle =
+                        worker_idle_time(ports, client, prefetch_depth);
+
+  const boost::int64_t jobs = static_cast<boost::int64_t>(num_prefetch_jobs);
+  std::cout << "Average idle gap between jobs of " << prefetch_blob_size
+            << " bytes without prefetch " << (idle / jobs) << " usec" << std::endl;
+  std::cout << "Average idle gap between jobs of " << prefetch_blob_size
+            << " bytes with a prefetch depth of " << prefetch_depth << " "
+            << (prefetched_idle / jobs) << " usec" << std::endl;
+  if(idle > 0)
+    {
+    std::cout << "Idle gap reduction "
+              << (100 * (idle - prefetched_idle) / idle) << "%" << std::endl;
+    }
+}
 
 }
 
@@ -171,11 +231,15 @@ int main(int argc, char* argv[])
 
   //submit a job, with a random binary blob. this is what the worker
   //will use as status
-  submit_Job(client);
+  submit_Job(client, blob_size);
 
   //INVALIDATES the worker shared_ptr!!!!!
   worker_transfer_performance(worker);
 
+  //measure how long workers wait between jobs, with and without
+  //fetching jobs ahead
+  worker_prefetch_performance(tcp_ports, client);
+
 
   return 0;
 }
@@ -0,0 +1,182 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/AsyncClient.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+static const std::size_t num_requests = 500;
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create a server with a factory that can launch no workers, so every
+  //job stays queued. The client router answers status queries on its own
+  //thread, so the responses arrive in a different order than the requests
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  server->threadingMode(remus::Server::MULTI_THREADED);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::AsyncClient> make_AsyncClient(
+                                    const remus::server::ServerPorts& ports)
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  boost::shared_ptr<remus::AsyncClient> c(new remus::client::AsyncClient(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission(std::size_t i)
+{
+  using namespace remus::proto;
+  remus::common::MeshIOType io_type("Model","Async");
+  JobSubmission sub( make_JobRequirements(io_type, "AsyncWorker", "") );
+  sub["data"] = make_JobContent(remus::testing::AsciiStringGenerator(16+i));
+  return sub;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job>
+verify_pipelined_submissions(boost::shared_ptr<remus::AsyncClient> client)
+{
+  using namespace remus::proto;
+
+  //queue every submission before waiting on any of them
+  std::vector< std::future<Job> > futures;
+  for(std::size_t i=0; i < num_requests; ++i)
+    {
+    futures.push_back( client->submitJob(make_Submission(i)) );
+    }
+
+  std::vector<Job> jobs;
+  for(std::size_t i=0; i < futures.size(); ++i)
+    {
+    jobs.push_back( futures[i].get() );
+    REMUS_ASSERT( (jobs[i].valid()) );
+    for(std::size_t j=0; j < i; ++j)
+      {
+      REMUS_ASSERT( (jobs[i].id() != jobs[j].id()) );
+      }
+    }
+  REMUS_ASSERT( (client->pendingRequestCount() == 0) );
+  return jobs;
+}
+
+//------------------------------------------------------------------------------
+void verify_mixed_requests(boost::shared_ptr<remus::AsyncClient> client,
+                           const std::vector<remus::proto::Job>& jobs)
+{
+  using namespace remus::proto;
+
+  //the status queries are answered before the submissions that were
+  //requested ahead of them, which only works when the responses are
+  //matched to their request
+  std::vector< std::future<Job> > submitted;
+  std::vector< std::future<JobStatus> > statuses;
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    submitted.push_back( client->submitJob(make_Submission(i)) );
+    statuses.push_back( client->jobStatus(jobs[i]) );
+    }
+  std::future<bool> canMesh = client->canMesh(jobs[0].type());
+
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    const JobStatus status = statuses[i].get();
+    REMUS_ASSERT( (status.id() == jobs[i].id()) );
+    REMUS_ASSERT( (status.status() == remus::QUEUED) );
+    REMUS_ASSERT( (submitted[i].get().valid()) );
+    }
+  REMUS_ASSERT( (canMesh.get() == false) );
+}
+
+//------------------------------------------------------------------------------
+void verify_shared_between_threads(boost::shared_ptr<remus::AsyncClient> client,
+                                   const std::vector<remus::proto::Job>& jobs)
+{
+  using namespace remus::proto;
+
+  //every thread terminates its own share of the jobs with callbacks
+  std::atomic<std::size_t> terminated(0);
+  std::vector<std::thread> threads;
+  const std::size_t num_threads = 4;
+  for(std::size_t t=0; t < num_threads; ++t)
+    {
+    threads.push_back( std::thread([&, t]()
+      {
+      for(std::size_t i=t; i < jobs.size(); i+=num_threads)
+        {
+        const boost::uuids::uuid id = jobs[i].id();
+        client->terminate(jobs[i], [&terminated, id](const JobStatus& s)
+          {
+          if(s.id() == id && s.status() == remus::FAILED) { ++terminated; }
+          });
+        }
+      }) );
+    }
+  for(std::size_t t=0; t < threads.size(); ++t)
+    {
+    threads[t].join();
+    }
+
+  for(int tries=0; tries < 100 && client->pendingRequestCount() > 0; ++tries)
+    {
+    remus::common::SleepForMillisec(50);
+    }
+  REMUS_ASSERT( (client->pendingRequestCount() == 0) );
+  REMUS_ASSERT( (terminated == jobs.size()) );
+}
+
+}
+
+//Pipelines many requests on a single connection with the async client
+int AsyncClientPipelining(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  boost::shared_ptr<remus::AsyncClient> client =
+                              make_AsyncClient( server->serverPortInfo() );
+
+  std::vector<remus::proto::Job> jobs = verify_pipelined_submissions(client);
+  verify_mixed_requests(client, jobs);
+  verify_shared_between_threads(client, jobs);
+
+  client.reset();
+  server->stopBrokering();
+  REMUS_ASSERT( (server->isBrokering() == false) );
+  return 0;
+}
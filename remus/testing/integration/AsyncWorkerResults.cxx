@@ -0,0 +1,165 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+#include <future>
+#include <vector>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  //setup a slower polling cycle so we don't kill a worker by mistake
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job submit_Job(boost::shared_ptr<remus::Client> client,
+                             const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+  JobSubmission sub( make_JobRequirements(io_type, "AsyncResultWorker", "") );
+  sub["data"] = make_JobContent("upload me");
+
+  Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() )
+  return job;
+}
+
+//------------------------------------------------------------------------------
+remus::worker::Job take_Job(boost::shared_ptr<remus::Worker> worker)
+{
+  worker->askForJobs(1);
+  while(worker->pendingJobCount() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    }
+  remus::worker::Job job = worker->takePendingJob();
+  REMUS_ASSERT( job.valid() )
+  return job;
+}
+
+//------------------------------------------------------------------------------
+std::string make_ResultData(std::size_t index)
+{
+  //large enough that the upload isn't instant
+  std::string data(1024*1024, 'a');
+  data[0] = static_cast<char>('0' + index);
+  return data;
+}
+
+//------------------------------------------------------------------------------
+void verify_async_results(boost::shared_ptr<remus::Client> client,
+                          boost::shared_ptr<remus::Worker> worker,
+                          const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+  const std::size_t numJobs = 4;
+
+  std::vector<Job> jobs;
+  for(std::size_t i=0; i < numJobs; ++i)
+    {
+    jobs.push_back( submit_Job(client, io_type) );
+    }
+
+  //return every result without waiting on the server, with a blocking
+  //result in the middle to verify the acknowledgements aren't mixed up
+  std::vector< std::future<bool> > sent;
+  for(std::size_t i=0; i < numJobs; ++i)
+    {
+    remus::worker::Job workerJob = take_Job(worker);
+    REMUS_ASSERT( (workerJob.id() == jobs[i].id()) )
+
+    JobResult result = make_JobResult(workerJob.id(), make_ResultData(i));
+    if(i == 2)
+      {
+      worker->returnResult(result);
+      }
+    else
+      {
+      sent.push_back( worker->returnResultAsync(result) );
+      }
+    }
+
+  worker->flushResults();
+  REMUS_ASSERT( (worker->pendingResultCount() == 0) )
+  for(std::size_t i=0; i < sent.size(); ++i)
+    {
+    REMUS_ASSERT( (sent[i].get() == true) )
+    }
+
+  for(std::size_t i=0; i < numJobs; ++i)
+    {
+    REMUS_ASSERT( (client->jobStatus(jobs[i]).finished()) )
+    JobResult result = client->retrieveResults(jobs[i]);
+    REMUS_ASSERT( (std::string(result.data(), result.dataSize()) ==
+                   make_ResultData(i)) )
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_flush_without_results(boost::shared_ptr<remus::Worker> worker)
+{
+  //flushing with nothing outstanding returns right away
+  REMUS_ASSERT( (worker->pendingResultCount() == 0) )
+  worker->flushResults();
+  REMUS_ASSERT( (worker->pendingResultCount() == 0) )
+}
+
+}
+
+//Verifies that workers can return results without blocking on the server
+//receiving them, and still know when the server has them
+int AsyncWorkerResults(int argc, char* argv[])
+{
+  using namespace remus::meshtypes;
+
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  boost::shared_ptr<remus::Client> client = detail::make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = detail::make_Worker( ports, io_type, "AsyncResultWorker" );
+
+  verify_flush_without_results(worker);
+  verify_async_results(client, worker, io_type);
+
+  server->stopBrokering();
+  REMUS_ASSERT( (server->isBrokering() == false) );
+  return 0;
+}
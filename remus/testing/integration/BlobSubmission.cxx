@@ -0,0 +1,156 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+#include <string>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  //setup a slower polling cycle so we don't kill a worker by mistake
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission(const remus::common::MeshIOType& io_type,
+                                            const remus::proto::JobContent& model,
+                                            const std::string& attributes)
+{
+  using namespace remus::proto;
+  JobSubmission sub( make_JobRequirements(io_type, "BlobWorker", "") );
+  sub["model"] = model;
+  sub["attributes"] = make_JobContent(attributes);
+  return sub;
+}
+
+//------------------------------------------------------------------------------
+void verify_job(boost::shared_ptr<remus::Worker> worker,
+                const remus::proto::Job& job,
+                const std::string& model,
+                const std::string& attributes)
+{
+  worker->askForJobs(1);
+  while(worker->pendingJobCount() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    }
+  remus::worker::Job workerJob = worker->takePendingJob();
+  REMUS_ASSERT( (workerJob.id() == job.id()) )
+
+  //the worker gets the contents, no matter if they were sent or taken
+  //from the blob store of the server
+  remus::proto::JobContent content;
+  REMUS_ASSERT( (workerJob.details("model", content)) )
+  REMUS_ASSERT( (std::string(content.data(), content.dataSize()) == model) )
+  REMUS_ASSERT( (workerJob.details("attributes") == attributes) )
+
+  worker->returnResult( remus::proto::make_JobResult(workerJob.id(), "done") );
+}
+
+//------------------------------------------------------------------------------
+void verify_resubmitted_model(boost::shared_ptr<remus::Client> client,
+                              boost::shared_ptr<remus::Worker> worker,
+                              const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //the model is large enough to be stored by the server, and each
+  //submission only changes the attributes
+  const std::string modelData = remus::testing::BinaryDataGenerator(1024*1024);
+  const JobContent model = make_JobContent(modelData);
+
+  for(int i=0; i < 3; ++i)
+    {
+    const std::string attributes = "attributes " + std::string(1, '0' + i);
+    Job job = client->submitJob( make_Submission(io_type, model, attributes) );
+    REMUS_ASSERT( job.valid() )
+    verify_job(worker, job, modelData, attributes);
+    }
+
+  //equal contents that are a different object are found by their hash
+  const JobContent copy = make_JobContent(modelData);
+  Job job = client->submitJob( make_Submission(io_type, copy, "copy") );
+  REMUS_ASSERT( job.valid() )
+  verify_job(worker, job, modelData, "copy");
+}
+
+//------------------------------------------------------------------------------
+void verify_small_store(boost::shared_ptr<remus::Server> server,
+                        boost::shared_ptr<remus::Client> client,
+                        boost::shared_ptr<remus::Worker> worker,
+                        const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //contents that don't fit in the store are sent every time
+  server->blobStoreSize(64*1024);
+  REMUS_ASSERT( (server->blobStoreSize() == 64*1024) )
+
+  const std::string modelData = remus::testing::BinaryDataGenerator(512*1024);
+  const JobContent model = make_JobContent(modelData);
+  for(int i=0; i < 2; ++i)
+    {
+    Job job = client->submitJob( make_Submission(io_type, model, "small") );
+    REMUS_ASSERT( job.valid() )
+    verify_job(worker, job, modelData, "small");
+    }
+}
+
+}
+
+//Verifies that large contents that the server already has are referenced
+//by their hash instead of being sent again
+int BlobSubmission(int argc, char* argv[])
+{
+  using namespace remus::meshtypes;
+
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  boost::shared_ptr<remus::Client> client = detail::make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = detail::make_Worker( ports, io_type, "BlobWorker" );
+
+  verify_resubmitted_model(client, worker, io_type);
+  verify_small_store(server, client, worker, io_type);
+
+  server->stopBrokering();
+  REMUS_ASSERT( (server->isBrokering() == false) );
+  return 0;
+}
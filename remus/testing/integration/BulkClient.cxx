@@ -0,0 +1,213 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+#include <vector>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create a server with a factory that can launch no workers, so we have
+  //to use workers that connect in
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+
+  //setup a slower polling cycle so we don't kill a worker by mistake
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::JobSubmission>
+make_Submissions(const std::vector<remus::common::MeshIOType>& types,
+                 std::size_t count)
+{
+  using namespace remus::proto;
+
+  //interleave the mesh types, so that the client has to put the results
+  //of the different batches back in the order of the submissions
+  std::vector<JobSubmission> submissions;
+  for(std::size_t i=0; i < count; ++i)
+    {
+    const remus::common::MeshIOType& io_type = types[i % types.size()];
+    JobSubmission sub( make_JobRequirements(io_type, "BulkWorker", "") );
+    sub["data"] = make_JobContent(remus::testing::AsciiStringGenerator(64+i));
+    submissions.push_back(sub);
+    }
+  return submissions;
+}
+
+//------------------------------------------------------------------------------
+void verify_empty_calls(boost::shared_ptr<remus::Client> client)
+{
+  const std::vector<remus::proto::Job> jobs =
+        client->submitJobs(std::vector<remus::proto::JobSubmission>());
+  REMUS_ASSERT( (jobs.empty()) );
+  REMUS_ASSERT( (client->jobStatuses(jobs).empty()) );
+  REMUS_ASSERT( (client->retrieveResults(jobs).empty()) );
+  REMUS_ASSERT( (client->terminate(jobs).empty()) );
+}
+
+//------------------------------------------------------------------------------
+std::vector<remus::proto::Job>
+verify_submit_jobs(boost::shared_ptr<remus::Client> client,
+                   const std::vector<remus::proto::JobSubmission>& submissions)
+{
+  using namespace remus::proto;
+
+  std::vector<Job> jobs = client->submitJobs(submissions);
+  REMUS_ASSERT( (jobs.size() == submissions.size()) );
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    REMUS_ASSERT( (jobs[i].valid()) );
+    REMUS_ASSERT( (jobs[i].type() == submissions[i].type()) );
+    for(std::size_t j=0; j < i; ++j)
+      {
+      REMUS_ASSERT( (jobs[i].id() != jobs[j].id()) );
+      }
+    }
+
+  //no worker is asking for jobs, so all of them are queued
+  std::vector<JobStatus> statuses = client->jobStatuses(jobs);
+  REMUS_ASSERT( (statuses.size() == jobs.size()) );
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    REMUS_ASSERT( (statuses[i].id() == jobs[i].id()) );
+    REMUS_ASSERT( (statuses[i].status() == remus::QUEUED) );
+    }
+  return jobs;
+}
+
+//------------------------------------------------------------------------------
+void verify_retrieve_results(boost::shared_ptr<remus::Client> client,
+                             const std::vector< boost::shared_ptr<remus::Worker> >& workers,
+                             const std::vector<remus::proto::Job>& jobs,
+                             const std::vector<remus::proto::JobSubmission>& submissions)
+{
+  using namespace remus::proto;
+
+  //run every job, returning the submission data as the result
+  for(std::size_t i=0; i < workers.size(); ++i)
+    {
+    for(std::size_t j=i; j < jobs.size(); j+=workers.size())
+      {
+      remus::worker::Job workerJob = workers[i]->getJob();
+      REMUS_ASSERT( (workerJob.valid()) );
+      REMUS_ASSERT( (workerJob.id() == jobs[j].id()) );
+      const JobContent& content = workerJob.submission().find("data")->second;
+      const std::string data(content.data(), content.dataSize());
+      workers[i]->returnResult( make_JobResult(workerJob.id(), data) );
+      }
+    }
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    detail::verify_job_status(jobs[i],client,remus::FINISHED);
+    }
+
+  std::vector<JobResult> results = client->retrieveResults(jobs);
+  REMUS_ASSERT( (results.size() == jobs.size()) );
+  for(std::size_t i=0; i < results.size(); ++i)
+    {
+    const JobContent& content = submissions[i].find("data")->second;
+    REMUS_ASSERT( (results[i].valid()) );
+    REMUS_ASSERT( (results[i].id() == jobs[i].id()) );
+    REMUS_ASSERT( (std::string(results[i].data(),results[i].dataSize()) ==
+                   std::string(content.data(), content.dataSize())) );
+    }
+
+  //the results have been removed from the server
+  std::vector<JobStatus> statuses = client->jobStatuses(jobs);
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    REMUS_ASSERT( (statuses[i].status() == remus::INVALID_STATUS) );
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_terminate_jobs(boost::shared_ptr<remus::Client> client,
+                           const std::vector<remus::proto::JobSubmission>& submissions)
+{
+  using namespace remus::proto;
+
+  std::vector<Job> jobs = client->submitJobs(submissions);
+  std::vector<JobStatus> statuses = client->terminate(jobs);
+  REMUS_ASSERT( (statuses.size() == jobs.size()) );
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    REMUS_ASSERT( (statuses[i].id() == jobs[i].id()) );
+    REMUS_ASSERT( (statuses[i].status() == remus::FAILED) );
+    }
+
+  //terminating the jobs again fails, as they no longer exist
+  statuses = client->terminate(jobs);
+  for(std::size_t i=0; i < statuses.size(); ++i)
+    {
+    REMUS_ASSERT( (statuses[i].status() == remus::INVALID_STATUS) );
+    }
+}
+
+}
+
+//Submits, queries, retrieves and terminates many jobs with the bulk
+//client calls, which send a request per mesh type instead of per job
+int BulkClient(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = detail::make_Client( ports );
+
+  std::vector<remus::common::MeshIOType> types;
+  types.push_back( remus::common::MeshIOType("Model","BulkA") );
+  types.push_back( remus::common::MeshIOType("Model","BulkB") );
+
+  typedef boost::shared_ptr<remus::Worker> WorkerHandle;
+  std::vector< WorkerHandle > workers;
+  for(std::size_t i=0; i < types.size(); ++i)
+    {
+    workers.push_back( detail::make_Worker( ports, types[i], "BulkWorker" ) );
+    }
+  remus::common::SleepForMillisec(250);
+
+  const std::vector<remus::proto::JobSubmission> submissions =
+                                              make_Submissions(types, 10);
+
+  verify_empty_calls(client);
+  std::vector<remus::proto::Job> jobs = verify_submit_jobs(client, submissions);
+  verify_retrieve_results(client, workers, jobs, submissions);
+  verify_terminate_jobs(client, submissions);
+
+  server->stopBrokering();
+  REMUS_ASSERT( (server->isBrokering() == false) );
+  return 0;
+}
@@ -0,0 +1,158 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/ConcurrentWorker.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+static const std::size_t num_threads = 4;
+static const std::size_t num_jobs = 12;
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  //setup a slower polling cycle so we don't kill a worker by mistake
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::ConcurrentWorker> make_ConcurrentWorker(
+                                  const remus::server::ServerPorts& ports,
+                                  const remus::common::MeshIOType& io_type)
+{
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+
+  remus::proto::JobRequirements requirements =
+        remus::proto::make_JobRequirements(io_type, "ConcurrentWorker", "");
+  boost::shared_ptr<remus::ConcurrentWorker> w(
+        new remus::ConcurrentWorker(requirements, conn, num_threads));
+  return w;
+}
+
+//------------------------------------------------------------------------------
+//the generated data is random, so it is returned in payloads for the results
+//to be compared against
+std::vector<remus::proto::Job> submit_Jobs(boost::shared_ptr<remus::Client> client,
+                                           const remus::common::MeshIOType& io_type,
+                                           std::vector<std::string>& payloads)
+{
+  using namespace remus::proto;
+
+  std::vector<Job> jobs;
+  for(std::size_t i=0; i < num_jobs; ++i)
+    {
+    JobSubmission sub( make_JobRequirements(io_type, "ConcurrentWorker", "") );
+    payloads.push_back( remus::testing::AsciiStringGenerator(16+i) );
+    sub["data"] = make_JobContent(payloads.back());
+    jobs.push_back( client->submitJob(sub) );
+    REMUS_ASSERT( (jobs.back().valid()) )
+    }
+  return jobs;
+}
+
+}
+
+//Verifies that a concurrent worker processes multiple jobs at the same time
+//and sends the results of every thread over its single connection
+int ConcurrentWorkerJobs(int argc, char* argv[])
+{
+  using namespace remus::meshtypes;
+  using namespace remus::proto;
+
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  boost::shared_ptr<remus::Client> client = detail::make_Client( ports );
+  boost::shared_ptr<remus::ConcurrentWorker> worker = make_ConcurrentWorker( ports, io_type );
+  REMUS_ASSERT( (worker->numberOfThreads() == num_threads) )
+
+  std::vector<std::string> payloads;
+  std::vector<Job> jobs = submit_Jobs(client, io_type, payloads);
+
+  //each job echos its data back as the result, after sleeping long enough
+  //that the jobs overlap
+  std::atomic<std::size_t> running(0);
+  std::atomic<std::size_t> most_running(0);
+  remus::ConcurrentWorker::JobFunction echo =
+    [&running, &most_running](const remus::worker::Job& job,
+                              remus::ConcurrentWorker& w)
+    {
+    const std::size_t now_running = ++running;
+    std::size_t most = most_running;
+    while(now_running > most &&
+          !most_running.compare_exchange_weak(most, now_running)) {}
+
+    w.sendProgress(job, 50, "echoing");
+    remus::common::SleepForMillisec(250);
+
+    const std::string data = job.details("data");
+    --running;
+    w.returnResult( make_JobResult(job.id(), data) );
+    };
+
+  std::size_t processed = 0;
+  std::thread processor([&]() { processed = worker->process(echo, num_jobs); });
+
+  for(std::size_t i=0; i < jobs.size(); ++i)
+    {
+    JobStatus status = client->waitForJob(jobs[i], 30000);
+    REMUS_ASSERT( (status.finished()) )
+
+    JobResult result = client->retrieveResults(jobs[i]);
+    const std::string data(result.data(), result.dataSize());
+    REMUS_ASSERT( (data == payloads[i]) )
+    }
+
+  processor.join();
+  REMUS_ASSERT( (processed == num_jobs) )
+  REMUS_ASSERT( (worker->activeJobCount() == 0) )
+
+  //the jobs overlapped, but never more than the number of threads
+  REMUS_ASSERT( (most_running > 1) )
+  REMUS_ASSERT( (most_running <= num_threads) )
+
+  worker.reset();
+  server->stopBrokering();
+  REMUS_ASSERT( (server->isBrokering() == false) );
+  return 0;
+}
@@ -0,0 +1,191 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/AsyncClient.h>
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  //setup a slower polling cycle so we don't kill a worker by mistake
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::AsyncClient> make_AsyncClient(
+                                    const remus::server::ServerPorts& ports)
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.statusEndpoint(ports.status().endpoint());
+  boost::shared_ptr<remus::AsyncClient> c(new remus::client::AsyncClient(conn));
+  return c;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job submit_Job(boost::shared_ptr<remus::Client> client,
+                             const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+  JobSubmission sub( make_JobRequirements(io_type, "NotifiedWorker", "") );
+  sub["data"] = make_JobContent("notify me");
+
+  Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() )
+  return job;
+}
+
+//------------------------------------------------------------------------------
+remus::worker::Job take_Job(boost::shared_ptr<remus::Worker> worker)
+{
+  worker->askForJobs(1);
+  while(worker->pendingJobCount() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    }
+  remus::worker::Job job = worker->takePendingJob();
+  REMUS_ASSERT( job.valid() )
+  return job;
+}
+
+//------------------------------------------------------------------------------
+void verify_wait_for_finished_job(boost::shared_ptr<remus::Client> client,
+                                  boost::shared_ptr<remus::Worker> worker,
+                                  const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  Job job = submit_Job(client, io_type);
+  remus::worker::Job workerJob = take_Job(worker);
+
+  //waiting on a job that isn't done times out with the current status
+  JobStatus status = client->waitForJob(job, 100);
+  REMUS_ASSERT( (status.id() == job.id()) )
+  REMUS_ASSERT( (status.good()) )
+
+  //return the result while the client is blocked waiting on the job
+  std::thread returner([worker, &workerJob]()
+    {
+    remus::common::SleepForMillisec(250);
+    worker->returnResult( make_JobResult(workerJob.id(), "notified") );
+    });
+
+  status = client->waitForJob(job);
+  returner.join();
+  REMUS_ASSERT( (status.id() == job.id()) )
+  REMUS_ASSERT( (status.finished()) )
+
+  //waiting on a job that is already done returns right away
+  status = client->waitForJob(job, 100);
+  REMUS_ASSERT( (status.finished()) )
+
+  JobResult result = client->retrieveResults(job);
+  REMUS_ASSERT( (std::string(result.data(), result.dataSize()) == "notified") )
+}
+
+//------------------------------------------------------------------------------
+void verify_job_finished_callbacks(boost::shared_ptr<remus::Client> client,
+                                   boost::shared_ptr<remus::AsyncClient> asyncClient,
+                                   boost::shared_ptr<remus::Worker> worker,
+                                   const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //one job is finished by the worker and the other is terminated while
+  //queued, and we are told about both
+  Job finishedJob = submit_Job(client, io_type);
+  Job terminatedJob = submit_Job(client, io_type);
+
+  std::future<JobStatus> finished = asyncClient->jobFinished(finishedJob);
+
+  std::atomic<int> failed(0);
+  const boost::uuids::uuid terminatedId = terminatedJob.id();
+  asyncClient->onJobFinished(terminatedJob,
+                             [&failed, terminatedId](const JobStatus& s)
+    {
+    if(s.id() == terminatedId && s.failed()) { ++failed; }
+    });
+
+  remus::worker::Job workerJob = take_Job(worker);
+  REMUS_ASSERT( (workerJob.id() == finishedJob.id()) )
+
+  client->terminate(terminatedJob);
+  worker->returnResult( make_JobResult(workerJob.id(), "notified") );
+
+  const JobStatus status = finished.get();
+  REMUS_ASSERT( (status.id() == finishedJob.id()) )
+  REMUS_ASSERT( (status.finished()) )
+
+  for(int tries=0; tries < 100 && failed == 0; ++tries)
+    {
+    remus::common::SleepForMillisec(50);
+    }
+  REMUS_ASSERT( (failed == 1) )
+
+  //waiting on jobs isn't counted as a pending request
+  REMUS_ASSERT( (asyncClient->pendingRequestCount() == 0) )
+}
+
+}
+
+//Verifies that clients are told when jobs are done, instead of having to
+//poll the server for the status of the job
+int JobNotifications(int argc, char* argv[])
+{
+  using namespace remus::meshtypes;
+
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  boost::shared_ptr<remus::Client> client = detail::make_Client( ports );
+  boost::shared_ptr<remus::AsyncClient> asyncClient = make_AsyncClient( ports );
+  boost::shared_ptr<remus::Worker> worker = detail::make_Worker( ports, io_type, "NotifiedWorker" );
+
+  verify_wait_for_finished_job(client, worker, io_type);
+  verify_job_finished_callbacks(client, asyncClient, worker, io_type);
+
+  asyncClient.reset();
+  server->stopBrokering();
+  REMUS_ASSERT( (server->isBrokering() == false) );
+  return 0;
+}
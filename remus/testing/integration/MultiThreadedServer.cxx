@@ -0,0 +1,156 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create a server that handles clients on their own thread, with a factory
+  //that can launch no workers, so we have to use workers that connect in
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  REMUS_ASSERT( (server->threadingMode() == remus::Server::SINGLE_THREADED) );
+
+  server->threadingMode(remus::Server::MULTI_THREADED);
+  REMUS_ASSERT( (server->threadingMode() == remus::Server::MULTI_THREADED) );
+
+  //setup a slower polling cycle so we don't kill a worker by mistake
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::JobSubmission make_Submission(const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //the same requirements that the worker has
+  JobSubmission sub( make_JobRequirements(io_type, "MultiThreadedWorker", "") );
+  sub["data"] = make_JobContent("multi threaded server");
+  return sub;
+}
+
+//------------------------------------------------------------------------------
+void verify_job_flow(boost::shared_ptr<remus::Client> client,
+                     boost::shared_ptr<remus::Worker> worker,
+                     const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //queries that the client thread forwards to the scheduling thread
+  REMUS_ASSERT( (client->canMesh(io_type) == false) );
+  worker->askForJobs(1);
+  remus::common::SleepForMillisec(250);
+  REMUS_ASSERT( (client->canMesh(io_type) == true) );
+
+  //the requirements come from the worker pool on the scheduling thread
+  JobRequirementsSet reqsFromServer = client->retrieveRequirements(io_type);
+  REMUS_ASSERT( (reqsFromServer.size()==1) )
+
+  const JobSubmission sub = make_Submission(io_type);
+  REMUS_ASSERT( (sub.requirements() == *reqsFromServer.begin()) );
+  Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() )
+
+  //the status is answered by the client thread, and has to already know
+  //about the job once the submission has returned
+  REMUS_ASSERT( (client->jobStatus(job).status() != remus::INVALID_STATUS) );
+  detail::verify_job_status(job,client,remus::QUEUED);
+
+  std::size_t numPendingJobs = worker->pendingJobCount();
+  while(numPendingJobs == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    numPendingJobs = worker->pendingJobCount();
+    }
+  remus::worker::Job workerJob = worker->takePendingJob();
+  REMUS_ASSERT( (workerJob.valid()) )
+  REMUS_ASSERT( (workerJob.submission() == sub) )
+
+  //flood the server with status queries while the job is running
+  JobStatus workerStatus(job.id(), JobProgress(50));
+  worker->updateStatus(workerStatus);
+  detail::verify_job_status(job,client,remus::IN_PROGRESS);
+  for(int i=0; i < 1000; ++i)
+    {
+    REMUS_ASSERT( (client->jobStatus(job) == workerStatus) );
+    }
+
+  const std::string ascii_data = remus::testing::AsciiStringGenerator(1024);
+  worker->returnResult( make_JobResult(job.id(),ascii_data) );
+  detail::verify_job_status(job,client,remus::FINISHED);
+
+  JobResult result = client->retrieveResults(job);
+  REMUS_ASSERT( (result.valid()) )
+  REMUS_ASSERT( (std::string(result.data(),result.dataSize()) == ascii_data) );
+
+  //once the result has been retrieved the server forgets about the job
+  REMUS_ASSERT( (client->jobStatus(job).status() == remus::INVALID_STATUS) );
+}
+
+//------------------------------------------------------------------------------
+void verify_terminate_queued_job(boost::shared_ptr<remus::Client> client,
+                                 const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //the worker isn't asking for jobs so the job stays queued
+  Job job = client->submitJob( make_Submission(io_type) );
+  REMUS_ASSERT( job.valid() )
+  detail::verify_job_status(job,client,remus::QUEUED);
+
+  client->terminate(job);
+  detail::verify_job_status(job,client,remus::INVALID_STATUS);
+}
+
+}
+
+//Runs a job through a server that handles clients on a separate thread
+int MultiThreadedServer(int argc, char* argv[])
+{
+  using namespace remus::meshtypes;
+
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  boost::shared_ptr<remus::Client> client = detail::make_Client( ports );
+  boost::shared_ptr<remus::Worker> worker = detail::make_Worker( ports, io_type, "MultiThreadedWorker" );
+
+  verify_job_flow(client, worker, io_type);
+  verify_terminate_queued_job(client, io_type);
+
+  server->stopBrokering();
+  REMUS_ASSERT( (server->isBrokering() == false) );
+  return 0;
+}
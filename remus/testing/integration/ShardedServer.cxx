@@ -0,0 +1,164 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+#include <vector>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create a server that splits its jobs and workers between shards, with a
+  //factory that can launch no workers, so we have to use workers that
+  //connect in
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+  REMUS_ASSERT( (server->shardCount() == 0) );
+
+  server->threadingMode(remus::Server::SHARDED);
+  server->shardCount(4);
+  REMUS_ASSERT( (server->threadingMode() == remus::Server::SHARDED) );
+  REMUS_ASSERT( (server->shardCount() == 4) );
+
+  //setup a slower polling cycle so we don't kill a worker by mistake
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+void verify_merged_io_types(boost::shared_ptr<remus::Client> client,
+                            const std::vector<remus::common::MeshIOType>& types)
+{
+  //the workers are spread over the shards, so the server has to merge the
+  //types every shard knows about
+  remus::common::MeshIOTypeSet validTypes = client->supportedIOTypes();
+  for(std::size_t i=0; i < types.size(); ++i)
+    {
+    REMUS_ASSERT( (validTypes.count(types[i]) == 1) );
+    REMUS_ASSERT( (client->canMesh(types[i]) == true) );
+    REMUS_ASSERT( (client->retrieveRequirements(types[i]).size() == 1) );
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_job_flow(boost::shared_ptr<remus::Client> client,
+                     boost::shared_ptr<remus::Worker> worker,
+                     const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //the worker has already asked for a job, so the job is sent to it by
+  //the shard that owns the mesh type
+  JobSubmission sub( make_JobRequirements(io_type, "ShardedWorker", "") );
+  sub["data"] = make_JobContent("sharded server");
+  Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() )
+
+  std::size_t numPendingJobs = worker->pendingJobCount();
+  while(numPendingJobs == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    numPendingJobs = worker->pendingJobCount();
+    }
+  remus::worker::Job workerJob = worker->takePendingJob();
+  REMUS_ASSERT( (workerJob.valid()) )
+  REMUS_ASSERT( (workerJob.id() == job.id()) )
+  REMUS_ASSERT( (workerJob.submission() == sub) )
+
+  JobStatus workerStatus(job.id(), JobProgress(50));
+  worker->updateStatus(workerStatus);
+  detail::verify_job_status(job,client,remus::IN_PROGRESS);
+
+  const std::string ascii_data = remus::testing::AsciiStringGenerator(1024);
+  worker->returnResult( make_JobResult(job.id(),ascii_data) );
+  detail::verify_job_status(job,client,remus::FINISHED);
+
+  JobResult result = client->retrieveResults(job);
+  REMUS_ASSERT( (result.valid()) )
+  REMUS_ASSERT( (std::string(result.data(),result.dataSize()) == ascii_data) );
+  REMUS_ASSERT( (client->jobStatus(job).status() == remus::INVALID_STATUS) );
+}
+
+//------------------------------------------------------------------------------
+void verify_terminate_queued_job(boost::shared_ptr<remus::Client> client,
+                                 const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //the worker isn't asking for jobs so the job stays queued
+  JobSubmission sub( make_JobRequirements(io_type, "ShardedWorker", "") );
+  Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() )
+  detail::verify_job_status(job,client,remus::QUEUED);
+
+  client->terminate(job);
+  detail::verify_job_status(job,client,remus::INVALID_STATUS);
+}
+
+}
+
+//Runs jobs of different mesh types through a server that splits the jobs
+//and workers between shards
+int ShardedServer(int argc, char* argv[])
+{
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  boost::shared_ptr<remus::Client> client = detail::make_Client( ports );
+
+  std::vector<remus::common::MeshIOType> types;
+  types.push_back( remus::common::MeshIOType("Model","ShardA") );
+  types.push_back( remus::common::MeshIOType("Model","ShardB") );
+  types.push_back( remus::common::MeshIOType("Model","ShardC") );
+  types.push_back( remus::common::MeshIOType("Model","ShardD") );
+
+  typedef boost::shared_ptr<remus::Worker> WorkerHandle;
+  std::vector< WorkerHandle > workers;
+  for(std::size_t i=0; i < types.size(); ++i)
+    {
+    workers.push_back( detail::make_Worker( ports, types[i], "ShardedWorker" ) );
+    workers[i]->askForJobs(1);
+    }
+  remus::common::SleepForMillisec(250);
+
+  verify_merged_io_types(client, types);
+
+  for(std::size_t i=0; i < types.size(); ++i)
+    {
+    verify_job_flow(client, workers[i], types[i]);
+    }
+  verify_terminate_queued_job(client, types[0]);
+
+  server->stopBrokering();
+  REMUS_ASSERT( (server->isBrokering() == false) );
+  return 0;
+}
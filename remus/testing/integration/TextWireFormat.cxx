@@ -0,0 +1,161 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+//a client that talks to the server the way clients that predate the
+//binary wire format do
+boost::shared_ptr<remus::Client> make_TextClient( const remus::server::ServerPorts& ports )
+{
+  remus::client::ServerConnection conn =
+              remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.statusEndpoint(ports.status().endpoint());
+  conn.wireFormat(remus::proto::WireFormat::Text);
+  return boost::shared_ptr<remus::Client>(new remus::client::Client(conn));
+}
+
+//------------------------------------------------------------------------------
+//a worker that talks to the server the way workers that predate the
+//binary wire format do
+boost::shared_ptr<remus::Worker> make_TextWorker( const remus::server::ServerPorts& ports,
+                                                  const remus::common::MeshIOType& io_type,
+                                                  const std::string& name )
+{
+  remus::worker::ServerConnection conn =
+              remus::worker::make_ServerConnection(ports.worker().endpoint());
+  conn.wireFormat(remus::proto::WireFormat::Text);
+
+  remus::proto::JobRequirements requirements =
+              remus::proto::make_JobRequirements(io_type, name, "");
+  return boost::shared_ptr<remus::Worker>(new remus::Worker(requirements,conn));
+}
+
+//------------------------------------------------------------------------------
+remus::worker::Job wait_for_job(boost::shared_ptr<remus::Worker> worker)
+{
+  while(worker->pendingJobCount() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    }
+  return worker->takePendingJob();
+}
+
+//------------------------------------------------------------------------------
+//submit a job, and have the worker return a result for it
+void verify_job_flow(boost::shared_ptr<remus::Client> client,
+                     boost::shared_ptr<remus::Worker> worker,
+                     const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  worker->askForJobs(1);
+  remus::common::SleepForMillisec(250);
+  REMUS_ASSERT( (client->canMesh(io_type) == true) );
+
+  JobRequirementsSet reqsFromServer = client->retrieveRequirements(io_type);
+  REMUS_ASSERT( (reqsFromServer.size()==1) )
+
+  JobSubmission sub((*reqsFromServer.begin()));
+  sub["extra_stuff"] = make_JobContent("random data");
+  sub["large"] = make_JobContent(remus::testing::AsciiStringGenerator(262144));
+
+  Job clientJob = client->submitJob(sub);
+  REMUS_ASSERT( clientJob.valid() )
+
+  remus::worker::Job workerJob = wait_for_job(worker);
+  REMUS_ASSERT( workerJob.valid() )
+  REMUS_ASSERT( (workerJob.id() == clientJob.id()) )
+  REMUS_ASSERT( (workerJob.submission() == sub) )
+
+  JobStatus workerStatus(clientJob.id(), JobProgress(50));
+  worker->updateStatus(workerStatus);
+  detail::verify_job_status(clientJob,client,remus::IN_PROGRESS);
+  REMUS_ASSERT( (client->jobStatus(clientJob) == workerStatus) )
+
+  const std::string ascii_data = remus::testing::AsciiStringGenerator(524288);
+  worker->returnResult( make_JobResult(clientJob.id(),ascii_data) );
+  detail::verify_job_status(clientJob,client,remus::FINISHED);
+
+  JobResult client_results = client->retrieveResults(clientJob);
+  REMUS_ASSERT( (client_results.valid()==true) )
+
+  const std::string resultText(client_results.data(), client_results.dataSize());
+  REMUS_ASSERT( (resultText==ascii_data) )
+}
+
+}
+
+//Verifies that clients and workers using the text wire format can run jobs,
+//and that the server answers each of them in the format they talk in
+int TextWireFormat(int argc, char* argv[])
+{
+  using namespace remus::meshtypes;
+
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+
+  //a text client with a text worker
+  boost::shared_ptr<remus::Client> textClient = make_TextClient( ports );
+  boost::shared_ptr<remus::Worker> textWorker = make_TextWorker( ports, io_type, "Worker" );
+  verify_job_flow(textClient, textWorker, io_type);
+
+  //a binary client with the text worker, so the server has to send the
+  //job it received in the binary format to the worker in the text format
+  boost::shared_ptr<remus::Client> binaryClient = detail::make_Client( ports );
+  verify_job_flow(binaryClient, textWorker, io_type);
+  textWorker.reset();
+
+  //a text client with a binary worker, so the server has to send the
+  //result it received in the binary format to the client in the text format.
+  //The worker has the same requirements as the text worker, so the client
+  //is only told about one of them
+  boost::shared_ptr<remus::Worker> binaryWorker =
+                            detail::make_Worker( ports, io_type, "Worker" );
+  verify_job_flow(textClient, binaryWorker, io_type);
+
+  return 0;
+}
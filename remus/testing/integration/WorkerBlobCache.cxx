@@ -0,0 +1,164 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/client/Client.h>
+#include <remus/server/Server.h>
+#include <remus/server/WorkerFactory.h>
+#include <remus/worker/Worker.h>
+
+#include <remus/common/SleepFor.h>
+#include <remus/testing/Testing.h>
+#include <remus/testing/integration/detail/Helpers.h>
+
+#include <string>
+
+namespace
+{
+  namespace detail
+  {
+  using namespace remus::testing::integration::detail;
+  }
+
+//------------------------------------------------------------------------------
+boost::shared_ptr<remus::Server> make_Server( remus::server::ServerPorts ports )
+{
+  //create the server and start brokering, with a factory that can launch
+  //no workers, so we have to use workers that connect in only
+  boost::shared_ptr<remus::server::WorkerFactory> factory(new remus::server::WorkerFactory());
+  factory->setMaxWorkerCount(0);
+
+  //setup a slower polling cycle so we don't kill a worker by mistake
+  boost::shared_ptr<remus::Server> server( new remus::Server(ports,factory) );
+
+  remus::server::PollingRates newRates(1500,60000);
+  server->pollingRates(newRates);
+  server->startBrokering();
+  return server;
+}
+
+//------------------------------------------------------------------------------
+remus::proto::Job submit_Job(boost::shared_ptr<remus::Client> client,
+                             const remus::common::MeshIOType& io_type,
+                             const std::string& workerName,
+                             const remus::proto::JobContent& model,
+                             const std::string& attributes)
+{
+  using namespace remus::proto;
+  JobSubmission sub( make_JobRequirements(io_type, workerName, "") );
+  sub["model"] = model;
+  sub["attributes"] = make_JobContent(attributes);
+
+  Job job = client->submitJob(sub);
+  REMUS_ASSERT( job.valid() )
+  return job;
+}
+
+//------------------------------------------------------------------------------
+void verify_job(boost::shared_ptr<remus::Worker> worker,
+                const remus::proto::Job& job,
+                const std::string& model,
+                const std::string& attributes)
+{
+  worker->askForJobs(1);
+  while(worker->pendingJobCount() == 0)
+    {
+    remus::common::SleepForMillisec(50);
+    }
+  remus::worker::Job workerJob = worker->takePendingJob();
+  REMUS_ASSERT( (workerJob.id() == job.id()) )
+
+  //the worker gets the contents, no matter if they were sent or taken
+  //from the cache of the worker
+  remus::proto::JobContent content;
+  REMUS_ASSERT( (workerJob.details("model", content)) )
+  REMUS_ASSERT( (std::string(content.data(), content.dataSize()) == model) )
+  REMUS_ASSERT( (workerJob.details("attributes") == attributes) )
+
+  worker->returnResult( remus::proto::make_JobResult(workerJob.id(), "done") );
+}
+
+//------------------------------------------------------------------------------
+void verify_cached_model(boost::shared_ptr<remus::Client> client,
+                         boost::shared_ptr<remus::Worker> worker,
+                         const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //the model is large enough to be submitted with a hash, so after the
+  //first job the server only sends the worker the hash of the model
+  const std::string modelData = remus::testing::BinaryDataGenerator(1024*1024);
+  const JobContent model = make_JobContent(modelData);
+
+  for(int i=0; i < 3; ++i)
+    {
+    const std::string attributes = "attributes " + std::string(1, '0' + i);
+    Job job = submit_Job(client, io_type, "CachingWorker", model, attributes);
+    verify_job(worker, job, modelData, attributes);
+    }
+}
+
+//------------------------------------------------------------------------------
+void verify_spilled_model(boost::shared_ptr<remus::Client> client,
+                          boost::shared_ptr<remus::Worker> worker,
+                          const remus::common::MeshIOType& io_type)
+{
+  using namespace remus::proto;
+
+  //the cache only holds one model in memory, so alternating between two
+  //models spills the other one to disk
+  const std::string firstData = remus::testing::BinaryDataGenerator(1024*1024);
+  const std::string secondData = remus::testing::BinaryDataGenerator(1024*1024);
+  const JobContent first = make_JobContent(firstData);
+  const JobContent second = make_JobContent(secondData);
+
+  for(int i=0; i < 2; ++i)
+    {
+    Job job = submit_Job(client, io_type, "SpillingWorker", first, "first");
+    verify_job(worker, job, firstData, "first");
+
+    job = submit_Job(client, io_type, "SpillingWorker", second, "second");
+    verify_job(worker, job, secondData, "second");
+    }
+}
+
+}
+
+//Verifies that workers which cache job contents get the same jobs as
+//workers that are sent every content
+int WorkerBlobCache(int argc, char* argv[])
+{
+  using namespace remus::meshtypes;
+
+  (void) argc;
+  (void) argv;
+
+  boost::shared_ptr<remus::Server> server = make_Server( remus::server::ServerPorts() );
+  const remus::server::ServerPorts& ports = server->serverPortInfo();
+
+  remus::common::MeshIOType io_type = remus::common::make_MeshIOType(Mesh2D(),Mesh3D());
+  boost::shared_ptr<remus::Client> client = detail::make_Client( ports );
+
+  boost::shared_ptr<remus::Worker> caching =
+                    detail::make_Worker( ports, io_type, "CachingWorker" );
+  caching->cacheBlobs(16*1024*1024);
+  verify_cached_model(client, caching, io_type);
+
+  const std::string spillDirectory =
+          remus::testing::UniqueString() + "_WorkerBlobCache";
+  boost::shared_ptr<remus::Worker> spilling =
+                    detail::make_Worker( ports, io_type, "SpillingWorker" );
+  spilling->cacheBlobs(1536*1024, spillDirectory, 4*1024*1024);
+  verify_spilled_model(client, spilling, io_type);
+
+  server->stopBrokering();
+  REMUS_ASSERT( (server->isBrokering() == false) );
+  return 0;
+}
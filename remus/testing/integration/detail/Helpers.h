@@ -52,6 +52,7 @@ inline boost::shared_ptr<remus::Client> make_Client( const remus::server::Server
 {
   remus::client::ServerConnection conn =
               remus::client::make_ServerConnection(ports.client().endpoint());
+  conn.statusEndpoint(ports.status().endpoint());
   if(share_context)
     {
     conn.context(ports.context());
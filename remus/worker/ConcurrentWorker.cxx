@@ -0,0 +1,240 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/worker/ConcurrentWorker.h>
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace remus{
+namespace worker{
+
+//-----------------------------------------------------------------------------
+ConcurrentWorker::ConcurrentWorker(
+                    const remus::proto::JobRequirements& requirements,
+                    const remus::worker::ServerConnection& conn,
+                    std::size_t numberOfThreads):
+  NumberOfThreads( std::max(numberOfThreads, std::size_t(1)) ),
+  Worker( new remus::worker::Worker(requirements, conn) ),
+  Mutex(),
+  JobsChanged(),
+  Jobs(),
+  ActiveJobs(0),
+  JobsToAskFor(0),
+  Stop(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+ConcurrentWorker::~ConcurrentWorker()
+{
+}
+
+//-----------------------------------------------------------------------------
+const remus::worker::ServerConnection& ConcurrentWorker::connection() const
+{
+  return this->Worker->connection();
+}
+
+//-----------------------------------------------------------------------------
+void ConcurrentWorker::pollingRates(const remus::worker::PollingRates& rates)
+{
+  this->Worker->pollingRates(rates);
+}
+
+//-----------------------------------------------------------------------------
+remus::worker::PollingRates ConcurrentWorker::pollingRates() const
+{
+  return this->Worker->pollingRates();
+}
+
+//-----------------------------------------------------------------------------
+void ConcurrentWorker::cacheBlobs( std::size_t maxBytes,
+                                   const std::string& spillDirectory,
+                                   std::size_t spillBytes )
+{
+  this->Worker->cacheBlobs(maxBytes, spillDirectory, spillBytes);
+}
+
+//-----------------------------------------------------------------------------
+std::size_t ConcurrentWorker::activeJobCount() const
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  return this->ActiveJobs;
+}
+
+//-----------------------------------------------------------------------------
+void ConcurrentWorker::process(const JobFunction& f)
+{
+  this->process(f, std::numeric_limits<std::size_t>::max());
+}
+
+//-----------------------------------------------------------------------------
+std::size_t ConcurrentWorker::process(const JobFunction& f,
+                                      std::size_t numberOfJobs)
+{
+  //we only ask the server for a job when a thread is free, so the number
+  //of jobs asked for and not received, plus the jobs being processed, is
+  //never more than the number of threads
+  const std::size_t initialJobs = std::min(this->NumberOfThreads, numberOfJobs);
+  {
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  this->Jobs.clear();
+  this->ActiveJobs = 0;
+  this->JobsToAskFor = numberOfJobs - initialJobs;
+  this->Stop = false;
+  }
+
+  std::vector<std::thread> pool;
+  for(std::size_t i=0; i < this->NumberOfThreads; ++i)
+    {
+    pool.push_back( std::thread(&ConcurrentWorker::runJobs, this, std::cref(f)) );
+    }
+
+  this->Worker->askForJobs( static_cast<unsigned int>(initialJobs) );
+
+  std::size_t jobsTaken = 0;
+  while(jobsTaken < numberOfJobs)
+    {
+    remus::worker::Job job = this->Worker->waitForPendingJob();
+    if(job.validityReason() == remus::worker::Job::TERMINATE_WORKER)
+      {
+      break;
+      }
+    if(!job.valid())
+      {
+      continue;
+      }
+
+    ++jobsTaken;
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->Jobs.push_back(job);
+    ++this->ActiveJobs;
+    this->JobsChanged.notify_one();
+    }
+
+  //the threads finish the jobs they have been given before they stop
+  {
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  this->Stop = true;
+  this->JobsChanged.notify_all();
+  }
+  for(std::size_t i=0; i < pool.size(); ++i)
+    {
+    pool[i].join();
+    }
+  return jobsTaken;
+}
+
+//-----------------------------------------------------------------------------
+void ConcurrentWorker::runJobs(const JobFunction& f)
+{
+  while(true)
+    {
+    remus::worker::Job job;
+    {
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    while(!this->Stop && this->Jobs.empty())
+      {
+      this->JobsChanged.wait(lock);
+      }
+    if(this->Jobs.empty())
+      {
+      return;
+      }
+    job = this->Jobs.front();
+    this->Jobs.pop_front();
+    }
+
+    try
+      {
+      f(job, *this);
+      }
+    catch(const std::exception& e)
+      {
+      this->sendJobFailure(job, e.what());
+      }
+    this->jobFinished();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void ConcurrentWorker::jobFinished()
+{
+  //the thread is free again, so ask the server for another job
+  bool askForJob = false;
+  {
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  --this->ActiveJobs;
+  if(this->JobsToAskFor > 0)
+    {
+    --this->JobsToAskFor;
+    askForJob = true;
+    }
+  }
+
+  if(askForJob && !this->Worker->workerShouldTerminate())
+    {
+    this->Worker->askForJobs(1);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void ConcurrentWorker::updateStatus(const remus::proto::JobStatus& info)
+{
+  this->Worker->updateStatus(info);
+}
+
+//-----------------------------------------------------------------------------
+void ConcurrentWorker::sendProgress(const remus::worker::Job& job,
+                                    int progress, const std::string& message)
+{
+  this->Worker->sendProgress(job, progress, message);
+}
+
+//-----------------------------------------------------------------------------
+void ConcurrentWorker::sendJobFailure(const remus::worker::Job& job,
+                                      const std::string& reason)
+{
+  this->Worker->sendJobFailure(job, reason);
+}
+
+//-----------------------------------------------------------------------------
+void ConcurrentWorker::returnResult(const remus::proto::JobResult& result)
+{
+  this->Worker->returnResult(result);
+}
+
+//-----------------------------------------------------------------------------
+std::future<bool>
+ConcurrentWorker::returnResultAsync(const remus::proto::JobResult& result)
+{
+  return this->Worker->returnResultAsync(result);
+}
+
+//-----------------------------------------------------------------------------
+bool ConcurrentWorker::workerShouldTerminate() const
+{
+  return this->Worker->workerShouldTerminate();
+}
+
+//-----------------------------------------------------------------------------
+bool ConcurrentWorker::jobShouldBeTerminated(const remus::worker::Job& job) const
+{
+  return this->Worker->jobShouldBeTerminated(job);
+}
+
+}
+}
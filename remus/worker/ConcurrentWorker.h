@@ -0,0 +1,142 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_worker_ConcurrentWorker_h
+#define remus_worker_ConcurrentWorker_h
+
+#include <remus/worker/Worker.h>
+
+//included for export symbols
+#include <remus/worker/WorkerExports.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#ifdef REMUS_MSVC
+ #pragma warning(push)
+ #pragma warning(disable:4251)  /*dll-interface missing on stl type*/
+#endif
+
+namespace remus{
+namespace worker{
+
+//The concurrent worker processes multiple jobs at the same time in a single
+//process. It owns a pool of threads and a single connection to the server,
+//so the mesher only has to be initialized once, and the status and results
+//of every thread are sent over the same connection.
+//
+//The worker only asks the server for as many jobs as it has free threads,
+//so jobs aren't held by this worker while other workers are free to
+//process them.
+class REMUSWORKER_EXPORT ConcurrentWorker
+{
+public:
+  //the function that processes a single job. It is invoked on one of the
+  //threads of the pool, and should report the status and result of the job
+  //with the given worker. If the function throws a std::exception the job
+  //is reported as failed.
+  typedef std::function<void (const remus::worker::Job&,
+                              remus::worker::ConcurrentWorker&)> JobFunction;
+
+  //construct a worker that can mesh only an exact set of requirements,
+  //and processes up to numberOfThreads jobs at the same time
+  ConcurrentWorker(const remus::proto::JobRequirements& requirements,
+                   const remus::worker::ServerConnection& conn,
+                   std::size_t numberOfThreads);
+
+  //stops talking to the server, process must have returned before the
+  //worker is destroyed
+  ~ConcurrentWorker();
+
+  //return the connection info that was used to connect to the
+  //remus server
+  const remus::worker::ServerConnection& connection() const;
+
+  //see Worker::pollingRates
+  void pollingRates( const remus::worker::PollingRates& rates );
+  remus::worker::PollingRates pollingRates() const;
+
+  //see Worker::cacheBlobs
+  void cacheBlobs( std::size_t maxBytes,
+                   const std::string& spillDirectory = std::string(),
+                   std::size_t spillBytes = 0 );
+
+  //returns the number of jobs that can be processed at the same time
+  std::size_t numberOfThreads() const { return this->NumberOfThreads; }
+
+  //returns the number of jobs that are being processed right now
+  std::size_t activeJobCount() const;
+
+  //Process jobs with the given function until the server tells the worker
+  //to terminate. Blocks the calling thread, and waits for all the jobs to
+  //finish before returning.
+  void process(const JobFunction& f);
+
+  //Process numberOfJobs jobs with the given function, and than return. Will
+  //return earlier if the server tells the worker to terminate. Blocks the
+  //calling thread, and waits for all the jobs to finish before returning.
+  //Returns the number of jobs that were processed.
+  std::size_t process(const JobFunction& f, std::size_t numberOfJobs);
+
+  //These calls can be made from any thread, and are sent to the server
+  //over the single connection of this worker
+  void updateStatus(const remus::proto::JobStatus& info);
+  void sendProgress( const remus::worker::Job& job,
+                     int progress, const std::string& message );
+  void sendJobFailure( const remus::worker::Job& job,
+                       const std::string& reason );
+  void returnResult(const remus::proto::JobResult& result);
+  std::future<bool> returnResultAsync(const remus::proto::JobResult& result);
+
+  //see Worker::workerShouldTerminate
+  bool workerShouldTerminate() const;
+
+  //see Worker::jobShouldBeTerminated
+  bool jobShouldBeTerminated( const remus::worker::Job& job ) const;
+
+private:
+  //the loop that each thread of the pool runs
+  void runJobs(const JobFunction& f);
+
+  //called by a thread of the pool once it has finished a job
+  void jobFinished();
+
+  const std::size_t NumberOfThreads;
+  boost::scoped_ptr<remus::worker::Worker> Worker;
+
+  mutable std::mutex Mutex;
+  std::condition_variable JobsChanged;
+  std::deque<remus::worker::Job> Jobs;
+  std::size_t ActiveJobs;
+  std::size_t JobsToAskFor;
+  bool Stop;
+
+  //explicitly state the worker doesn't support copy or move semantics
+  ConcurrentWorker(const ConcurrentWorker&);
+  void operator=(const ConcurrentWorker&);
+};
+
+}
+
+//We want the user to have a nicer experience creating the worker interface.
+//For this reason we remove the stuttering when making an instance of the worker.
+typedef remus::worker::ConcurrentWorker ConcurrentWorker;
+
+}
+
+#ifdef REMUS_MSVC
+  #pragma warning(pop)
+#endif
+
+#endif
@@ -54,9 +54,16 @@ inline remus::worker::Job to_Job(const std::string& msg)
 //------------------------------------------------------------------------------
 inline remus::worker::Job to_Job(const char* data, int size)
 {
-  //convert a job from a string, used as a hack to serialize
-  const std::string temp(data,size);
-  return to_Job( temp );
+  return remus::proto::to_WorkerJob(data, static_cast<std::size_t>(size));
+}
+
+//------------------------------------------------------------------------------
+//decode a job that references data instead of copying the submission
+//contents out of it
+inline remus::worker::Job to_Job(const boost::shared_ptr<const char>& data,
+                                 std::size_t size)
+{
+  return remus::proto::to_WorkerJob(data, size);
 }
 
 }
@@ -30,7 +30,8 @@ ServerConnection::ServerConnection():
   Context( ),
   Endpoint(zmq::socketInfo<zmq::proto::tcp>("127.0.0.1",
                           remus::server::WORKER_PORT).endpoint()),
-  IsLocalEndpoint(true) //no need to call zmq::isLocalEndpoint
+  IsLocalEndpoint(true), //no need to call zmq::isLocalEndpoint
+  Format(remus::proto::WireFormat::Binary)
 {
 }
 
@@ -38,7 +39,8 @@ ServerConnection::ServerConnection():
 ServerConnection::ServerConnection(const std::string& hostName, int port):
   Context( ),
   Endpoint(zmq::socketInfo<zmq::proto::tcp>(hostName,port).endpoint()),
-  IsLocalEndpoint( zmq::isLocalEndpoint(zmq::socketInfo<zmq::proto::tcp>(hostName,port)) )
+  IsLocalEndpoint( zmq::isLocalEndpoint(zmq::socketInfo<zmq::proto::tcp>(hostName,port)) ),
+  Format(remus::proto::WireFormat::Binary)
 {
   assert(hostName.size() > 0);
   assert(port > 0 && port < 65536);
@@ -13,6 +13,7 @@
 #ifndef remus_worker_ServerConnection_h
 #define remus_worker_ServerConnection_h
 
+#include <remus/proto/WireFormat.h>
 #include <remus/proto/zmqSocketInfo.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
@@ -68,10 +69,20 @@ public:
   //Not Thread Safe
   void context(boost::shared_ptr<zmq::context_t> c) { this->Context = c; }
 
+  //the wire format that results are sent to the server in. Binary is the
+  //default and sends the result data as its own frame. Servers that predate
+  //the binary format only understand Text, which sends each result as a
+  //single frame.
+  //Not Thread Safe
+  inline remus::proto::WireFormat::Type wireFormat() const{ return Format; }
+  void wireFormat(remus::proto::WireFormat::Type format)
+    { this->Format = format; }
+
 private:
   mutable boost::shared_ptr<zmq::context_t> Context;
   std::string Endpoint;
   bool IsLocalEndpoint;
+  remus::proto::WireFormat::Type Format;
 };
 
 //convert a string in the form of proto://hostname:port where :port
@@ -90,7 +101,8 @@ template<typename T>
 ServerConnection::ServerConnection(zmq::socketInfo<T> const& socket):
   Context( ),
   Endpoint(socket.endpoint()),
-  IsLocalEndpoint( zmq::isLocalEndpoint(socket) )
+  IsLocalEndpoint( zmq::isLocalEndpoint(socket) ),
+  Format(remus::proto::WireFormat::Binary)
 {
 }
 
@@ -18,6 +18,9 @@
 #include <remus/worker/detail/JobQueue.h>
 #include <remus/worker/detail/MessageRouter.h>
 
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 
 //suppress warnings inside boost headers for gcc and clang
@@ -39,11 +42,18 @@ struct ZmqManagement
   //the same context.
   boost::shared_ptr<zmq::context_t> InterWorkerContext;
   zmq::socket_t Server;
+  //guards the server socket, so that multiple threads can send status
+  //and results for the jobs they are processing
+  std::mutex ServerMutex;
+  //the number of jobs we have asked the server for, guarded by ServerMutex
+  std::size_t JobsAskedFor;
   std::string WorkerChannelUUID;
   std::string JobChannelUUID;
   ZmqManagement( remus::worker::ServerConnection const& conn ):
     InterWorkerContext( conn.context() ),
     Server( *InterWorkerContext, ZMQ_PAIR),
+    ServerMutex(),
+    JobsAskedFor(0),
     WorkerChannelUUID(),
     JobChannelUUID()
   {
@@ -74,7 +84,8 @@ Worker::Worker(remus::common::MeshIOType mtype,
                     zmq::socketInfo<zmq::proto::inproc>(Zmq->WorkerChannelUUID),
                     zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID))),
   JobQueue( new remus::worker::detail::JobQueue( *Zmq->InterWorkerContext,
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)))
+                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID))),
+  PrefetchDepth(0)
 {
   //build the buffer before we start the message router. This shortens the
   //duration that the worker is stalling, while the message router is active
@@ -90,7 +101,8 @@ Worker::Worker(remus::common::MeshIOType mtype,
   remus::proto::send_Message(this->MeshRequirements.meshTypes(),
                             remus::CAN_MESH_REQUIREMENTS,
                             buffer_str,
-                            &this->Zmq->Server);
+                            &this->Zmq->Server,
+                            this->ConnectionInfo.wireFormat());
 }
 
 //-----------------------------------------------------------------------------
@@ -103,7 +115,8 @@ Worker::Worker(const remus::proto::JobRequirements& requirements,
                     zmq::socketInfo<zmq::proto::inproc>(Zmq->WorkerChannelUUID),
                     zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)) ),
   JobQueue( new remus::worker::detail::JobQueue( *Zmq->InterWorkerContext,
-                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)) )
+                    zmq::socketInfo<zmq::proto::inproc>(Zmq->JobChannelUUID)) ),
+  PrefetchDepth(0)
 {
   //build the buffer before we start the message router. This shortens the
   //duration that the worker is stalling, while the message router is active
@@ -119,20 +132,27 @@ Worker::Worker(const remus::proto::JobRequirements& requirements,
   remus::proto::send_Message(this->MeshRequirements.meshTypes(),
                             remus::CAN_MESH_REQUIREMENTS,
                             buffer_str,
-                            &this->Zmq->Server);
+                            &this->Zmq->Server,
+                            this->ConnectionInfo.wireFormat());
 }
 
 
 //-----------------------------------------------------------------------------
 Worker::~Worker()
 {
+  //results that are still being sent to the server would be dropped
+  //once we stop talking to it
+  this->flushResults();
+
   if(this->MessageRouter->valid())
     {
     //send message that we are shutting down communication, and we can stop
     //polling the server
+    std::unique_lock<std::mutex> lock(this->Zmq->ServerMutex);
     remus::proto::send_Message(this->MeshRequirements.meshTypes(),
                                remus::TERMINATE_WORKER,
-                               &this->Zmq->Server);
+                               &this->Zmq->Server,
+                               this->ConnectionInfo.wireFormat());
     } 
 }
 
@@ -163,6 +183,17 @@ remus::worker::PollingRates Worker::pollingRates() const
   return remus::worker::PollingRates(low,high);
 }
 
+//-----------------------------------------------------------------------------
+void Worker::cacheBlobs( std::size_t maxBytes,
+                         const std::string& spillDirectory,
+                         std::size_t spillBytes )
+{
+  //the cache lives in the MessageRouter, since it has to fill in the jobs
+  //as they come from the server
+  this->MessageRouter->cacheBlobs(this->MeshRequirements.meshTypes(),
+                                  maxBytes, spillDirectory, spillBytes);
+}
+
 //-----------------------------------------------------------------------------
 void Worker::askForJobs( unsigned int numberOfJobs )
 {
@@ -181,12 +212,15 @@ void Worker::askForJobs( unsigned int numberOfJobs )
     std::ostringstream input_buffer;
     input_buffer << lightReqs;
 
+    std::unique_lock<std::mutex> lock(this->Zmq->ServerMutex);
+    this->Zmq->JobsAskedFor += numberOfJobs;
     for(unsigned int i=0; i < numberOfJobs; ++i)
       {
       proto::send_Message(this->MeshRequirements.meshTypes(),
                           remus::MAKE_MESH,
                           input_buffer.str(),
-                          &this->Zmq->Server);
+                          &this->Zmq->Server,
+                          this->ConnectionInfo.wireFormat());
       }
     }
 }
@@ -206,10 +240,57 @@ remus::worker::Job Worker::takePendingJob()
 //-----------------------------------------------------------------------------
 remus::worker::Job Worker::getJob()
 {
-  if(this->pendingJobCount() == 0)
+  if(this->PrefetchDepth == 0)
+    {
+    if(this->pendingJobCount() == 0)
+      {
+      this->askForJobs(1);
+      }
+    }
+  else
+    {
+    //the job we are about to take plus the jobs to fetch while it is
+    //processed
+    this->askForJobsUpTo(1 + this->PrefetchDepth);
+    }
+  return this->JobQueue->waitAndTakeJob();
+}
+
+//-----------------------------------------------------------------------------
+void Worker::prefetchDepth(unsigned int depth)
+{
+  this->PrefetchDepth = depth;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int Worker::prefetchDepth() const
+{
+  return this->PrefetchDepth;
+}
+
+//-----------------------------------------------------------------------------
+void Worker::askForJobsUpTo(std::size_t count)
+{
+  std::size_t askedFor = 0;
+  {
+  std::unique_lock<std::mutex> lock(this->Zmq->ServerMutex);
+  askedFor = this->Zmq->JobsAskedFor;
+  }
+
+  //the jobs that are on their way from the server
+  const std::size_t received = this->JobQueue->receivedCount();
+  const std::size_t inFlight = askedFor > received ? askedFor - received : 0;
+
+  const std::size_t have = this->pendingJobCount() + inFlight;
+  if(have < count)
     {
-    this->askForJobs(1);
+    this->askForJobs( static_cast<unsigned int>(count - have) );
     }
+}
+
+//-----------------------------------------------------------------------------
+remus::worker::Job Worker::waitForPendingJob()
+{
   return this->JobQueue->waitAndTakeJob();
 }
 
@@ -221,10 +302,12 @@ void Worker::updateStatus(const remus::proto::JobStatus& info)
     //We want to send status as non blocking so we don't waste cycles
     //waiting to hear back from zmq that the message left its inbox
     std::string msg = remus::proto::to_string(info);
+    std::unique_lock<std::mutex> lock(this->Zmq->ServerMutex);
     remus::proto::send_NonBlockingMessage(this->MeshRequirements.meshTypes(),
                               remus::MESH_STATUS,
                               msg,
-                              &this->Zmq->Server);
+                              &this->Zmq->Server,
+                              this->ConnectionInfo.wireFormat());
     }
 }
 
@@ -254,12 +337,18 @@ void Worker::returnResult(const remus::proto::JobResult& result)
 {
   if(this->MessageRouter->valid())
     {
-    //send a message that contains, the path to the resulting file
-    std::string msg = remus::proto::to_string(result);
+    //send a message that contains the result, with the result data as
+    //its own frame so that it isn't copied, unless the server only
+    //understands the text wire format. The lock is held until the
+    //server responds, so that the response isn't taken by another thread
+    std::unique_lock<std::mutex> lock(this->Zmq->ServerMutex);
+    this->MessageRouter->expectResult(detail::MessageRouter::ResultAck());
     remus::proto::send_Message(this->MeshRequirements.meshTypes(),
                                remus::RETRIEVE_RESULT,
-                               msg,
-                               &this->Zmq->Server);
+                               remus::proto::to_FrameSet(result,
+                                        this->ConnectionInfo.wireFormat()),
+                               &this->Zmq->Server,
+                               this->ConnectionInfo.wireFormat());
 
     //we need to block on waiting for the server to notify it has our result.
     //Otherwise it is possible to delete a worker before it is done transimiting
@@ -271,6 +360,41 @@ void Worker::returnResult(const remus::proto::JobResult& result)
     }
 }
 
+//-----------------------------------------------------------------------------
+std::future<bool>
+Worker::returnResultAsync(const remus::proto::JobResult& result)
+{
+  detail::MessageRouter::ResultAck ack =
+      std::make_shared< std::promise<bool> >();
+  std::future<bool> received = ack->get_future();
+
+  //the message router completes the ack once the server has the result,
+  //so the lock is only held while the result is handed to the router
+  std::unique_lock<std::mutex> lock(this->Zmq->ServerMutex);
+  if(this->MessageRouter->expectResult(ack))
+    {
+    remus::proto::send_Message(this->MeshRequirements.meshTypes(),
+                               remus::RETRIEVE_RESULT,
+                               remus::proto::to_FrameSet(result,
+                                        this->ConnectionInfo.wireFormat()),
+                               &this->Zmq->Server,
+                               this->ConnectionInfo.wireFormat());
+    }
+  return received;
+}
+
+//-----------------------------------------------------------------------------
+std::size_t Worker::pendingResultCount() const
+{
+  return this->MessageRouter->pendingResultCount();
+}
+
+//-----------------------------------------------------------------------------
+void Worker::flushResults()
+{
+  this->MessageRouter->waitForResults();
+}
+
 //-----------------------------------------------------------------------------
 bool Worker::workerShouldTerminate() const
 {
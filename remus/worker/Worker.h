@@ -31,6 +31,8 @@ REMUS_THIRDPARTY_POST_INCLUDE
 //included for export symbols
 #include <remus/worker/WorkerExports.h>
 
+#include <future>
+
 #ifdef REMUS_MSVC
  #pragma warning(push)
  #pragma warning(disable:4251)  /*dll-interface missing on stl type*/
@@ -70,6 +72,10 @@ private:
 // remus server. Once you get a job from the server you process the given
 // job reporting back the status of the job, and than once finished the
 // results of the job.
+//
+// The calls that send to the server ( askForJobs, updateStatus, sendProgress,
+// sendJobFailure and returnResult ) are thread safe, so jobs can be processed
+// on multiple threads that share a single worker. See ConcurrentWorker.
 class REMUSWORKER_EXPORT Worker
 {
 public:
@@ -104,6 +110,23 @@ public:
   void pollingRates( const remus::worker::PollingRates& rates );
   remus::worker::PollingRates pollingRates() const;
 
+  //Keep a local cache of the job contents this worker is sent, keyed by
+  //the hash of the contents. The server is told which contents we hold,
+  //and sends only the hash of those contents instead of the bytes, which
+  //helps when the same large model is meshed many times. Contents are
+  //filled back in before the job is handed out, so Job::details() works
+  //the same with or without a cache. Only contents submitted with a hash
+  //are cached, see Client::submitJob.
+  //
+  //The cache holds maxBytes of contents in memory. When spillDirectory
+  //isn't empty the least recently used contents are written to that
+  //directory instead of being dropped, until spillBytes are on disk. The
+  //spilled files are removed when the worker is destroyed. Calling this
+  //again changes how many bytes the cache holds, but not where it spills.
+  void cacheBlobs( std::size_t maxBytes,
+                   const std::string& spillDirectory = std::string(),
+                   std::size_t spillBytes = 0 );
+
   //send a message to the server stating how many jobs
   //that we want to be sent to process
   void askForJobs( unsigned int numberOfJobs = 1 );
@@ -119,6 +142,21 @@ public:
   //Blocking fetch a pending job and return it
   remus::worker::Job getJob();
 
+  //Set how many jobs getJob keeps fetched ahead of the job that is being
+  //processed. With a depth of zero getJob only asks the server for a job
+  //once no jobs are pending, so each job has to wait on a round trip to
+  //the server. With a depth of K, getJob asks for jobs so that K jobs
+  //are transferred to the worker while the current job is processed. Jobs
+  //that are terminated before they are taken are removed, and replaced
+  //by the next call to getJob. Defaults to zero.
+  void prefetchDepth(unsigned int depth);
+  unsigned int prefetchDepth() const;
+
+  //Blocking fetch a pending job and return it. Unlike getJob this never
+  //asks the server for a job, so it is used by callers that keep track
+  //of how many jobs they have asked for
+  remus::worker::Job waitForPendingJob();
+
   //update the status of the worker
   void updateStatus(const remus::proto::JobStatus& info);
 
@@ -132,9 +170,26 @@ public:
   //JobStatus object and mark it as failed
   void sendJobFailure( const remus::worker::Job&, const std::string& reason );
 
-  //send to the server the mesh results.
+  //send to the server the mesh results. Blocks until the server has
+  //received the results.
   void returnResult(const remus::proto::JobResult& result);
 
+  //send to the server the mesh results without waiting for the server to
+  //receive them, so the next job can be processed while a large result is
+  //uploaded. The returned future is true once the server has the results,
+  //and false if the server terminates the worker before that. The data of
+  //the result must stay valid until the future is ready. Results are
+  //received by the server in the order they are returned, sync or async.
+  std::future<bool> returnResultAsync(const remus::proto::JobResult& result);
+
+  //returns the number of results sent with returnResultAsync that the
+  //server hasn't received yet
+  std::size_t pendingResultCount() const;
+
+  //blocks until the server has received every result sent with
+  //returnResultAsync. The destructor of the worker calls this.
+  void flushResults();
+
   //ask the worker API if the server has told us we should shutdown.
   //This means that the server has shutdown and all jobs the worker
   //has are invalid and can be terminated.
@@ -155,6 +210,12 @@ private:
   boost::scoped_ptr<remus::worker::detail::MessageRouter> MessageRouter;
   boost::scoped_ptr<remus::worker::detail::JobQueue> JobQueue;
 
+  unsigned int PrefetchDepth;
+
+  //ask the server for enough jobs that the pending jobs plus the
+  //jobs we have asked for and not yet received is at least count
+  void askForJobsUpTo( std::size_t count );
+
   //explicitly state the worker doesn't support copy or move semantics
   Worker(const Worker&);
   void operator=(const Worker&);
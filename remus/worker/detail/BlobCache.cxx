@@ -0,0 +1,378 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#include <remus/worker/detail/BlobCache.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+//force to use filesystem version 3
+#define BOOST_FILESYSTEM_VERSION 3
+#include <boost/filesystem.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <cctype>
+#include <fstream>
+
+namespace
+{
+//------------------------------------------------------------------------------
+//the hash is used as the name of the spilled file, so only spill blobs
+//whose hash can't name a file outside of the spill directory
+bool is_SpillableHash(const std::string& hash)
+{
+  for(std::string::const_iterator i = hash.begin(); i != hash.end(); ++i)
+    {
+    if(!std::isalnum(static_cast<unsigned char>(*i)))
+      {
+      return false;
+      }
+    }
+  return !hash.empty();
+}
+}
+
+namespace remus{
+namespace worker{
+namespace detail{
+
+//------------------------------------------------------------------------------
+BlobCache::BlobCache(std::size_t maxBytes,
+                     const std::string& spillDirectory,
+                     std::size_t spillBytes):
+  MaxBytes(maxBytes),
+  ByteCount(0),
+  Usage(),
+  Blobs(),
+  SpillDirectory(spillDirectory),
+  SpillBytes(spillBytes),
+  SpilledByteCount(0),
+  SpillUsage(),
+  Spilled(),
+  Retired(),
+  NextAdvert(1),
+  Changed(true)
+{
+  //we start out changed so that the server is told about the empty cache
+  if(!this->SpillDirectory.empty())
+    {
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(this->SpillDirectory, ec);
+    if(ec)
+      { //we can't spill to a directory we can't create
+      this->SpillDirectory.clear();
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+BlobCache::~BlobCache()
+{
+  for(SpillList::const_iterator i = this->SpillUsage.begin();
+      i != this->SpillUsage.end(); ++i)
+    {
+    this->removeSpilled(i->first);
+    }
+  for(RetiredMap::const_iterator i = this->Retired.begin();
+      i != this->Retired.end(); ++i)
+    {
+    if(i->second.Spilled)
+      {
+      this->removeSpilled(i->first);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void BlobCache::maxBytes(std::size_t bytes)
+{
+  this->MaxBytes = bytes;
+  this->evict();
+}
+
+//------------------------------------------------------------------------------
+void BlobCache::spillBytes(std::size_t bytes)
+{
+  this->SpillBytes = bytes;
+  this->evictSpilled();
+}
+
+//------------------------------------------------------------------------------
+bool BlobCache::add(const std::string& hash, const remus::proto::Frame& blob)
+{
+  if(hash.empty() || blob.size() > this->MaxBytes)
+    {
+    return false;
+    }
+
+  BlobMap::iterator i = this->Blobs.find(hash);
+  if(i != this->Blobs.end())
+    { //already held, it is now the most recently used
+    this->Usage.splice(this->Usage.begin(), this->Usage, i->second);
+    return true;
+    }
+
+  //a blob moving from disk back into memory is still held, anything else
+  //changes what we hold
+  SpillMap::iterator s = this->Spilled.find(hash);
+  if(s != this->Spilled.end())
+    {
+    this->SpilledByteCount -= s->second->second;
+    this->SpillUsage.erase(s->second);
+    this->Spilled.erase(s);
+    this->removeSpilled(hash);
+    }
+  else
+    {
+    RetiredMap::iterator r = this->Retired.find(hash);
+    if(r != this->Retired.end())
+      {
+      if(r->second.Spilled)
+        {
+        this->removeSpilled(hash);
+        }
+      this->Retired.erase(r);
+      }
+    this->Changed = true;
+    }
+
+  this->Usage.push_front( UsageList::value_type(hash, blob) );
+  this->Blobs.insert( BlobMap::value_type(hash, this->Usage.begin()) );
+  this->ByteCount += blob.size();
+  this->evict();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool BlobCache::find(const std::string& hash, remus::proto::Frame& blob)
+{
+  BlobMap::iterator i = this->Blobs.find(hash);
+  if(i != this->Blobs.end())
+    {
+    this->Usage.splice(this->Usage.begin(), this->Usage, i->second);
+    blob = i->second->second;
+    return true;
+    }
+
+  SpillMap::iterator s = this->Spilled.find(hash);
+  if(s != this->Spilled.end())
+    {
+    if(!this->readSpilled(hash, blob))
+      { //somebody removed or changed the file, so we no longer hold the blob
+      this->SpilledByteCount -= s->second->second;
+      this->SpillUsage.erase(s->second);
+      this->Spilled.erase(s);
+      this->removeSpilled(hash);
+      this->Changed = true;
+      return false;
+      }
+    //the blob is being used, so bring it back into memory
+    this->add(hash, blob);
+    return true;
+    }
+
+  RetiredMap::iterator r = this->Retired.find(hash);
+  if(r != this->Retired.end())
+    {
+    if(!r->second.Spilled)
+      {
+      blob = r->second.Blob;
+      }
+    else if(!this->readSpilled(hash, blob))
+      {
+      this->removeSpilled(hash);
+      this->Retired.erase(r);
+      return false;
+      }
+    //the blob is being used again, so hold it again
+    this->add(hash, blob);
+    return true;
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+bool BlobCache::holds(const std::string& hash) const
+{
+  return this->Blobs.count(hash) > 0 || this->Spilled.count(hash) > 0;
+}
+
+//------------------------------------------------------------------------------
+std::size_t BlobCache::advertise(std::vector<std::string>& hashes)
+{
+  hashes.clear();
+  hashes.reserve(this->size());
+  for(UsageList::const_iterator i = this->Usage.begin();
+      i != this->Usage.end(); ++i)
+    {
+    hashes.push_back(i->first);
+    }
+  for(SpillList::const_iterator i = this->SpillUsage.begin();
+      i != this->SpillUsage.end(); ++i)
+    {
+    hashes.push_back(i->first);
+    }
+
+  this->Changed = false;
+  return this->NextAdvert++;
+}
+
+//------------------------------------------------------------------------------
+void BlobCache::release(std::size_t advert)
+{
+  RetiredMap::iterator i = this->Retired.begin();
+  while(i != this->Retired.end())
+    {
+    if(i->second.Advert <= advert)
+      {
+      if(i->second.Spilled)
+        {
+        this->removeSpilled(i->first);
+        }
+      i = this->Retired.erase(i);
+      }
+    else
+      {
+      ++i;
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+std::size_t BlobCache::size() const
+{
+  return this->Blobs.size() + this->Spilled.size();
+}
+
+//------------------------------------------------------------------------------
+void BlobCache::evict()
+{
+  while(this->ByteCount > this->MaxBytes && !this->Usage.empty())
+    {
+    const UsageList::value_type oldest = this->Usage.back();
+    this->ByteCount -= oldest.second.size();
+    this->Blobs.erase(oldest.first);
+    this->Usage.pop_back();
+
+    //spill the blob to disk instead of dropping it when we can
+    const bool spill = !this->SpillDirectory.empty() &&
+                       oldest.second.size() <= this->SpillBytes &&
+                       this->writeSpilled(oldest.first, oldest.second);
+    if(spill)
+      {
+      this->SpillUsage.push_front(
+              SpillList::value_type(oldest.first, oldest.second.size()) );
+      this->Spilled.insert(
+              SpillMap::value_type(oldest.first, this->SpillUsage.begin()) );
+      this->SpilledByteCount += oldest.second.size();
+      }
+    else
+      {
+      this->retire(oldest.first, oldest.second, false);
+      }
+    }
+  this->evictSpilled();
+}
+
+//------------------------------------------------------------------------------
+void BlobCache::evictSpilled()
+{
+  while(this->SpilledByteCount > this->SpillBytes && !this->SpillUsage.empty())
+    {
+    const SpillList::value_type oldest = this->SpillUsage.back();
+    this->SpilledByteCount -= oldest.second;
+    this->Spilled.erase(oldest.first);
+    this->SpillUsage.pop_back();
+
+    //the file is kept until the blob is released
+    this->retire(oldest.first, remus::proto::Frame(), true);
+    }
+}
+
+//------------------------------------------------------------------------------
+void BlobCache::retire(const std::string& hash,
+                       const remus::proto::Frame& blob,
+                       bool spilled)
+{
+  //the advert that no longer holds the blob is the next one we send
+  RetiredBlob& retired = this->Retired[hash];
+  retired.Advert = this->NextAdvert;
+  retired.Blob = blob;
+  retired.Spilled = spilled;
+  this->Changed = true;
+}
+
+//------------------------------------------------------------------------------
+std::string BlobCache::spillPath(const std::string& hash) const
+{
+  return (boost::filesystem::path(this->SpillDirectory) / hash).string();
+}
+
+//------------------------------------------------------------------------------
+bool BlobCache::writeSpilled(const std::string& hash,
+                             const remus::proto::Frame& blob)
+{
+  if(!is_SpillableHash(hash))
+    {
+    return false;
+    }
+
+  bool written = false;
+    {
+    std::ofstream file(this->spillPath(hash).c_str(),
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+    written = file.good();
+    }
+  if(!written)
+    { //don't leave a partial blob around
+    this->removeSpilled(hash);
+    }
+  return written;
+}
+
+//------------------------------------------------------------------------------
+bool BlobCache::readSpilled(const std::string& hash,
+                            remus::proto::Frame& blob) const
+{
+  std::ifstream file(this->spillPath(hash).c_str(),
+                     std::ios::in | std::ios::binary | std::ios::ate);
+  if(!file)
+    {
+    return false;
+    }
+
+  std::string data(static_cast<std::size_t>(file.tellg()), '\0');
+  file.seekg(0, std::ios::beg);
+  if(!data.empty() && !file.read(&data[0], static_cast<std::streamsize>(data.size())))
+    {
+    return false;
+    }
+
+  //a truncated or modified file must not end up as the contents of a job
+  remus::proto::Frame read = remus::proto::detail::make_HeaderFrame(data);
+  if(remus::proto::to_ContentHash(read) != hash)
+    {
+    return false;
+    }
+  blob = read;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void BlobCache::removeSpilled(const std::string& hash)
+{
+  boost::system::error_code ec;
+  boost::filesystem::remove(this->spillPath(hash), ec);
+}
+
+}
+}
+}
@@ -0,0 +1,160 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+
+#ifndef remus_worker_detail_BlobCache_h
+#define remus_worker_detail_BlobCache_h
+
+#include <remus/common/CompilerInformation.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#include <boost/unordered_map.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <remus/proto/FrameSet.h>
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace remus{
+namespace worker{
+namespace detail{
+
+//A cache of the job contents a worker has been sent, keyed by the content
+//hash of each blob, so that the server only has to send the hash of the
+//contents the worker already holds.
+//
+//The cache holds at most maxBytes worth of blobs in memory, and when given
+//a spill directory the least recently used blobs are written to disk
+//instead of being dropped, until spillBytes worth of blobs are on disk.
+//
+//The server decides which blobs to reference from the hashes we last
+//advertised to it, so blobs that are dropped are retired instead of freed.
+//Retired blobs can still be found until the server has acknowledged an
+//advert that doesn't hold them.
+//
+//The cache is only used by the thread that talks to the server, so it
+//isn't thread safe.
+class BlobCache
+{
+public:
+  BlobCache(std::size_t maxBytes,
+            const std::string& spillDirectory = std::string(),
+            std::size_t spillBytes = 0);
+
+  //removes every blob that was spilled to disk
+  ~BlobCache();
+
+  //change how many bytes of blobs are held in memory and on disk,
+  //dropping blobs when the cache is now too large
+  void maxBytes(std::size_t bytes);
+  std::size_t maxBytes() const { return this->MaxBytes; }
+  void spillBytes(std::size_t bytes);
+  std::size_t spillBytes() const { return this->SpillBytes; }
+
+  //store the blob under the given hash. Returns false when the blob
+  //is larger than the cache, and isn't stored
+  bool add(const std::string& hash, const remus::proto::Frame& blob);
+
+  //returns true and sets blob when the cache holds a blob with the given
+  //hash, or the blob has been retired but not released. The blob is marked
+  //as the most recently used, and is loaded back into memory when it was
+  //spilled to disk.
+  bool find(const std::string& hash, remus::proto::Frame& blob);
+
+  //returns true when the cache holds a blob with the given hash, retired
+  //blobs aren't held
+  bool holds(const std::string& hash) const;
+
+  //returns true when the blobs held have changed since the last advert
+  bool changed() const { return this->Changed; }
+
+  //fills hashes with the hash of every blob held, and returns the number
+  //of the advert. Blobs dropped from now on are kept until the advert
+  //after this one is released.
+  std::size_t advertise(std::vector<std::string>& hashes);
+
+  //the server has acknowledged the given advert, so free the blobs that
+  //were retired before it was sent
+  void release(std::size_t advert);
+
+  //number of blobs held in memory and on disk
+  std::size_t size() const;
+
+  //number of bytes of blobs held in memory
+  std::size_t byteCount() const { return this->ByteCount; }
+
+  //number of bytes of blobs held on disk
+  std::size_t spilledByteCount() const { return this->SpilledByteCount; }
+
+  //number of blobs that are retired and haven't been released
+  std::size_t retiredCount() const { return this->Retired.size(); }
+
+private:
+  //explicitly state the cache doesn't support copy or move semantics
+  BlobCache(const BlobCache&);
+  void operator=(const BlobCache&);
+
+  //move the least recently used blobs out of memory until we fit in
+  //MaxBytes, and off disk until we fit in SpillBytes
+  void evict();
+  void evictSpilled();
+
+  //keep a dropped blob until the next advert is released
+  void retire(const std::string& hash, const remus::proto::Frame& blob,
+              bool spilled);
+
+  //read and write the blobs spilled to disk. Reading fails when the file
+  //is gone, or its contents no longer match the hash it is named after
+  std::string spillPath(const std::string& hash) const;
+  bool writeSpilled(const std::string& hash, const remus::proto::Frame& blob);
+  bool readSpilled(const std::string& hash, remus::proto::Frame& blob) const;
+  void removeSpilled(const std::string& hash);
+
+  //the blobs in memory ordered from most to least recently used
+  typedef std::list< std::pair<std::string, remus::proto::Frame> > UsageList;
+  typedef boost::unordered_map< std::string, UsageList::iterator > BlobMap;
+
+  //the hash and size of the blobs on disk, from most to least recently used
+  typedef std::list< std::pair<std::string, std::size_t> > SpillList;
+  typedef boost::unordered_map< std::string, SpillList::iterator > SpillMap;
+
+  struct RetiredBlob
+  {
+    std::size_t Advert;
+    remus::proto::Frame Blob;
+    bool Spilled;
+  };
+  typedef boost::unordered_map< std::string, RetiredBlob > RetiredMap;
+
+  std::size_t MaxBytes;
+  std::size_t ByteCount;
+  UsageList Usage;
+  BlobMap Blobs;
+
+  std::string SpillDirectory;
+  std::size_t SpillBytes;
+  std::size_t SpilledByteCount;
+  SpillList SpillUsage;
+  SpillMap Spilled;
+
+  RetiredMap Retired;
+  std::size_t NextAdvert;
+  bool Changed;
+};
+
+}
+}
+}
+
+#endif
@@ -53,12 +53,21 @@ class JobQueue::JobQueueImplementation
   boost::condition_variable QueueChanged;
   std::deque< remus::worker::Job > Queue;
 
+  //the number of jobs we have been sent by the server, including the jobs
+  //that have since been taken or terminated
+  std::size_t ReceivedCount;
+
   //a set of jobs that the JobQueue has been told should be terminated
   std::set< boost::uuids::uuid > TerminatedJobs;
 
   //need to store our endpoint so we can pass it to the worker
   std::string EndPoint;
 
+  //the polling thread sleeps until it has a message, so we wake it up
+  //through this endpoint when it has to stop
+  zmq::context_t* Context;
+  zmq::socketInfo<zmq::proto::inproc> WakeUpInfo;
+
   //state to tell when we should stop polling
   bool ContinuePolling;
 
@@ -78,8 +87,11 @@ JobQueueImplementation(zmq::context_t& context,
   QueueMutex(),
   QueueChanged(),
   Queue(),
+  ReceivedCount(0),
   TerminatedJobs(),
   EndPoint(),
+  Context(&context),
+  WakeUpInfo(queue_info.host() + "_wakeup"),
   ContinuePolling(true),
   PollingStarted(false),
   PollingFinished(false)
@@ -116,6 +128,12 @@ void stop()
   this->PollingFinished = true;
 }
 
+//------------------------------------------------------------------------------
+void wakeUp()
+{
+  zmq::wake_up(*this->Context, this->WakeUpInfo.endpoint());
+}
+
 //------------------------------------------------------------------------------
 void pollForJobs(zmq::context_t* context,
                  zmq::socketInfo<zmq::proto::inproc> queue_info)
@@ -129,18 +147,29 @@ void pollForJobs(zmq::context_t* context,
   //otherwise we can get segment-faults when trying to use multiple workers in
   //the same process.
   zmq::socket_t serverComm(*context,ZMQ_PAIR);
+  zmq::socket_t wakeUpComm(*context,ZMQ_PULL);
 
   //bind to the work_jobs communication channel first
   this->EndPoint = zmq::bindToAddress(serverComm, queue_info).endpoint();
+  zmq::bindToAddress(wakeUpComm, this->WakeUpInfo);
 
   //now that we have finished binding we are ready to accept jobs
   this->PollingStarted = true;
 
-  zmq::pollitem_t item  = { serverComm,  0, ZMQ_POLLIN, 0 };
+  //we are woken up when we have a message, or have been told to stop, so
+  //the timeout only limits how long a single poll can be
+  const boost::int64_t pollTimeout(60000);
+
+  zmq::pollitem_t items[2]  = { { serverComm,  0, ZMQ_POLLIN, 0 },
+                                { wakeUpComm,  0, ZMQ_POLLIN, 0 } };
   while( this->ContinuePolling )
     {
-    zmq::poll_safely(&item,1,250);
-    if(item.revents & ZMQ_POLLIN)
+    zmq::poll_safely(&items[0],2,pollTimeout);
+    if(items[1].revents & ZMQ_POLLIN)
+      {
+      zmq::drain_wake_ups(wakeUpComm);
+      }
+    if(items[0].revents & ZMQ_POLLIN)
       {
       remus::proto::Response response =
           remus::proto::receive_Response(&serverComm);
@@ -210,11 +239,11 @@ void addItem(remus::proto::Response& response )
 {
   boost::lock_guard<boost::mutex> lock(this->QueueMutex);
 
-  //required to use the char*, len constructor as response's data can
-  //be binary data with lots of null terminators.
-  const std::string data(response.data(), response.dataSize());
-  remus::worker::Job j = remus::worker::to_Job(data);
+  //the job references the received frames instead of copying the
+  //submission contents out of them
+  remus::worker::Job j = remus::proto::to_WorkerJob(response.frames());
   this->Queue.push_back( j );
+  ++this->ReceivedCount;
 
   this->QueueChanged.notify_all();
 }
@@ -261,6 +290,13 @@ std::size_t size()
   return this->Queue.size();
 }
 
+//------------------------------------------------------------------------------
+std::size_t receivedCount()
+{
+  boost::lock_guard<boost::mutex> lock(this->QueueMutex);
+  return this->ReceivedCount;
+}
+
 //------------------------------------------------------------------------------
 bool isReady() const
 {
@@ -285,6 +321,7 @@ JobQueue::JobQueue(zmq::context_t& context,
 JobQueue::~JobQueue()
 {
   this->Implementation->stop();
+  this->Implementation->wakeUp();
 }
 
 //------------------------------------------------------------------------------
@@ -317,6 +354,12 @@ std::size_t JobQueue::size() const
   return this->Implementation->size();
 }
 
+//------------------------------------------------------------------------------
+std::size_t JobQueue::receivedCount() const
+{
+  return this->Implementation->receivedCount();
+}
+
 //------------------------------------------------------------------------------
 bool JobQueue::isReady() const
 {
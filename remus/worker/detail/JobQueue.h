@@ -55,6 +55,10 @@ public:
   //return the number of jobs waiting for work
   std::size_t size() const;
 
+  //return the number of jobs that have been sent by the server, including
+  //the jobs that have since been taken or terminated
+  std::size_t receivedCount() const;
+
   //has finished setting up and is ready for jobs
   bool isReady() const;
 
@@ -12,13 +12,17 @@
 
 #include <remus/worker/detail/MessageRouter.h>
 
+#include <remus/proto/FrameSet.h>
+#include <remus/proto/JobStatus.h>
 #include <remus/proto/Message.h>
 #include <remus/proto/Response.h>
 #include <remus/proto/zmqHelper.h>
 
 #include <remus/common/CompilerInformation.h>
+#include <remus/common/MonotonicClock.h>
 #include <remus/common/PollingMonitor.h>
 #include <remus/worker/Job.h>
+#include <remus/worker/detail/BlobCache.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/thread.hpp>
@@ -26,6 +30,10 @@ REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/uuid/uuid.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <algorithm>
+#include <deque>
+#include <sstream>
+
 namespace remus{
 namespace worker{
 namespace detail{
@@ -35,7 +43,40 @@ class MessageRouter::MessageRouterImplementation
 {
   std::string WorkerEndpoint;
   std::string QueueEndpoint;
-  std::size_t OutstandingResults;
+
+  //results the worker is about to send, in the order they will be sent
+  std::deque<MessageRouter::ResultAck> ExpectedResults;
+
+  //results that have been sent to the server and are waiting on it to
+  //acknowledge them. Only used by the polling thread
+  std::deque<MessageRouter::ResultAck> OutstandingResults;
+
+  //the number of results with an ack that haven't been acknowledged
+  std::size_t PendingAckedResults;
+  mutable boost::condition_variable AckedResultsChanged;
+
+  //the blob cache settings the worker has asked for, which the polling
+  //thread applies
+  bool CacheSettingsChanged;
+  remus::common::MeshIOType CacheSettingsMeshTypes;
+  std::size_t CacheMaxBytes;
+  std::string CacheSpillDirectory;
+  std::size_t CacheSpillBytes;
+
+  //the cache of the blobs of the jobs we have been sent, and the mesh
+  //types we advertise it with. Only used by the polling thread
+  boost::scoped_ptr<BlobCache> Cache;
+  remus::common::MeshIOType CacheMeshTypes;
+
+  //the wire format of the messages we send the server ourselves, messages
+  //from the worker are forwarded in the format they were sent in. Only
+  //used by the polling thread
+  remus::proto::WireFormat::Type Format;
+
+  //the polling thread sleeps until it has a message or needs to send a
+  //heartbeat, so we wake it up through this endpoint when it has to stop
+  zmq::socketInfo<zmq::proto::inproc> WakeUpInfo;
+  zmq::context_t* WakeUpContext;
 
   //kept as a member variable so that we can allow the user to specify
   //custom polling rates for workers
@@ -63,7 +104,20 @@ MessageRouterImplementation(
                       const zmq::socketInfo<zmq::proto::inproc>& queue_info):
   WorkerEndpoint(worker_info.endpoint()),
   QueueEndpoint(queue_info.endpoint()),
-  OutstandingResults(0),
+  ExpectedResults(),
+  OutstandingResults(),
+  PendingAckedResults(0),
+  AckedResultsChanged(),
+  CacheSettingsChanged(false),
+  CacheSettingsMeshTypes(),
+  CacheMaxBytes(0),
+  CacheSpillDirectory(),
+  CacheSpillBytes(0),
+  Cache(),
+  CacheMeshTypes(),
+  Format(remus::proto::WireFormat::Binary),
+  WakeUpInfo(worker_info.host() + "_wakeup"),
+  WakeUpContext(NULL),
   PollMonitor(boost::int64_t(250), boost::int64_t(60000)), //assign a low floor for faster testing
   ThreadMutex(),
   ThreadStatusChanged(),
@@ -114,6 +168,7 @@ bool startTalking(const remus::worker::ServerConnection& server_info,
     launchThread = !this->ContinuePolling && !threadIsRunning;
     if(launchThread)
       {
+      this->WakeUpContext = &internal_inproc_context;
       boost::scoped_ptr<boost::thread> pollthread(
         new boost::thread( &MessageRouterImplementation::poll, this,
                             server_info,
@@ -132,12 +187,82 @@ bool startTalking(const remus::worker::ServerConnection& server_info,
   return this->isTalking();
 }
 
+//----------------------------------------------------------------------------
+bool expectResult(const MessageRouter::ResultAck& ack)
+{
+  bool queued = false;
+    {
+    boost::lock_guard<boost::mutex> lock(ThreadMutex);
+    //once we have stopped polling nobody will send the result, so
+    //don't make the worker wait on it
+    queued = this->ContinuePolling;
+    if(queued)
+      {
+      this->ExpectedResults.push_back(ack);
+      if(ack)
+        {
+        ++this->PendingAckedResults;
+        }
+      }
+    }
+  if(!queued && ack)
+    {
+    ack->set_value(false);
+    }
+  return queued;
+}
+
+//----------------------------------------------------------------------------
+std::size_t pendingResultCount() const
+{
+  boost::lock_guard<boost::mutex> lock(ThreadMutex);
+  return this->PendingAckedResults;
+}
+
+//----------------------------------------------------------------------------
+void waitForResults() const
+{
+  boost::unique_lock<boost::mutex> lock(ThreadMutex);
+  while(this->PendingAckedResults > 0)
+    {
+    AckedResultsChanged.wait(lock);
+    }
+}
+
+//----------------------------------------------------------------------------
+void cacheBlobs(const remus::common::MeshIOType& meshTypes,
+                std::size_t maxBytes,
+                const std::string& spillDirectory,
+                std::size_t spillBytes)
+{
+  zmq::context_t* context = NULL;
+    {
+    boost::lock_guard<boost::mutex> lock(ThreadMutex);
+    this->CacheSettingsChanged = true;
+    this->CacheSettingsMeshTypes = meshTypes;
+    this->CacheMaxBytes = maxBytes;
+    this->CacheSpillDirectory = spillDirectory;
+    this->CacheSpillBytes = spillBytes;
+    if(this->ContinuePolling)
+      {
+      context = this->WakeUpContext;
+      }
+    }
+
+  //when we aren't polling yet the settings are applied once we start
+  if(context)
+    {
+    zmq::wake_up(*context, this->WakeUpInfo.endpoint());
+    }
+}
+
 //----------------------------------------------------------------------------
 void stop()
 {
   if(this->PollingThread && this->isTalking())
     {
     this->setIsTalking(false);
+    zmq::wake_up(*this->WakeUpContext, this->WakeUpInfo.endpoint());
     this->PollingThread->join();
     }
 }
@@ -163,6 +288,56 @@ void waitForThreadToStart()
     }
 }
 
+//----------------------------------------------------------------------------
+//returns how the next result the worker sends is acknowledged. An empty
+//ack means the worker is waiting on the acknowledgement itself
+MessageRouter::ResultAck takeExpectedResult()
+{
+  boost::lock_guard<boost::mutex> lock(ThreadMutex);
+  MessageRouter::ResultAck ack;
+  if(!this->ExpectedResults.empty())
+    {
+    ack = this->ExpectedResults.front();
+    this->ExpectedResults.pop_front();
+    }
+  return ack;
+}
+
+//----------------------------------------------------------------------------
+void acknowledgeResult(const MessageRouter::ResultAck& ack, bool received)
+{
+  ack->set_value(received);
+    {
+    boost::lock_guard<boost::mutex> lock(ThreadMutex);
+    --this->PendingAckedResults;
+    }
+  this->AckedResultsChanged.notify_all();
+}
+
+//----------------------------------------------------------------------------
+//the server will never acknowledge the results that are still outstanding,
+//so let everybody waiting on them know
+void abandonResults()
+{
+  std::deque<MessageRouter::ResultAck> abandoned;
+  abandoned.swap(this->OutstandingResults);
+    {
+    boost::lock_guard<boost::mutex> lock(ThreadMutex);
+    abandoned.insert(abandoned.end(), this->ExpectedResults.begin(),
+                                      this->ExpectedResults.end());
+    this->ExpectedResults.clear();
+    }
+
+  typedef std::deque<MessageRouter::ResultAck>::const_iterator It;
+  for(It i = abandoned.begin(); i != abandoned.end(); ++i)
+    {
+    if(*i)
+      {
+      this->acknowledgeResult(*i, false);
+      }
+    }
+}
+
 //------------------------------------------------------------------------------
 void poll(remus::worker::ServerConnection server_info,
           zmq::context_t* internal_inproc_context)
@@ -172,6 +347,7 @@ void poll(remus::worker::ServerConnection server_info,
 
   zmq::socket_t serverComm(*(server_info.context()),ZMQ_DEALER);
   zmq::connectToAddress(serverComm, server_info.endpoint());
+  this->Format = server_info.wireFormat();
 
   zmq::socket_t queueComm(*internal_inproc_context,ZMQ_PAIR);
   zmq::connectToAddress(queueComm,  this->QueueEndpoint);
@@ -179,11 +355,21 @@ void poll(remus::worker::ServerConnection server_info,
   zmq::socket_t workerComm(*internal_inproc_context,ZMQ_PAIR);
   zmq::connectToAddress(workerComm, this->WorkerEndpoint);
 
-  zmq::pollitem_t items[2]  = {
+  zmq::socket_t wakeUpComm(*internal_inproc_context,ZMQ_PULL);
+  zmq::bindToAddress(wakeUpComm, this->WakeUpInfo);
+
+  zmq::pollitem_t items[3]  = {
                                 { workerComm,  0, ZMQ_POLLIN, 0 },
-                                { serverComm,  0, ZMQ_POLLIN, 0 }
+                                { serverComm,  0, ZMQ_POLLIN, 0 },
+                                { wakeUpComm,  0, ZMQ_POLLIN, 0 }
                               };
 
+  //the first heartbeat lets the server know about us right away, after
+  //that we only need to heartbeat when we haven't sent the server anything
+  //for as long as we have told it to wait for our next heartbeat
+  typedef remus::common::MonotonicClock MonotonicClock;
+  MonotonicClock::TimePoint nextHeartBeat = MonotonicClock::now();
+
 
   //We need to notify the Thread management that polling is about to start.
   //This allows the calling thread to resume, as it has been waiting for this
@@ -192,11 +378,24 @@ void poll(remus::worker::ServerConnection server_info,
   this->setIsTalking(true);
   while( this->isTalking() )
     {
-    zmq::poll_safely(&items[0],2,this->PollMonitor.current());
+    //sleep until we have a message, or it is time for the next heartbeat
+    const boost::int64_t untilHeartBeat = MonotonicClock::toMilliseconds(
+                                  nextHeartBeat - MonotonicClock::now() );
+    const boost::int64_t timeout = std::min(untilHeartBeat,
+                                            this->PollMonitor.maxTimeOut());
+    zmq::poll_safely(&items[0],3,std::max(timeout, boost::int64_t(1)));
     this->PollMonitor.pollOccurred();
 
-    //handle taking
-    bool notSentToServer = true;
+    //the poll has read the clock, use that reading as the current time
+    const MonotonicClock::TimePoint currentTime = this->PollMonitor.lastPollTime();
+    const MonotonicClock::TimePoint heartBeatInterval =
+              MonotonicClock::milliseconds(this->PollMonitor.maxTimeOut());
+
+    if(items[2].revents & ZMQ_POLLIN)
+        {
+        //we have been woken up, the loop condition tells us if we need to stop
+        zmq::drain_wake_ups(wakeUpComm);
+        }
     if(items[1].revents & ZMQ_POLLIN)
         {
         //handle accepting message from the server and forwarding
@@ -207,10 +406,11 @@ void poll(remus::worker::ServerConnection server_info,
         }
     if(items[0].revents & ZMQ_POLLIN)
         {
-        notSentToServer = false;
         //handle accepting messages from the worker and forwarding
-        //them to the server
+        //them to the server. The server treats any message from us
+        //as a heartbeat
         this->handleWorkerMessage(workerComm, serverComm, queueComm);
+        nextHeartBeat = currentTime + heartBeatInterval;
         if(!ContinueForwardingToServer)
           {
           //we are shutting down so we mark that we will not accept any
@@ -219,13 +419,20 @@ void poll(remus::worker::ServerConnection server_info,
           }
         }
 
-     if(notSentToServer)
+    //tell the server which blobs we hold whenever that changes
+    this->updateBlobCache(serverComm);
+
+     if(nextHeartBeat <= currentTime)
         {
         //we are going to send a heartbeat now since we have gone long enough
         //without sending a message to the server
         this->sendHeartBeat(serverComm, this->PollMonitor);
+        nextHeartBeat = currentTime + heartBeatInterval;
         }
     }
+
+  //we have stopped polling, so nothing we are holding will be acknowledged
+  this->abandonResults();
 }
 
 //------------------------------------------------------------------------------
@@ -239,6 +446,15 @@ void handleWorkerMessage(zmq::socket_t& workerComm,
   //always is connected to a server
   remus::proto::Message message = remus::proto::receive_Message(&workerComm);
 
+  //every result the worker sends has a matching expectation, which we
+  //need to consume even when we don't forward the result
+  MessageRouter::ResultAck resultAck;
+  const bool isResult = message.serviceType()==remus::RETRIEVE_RESULT;
+  if(isResult)
+    {
+    resultAck = this->takeExpectedResult();
+    }
+
   //next we check if we are forwarding messages to the server,
   //if we aren't doing that there is no point to send the message
   //otherwise it will hang around in our zmq inbox and make
@@ -275,9 +491,14 @@ void handleWorkerMessage(zmq::socket_t& workerComm,
       //server to get our data, we will drop the results as the socket linger
       //time is less than the amount of time it takes to transmit the results
       //to the server.
-      ++this->OutstandingResults;
+      this->OutstandingResults.push_back(resultAck);
       }
     }
+  else if(isResult && resultAck)
+    {
+    //the result will never reach the server
+    this->acknowledgeResult(resultAck, false);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -304,14 +525,23 @@ void handleServerMessage( zmq::socket_t& workerComm,
         }
       //if the server is shutting down the worker and the worker
       //is still waiting for a response to a RETRIEVE_RESULT we
-      //send that first
-      while(this->OutstandingResults > 0)
+      //send that first. Results sent with returnResultAsync are told that the
+      //server didn't receive them
+      while(!this->OutstandingResults.empty())
         {
-        remus::proto::send_NonBlockingResponse(remus::RETRIEVE_RESULT,
-                                               remus::INVALID_MSG,
-                                               &workerComm,
-                                               (zmq::SocketIdentity()));
-        --this->OutstandingResults;
+        MessageRouter::ResultAck ack = this->OutstandingResults.front();
+        this->OutstandingResults.pop_front();
+        if(ack)
+          {
+          this->acknowledgeResult(ack, false);
+          }
+        else
+          {
+          remus::proto::send_NonBlockingResponse(remus::RETRIEVE_RESULT,
+                                                 remus::INVALID_MSG,
+                                                 &workerComm,
+                                                 (zmq::SocketIdentity()));
+          }
         }
 
 
@@ -319,6 +549,24 @@ void handleServerMessage( zmq::socket_t& workerComm,
       //might not exist so don't continue trying to send it messages
       this->ContinueForwardingToServer = false;
       }
+    else if(goodToForwardToQueue && this->Cache &&
+            response.serviceType() == remus::MAKE_MESH)
+      {
+      //the job can reference blobs we hold instead of sending them
+      this->forwardCachedJob(response, serverComm, queueComm);
+      }
+    else if(response.serviceType() == remus::CACHED_BLOBS && this->Cache)
+      {
+      //the server now knows which blobs we hold as of the given advert, so
+      //it won't reference the blobs we dropped before it
+      std::istringstream buffer(std::string(response.data(),
+                                            response.dataSize()));
+      std::size_t advert = 0;
+      if(buffer >> advert)
+        {
+        this->Cache->release(advert);
+        }
+      }
     else if(goodToForwardToQueue &&
             ( response.serviceType() == remus::TERMINATE_JOB ||
               response.serviceType() == remus::MAKE_MESH ) )
@@ -327,18 +575,132 @@ void handleServerMessage( zmq::socket_t& workerComm,
                                      &queueComm,
                                      zmq::SocketIdentity());
       }
-    else if ( response.serviceType() == remus::RETRIEVE_RESULT)
-      { //the worker is notifying us that it recieved our results, so decrement
-        //our outstanding results, and forward the message to the worker so
-        //it can stop blocking
-      remus::proto::forward_Response(response,
-                                     &workerComm,
-                                     zmq::SocketIdentity());
-      --this->OutstandingResults;
+    else if ( response.serviceType() == remus::RETRIEVE_RESULT &&
+              !this->OutstandingResults.empty() )
+      { //the server is notifying us that it recieved our results. The server
+        //acknowledges results in the order they are sent, so this is for our
+        //oldest outstanding result. Either forward the message to the worker
+        //so it can stop blocking, or complete the async result
+      MessageRouter::ResultAck ack = this->OutstandingResults.front();
+      this->OutstandingResults.pop_front();
+      if(ack)
+        {
+        this->acknowledgeResult(ack, true);
+        }
+      else
+        {
+        remus::proto::forward_Response(response,
+                                       &workerComm,
+                                       zmq::SocketIdentity());
+        }
       }
       // do nothing if it isn't terminate_job, terminate_worker,
-      // make_mesh or retrieve result
+      // make_mesh, cached_blobs or retrieve result
+    }
+}
+
+//------------------------------------------------------------------------------
+//jobs sent to a worker that caches blobs have the hash of each blob, and
+//only the blobs we didn't hold when the server sent the job. We fill in
+//the blobs from the cache and cache the blobs we are sent, so the job queue
+//gets the job as if every blob had been sent.
+void forwardCachedJob(const remus::proto::Response& response,
+                      zmq::socket_t& serverComm,
+                      zmq::socket_t& queueComm)
+{
+  remus::proto::ReferencedFrameSet refs =
+                      remus::proto::to_ReferencedFrameSet(response.frames());
+  if(refs.Frames.Header.size() == 0)
+    { //the job doesn't reference any blobs
+    remus::proto::forward_Response(response,
+                                   &queueComm,
+                                   zmq::SocketIdentity());
+    return;
+    }
+
+  std::vector<remus::proto::Frame>& blobs = refs.Frames.Blobs;
+  for(std::size_t i=0; i < blobs.size(); ++i)
+    {
+    const std::string& hash = refs.Hashes[i];
+    if(refs.Referenced[i])
+      {
+      if(!this->Cache->find(hash, blobs[i]))
+        {
+        //we have lost the blob, so the job can't be run. Tell the server
+        //the job failed instead of running it with the wrong contents
+        const remus::proto::WorkerJob job = remus::proto::to_WorkerJob(refs.Frames);
+        remus::proto::send_Message(this->CacheMeshTypes,
+                 remus::MESH_STATUS,
+                 remus::proto::to_string(remus::proto::make_FailedJobStatus(
+                        job.id(), "worker no longer holds a cached blob")),
+                 &serverComm,
+                 this->Format);
+        return;
+        }
+      }
+    else if(!hash.empty())
+      {
+      this->Cache->add(hash, blobs[i]);
+      }
+    }
+
+  remus::proto::send_NonBlockingResponse(remus::MAKE_MESH,
+                                         refs.Frames,
+                                         &queueComm,
+                                         zmq::SocketIdentity());
+}
+
+//------------------------------------------------------------------------------
+//creates or resizes the blob cache when the worker has asked us to, and
+//sends the server an advert of the blobs we hold whenever that changes
+void updateBlobCache(zmq::socket_t& serverComm)
+{
+    {
+    boost::lock_guard<boost::mutex> lock(ThreadMutex);
+    if(this->CacheSettingsChanged)
+      {
+      this->CacheSettingsChanged = false;
+      this->CacheMeshTypes = this->CacheSettingsMeshTypes;
+      if(!this->Cache)
+        {
+        this->Cache.reset( new BlobCache(this->CacheMaxBytes,
+                                         this->CacheSpillDirectory,
+                                         this->CacheSpillBytes) );
+        }
+      else
+        {
+        this->Cache->maxBytes(this->CacheMaxBytes);
+        this->Cache->spillBytes(this->CacheSpillBytes);
+        }
+      }
+    }
+
+  //servers that only understand the text wire format have no use for
+  //adverts, and never reference the blobs we hold
+  if(!this->Cache || !this->Cache->changed() ||
+     !this->ContinueForwardingToServer ||
+     this->Format == remus::proto::WireFormat::Text)
+    {
+    return;
+    }
+
+  //the advert starts with its number, which the server acknowledges,
+  //followed by one hash per line
+  std::vector<std::string> hashes;
+  const std::size_t advert = this->Cache->advertise(hashes);
+
+  std::ostringstream buffer;
+  buffer << advert << '\n';
+  typedef std::vector<std::string>::const_iterator It;
+  for(It i = hashes.begin(); i != hashes.end(); ++i)
+    {
+    buffer << *i << '\n';
     }
+  remus::proto::send_Message(this->CacheMeshTypes,
+                             remus::CACHED_BLOBS,
+                             buffer.str(),
+                             &serverComm,
+                             this->Format);
 }
 
 //------------------------------------------------------------------------------
@@ -360,7 +722,8 @@ void sendHeartBeat(zmq::socket_t& serverComm,
     remus::proto::send_Message(remus::common::MeshIOType(),
                                remus::HEARTBEAT,
                                boost::lexical_cast<std::string>(polldur),
-                               &serverComm);
+                               &serverComm,
+                               this->Format);
     }
 }
 
@@ -407,6 +770,34 @@ void MessageRouter::stop()
   return this->Implementation->stop();
 }
 
+//-----------------------------------------------------------------------------
+bool MessageRouter::expectResult(const ResultAck& ack)
+{
+  return this->Implementation->expectResult(ack);
+}
+
+//-----------------------------------------------------------------------------
+std::size_t MessageRouter::pendingResultCount() const
+{
+  return this->Implementation->pendingResultCount();
+}
+
+//-----------------------------------------------------------------------------
+void MessageRouter::waitForResults() const
+{
+  this->Implementation->waitForResults();
+}
+
+//-----------------------------------------------------------------------------
+void MessageRouter::cacheBlobs(const remus::common::MeshIOType& meshTypes,
+                               std::size_t maxBytes,
+                               const std::string& spillDirectory,
+                               std::size_t spillBytes)
+{
+  this->Implementation->cacheBlobs(meshTypes, maxBytes,
+                                   spillDirectory, spillBytes);
+}
+
 //-----------------------------------------------------------------------------
 remus::common::PollingMonitor MessageRouter::pollingMonitor() const
 {
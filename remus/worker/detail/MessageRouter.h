@@ -16,12 +16,15 @@
 #include <remus/proto/zmqSocketInfo.h>
 #include <remus/worker/ServerConnection.h>
 
+#include <remus/common/MeshIOType.h>
 #include <remus/common/PollingMonitor.h>
 
 REMUS_THIRDPARTY_PRE_INCLUDE
 #include <boost/scoped_ptr.hpp>
 REMUS_THIRDPARTY_POST_INCLUDE
 
+#include <future>
+#include <memory>
 #include <string>
 
 namespace remus{
@@ -64,6 +67,34 @@ public:
   //Out of band way of stopping the MessageRouter.
   void stop();
 
+  //The server acknowledges every result it is sent, in the order they were
+  //sent. Before sending a RETRIEVE_RESULT the worker tells us how that
+  //result is acknowledged. When ack is empty the acknowledgement is
+  //forwarded to the worker, otherwise the ack is set to true once the server
+  //has the result, or false if the server goes away before it does.
+  //Returns false when we have stopped routing, and the result shouldn't
+  //be sent.
+  typedef std::shared_ptr< std::promise<bool> > ResultAck;
+  bool expectResult(const ResultAck& ack);
+
+  //returns the number of results with an ack that haven't been acknowledged
+  std::size_t pendingResultCount() const;
+
+  //blocks until every result with an ack has been acknowledged
+  void waitForResults() const;
+
+  //Keep a local cache of the blobs of the jobs we are sent, so that the
+  //server only sends the hash of the blobs we already hold. The cache holds
+  //maxBytes of blobs in memory, and when spillDirectory isn't empty up to
+  //spillBytes of blobs on disk. The server is told which blobs we hold
+  //every time that changes, with messages of the given mesh types.
+  //The spill directory can't be changed once the cache exists, calling
+  //this again only changes how many bytes the cache holds.
+  void cacheBlobs(const remus::common::MeshIOType& meshTypes,
+                  std::size_t maxBytes,
+                  const std::string& spillDirectory,
+                  std::size_t spillBytes);
+
   //Returns the polling monitor, modifications of the returned object will
   //modify the message router instance.
   remus::common::PollingMonitor pollingMonitor() const;
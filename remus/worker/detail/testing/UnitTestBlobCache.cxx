@@ -0,0 +1,236 @@
+//=============================================================================
+//
+//  Copyright (c) Kitware, Inc.
+//  All rights reserved.
+//  See LICENSE.txt for details.
+//
+//  This software is distributed WITHOUT ANY WARRANTY; without even
+//  the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+//  PURPOSE.  See the above copyright notice for more information.
+//
+//=============================================================================
+#include <remus/worker/detail/BlobCache.h>
+
+#include <remus/testing/Testing.h>
+
+REMUS_THIRDPARTY_PRE_INCLUDE
+#define BOOST_FILESYSTEM_VERSION 3
+#include <boost/filesystem.hpp>
+REMUS_THIRDPARTY_POST_INCLUDE
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using remus::proto::Frame;
+using remus::worker::detail::BlobCache;
+
+Frame make_Frame(const std::string& data)
+{
+  std::string copy(data);
+  return remus::proto::detail::make_HeaderFrame(copy);
+}
+
+std::string to_string(const Frame& f)
+{
+  return std::string(f.data(), f.size());
+}
+
+//the hash a blob is cached under, which spilled blobs are checked against
+std::string hash_of(const std::string& data)
+{
+  return remus::proto::to_ContentHash(make_Frame(data));
+}
+
+bool advertised(const std::vector<std::string>& hashes, const std::string& h)
+{
+  return std::find(hashes.begin(), hashes.end(), h) != hashes.end();
+}
+
+//------------------------------------------------------------------------------
+void verify_add_and_find()
+{
+  BlobCache cache(1024);
+  REMUS_ASSERT( (cache.size() == 0) );
+
+  //a new cache needs to tell the server it holds nothing
+  REMUS_ASSERT( (cache.changed()) );
+  std::vector<std::string> hashes;
+  const std::size_t first = cache.advertise(hashes);
+  REMUS_ASSERT( (hashes.empty()) );
+  REMUS_ASSERT( (!cache.changed()) );
+
+  Frame blob;
+  REMUS_ASSERT( (!cache.find("a", blob)) );
+  REMUS_ASSERT( (cache.add("a", make_Frame("aaaa"))) );
+  REMUS_ASSERT( (cache.holds("a")) );
+  REMUS_ASSERT( (cache.changed()) );
+  REMUS_ASSERT( (cache.find("a", blob)) );
+  REMUS_ASSERT( (to_string(blob) == "aaaa") );
+  REMUS_ASSERT( (cache.byteCount() == 4) );
+
+  //blobs without a hash or larger than the cache aren't held
+  REMUS_ASSERT( (!cache.add("", make_Frame("bbbb"))) );
+  REMUS_ASSERT( (!cache.add("big", make_Frame(std::string(2048,'b')))) );
+  REMUS_ASSERT( (!cache.holds("big")) );
+
+  const std::size_t second = cache.advertise(hashes);
+  REMUS_ASSERT( (second > first) );
+  REMUS_ASSERT( (hashes.size() == 1) );
+  REMUS_ASSERT( (advertised(hashes, "a")) );
+
+  //adding a blob we hold doesn't change what we hold
+  REMUS_ASSERT( (cache.add("a", make_Frame("aaaa"))) );
+  REMUS_ASSERT( (!cache.changed()) );
+}
+
+//------------------------------------------------------------------------------
+void verify_retired_blobs()
+{
+  BlobCache cache(8);
+  std::vector<std::string> hashes;
+
+  cache.add("a", make_Frame("aaaa"));
+  cache.add("b", make_Frame("bbbb"));
+  const std::size_t holdsA = cache.advertise(hashes);
+  REMUS_ASSERT( (advertised(hashes, "a")) );
+
+  //adding c drops a, which the server could still be referencing
+  cache.add("c", make_Frame("cccc"));
+  REMUS_ASSERT( (!cache.holds("a")) );
+  REMUS_ASSERT( (cache.retiredCount() == 1) );
+  REMUS_ASSERT( (cache.changed()) );
+
+  //acknowledging the advert that still held a doesn't release it
+  cache.release(holdsA);
+  REMUS_ASSERT( (cache.retiredCount() == 1) );
+
+  const std::size_t dropsA = cache.advertise(hashes);
+  REMUS_ASSERT( (!advertised(hashes, "a")) );
+  REMUS_ASSERT( (cache.retiredCount() == 1) );
+
+  //a job sent before the server saw the advert can still find a
+  Frame blob;
+  cache.release(holdsA);
+  REMUS_ASSERT( (cache.retiredCount() == 1) );
+  cache.release(dropsA);
+  REMUS_ASSERT( (cache.retiredCount() == 0) );
+  REMUS_ASSERT( (!cache.find("a", blob)) );
+
+  //finding a retired blob makes the cache hold it again
+  cache.add("a", make_Frame("aaaa"));
+  REMUS_ASSERT( (cache.retiredCount() == 1) );
+  REMUS_ASSERT( (!cache.holds("b")) );
+  REMUS_ASSERT( (cache.find("b", blob)) );
+  REMUS_ASSERT( (to_string(blob) == "bbbb") );
+  REMUS_ASSERT( (cache.holds("b")) );
+
+  //shrinking the cache retires blobs
+  cache.maxBytes(4);
+  REMUS_ASSERT( (cache.size() == 1) );
+  REMUS_ASSERT( (cache.byteCount() == 4) );
+}
+
+//------------------------------------------------------------------------------
+void verify_spill_to_disk()
+{
+  const boost::filesystem::path dir = boost::filesystem::temp_directory_path() /
+                                      remus::testing::UniqueString();
+  const std::string a = hash_of("aaaa");
+  const std::string b = hash_of("bbbb");
+  {
+  BlobCache cache(8, dir.string(), 8);
+  std::vector<std::string> hashes;
+  cache.add(a, make_Frame("aaaa"));
+  cache.add(b, make_Frame("bbbb"));
+  cache.advertise(hashes);
+
+  //a is spilled instead of dropped, so we still hold it
+  cache.add(hash_of("cccc"), make_Frame("cccc"));
+  REMUS_ASSERT( (cache.holds(a)) );
+  REMUS_ASSERT( (cache.byteCount() == 8) );
+  REMUS_ASSERT( (cache.spilledByteCount() == 4) );
+  REMUS_ASSERT( (boost::filesystem::exists(dir / a)) );
+
+  //finding a spilled blob brings it back into memory, and spills b
+  Frame blob;
+  REMUS_ASSERT( (cache.find(a, blob)) );
+  REMUS_ASSERT( (to_string(blob) == "aaaa") );
+  REMUS_ASSERT( (!boost::filesystem::exists(dir / a)) );
+  REMUS_ASSERT( (boost::filesystem::exists(dir / b)) );
+  REMUS_ASSERT( (cache.size() == 3) );
+
+  //once the disk is full too blobs are retired, keeping the file around
+  //until the server knows we dropped it
+  cache.add(hash_of("dddd"), make_Frame("dddd"));
+  cache.add(hash_of("eeee"), make_Frame("eeee"));
+  REMUS_ASSERT( (cache.spilledByteCount() == 8) );
+  REMUS_ASSERT( (!cache.holds(b)) );
+  REMUS_ASSERT( (cache.retiredCount() == 1) );
+  REMUS_ASSERT( (boost::filesystem::exists(dir / b)) );
+
+  const std::size_t dropsB = cache.advertise(hashes);
+  REMUS_ASSERT( (hashes.size() == 4) );
+  cache.release(dropsB);
+  REMUS_ASSERT( (!boost::filesystem::exists(dir / b)) );
+  }
+
+  //the spilled files are removed with the cache
+  REMUS_ASSERT( (boost::filesystem::is_empty(dir)) );
+  boost::filesystem::remove_all(dir);
+}
+
+//------------------------------------------------------------------------------
+void verify_corrupt_spilled_blobs()
+{
+  const boost::filesystem::path dir = boost::filesystem::temp_directory_path() /
+                                      remus::testing::UniqueString();
+  const std::string a = hash_of("aaaa");
+  const std::string b = hash_of("bbbb");
+  {
+  BlobCache cache(4, dir.string(), 8);
+  std::vector<std::string> hashes;
+  cache.add(a, make_Frame("aaaa"));
+  cache.add(b, make_Frame("bbbb"));
+  cache.add(hash_of("cccc"), make_Frame("cccc"));
+  cache.advertise(hashes);
+  REMUS_ASSERT( (cache.holds(a)) );
+  REMUS_ASSERT( (cache.holds(b)) );
+
+  //a truncated file is treated like a missing one
+  boost::filesystem::resize_file(dir / a, 2);
+  Frame blob;
+  REMUS_ASSERT( (!cache.find(a, blob)) );
+  REMUS_ASSERT( (!cache.holds(a)) );
+  REMUS_ASSERT( (cache.changed()) );
+  REMUS_ASSERT( (!boost::filesystem::exists(dir / a)) );
+  REMUS_ASSERT( (cache.spilledByteCount() == 4) );
+
+  //so is a file whose contents were changed
+  {
+  std::ofstream file((dir / b).string().c_str(),
+                     std::ios::out | std::ios::binary | std::ios::trunc);
+  file << "xxxx";
+  }
+  cache.advertise(hashes);
+  REMUS_ASSERT( (!cache.find(b, blob)) );
+  REMUS_ASSERT( (!cache.holds(b)) );
+  REMUS_ASSERT( (cache.changed()) );
+  REMUS_ASSERT( (cache.spilledByteCount() == 0) );
+  }
+  boost::filesystem::remove_all(dir);
+}
+
+}
+
+int UnitTestBlobCache(int, char *[])
+{
+  verify_add_and_find();
+  verify_retired_blobs();
+  verify_spill_to_disk();
+  verify_corrupt_spilled_blobs();
+  return 0;
+}
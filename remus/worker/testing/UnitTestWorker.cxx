@@ -216,6 +216,31 @@ void verify_polling_rates()
   REMUS_ASSERT( (worker.pollingRates().maxRate() == 120 ) )
 }
 
+//------------------------------------------------------------------------------
+void verify_prefetch_depth()
+{
+  using namespace remus::meshtypes;
+  const remus::common::MeshIOType mtype =
+                          remus::common::make_MeshIOType(Model(),Model());
+
+  zmq::socketInfo<zmq::proto::tcp> local_socket("127.0.0.1",
+                                        remus::server::WORKER_PORT+102);
+  remus::worker::ServerConnection tcp_ip_conn(local_socket);
+
+  //start up server to talk to worker
+  fake_server fake_def_server(local_socket, tcp_ip_conn.context());
+  remus::worker::Worker worker(mtype,tcp_ip_conn);
+
+  //by default jobs aren't fetched ahead
+  REMUS_ASSERT( (worker.prefetchDepth() == 0) )
+
+  worker.prefetchDepth(3);
+  REMUS_ASSERT( (worker.prefetchDepth() == 3) )
+
+  worker.prefetchDepth(0);
+  REMUS_ASSERT( (worker.prefetchDepth() == 0) )
+}
+
 } //namespace
 
 
@@ -228,6 +253,7 @@ int UnitTestWorker(int, char *[])
 #endif
 
   verify_polling_rates();
+  verify_prefetch_depth();
 
   //Keep the test running while the OS has time to unbind the sockets, this
   //should help other tests from failing to bind to the now released socket
@@ -181,6 +181,42 @@ void verify_submission()
 
 }
 
+void verify_serialization()
+{ //verify that jobs round trip through both wire formats, and that
+  //the shared decode points into the buffer it was given
+  remus::proto::JobSubmission sub = make_empty_sub();
+  sub["model"] = remus::proto::make_JobContent(
+                            remus::testing::BinaryDataGenerator(8192));
+  Job job(make_id(),sub);
+
+  Job from_text = to_Job(remus::worker::to_string(job));
+  REMUS_ASSERT( (from_text.id() == job.id()) );
+  REMUS_ASSERT( (from_text.submission() == job.submission()) );
+
+  const std::string binary = remus::proto::to_string(job,
+                                    remus::proto::WireFormat::Binary);
+  Job from_binary = to_Job(binary);
+  REMUS_ASSERT( (from_binary.valid() == true) );
+  REMUS_ASSERT( (from_binary.id() == job.id()) );
+  REMUS_ASSERT( (from_binary.submission() == job.submission()) );
+
+  boost::shared_ptr<std::string> slab(new std::string(binary));
+  boost::shared_ptr<const char> buffer(slab, slab->c_str());
+  Job from_shared = to_Job(buffer, slab->size());
+  REMUS_ASSERT( (from_shared.id() == job.id()) );
+  REMUS_ASSERT( (from_shared.submission() == job.submission()) );
+
+  remus::proto::JobContent model;
+  from_shared.details("model",model);
+  REMUS_ASSERT( (model.data() > slab->c_str()) );
+  REMUS_ASSERT( (model.data() < slab->c_str() + slab->size()) );
+
+  //the job must keep the buffer alive after everyone else lets go of it
+  buffer.reset();
+  slab.reset();
+  REMUS_ASSERT( (from_shared.details("model") == job.details("model")) );
+}
+
 } //namespace
 
 
@@ -190,5 +226,6 @@ int UnitTestWorkerJob(int, char *[])
   verify_validity();
   verify_meshTypes();
   verify_submission();
+  verify_serialization();
   return 0;
 }
@@ -92,6 +92,12 @@ int UnitTestWorkerServerConnection(int, char *[])
   REMUS_ASSERT( (sc_ipc.isLocalEndpoint()==true) );
   REMUS_ASSERT( (sc_ipc.endpoint() == std::string("ipc://task_pool")) );
 
+  //the binary wire format is the default, older servers need text
+  REMUS_ASSERT( (sc.wireFormat() == remus::proto::WireFormat::Binary) );
+  REMUS_ASSERT( (sc_ipc2.wireFormat() == remus::proto::WireFormat::Binary) );
+  sc_ipc2.wireFormat(remus::proto::WireFormat::Text);
+  REMUS_ASSERT( (sc_ipc2.wireFormat() == remus::proto::WireFormat::Text) );
+
   //test sharing a context.
   remus::worker::ServerConnection share_context;
   share_context.context(sc.context());